@@ -56,6 +56,43 @@ xmmsc_bindata_retrieve (xmmsc_connection_t *c, const char *hash)
 	                       XMMSV_LIST_ENTRY_STR (hash), XMMSV_LIST_END);
 }
 
+/**
+ * Retrieve at most length bytes starting at offset from a file in the
+ * servers bindata directory. Large files can be fetched in chunks until
+ * a chunk shorter than requested is returned.
+ */
+xmmsc_result_t *
+xmmsc_bindata_retrieve_range (xmmsc_connection_t *c, const char *hash,
+                              int offset, int length)
+{
+	x_check_conn (c, NULL);
+	x_api_error_if (offset < 0, "with negative offset", NULL);
+	x_api_error_if (length < 0, "with negative length", NULL);
+
+	return xmmsc_send_cmd (c, XMMS_IPC_OBJECT_BINDATA, XMMS_IPC_CMD_GET_DATA_RANGE,
+	                       XMMSV_LIST_ENTRY_STR (hash),
+	                       XMMSV_LIST_ENTRY_INT (offset),
+	                       XMMSV_LIST_ENTRY_INT (length),
+	                       XMMSV_LIST_END);
+}
+
+/**
+ * Retrieve an image from the servers bindata directory, scaled down so
+ * that neither side is larger than size pixels. The server returns the
+ * original if it can not be scaled.
+ */
+xmmsc_result_t *
+xmmsc_bindata_retrieve_thumbnail (xmmsc_connection_t *c, const char *hash,
+                                  int size)
+{
+	x_check_conn (c, NULL);
+
+	return xmmsc_send_cmd (c, XMMS_IPC_OBJECT_BINDATA, XMMS_IPC_CMD_GET_DATA_THUMBNAIL,
+	                       XMMSV_LIST_ENTRY_STR (hash),
+	                       XMMSV_LIST_ENTRY_INT (size),
+	                       XMMSV_LIST_END);
+}
+
 /**
  * Remove a file with associated with the hash from the server
  */
@@ -315,6 +315,23 @@ xmmsc_broadcast_collection_changed (xmmsc_connection_t *c)
 	return xmmsc_send_broadcast_msg (c, XMMS_IPC_SIGNAL_COLLECTION_CHANGED);
 }
 
+/**
+ * Request the collection changed broadcast for a single namespace. The
+ * server drops changes to collections in other namespaces instead of
+ * sending them.
+ */
+xmmsc_result_t*
+xmmsc_broadcast_collection_changed_filtered (xmmsc_connection_t *c,
+                                             xmmsv_coll_namespace_t ns)
+{
+	x_check_conn (c, NULL);
+	x_api_error_if (!ns, "with a NULL namespace", NULL);
+
+	return xmmsc_send_broadcast_filtered_msg (c, XMMS_IPC_SIGNAL_COLLECTION_CHANGED,
+	                                          xmmsv_build_dict (XMMSV_DICT_ENTRY_STR ("namespace", ns),
+	                                                            XMMSV_DICT_END));
+}
+
 /**
  * Create a new collections structure with type idlist
  * from a playlist file.
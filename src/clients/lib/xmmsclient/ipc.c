@@ -33,10 +33,22 @@
 #include "xmmsc/xmmsc_sockets.h"
 
 
+#define XMMSC_IPC_RESULTS_MIN_SIZE 32
+
+/* Pending results are kept in an open addressing table keyed by cookie,
+ * collisions are resolved by linear probing. The cookie is stored next
+ * to the result so probing never has to touch the result itself. */
+typedef struct xmmsc_ipc_result_slot_St {
+	uint32_t cookie;
+	xmmsc_result_t *res;
+} xmmsc_ipc_result_slot_t;
+
 struct xmmsc_ipc_St {
 	xmms_ipc_transport_t *transport;
 	xmms_ipc_msg_t *read_msg;
-	x_list_t *results_list;
+	xmmsc_ipc_result_slot_t *results;
+	unsigned int results_size;
+	unsigned int results_count;
 	x_queue_t *out_msg;
 	char *error;
 	bool disconnect;
@@ -135,6 +147,16 @@ xmmsc_ipc_fd_get (xmmsc_ipc_t *ipc)
 	return xmms_ipc_transport_fd_get (ipc->transport);
 }
 
+/**
+ * Whether the server may pass large messages as a descriptor on this
+ * connection.
+ */
+int
+xmmsc_ipc_fd_passing (xmmsc_ipc_t *ipc)
+{
+	x_return_val_if_fail (ipc, 0);
+	return xmms_ipc_transport_fd_passing (ipc->transport);
+}
 
 const char *
 xmmsc_ipc_error_get (xmmsc_ipc_t *ipc)
@@ -170,7 +192,7 @@ xmmsc_ipc_init (void)
 	xmmsc_ipc_t *ipc;
 	ipc = x_new0 (xmmsc_ipc_t, 1);
 	ipc->disconnect = false;
-	ipc->results_list = NULL;
+	ipc->results = NULL;
 	ipc->out_msg = x_queue_new ();
 
 	return ipc;
@@ -202,6 +224,54 @@ xmmsc_ipc_lock_set (xmmsc_ipc_t *ipc, void *lock, void (*lockfunc)(void *), void
 	ipc->unlockfunc = unlockfunc;
 }
 
+/* cookies are handed out sequentially, an odd multiplier keeps them
+ * spread over the whole table */
+static inline unsigned int
+xmmsc_ipc_result_hash (xmmsc_ipc_t *ipc, uint32_t cookie)
+{
+	return (cookie * 2654435761U) & (ipc->results_size - 1);
+}
+
+static void
+xmmsc_ipc_result_insert (xmmsc_ipc_t *ipc, uint32_t cookie, xmmsc_result_t *res)
+{
+	unsigned int i, mask = ipc->results_size - 1;
+
+	for (i = xmmsc_ipc_result_hash (ipc, cookie); ipc->results[i].res; i = (i + 1) & mask)
+		;
+
+	ipc->results[i].cookie = cookie;
+	ipc->results[i].res = res;
+	ipc->results_count++;
+}
+
+static bool
+xmmsc_ipc_result_resize (xmmsc_ipc_t *ipc, unsigned int size)
+{
+	xmmsc_ipc_result_slot_t *old = ipc->results;
+	unsigned int i, old_size = ipc->results_size;
+
+	ipc->results = x_new0 (xmmsc_ipc_result_slot_t, size);
+	if (!ipc->results) {
+		x_oom ();
+		ipc->results = old;
+		return false;
+	}
+
+	ipc->results_size = size;
+	ipc->results_count = 0;
+
+	for (i = 0; i < old_size; i++) {
+		if (old[i].res) {
+			xmmsc_ipc_result_insert (ipc, old[i].cookie, old[i].res);
+		}
+	}
+
+	free (old);
+
+	return true;
+}
+
 void
 xmmsc_ipc_result_register (xmmsc_ipc_t *ipc, xmmsc_result_t *res)
 {
@@ -209,7 +279,23 @@ xmmsc_ipc_result_register (xmmsc_ipc_t *ipc, xmmsc_result_t *res)
 	x_return_if_fail (res);
 
 	xmmsc_ipc_lock (ipc);
-	ipc->results_list = x_list_prepend (ipc->results_list, res);
+
+	/* keep the table at most half full so probe sequences stay short */
+	if ((ipc->results_count + 1) * 2 > ipc->results_size) {
+		unsigned int size = ipc->results_size * 2;
+
+		if (size < XMMSC_IPC_RESULTS_MIN_SIZE) {
+			size = XMMSC_IPC_RESULTS_MIN_SIZE;
+		}
+
+		if (!xmmsc_ipc_result_resize (ipc, size)) {
+			xmmsc_ipc_unlock (ipc);
+			return;
+		}
+	}
+
+	xmmsc_ipc_result_insert (ipc, xmmsc_result_cookie_get (res), res);
+
 	xmmsc_ipc_unlock (ipc);
 }
 
@@ -217,18 +303,20 @@ xmmsc_result_t *
 xmmsc_ipc_result_lookup (xmmsc_ipc_t *ipc, uint32_t cookie)
 {
 	xmmsc_result_t *res = NULL;
-	x_list_t *n;
+	unsigned int i, mask;
 
 	x_return_val_if_fail (ipc, NULL);
 
 	xmmsc_ipc_lock (ipc);
 
-	for (n = ipc->results_list; n; n = x_list_next (n)) {
-		xmmsc_result_t *tmp = n->data;
+	if (ipc->results_count) {
+		mask = ipc->results_size - 1;
 
-		if (cookie == xmmsc_result_cookie_get (tmp)) {
-			res = tmp;
-			break;
+		for (i = xmmsc_ipc_result_hash (ipc, cookie); ipc->results[i].res; i = (i + 1) & mask) {
+			if (ipc->results[i].cookie == cookie) {
+				res = ipc->results[i].res;
+				break;
+			}
 		}
 	}
 
@@ -240,22 +328,48 @@ xmmsc_ipc_result_lookup (xmmsc_ipc_t *ipc, uint32_t cookie)
 void
 xmmsc_ipc_result_unregister (xmmsc_ipc_t *ipc, xmmsc_result_t *res)
 {
-	x_list_t *n;
+	unsigned int i, j, home, mask;
 
 	x_return_if_fail (ipc);
 	x_return_if_fail (res);
 
 	xmmsc_ipc_lock (ipc);
 
-	for (n = ipc->results_list; n; n = x_list_next (n)) {
-		xmmsc_result_t *tmp = n->data;
+	if (!ipc->results_count) {
+		xmmsc_ipc_unlock (ipc);
+		return;
+	}
+
+	mask = ipc->results_size - 1;
 
-		if (xmmsc_result_cookie_get (res) == xmmsc_result_cookie_get (tmp)) {
-			ipc->results_list = x_list_delete_link (ipc->results_list, n);
-			break;
+	for (i = xmmsc_ipc_result_hash (ipc, xmmsc_result_cookie_get (res));
+	     ipc->results[i].res != res; i = (i + 1) & mask) {
+		if (!ipc->results[i].res) {
+			xmmsc_ipc_unlock (ipc);
+			return;
+		}
+	}
+
+	/* Shift the following entries of the probe sequence back into the
+	 * hole, so lookups never need tombstones. An entry may only move
+	 * if the hole lies between its home slot and its current slot. */
+	for (j = (i + 1) & mask; ipc->results[j].res; j = (j + 1) & mask) {
+		home = xmmsc_ipc_result_hash (ipc, ipc->results[j].cookie);
+		if (((j - home) & mask) >= ((j - i) & mask)) {
+			ipc->results[i] = ipc->results[j];
+			i = j;
 		}
 	}
 
+	ipc->results[i].res = NULL;
+	ipc->results_count--;
+
+	/* give the memory back after a burst of pipelined requests */
+	if (ipc->results_size > XMMSC_IPC_RESULTS_MIN_SIZE &&
+	    ipc->results_count * 8 < ipc->results_size) {
+		xmmsc_ipc_result_resize (ipc, ipc->results_size / 2);
+	}
+
 	xmmsc_ipc_unlock (ipc);
 }
 
@@ -277,6 +391,14 @@ xmmsc_ipc_wait_for_event (xmmsc_ipc_t *ipc, unsigned int timeout)
 	x_return_if_fail (ipc);
 	x_return_if_fail (!ipc->disconnect);
 
+	/* When called from a result callback, the rest of the last read,
+	 * possibly including the reply waited for, is still buffered and
+	 * select() would never report it. */
+	if (xmms_ipc_transport_buffered (ipc->transport)) {
+		xmmsc_ipc_io_in_callback (ipc);
+		return;
+	}
+
 	tmout.tv_sec = timeout;
 	tmout.tv_usec = 0;
 
@@ -326,7 +448,7 @@ xmmsc_ipc_destroy (xmmsc_ipc_t *ipc)
 	if (!ipc)
 		return;
 
-	x_list_free (ipc->results_list);
+	free (ipc->results);
 	if (ipc->transport) {
 		xmms_ipc_transport_destroy (ipc->transport);
 	}
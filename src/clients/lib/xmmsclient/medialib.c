@@ -99,6 +99,65 @@ xmmsc_medialib_move_entry (xmmsc_connection_t *conn, int entry, const char *url)
 	                       XMMSV_LIST_END);
 }
 
+/**
+ * Change the url prefix of all entries under a prefix in the media
+ * library in one go, e.g. after a directory has been moved. Note that
+ * you need to handle the actual move yourself.
+ *
+ * @param conn The #xmmsc_connection_t
+ * @param from The url prefix the entries are under, usually ending with a slash
+ * @param to The url prefix to replace it with
+ * @return The number of moved entries
+ */
+xmmsc_result_t *
+xmmsc_medialib_move_prefix (xmmsc_connection_t *conn, const char *from,
+                            const char *to)
+{
+	x_check_conn (conn, NULL);
+
+	return xmmsc_send_cmd (conn, XMMS_IPC_OBJECT_MEDIALIB,
+	                       XMMS_IPC_CMD_MOVE_PREFIX,
+	                       XMMSV_LIST_ENTRY_STR (from),
+	                       XMMSV_LIST_ENTRY_STR (to),
+	                       XMMSV_LIST_END);
+}
+
+/**
+ * Remove all entries under an url prefix from the medialib in one go.
+ *
+ * @param conn The #xmmsc_connection_t
+ * @param prefix The url prefix, usually a directory ending with a slash
+ * @return The number of removed entries
+ */
+xmmsc_result_t *
+xmmsc_medialib_remove_prefix (xmmsc_connection_t *conn, const char *prefix)
+{
+	x_check_conn (conn, NULL);
+
+	return xmmsc_send_cmd (conn, XMMS_IPC_OBJECT_MEDIALIB,
+	                       XMMS_IPC_CMD_REMOVE_PREFIX,
+	                       XMMSV_LIST_ENTRY_STR (prefix),
+	                       XMMSV_LIST_END);
+}
+
+/**
+ * Rehash all entries under an url prefix in one go.
+ *
+ * @param conn The #xmmsc_connection_t
+ * @param prefix The url prefix, usually a directory ending with a slash
+ * @return The number of entries marked for rehashing
+ */
+xmmsc_result_t *
+xmmsc_medialib_rehash_prefix (xmmsc_connection_t *conn, const char *prefix)
+{
+	x_check_conn (conn, NULL);
+
+	return xmmsc_send_cmd (conn, XMMS_IPC_OBJECT_MEDIALIB,
+	                       XMMS_IPC_CMD_REHASH_PREFIX,
+	                       XMMSV_LIST_ENTRY_STR (prefix),
+	                       XMMSV_LIST_END);
+}
+
 /**
  * Remove a entry from the medialib
  * @param conn The #xmmsc_connection_t
@@ -340,6 +399,39 @@ xmmsc_broadcast_medialib_entry_changed (xmmsc_connection_t *c)
 	return xmmsc_send_broadcast_msg (c, XMMS_IPC_SIGNAL_MEDIALIB_ENTRY_UPDATE);
 }
 
+/**
+ * Request the medialib_entry_changed broadcast for a set of entries.
+ * The server only sends changes to the entries in ids.
+ *
+ * @param ids a list of medialib ids.
+ */
+xmmsc_result_t *
+xmmsc_broadcast_medialib_entry_changed_filtered (xmmsc_connection_t *c,
+                                                 xmmsv_t *ids)
+{
+	x_check_conn (c, NULL);
+	x_api_error_if (!ids, "with a NULL id list", NULL);
+	x_api_error_if (!xmmsv_is_type (ids, XMMSV_TYPE_LIST), "with a non-list", NULL);
+
+	return xmmsc_send_broadcast_filtered_msg (c, XMMS_IPC_SIGNAL_MEDIALIB_ENTRY_UPDATE,
+	                                          xmmsv_build_dict (XMMSV_DICT_ENTRY ("value", xmmsv_ref (ids)),
+	                                                            XMMSV_DICT_END));
+}
+
+/**
+ * Request the medialib_entries_changed broadcast. This will be called
+ * once for changes to many entries on the serverside, such as prefix
+ * operations. The argument is a dict with the lists of "added",
+ * "changed" and "removed" medialib ids.
+ */
+xmmsc_result_t *
+xmmsc_broadcast_medialib_entries_changed (xmmsc_connection_t *c)
+{
+	x_check_conn (c, NULL);
+
+	return xmmsc_send_broadcast_msg (c, XMMS_IPC_SIGNAL_MEDIALIB_ENTRIES_CHANGED);
+}
+
 /**
  * Associate a int value with a medialib entry. Uses default
  * source which is client/&lt;clientname&gt;
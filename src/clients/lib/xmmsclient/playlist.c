@@ -820,6 +820,24 @@ xmmsc_broadcast_playlist_changed (xmmsc_connection_t *c)
 	return xmmsc_send_broadcast_msg (c, XMMS_IPC_SIGNAL_PLAYLIST_CHANGED);
 }
 
+/**
+ * Request the playlist changed broadcast for a single playlist. The
+ * server drops changes to other playlists instead of sending them.
+ *
+ * @param playlist the name of the playlist, not an alias like "_active".
+ */
+xmmsc_result_t *
+xmmsc_broadcast_playlist_changed_filtered (xmmsc_connection_t *c,
+                                           const char *playlist)
+{
+	x_check_conn (c, NULL);
+	x_api_error_if (!playlist, "with a NULL playlist", NULL);
+
+	return xmmsc_send_broadcast_filtered_msg (c, XMMS_IPC_SIGNAL_PLAYLIST_CHANGED,
+	                                          xmmsv_build_dict (XMMSV_DICT_ENTRY_STR ("name", playlist),
+	                                                            XMMSV_DICT_END));
+}
+
 /**
  * Request the playlist current pos broadcast. When the position
  * in the playlist is changed this will be called.
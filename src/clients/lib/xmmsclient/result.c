@@ -198,7 +198,10 @@ xmmsc_result_restart (xmmsc_result_t *res)
 		return;
 	}
 
+	/* pending results are indexed by cookie */
+	xmmsc_ipc_result_unregister (res->ipc, res);
 	res->cookie = xmmsc_write_signal_msg (res->c, res->restart_signal);
+	xmmsc_ipc_result_register (res->ipc, res);
 }
 
 static bool
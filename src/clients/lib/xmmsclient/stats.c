@@ -55,6 +55,25 @@ xmmsc_main_stats (xmmsc_connection_t *c)
 	return xmmsc_send_msg_no_arg (c, XMMS_IPC_OBJECT_MAIN, XMMS_IPC_CMD_STATS);
 }
 
+/**
+ * Get the server's internal counters and latency histograms.
+ *
+ * The result is a dict with the number of threads that recorded
+ * anything, a dict of "counters", a dict of "histograms" for medialib
+ * queries, s4 commits, xform chain setup, filler reads and the ring
+ * buffer fill level, and an "ipc" list with one histogram per IPC
+ * object and command that has been called. Each histogram holds its
+ * "count", "mean", "max", "unit" and a list of "buckets", where bucket
+ * n counts values from 2^(n-1) up to 2^n.
+ */
+xmmsc_result_t *
+xmmsc_stats_get (xmmsc_connection_t *c)
+{
+	x_check_conn (c, NULL);
+
+	return xmmsc_send_msg_no_arg (c, XMMS_IPC_OBJECT_STATS, XMMS_IPC_CMD_STATS_GET);
+}
+
 /**
  * Request status for the mediainfo reader. It can be idle or working
  */
@@ -37,6 +37,7 @@
 #define XMMS_MAX_URI_LEN 1024
 
 static void xmmsc_deinit (xmmsc_connection_t *c);
+static uint32_t xmmsc_write_msg_to_ipc (xmmsc_connection_t *c, xmms_ipc_msg_t *msg);
 
 /*
  * Public methods
@@ -124,11 +125,34 @@ static xmmsc_result_t *
 xmmsc_send_hello (xmmsc_connection_t *c)
 {
 	const int protocol_version = XMMS_IPC_PROTOCOL_VERSION;
+	xmmsc_result_t *res;
+	xmms_ipc_msg_t *msg;
+	xmmsv_t *args;
 
-	return xmmsc_send_cmd (c, XMMS_IPC_OBJECT_MAIN, XMMS_IPC_CMD_HELLO,
-	                       XMMSV_LIST_ENTRY_INT (protocol_version),
-	                       XMMSV_LIST_ENTRY_STR (c->clientname),
-	                       XMMSV_LIST_END);
+	res = xmmsc_send_cmd (c, XMMS_IPC_OBJECT_MAIN, XMMS_IPC_CMD_HELLO,
+	                      XMMSV_LIST_ENTRY_INT (protocol_version),
+	                      XMMSV_LIST_ENTRY_STR (c->clientname),
+	                      XMMSV_LIST_END);
+
+	/* Ask for the compact encoding of values. The command gets no
+	 * reply, and servers that don't know it ignore it and keep
+	 * sending the legacy encoding, which is read just as well. */
+	msg = xmms_ipc_msg_new (XMMS_IPC_OBJECT_SIGNAL, XMMS_IPC_CMD_WIRE_FORMAT);
+	args = xmmsv_build_list (XMMSV_LIST_ENTRY_INT (XMMS_IPC_WIRE_COMPACT),
+	                         XMMSV_LIST_END);
+	xmms_ipc_msg_put_value (msg, args);
+	xmmsv_unref (args);
+
+	xmmsc_write_msg_to_ipc (c, msg);
+
+	/* Large replies can be mapped from a descriptor on local sockets,
+	 * servers that don't know about this keep using the socket. */
+	if (xmmsc_ipc_fd_passing (c->ipc)) {
+		msg = xmms_ipc_msg_new (XMMS_IPC_OBJECT_SIGNAL, XMMS_IPC_CMD_FD_PAYLOADS);
+		xmmsc_write_msg_to_ipc (c, msg);
+	}
+
+	return res;
 }
 
 /**
@@ -355,6 +379,20 @@ xmmsc_send_broadcast_msg (xmmsc_connection_t *c, int signalid)
 	                       XMMSV_LIST_END);
 }
 
+/**
+ * Subscribe to a broadcast that the server only sends when it matches
+ * filter. Takes over the reference to filter.
+ */
+xmmsc_result_t *
+xmmsc_send_broadcast_filtered_msg (xmmsc_connection_t *c, int signalid,
+                                   xmmsv_t *filter)
+{
+	return xmmsc_send_cmd (c, XMMS_IPC_OBJECT_SIGNAL, XMMS_IPC_CMD_BROADCAST,
+	                       XMMSV_LIST_ENTRY_INT (signalid),
+	                       XMMSV_LIST_ENTRY (filter),
+	                       XMMSV_LIST_END);
+}
+
 
 uint32_t
 xmmsc_write_signal_msg (xmmsc_connection_t *c, int signalid)
@@ -448,6 +486,50 @@ xmmsc_send_cmd (xmmsc_connection_t *c, int obj, int cmd, ...)
 	return xmmsc_send_msg (c, msg);
 }
 
+/**
+ * @defgroup BatchFunctions BatchFunctions
+ * @ingroup XMMSClient
+ * @brief Running many commands in one round trip.
+ *
+ * @{
+ */
+
+/**
+ * Run several commands on the server in one round trip.
+ *
+ * The server runs the commands in order, from a single dispatch. They
+ * do not share a medialib transaction. Signal and broadcast
+ * registrations can not be batched, since each needs a cookie of its
+ * own.
+ *
+ * The reply is a list with one entry per command, in the order of
+ * commands. An entry holds the command's return value, none if it has
+ * none, or an error value (see xmmsv_get_error) if the command failed,
+ * does not exist or is malformed. A failing command does not stop the
+ * rest of the batch. The result itself is only an error if commands
+ * could not be read as a list at all.
+ *
+ * @param c The connection to the server.
+ * @param commands A list of commands, each a list of object id, command
+ * id and a list of the command arguments, for example built with
+ * xmmsv_build_list.
+ * @returns A result holding the list of replies.
+ */
+xmmsc_result_t *
+xmmsc_batch (xmmsc_connection_t *c, xmmsv_t *commands)
+{
+	x_check_conn (c, NULL);
+	x_api_error_if (!commands, "with a NULL command list", NULL);
+	x_api_error_if (!xmmsv_is_type (commands, XMMSV_TYPE_LIST),
+	                "with a non-list command list", NULL);
+
+	return xmmsc_send_cmd (c, XMMS_IPC_OBJECT_SIGNAL, XMMS_IPC_CMD_BATCH,
+	                       XMMSV_LIST_ENTRY (xmmsv_ref (commands)),
+	                       XMMSV_LIST_END);
+}
+
+/** @} */
+
 /**
  * @defgroup IOFunctions IOFunctions
  * @ingroup XMMSClient
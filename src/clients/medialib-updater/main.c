@@ -22,10 +22,47 @@
 
 #include <xmms_configuration.h>
 
+/* Attributes needed to tell whether a file changed since it was indexed */
+#define UPDATER_FILE_ATTRIBUTES \
+	G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+	G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+	G_FILE_ATTRIBUTE_STANDARD_SIZE "," \
+	G_FILE_ATTRIBUTE_TIME_MODIFIED "," \
+	G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC "," \
+	G_FILE_ATTRIBUTE_UNIX_INODE
+
+#define UPDATER_INDEX_HEADER "xmms2-mlib-updater index 1"
+
+/* Commands sent to the server in one batch */
+#define UPDATER_BATCH_SIZE 256
+
+/* Events are collected until none arrived for this long... */
+#define UPDATER_DEBOUNCE_MS 500
+/* ...but never for longer than this */
+#define UPDATER_DEBOUNCE_MAX_MS 5000
+
+typedef struct updater_entry_St {
+	guint64 mtime;
+	guint64 size;
+	guint64 inode;
+} updater_entry_t;
+
 typedef struct updater_St {
 	xmmsc_connection_t *conn;
 	GHashTable *watchers;
 	GFile *root;
+
+	/* path -> updater_entry_t of every file below the watched root */
+	GHashTable *index;
+	gchar *index_filename;
+
+	/* the index changed since it was last saved */
+	gboolean dirty;
+
+	/* paths touched since the last flush */
+	GHashTable *pending;
+	guint debounce_source;
+	GTimeVal debounce_start;
 } updater_t;
 
 typedef struct updater_quit_St {
@@ -34,7 +71,17 @@ typedef struct updater_quit_St {
 	void *source;
 } updater_quit_t;
 
-static gboolean updater_add_watcher (updater_t *updater, GFile *root);
+typedef struct updater_batch_St {
+	updater_t *updater;
+	gint cmd;
+} updater_batch_t;
+
+typedef struct updater_removal_St {
+	updater_t *updater;
+	gchar *path;
+} updater_removal_t;
+
+static gboolean updater_add_watcher (updater_t *updater, GFile *root, GHashTable *scan);
 static void on_directory_event (GFileMonitor *monitor, GFile *dir,
                                 GFile *other, GFileMonitorEvent event,
                                 gpointer udata);
@@ -77,6 +124,26 @@ unregister_monitor (gpointer ptr)
 	g_object_unref (monitor);
 }
 
+static GHashTable *
+updater_index_new (void)
+{
+	return g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+}
+
+static gchar *
+updater_index_filename (void)
+{
+	gchar *filename, *dir;
+
+	dir = g_new0 (gchar, XMMS_PATH_MAX);
+	xmmsc_userconfdir_get (dir, XMMS_PATH_MAX);
+	filename = g_build_path (G_DIR_SEPARATOR_S, dir, "clients",
+	                         "mlibupdater.index", NULL);
+	g_free (dir);
+
+	return filename;
+}
+
 static updater_t *
 updater_new (void)
 {
@@ -85,6 +152,10 @@ updater_new (void)
 	updater->conn = xmmsc_init ("XMMS2-Medialib-Updater");
 	updater->watchers = g_hash_table_new_full (g_str_hash, g_str_equal,
 	                                           g_free, unregister_monitor);
+	updater->index = updater_index_new ();
+	updater->index_filename = updater_index_filename ();
+	updater->pending = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                          g_free, NULL);
 
 	return updater;
 }
@@ -96,6 +167,17 @@ updater_destroy (updater_t *updater)
 	g_return_if_fail (updater->watchers);
 	g_return_if_fail (updater->conn);
 
+	if (updater->debounce_source) {
+		g_source_remove (updater->debounce_source);
+	}
+
+	if (updater->root) {
+		g_object_unref (updater->root);
+	}
+
+	g_hash_table_destroy (updater->pending);
+	g_hash_table_destroy (updater->index);
+	g_free (updater->index_filename);
 	g_hash_table_destroy (updater->watchers);
 	xmmsc_unref (updater->conn);
 	g_free (updater);
@@ -152,9 +234,117 @@ updater_clear_watchers (updater_t *updater)
 	g_hash_table_remove_all (updater->watchers);
 }
 
+/**
+ * Load the index saved for the given root, returns NULL if there is
+ * none or it was saved for another root.
+ */
+static GHashTable *
+updater_index_load (updater_t *updater, const gchar *root)
+{
+	GHashTable *index;
+	gchar *contents, **lines, *path;
+	updater_entry_t entry, *value;
+	gint i, offset;
+
+	if (!g_file_get_contents (updater->index_filename, &contents, NULL, NULL)) {
+		return NULL;
+	}
+
+	lines = g_strsplit (contents, "\n", 0);
+	g_free (contents);
+
+	if (!lines[0] || strcmp (lines[0], UPDATER_INDEX_HEADER) != 0 ||
+	    !lines[1] || strcmp (lines[1], root) != 0) {
+		g_debug ("index does not match '%s', ignoring it", root);
+		g_strfreev (lines);
+		return NULL;
+	}
+
+	index = updater_index_new ();
+
+	for (i = 2; lines[i] != NULL; i++) {
+		offset = 0;
+		if (sscanf (lines[i], "%" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT
+		            " %" G_GUINT64_FORMAT " %n", &entry.mtime, &entry.size,
+		            &entry.inode, &offset) != 3 || offset == 0) {
+			continue;
+		}
+
+		path = g_strcompress (lines[i] + offset);
+		value = g_new (updater_entry_t, 1);
+		*value = entry;
+		g_hash_table_insert (index, path, value);
+	}
+
+	g_strfreev (lines);
+
+	g_debug ("loaded index of %u files", g_hash_table_size (index));
+
+	return index;
+}
+
+static void
+updater_index_save (updater_t *updater)
+{
+	GHashTableIter iter;
+	updater_entry_t *entry;
+	GError *err = NULL;
+	GString *contents;
+	gchar *path, *dir;
+	gpointer key, value;
+
+	if (!updater->root) {
+		return;
+	}
+
+	path = g_file_get_path (updater->root);
+	contents = g_string_new (UPDATER_INDEX_HEADER "\n");
+	g_string_append_printf (contents, "%s\n", path);
+	g_free (path);
+
+	g_hash_table_iter_init (&iter, updater->index);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		entry = (updater_entry_t *) value;
+		/* keeps newlines in file names from breaking the format */
+		path = g_strescape ((const gchar *) key, NULL);
+		g_string_append_printf (contents, "%" G_GUINT64_FORMAT " %"
+		                        G_GUINT64_FORMAT " %" G_GUINT64_FORMAT " %s\n",
+		                        entry->mtime, entry->size, entry->inode, path);
+		g_free (path);
+	}
+
+	dir = g_path_get_dirname (updater->index_filename);
+	g_mkdir_with_parents (dir, 0755);
+	g_free (dir);
+
+	if (!g_file_set_contents (updater->index_filename, contents->str,
+	                          contents->len, &err)) {
+		g_warning ("Unable to save index: %s", err->message);
+		g_error_free (err);
+	} else {
+		updater->dirty = FALSE;
+	}
+
+	g_string_free (contents, TRUE);
+}
+
+static void
+updater_entry_from_info (updater_entry_t *entry, GFileInfo *info)
+{
+	entry->mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC +
+	               g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+	entry->size = g_file_info_get_size (info);
+	entry->inode = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_UNIX_INODE);
+}
+
+static gboolean
+updater_entry_equal (const updater_entry_t *a, const updater_entry_t *b)
+{
+	return a->mtime == b->mtime && a->size == b->size && a->inode == b->inode;
+}
 
 static void
-updater_find_sub_directories (updater_t *updater, GFile *file)
+updater_find_sub_directories (updater_t *updater, GFile *file, GHashTable *scan)
 {
 	GFileEnumerator *enumerator;
 	GFileInfo *info;
@@ -163,23 +353,41 @@ updater_find_sub_directories (updater_t *updater, GFile *file)
 	g_return_if_fail (updater);
 	g_return_if_fail (file);
 
-	enumerator = g_file_enumerate_children (file, G_FILE_ATTRIBUTE_STANDARD_NAME,
+	enumerator = g_file_enumerate_children (file, UPDATER_FILE_ATTRIBUTES,
 	                                        G_FILE_QUERY_INFO_NONE, NULL, &err);
 
 	g_clear_error (&err);
 
+	if (!enumerator) {
+		return;
+	}
+
 	while ((info = g_file_enumerator_next_file (enumerator, NULL, &err)) != NULL) {
+		updater_entry_t *entry;
 		const gchar *name;
 		GFile *child;
 
 		name = g_file_info_get_name (info);
 		child = g_file_get_child (file, name);
-		g_object_unref (info);
 
-		updater_add_watcher (updater, child);
+		switch (g_file_info_get_file_type (info)) {
+		case G_FILE_TYPE_DIRECTORY:
+			updater_add_watcher (updater, child, scan);
+			break;
+		case G_FILE_TYPE_REGULAR:
+			entry = g_new (updater_entry_t, 1);
+			updater_entry_from_info (entry, info);
+			g_hash_table_insert (scan, g_file_get_path (child), entry);
+			break;
+		default:
+			break;
+		}
+
+		g_object_unref (info);
 		g_object_unref (child);
 	}
 
+	g_clear_error (&err);
 	g_object_unref (enumerator);
 }
 
@@ -200,8 +408,12 @@ updater_is_dir (GFile *file)
 	return TRUE;
 }
 
+/**
+ * Watch a directory and everything below it, recording the regular
+ * files found on the way in scan.
+ */
 static gboolean
-updater_add_watcher (updater_t *updater, GFile *file)
+updater_add_watcher (updater_t *updater, GFile *file, GHashTable *scan)
 {
 	GFileMonitor *monitor;
 	GError *err = NULL;
@@ -216,6 +428,11 @@ updater_add_watcher (updater_t *updater, GFile *file)
 
 	path = g_file_get_path (file);
 
+	if (g_hash_table_lookup (updater->watchers, path)) {
+		g_free (path);
+		return TRUE;
+	}
+
 	monitor = g_file_monitor_directory (file, G_FILE_MONITOR_NONE, NULL, &err);
 	if (err) {
 		g_printerr ("Unable to monitor '%s', %s\n", path, err->message);
@@ -230,54 +447,226 @@ updater_add_watcher (updater_t *updater, GFile *file)
 	/* path ownership transfered to the hash */
 	g_hash_table_insert (updater->watchers, path, monitor);
 
-	updater_find_sub_directories (updater, file);
+	updater_find_sub_directories (updater, file, scan);
 
 	return TRUE;
 }
 
-static gboolean
-updater_add_watcher_and_import (updater_t *updater, GFile *file)
+static void
+updater_batch_append (xmmsv_t *batch, gint cmd, xmmsv_t *arg)
 {
-	xmmsc_result_t *res;
-	gchar *url, *path;
+	xmmsv_t *command;
+
+	command = xmmsv_build_list (XMMSV_LIST_ENTRY_INT (XMMS_IPC_OBJECT_MEDIALIB),
+	                            XMMSV_LIST_ENTRY_INT (cmd),
+	                            XMMSV_LIST_ENTRY (xmmsv_build_list (XMMSV_LIST_ENTRY (arg),
+	                                                                XMMSV_LIST_END)),
+	                            XMMSV_LIST_END);
+	xmmsv_list_append (batch, command);
+	xmmsv_unref (command);
+}
 
-	g_return_val_if_fail (updater, FALSE);
-	g_return_val_if_fail (file, FALSE);
+static int
+updater_batch_ids (xmmsv_t *value, void *udata)
+{
+	updater_batch_t *data = (updater_batch_t *) udata;
+	xmmsc_result_t *res;
+	xmmsv_list_iter_t *it;
+	xmmsv_t *batch;
+	const gchar *err;
+	gint mid;
 
-	if (!updater_add_watcher (updater, file)) {
+	if (xmmsv_get_error (value, &err)) {
+		g_warning ("Couldn't resolve entries: %s", err);
 		return FALSE;
 	}
 
-	path = g_file_get_path (file);
-	url = g_strdup_printf ("file://%s", path);
-	g_free (path);
+	batch = xmmsv_new_list ();
+
+	/* urls the server failed to resolve come back as errors, skip them */
+	xmmsv_get_list_iter (value, &it);
+	for (; xmmsv_list_iter_valid (it); xmmsv_list_iter_next (it)) {
+		if (xmmsv_list_iter_entry_int (it, &mid) && mid) {
+			updater_batch_append (batch, data->cmd, xmmsv_new_int (mid));
+		}
+	}
+
+	if (xmmsv_list_get_size (batch) > 0) {
+		res = xmmsc_batch (data->updater->conn, batch);
+		xmmsc_result_unref (res);
+	}
+
+	xmmsv_unref (batch);
+
+	return FALSE;
+}
+
+static void
+updater_send_batch (updater_t *updater, xmmsv_t *batch, gint cmd)
+{
+	xmmsc_result_t *res;
+	updater_batch_t *data;
+
+	res = xmmsc_batch (updater->conn, batch);
+
+	/* rehash and remove need the ids the urls were resolved to */
+	if (cmd != XMMS_IPC_CMD_MLIB_ADD_URL) {
+		data = g_new0 (updater_batch_t, 1);
+		data->updater = updater;
+		data->cmd = cmd;
+		xmmsc_result_notifier_set_full (res, updater_batch_ids, data, g_free);
+	}
 
-	res = xmmsc_medialib_import_path (updater->conn, url);
 	xmmsc_result_unref (res);
+}
 
-	g_free (url);
+/**
+ * Add, rehash or remove a list of files, UPDATER_BATCH_SIZE at a time.
+ * Urls are resolved to ids in one batch and the ids handled in the next.
+ */
+static void
+updater_apply (updater_t *updater, GPtrArray *paths, gint cmd)
+{
+	xmmsv_t *batch = NULL;
+	gchar *url, *encoded;
+	gint i;
 
-	return TRUE;
+	for (i = 0; i < paths->len; i++) {
+		if (!batch) {
+			batch = xmmsv_new_list ();
+		}
+
+		url = g_strdup_printf ("file://%s", (gchar *) g_ptr_array_index (paths, i));
+		encoded = xmmsc_medialib_encode_url (url);
+		g_free (url);
+
+		if (!encoded) {
+			continue;
+		}
+
+		updater_batch_append (batch,
+		                      cmd == XMMS_IPC_CMD_MLIB_ADD_URL ? cmd : XMMS_IPC_CMD_GET_ID,
+		                      xmmsv_new_string (encoded));
+		free (encoded);
+
+		if (xmmsv_list_get_size (batch) == UPDATER_BATCH_SIZE) {
+			updater_send_batch (updater, batch, cmd);
+			xmmsv_unref (batch);
+			batch = NULL;
+		}
+	}
+
+	if (batch) {
+		if (xmmsv_list_get_size (batch) > 0) {
+			updater_send_batch (updater, batch, cmd);
+		}
+		xmmsv_unref (batch);
+	}
 }
 
-static gboolean
-updater_remove_watcher (updater_t *updater, GFile *file)
+/**
+ * Files added to or changed in scan compared to the index go to added
+ * and changed and the index is updated. Paths in the arrays point into
+ * the index.
+ */
+static void
+updater_index_merge (updater_t *updater, GHashTable *scan,
+                     GPtrArray *added, GPtrArray *changed)
 {
-	gboolean ret = TRUE;
-	gchar *path;
+	GHashTableIter iter;
+	updater_entry_t *old;
+	gpointer key, value;
+
+	g_hash_table_iter_init (&iter, scan);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		old = g_hash_table_lookup (updater->index, key);
+		if (old && updater_entry_equal (old, value)) {
+			continue;
+		}
 
-	g_return_val_if_fail (updater, FALSE);
-	g_return_val_if_fail (file, FALSE);
+		if (old) {
+			g_ptr_array_add (changed, key);
+		} else {
+			g_ptr_array_add (added, key);
+		}
 
-	path = g_file_get_path (file);
+		/* hand the path and entry over to the index */
+		g_hash_table_iter_steal (&iter);
+		g_hash_table_insert (updater->index, key, value);
+	}
+}
 
-	if (!g_hash_table_remove (updater->watchers, path)) {
-		ret = FALSE;
+static void
+updater_apply_changes (updater_t *updater, GPtrArray *added,
+                       GPtrArray *changed, GPtrArray *removed)
+{
+	if (added->len || changed->len || removed->len) {
+		g_debug ("%u added, %u changed, %u removed",
+		         added->len, changed->len, removed->len);
 	}
 
-	g_free (path);
+	updater_apply (updater, added, XMMS_IPC_CMD_MLIB_ADD_URL);
+	updater_apply (updater, changed, XMMS_IPC_CMD_REHASH);
+	updater_apply (updater, removed, XMMS_IPC_CMD_REMOVE_ID);
+}
+
+/**
+ * Bring the medialib up to date with the tree below the new root.
+ *
+ * With an index saved for this root only the difference between the
+ * index and the tree is sent to the server, otherwise the whole root
+ * is imported.
+ */
+static void
+updater_reconcile (updater_t *updater, GFile *root, GHashTable *scan)
+{
+	GPtrArray *added, *changed, *removed;
+	GHashTableIter iter;
+	GHashTable *index;
+	xmmsc_result_t *res;
+	gpointer key;
+	gchar *path, *url;
+
+	path = g_file_get_path (root);
+	index = updater_index_load (updater, path);
+
+	g_hash_table_destroy (updater->index);
+
+	if (!index) {
+		url = g_strdup_printf ("file://%s", path);
+		res = xmmsc_medialib_import_path (updater->conn, url);
+		xmmsc_result_unref (res);
+		g_free (url);
+
+		updater->index = scan;
+		g_free (path);
+		return;
+	}
+
+	updater->index = index;
 
-	return ret;
+	added = g_ptr_array_new ();
+	changed = g_ptr_array_new ();
+	removed = g_ptr_array_new_with_free_func (g_free);
+
+	/* whatever is in the index but no longer on disk is gone */
+	g_hash_table_iter_init (&iter, index);
+	while (g_hash_table_iter_next (&iter, &key, NULL)) {
+		if (!g_hash_table_lookup (scan, key)) {
+			g_ptr_array_add (removed, g_strdup (key));
+			g_hash_table_iter_remove (&iter);
+		}
+	}
+
+	updater_index_merge (updater, scan, added, changed);
+	updater_apply_changes (updater, added, changed, removed);
+
+	g_ptr_array_free (added, TRUE);
+	g_ptr_array_free (changed, TRUE);
+	g_ptr_array_free (removed, TRUE);
+
+	g_hash_table_destroy (scan);
+	g_free (path);
 }
 
 /**
@@ -286,6 +675,7 @@ updater_remove_watcher (updater_t *updater, GFile *file)
 static gboolean
 updater_switch_directory (updater_t *updater, const gchar *path)
 {
+	GHashTable *scan;
 	GFile *file;
 
 	g_return_val_if_fail (updater, FALSE);
@@ -302,8 +692,18 @@ updater_switch_directory (updater_t *updater, const gchar *path)
 	}
 
 	updater_clear_watchers (updater);
-	updater_add_watcher_and_import (updater, file);
-	g_object_unref (file);
+	g_hash_table_remove_all (updater->pending);
+
+	scan = updater_index_new ();
+	updater_add_watcher (updater, file, scan);
+	updater_reconcile (updater, file, scan);
+
+	if (updater->root) {
+		g_object_unref (updater->root);
+	}
+	updater->root = file;
+
+	updater_index_save (updater);
 
 	return TRUE;
 }
@@ -401,237 +801,202 @@ updater_subscribe_config (updater_t *updater)
 	xmmsc_result_unref (res);
 }
 
-static void
-updater_add_file (updater_t *updater, GFile *file)
+static gboolean
+has_path_prefix (const gchar *path, const gchar *prefix, gsize len)
 {
-	xmmsc_result_t *res;
-	gchar *path, *url;
-
-	g_return_if_fail (updater);
-	g_return_if_fail (updater->conn);
-	g_return_if_fail (file);
-
-	path = g_file_get_path (file);
-	url = g_strdup_printf ("file://%s", path);
-	g_free (path);
+	return strncmp (path, prefix, len) == 0 &&
+	       (path[len] == '\0' || path[len] == G_DIR_SEPARATOR);
+}
 
-	res = xmmsc_medialib_add_entry (updater->conn, url);
-	xmmsc_result_unref (res);
+static void
+updater_removal_free (void *udata)
+{
+	updater_removal_t *data = (updater_removal_t *) udata;
 
-	g_free (url);
+	g_free (data->path);
+	g_free (data);
 }
 
+/**
+ * Drop the files below a deleted directory from the index once the
+ * server has removed them; if it failed they stay indexed.
+ */
 static int
-updater_remove_file_by_id (xmmsv_t *value, void *udata)
+updater_remove_directory_done (xmmsv_t *value, void *udata)
 {
-	xmmsc_result_t *res;
-	updater_t *updater;
-	int mid;
-
-	updater = (updater_t *) udata;
-
-	g_return_val_if_fail (updater, FALSE);
-
-	if (!xmmsv_get_int (value, &mid)) {
-		g_error ("couldn't find this one!");
+	updater_removal_t *data = (updater_removal_t *) udata;
+	updater_t *updater = data->updater;
+	GHashTableIter iter;
+	const gchar *err;
+	gpointer key;
+	gsize len;
+
+	if (xmmsv_get_error (value, &err)) {
+		g_warning ("Couldn't remove '%s': %s", data->path, err);
 		return FALSE;
 	}
 
-	if (!mid) {
-		g_debug ("entry not in medialib");
-		return FALSE;
+	len = strlen (data->path);
+
+	g_hash_table_iter_init (&iter, updater->index);
+	while (g_hash_table_iter_next (&iter, &key, NULL)) {
+		if (has_path_prefix (key, data->path, len)) {
+			g_hash_table_iter_remove (&iter);
+			updater->dirty = TRUE;
+		}
 	}
 
-	res = xmmsc_medialib_remove_entry (updater->conn, mid);
-	xmmsc_result_unref (res);
+	/* a pending flush saves the index anyway */
+	if (updater->dirty && !updater->debounce_source) {
+		updater_index_save (updater);
+	}
 
 	return FALSE;
 }
 
+/**
+ * Forget a deleted directory: stop watching it and everything below,
+ * and remove everything below it from the medialib in one command.
+ */
 static void
-updater_remove_file (updater_t *updater, GFile *file)
+updater_remove_directory (updater_t *updater, const gchar *path)
 {
+	updater_removal_t *data;
 	xmmsc_result_t *res;
-	gchar *path, *url;
+	GHashTableIter iter;
+	gpointer key;
+	gchar *url;
+	gsize len;
 
-	g_return_if_fail (updater);
-	g_return_if_fail (updater->conn);
-	g_return_if_fail (file);
+	len = strlen (path);
 
-	path = g_file_get_path (file);
-	url = g_strdup_printf ("file://%s", path);
-	g_free (path);
+	g_hash_table_iter_init (&iter, updater->watchers);
+	while (g_hash_table_iter_next (&iter, &key, NULL)) {
+		if (has_path_prefix (key, path, len)) {
+			g_hash_table_iter_remove (&iter);
+		}
+	}
 
-	g_debug ("removing file '%s'", url);
+	data = g_new0 (updater_removal_t, 1);
+	data->updater = updater;
+	data->path = g_strdup (path);
 
-	res = xmmsc_medialib_get_id (updater->conn, url);
-	xmmsc_result_notifier_set (res, updater_remove_file_by_id, updater);
+	url = g_strdup_printf ("file://%s/", path);
+	res = xmmsc_medialib_remove_prefix (updater->conn, url);
+	xmmsc_result_notifier_set_full (res, updater_remove_directory_done,
+	                                data, updater_removal_free);
 	xmmsc_result_unref (res);
-
 	g_free (url);
 }
 
-static int
-updater_remove_directory_by_id (xmmsv_t *value, void *udata)
+/**
+ * Compare what is on disk now at each path touched since the last flush
+ * with the index, and send the difference to the server.
+ */
+static void
+updater_flush (updater_t *updater)
 {
-	xmmsv_list_iter_t *it;
-
-	xmmsv_get_list_iter (value, &it);
-	while (xmmsv_list_iter_valid (it)) {
-		xmmsv_t *item;
-
-		if (xmmsv_list_iter_entry (it, &item)) {
-			updater_remove_file_by_id (item, udata);
+	GPtrArray *added, *changed, *removed;
+	GHashTable *scan;
+	GHashTableIter iter;
+	GFileInfo *info;
+	GFile *file;
+	gpointer key;
+
+	added = g_ptr_array_new ();
+	changed = g_ptr_array_new ();
+	removed = g_ptr_array_new_with_free_func (g_free);
+	scan = updater_index_new ();
+
+	g_hash_table_iter_init (&iter, updater->pending);
+	while (g_hash_table_iter_next (&iter, &key, NULL)) {
+		const gchar *path = (const gchar *) key;
+		updater_entry_t *entry;
+
+		file = g_file_new_for_path (path);
+		info = g_file_query_info (file, UPDATER_FILE_ATTRIBUTES,
+		                          G_FILE_QUERY_INFO_NONE, NULL, NULL);
+
+		if (!info) {
+			if (g_hash_table_lookup (updater->watchers, path)) {
+				g_debug ("directory '%s' deleted", path);
+				updater_remove_directory (updater, path);
+			} else if (g_hash_table_remove (updater->index, path)) {
+				g_debug ("file '%s' deleted", path);
+				g_ptr_array_add (removed, g_strdup (path));
+			}
+		} else if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY) {
+			updater_add_watcher (updater, file, scan);
+		} else if (g_file_info_get_file_type (info) == G_FILE_TYPE_REGULAR) {
+			entry = g_new (updater_entry_t, 1);
+			updater_entry_from_info (entry, info);
+			g_hash_table_insert (scan, g_strdup (path), entry);
 		}
 
-		xmmsv_list_iter_next (it);
+		if (info) {
+			g_object_unref (info);
+		}
+		g_object_unref (file);
 	}
-	return TRUE;
-}
 
-static void
-updater_remove_directory (updater_t *updater, GFile *file)
-{
-	xmmsc_result_t *res;
-	xmmsv_coll_t *univ, *coll;
-	gchar *path, *pattern, *encoded;
-
-	path = g_file_get_path (file);
-	encoded = xmmsc_medialib_encode_url (path);
-	g_free (path);
-
-	pattern = g_strdup_printf ("file://%s/*", encoded);
-	g_free (encoded);
-
-	univ = xmmsv_coll_universe ();
-	coll = xmmsv_coll_new (XMMS_COLLECTION_TYPE_MATCH);
-
-	xmmsv_coll_add_operand (coll, univ);
-	xmmsv_coll_attribute_set (coll, "field", "url");
-	xmmsv_coll_attribute_set (coll, "value", pattern);
-	xmmsv_coll_attribute_set (coll, "case-sensitive", "true");
-
-	g_debug ("remove '%s' from mlib", pattern);
+	g_hash_table_remove_all (updater->pending);
 
-	res = xmmsc_coll_query_ids (updater->conn, coll, NULL, 0, 0);
-	xmmsc_result_notifier_set (res, updater_remove_directory_by_id, updater);
-	xmmsc_result_unref (res);
-
-	xmmsv_coll_unref (coll);
-	xmmsv_coll_unref (univ);
-
-	g_free (pattern);
-}
-
-static int
-updater_rehash_file_by_id (xmmsv_t *value, void *udata)
-{
-	xmmsc_result_t *res;
-	updater_t *updater;
-	int mid;
+	updater_index_merge (updater, scan, added, changed);
+	updater_apply_changes (updater, added, changed, removed);
 
-	updater = (updater_t *) udata;
-
-	g_return_val_if_fail (updater, FALSE);
-
-	if (!xmmsv_get_int (value, &mid)) {
-		return FALSE;
+	if (added->len || changed->len || removed->len) {
+		updater->dirty = TRUE;
 	}
 
-	if (!mid) {
-		g_warning ("Couldn't find requested medialib entry.");
-		return FALSE;
+	if (updater->dirty) {
+		updater_index_save (updater);
 	}
 
-	res = xmmsc_medialib_rehash (updater->conn, mid);
-	xmmsc_result_unref (res);
-
-	return FALSE;
-}
-
-static void
-updater_rehash_file (updater_t *updater, GFile *file)
-{
-	xmmsc_result_t *res;
-	gchar *path, *url;
-
-	g_return_if_fail (updater);
-	g_return_if_fail (updater->conn);
-	g_return_if_fail (file);
-
-	path = g_file_get_path (file);
-	url = g_strdup_printf ("file://%s", path);
-	g_free (path);
-
-	g_debug ("resolving entry '%s'", url);
-
-	res = xmmsc_medialib_get_id (updater->conn, url);
-	xmmsc_result_notifier_set (res, updater_rehash_file_by_id, updater);
-	xmmsc_result_unref (res);
-
-	g_free (url);
+	g_ptr_array_free (added, TRUE);
+	g_ptr_array_free (changed, TRUE);
+	g_ptr_array_free (removed, TRUE);
+	g_hash_table_destroy (scan);
 }
 
-static void
-on_entity_created (updater_t *updater, GFile *entity)
+static gboolean
+updater_debounce_timeout (gpointer udata)
 {
-	GFileType type;
+	updater_t *updater = (updater_t *) udata;
 
-	g_return_if_fail (updater);
-	g_return_if_fail (entity);
+	updater->debounce_source = 0;
+	updater_flush (updater);
 
-	type = g_file_query_file_type (entity, G_FILE_QUERY_INFO_NONE, NULL);
-	switch (type) {
-	case G_FILE_TYPE_DIRECTORY:
-		g_debug ("directory created");
-		updater_add_watcher_and_import (updater, entity);
-		break;
-	case G_FILE_TYPE_REGULAR:
-		g_debug ("file created");
-		updater_add_file (updater, entity);
-		break;
-	default:
-		g_debug ("something else created: %d", (int) type);
-		break;
-	}
+	return FALSE;
 }
 
+/**
+ * Remember a touched path and (re)arm the debounce timer, so a storm of
+ * events on the same files ends up as one batch per file.
+ */
 static void
-on_entity_changed (updater_t *updater, GFile *entity)
+updater_queue (updater_t *updater, GFile *entity)
 {
-	GFileType type;
+	GTimeVal now;
+	glong elapsed;
 
-	g_return_if_fail (updater);
-	g_return_if_fail (entity);
-
-	type = g_file_query_file_type (entity, G_FILE_QUERY_INFO_NONE, NULL);
-	switch (type) {
-	case G_FILE_TYPE_REGULAR:
-		updater_rehash_file (updater, entity);
-		break;
-	default:
-		g_debug ("something else changed: %d", (int) type);
-		break;
-	}
-}
+	g_hash_table_insert (updater->pending, g_file_get_path (entity), NULL);
 
-static void
-on_entity_deleted (updater_t *updater, GFile *entity)
-{
-	g_debug ("entity deleted");
+	g_get_current_time (&now);
 
-	g_return_if_fail (updater);
-	g_return_if_fail (entity);
-
-	/* There is no way of knowing if the deleted event
-	 * came from a file or a directory so lets give it
-	 * a go with both actions and see what happens.
-	 */
-	if (updater_remove_watcher (updater, entity)) {
-		updater_remove_directory (updater, entity);
+	if (updater->debounce_source) {
+		elapsed = (now.tv_sec - updater->debounce_start.tv_sec) * 1000 +
+		          (now.tv_usec - updater->debounce_start.tv_usec) / 1000;
+		if (elapsed >= UPDATER_DEBOUNCE_MAX_MS - UPDATER_DEBOUNCE_MS) {
+			return;
+		}
+		g_source_remove (updater->debounce_source);
 	} else {
-		updater_remove_file (updater, entity);
+		updater->debounce_start = now;
 	}
+
+	updater->debounce_source = g_timeout_add (UPDATER_DEBOUNCE_MS,
+	                                          updater_debounce_timeout,
+	                                          updater);
 }
 
 static void
@@ -644,13 +1009,9 @@ on_directory_event (GFileMonitor *monitor, GFile *entity, GFile *other,
 
 	switch (event) {
 	case G_FILE_MONITOR_EVENT_CREATED:
-		on_entity_created (updater, entity);
-		break;
 	case G_FILE_MONITOR_EVENT_CHANGED:
-		on_entity_changed (updater, entity);
-		break;
 	case G_FILE_MONITOR_EVENT_DELETED:
-		on_entity_deleted (updater, entity);
+		updater_queue (updater, entity);
 		break;
 	default:
 		break;
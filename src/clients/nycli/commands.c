@@ -153,6 +153,11 @@ CLI_SIMPLE_SETUP("server stats", cli_server_stats,
                  COMMAND_REQ_CONNECTION,
                  NULL,
                  _("Display statistics about the server: uptime, version, size of the medialib, etc"))
+CLI_SIMPLE_SETUP("server latency", cli_server_latency,
+                 COMMAND_REQ_CONNECTION,
+                 NULL,
+                 _("Display the server's internal counters and latency histograms:\n"
+                   "IPC commands, medialib queries, s4 commits, chain setup, filler reads and buffer fill."))
 CLI_SIMPLE_SETUP("server sync", cli_server_sync,
                  COMMAND_REQ_CONNECTION,
                  NULL,
@@ -2295,6 +2300,19 @@ cli_server_stats (cli_infos_t *infos, command_context_t *ctx)
 	return FALSE;
 }
 
+gboolean
+cli_server_latency (cli_infos_t *infos, command_context_t *ctx)
+{
+	xmmsc_result_t *res;
+
+	res = xmmsc_stats_get (infos->sync);
+	xmmsc_result_wait (res);
+
+	print_latency (infos, res);
+
+	return FALSE;
+}
+
 gboolean
 cli_server_sync (cli_infos_t *infos, command_context_t *ctx)
 {
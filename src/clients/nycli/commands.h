@@ -68,6 +68,7 @@ gboolean cli_server_property (cli_infos_t *infos, command_context_t *ctx);
 gboolean cli_server_plugins (cli_infos_t *infos, command_context_t *ctx);
 gboolean cli_server_volume (cli_infos_t *infos, command_context_t *ctx);
 gboolean cli_server_stats (cli_infos_t *infos, command_context_t *ctx);
+gboolean cli_server_latency (cli_infos_t *infos, command_context_t *ctx);
 gboolean cli_server_sync (cli_infos_t *infos, command_context_t *ctx);
 gboolean cli_server_shutdown (cli_infos_t *infos, command_context_t *ctx);
 
@@ -112,6 +113,7 @@ void cli_server_property_setup (command_action_t *action);
 void cli_server_plugins_setup (command_action_t *action);
 void cli_server_volume_setup (command_action_t *action);
 void cli_server_stats_setup (command_action_t *action);
+void cli_server_latency_setup (command_action_t *action);
 void cli_server_sync_setup (command_action_t *action);
 void cli_server_shutdown_setup (command_action_t *action);
 
@@ -154,6 +156,7 @@ static const command_setup_func commandlist[] =
 	cli_server_browse_setup,
 	cli_server_config_setup,
 	cli_server_import_setup,
+	cli_server_latency_setup,
 	cli_server_plugins_setup,
 	cli_server_property_setup,
 	cli_server_rehash_setup,
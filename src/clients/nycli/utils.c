@@ -41,6 +41,24 @@ typedef enum {
 	IDLIST_CMD_REMOVE
 } idlist_command_t;
 
+/* Number of medialib info requests kept in flight while printing */
+#define INFO_PIPELINE_DEPTH 128
+
+/* Called in request order with a finished info result, which it owns */
+typedef void (*info_pipeline_func_t) (xmmsc_result_t *res, guint id, gint pos, void *udata);
+
+/* Fetches infos for many ids without waiting a round trip for each */
+typedef struct {
+	cli_infos_t *infos;
+	info_pipeline_func_t func;
+	void *udata;
+	xmmsc_result_t *results[INFO_PIPELINE_DEPTH];
+	guint ids[INFO_PIPELINE_DEPTH];
+	gint positions[INFO_PIPELINE_DEPTH];
+	gint head;
+	gint len;
+} info_pipeline_t;
+
 typedef struct {
 	cli_infos_t *infos;
 	column_display_t *coldisp;
@@ -48,6 +66,7 @@ typedef struct {
 	GArray *entries;
 	gint inc;
 	gint pos;
+	info_pipeline_t *pipeline;
 } pl_pos_udata_t;
 
 /* Dumps a propdict on stdout */
@@ -228,6 +247,121 @@ print_stats (cli_infos_t *infos, xmmsc_result_t *res)
 	xmmsc_result_unref (res);
 }
 
+/* Upper bound of the log2 bucket that holds the given fraction of values */
+static gint
+histogram_percentile (xmmsv_t *histogram, gint count, gdouble fraction)
+{
+	xmmsv_list_iter_t *it;
+	xmmsv_t *buckets;
+	gint bucket, n, seen = 0;
+
+	if (!xmmsv_dict_get (histogram, "buckets", &buckets) ||
+	    !xmmsv_get_list_iter (buckets, &it)) {
+		return 0;
+	}
+
+	for (bucket = 0; xmmsv_list_iter_entry_int (it, &n); bucket++) {
+		seen += n;
+		if (seen >= count * fraction) {
+			break;
+		}
+		xmmsv_list_iter_next (it);
+	}
+
+	return bucket ? 1 << MIN (bucket, 30) : 0;
+}
+
+static void
+print_histogram (const gchar *name, xmmsv_t *histogram)
+{
+	const gchar *unit = "";
+	gint count = 0, mean = 0, max = 0;
+
+	xmmsv_dict_entry_get_int (histogram, "count", &count);
+	xmmsv_dict_entry_get_int (histogram, "mean", &mean);
+	xmmsv_dict_entry_get_int (histogram, "max", &max);
+	xmmsv_dict_entry_get_string (histogram, "unit", &unit);
+
+	g_printf ("%-24s %10d %10d %10d %10d %10d %s\n", name, count, mean,
+	          histogram_percentile (histogram, count, 0.5),
+	          histogram_percentile (histogram, count, 0.99),
+	          max, unit);
+}
+
+static void
+print_latency_counter (const gchar *name, xmmsv_t *value, void *udata)
+{
+	gint n;
+
+	if (xmmsv_get_int (value, &n)) {
+		g_printf ("%s = %d\n", name, n);
+	}
+}
+
+static void
+print_latency_histogram (const gchar *name, xmmsv_t *value, void *udata)
+{
+	print_histogram (name, value);
+}
+
+void
+print_latency (cli_infos_t *infos, xmmsc_result_t *res)
+{
+	xmmsv_list_iter_t *it;
+	xmmsv_t *val, *dict, *list, *entry;
+	const gchar *err, *object;
+	gchar *name;
+	gint threads, command;
+
+	val = xmmsc_result_get_value (res);
+
+	if (xmmsv_get_error (val, &err)) {
+		g_printf (_("Server error: %s\n"), err);
+		xmmsc_result_unref (res);
+		return;
+	}
+
+	if (xmmsv_dict_entry_get_int (val, "threads", &threads)) {
+		g_printf ("threads = %d\n", threads);
+	}
+	if (xmmsv_dict_get (val, "counters", &dict)) {
+		xmmsv_dict_foreach (dict, print_latency_counter, NULL);
+	}
+
+	/* percentiles are the upper bounds of log2 buckets */
+	g_printf ("\n%-24s %10s %10s %10s %10s %10s\n", "", "count", "mean",
+	          "p50", "p99", "max");
+
+	if (xmmsv_dict_get (val, "histograms", &dict)) {
+		xmmsv_dict_foreach (dict, print_latency_histogram, NULL);
+	}
+
+	if (xmmsv_dict_get (val, "ipc", &list) && xmmsv_get_list_iter (list, &it)) {
+		while (xmmsv_list_iter_entry (it, &entry)) {
+			if (xmmsv_dict_entry_get_string (entry, "object", &object) &&
+			    xmmsv_dict_entry_get_int (entry, "command", &command)) {
+				name = g_strdup_printf ("ipc %s.%d", object, command);
+				print_histogram (name, entry);
+				g_free (name);
+			}
+			xmmsv_list_iter_next (it);
+		}
+	}
+
+	if (xmmsv_dict_get (val, "signals", &list) && xmmsv_get_list_iter (list, &it)) {
+		while (xmmsv_list_iter_entry (it, &entry)) {
+			if (xmmsv_dict_entry_get_int (entry, "signal", &command)) {
+				name = g_strdup_printf ("signal %d", command);
+				print_histogram (name, entry);
+				g_free (name);
+			}
+			xmmsv_list_iter_next (it);
+		}
+	}
+
+	xmmsc_result_unref (res);
+}
+
 static void
 print_config_entry (const gchar *confname, xmmsv_t *val, void *udata)
 {
@@ -508,6 +642,56 @@ currently_playing_mode (cli_infos_t *infos, const gchar *format, gint refresh)
 	}
 }
 
+static void
+info_pipeline_init (info_pipeline_t *pipeline, cli_infos_t *infos,
+                    info_pipeline_func_t func, void *udata)
+{
+	pipeline->infos = infos;
+	pipeline->func = func;
+	pipeline->udata = udata;
+	pipeline->head = 0;
+	pipeline->len = 0;
+}
+
+/* Wait for the oldest request and hand it to the callback */
+static void
+info_pipeline_pop (info_pipeline_t *pipeline)
+{
+	gint head = pipeline->head;
+
+	xmmsc_result_wait (pipeline->results[head]);
+	pipeline->func (pipeline->results[head], pipeline->ids[head],
+	                pipeline->positions[head], pipeline->udata);
+
+	pipeline->head = (head + 1) % INFO_PIPELINE_DEPTH;
+	pipeline->len--;
+}
+
+/* Queue an info request, printing the oldest one first if the window is full */
+static void
+info_pipeline_push (info_pipeline_t *pipeline, guint id, gint pos)
+{
+	gint tail;
+
+	if (pipeline->len == INFO_PIPELINE_DEPTH) {
+		info_pipeline_pop (pipeline);
+	}
+
+	tail = (pipeline->head + pipeline->len) % INFO_PIPELINE_DEPTH;
+	pipeline->results[tail] = xmmsc_medialib_get_info (pipeline->infos->sync, id);
+	pipeline->ids[tail] = id;
+	pipeline->positions[tail] = pos;
+	pipeline->len++;
+}
+
+static void
+info_pipeline_flush (info_pipeline_t *pipeline)
+{
+	while (pipeline->len > 0) {
+		info_pipeline_pop (pipeline);
+	}
+}
+
 static void
 id_print_info (xmmsc_result_t *res, guint id, const gchar *source)
 {
@@ -525,39 +709,46 @@ id_print_info (xmmsc_result_t *res, guint id, const gchar *source)
 	xmmsc_result_unref (res);
 }
 
+static void
+info_print_cb (xmmsc_result_t *res, guint id, gint pos, void *userdata)
+{
+	gint *printed = (gint *) userdata;
+
+	/* Do not prepend newline before the first entry */
+	if ((*printed)++ > 0) {
+		g_printf ("\n");
+	}
+	id_print_info (res, id, NULL);
+}
+
 void
 list_print_info (xmmsc_result_t *res, cli_infos_t *infos)
 {
-	xmmsc_result_t *infores = NULL;
+	info_pipeline_t pipeline;
 	xmmsv_t *val;
 	const gchar *err;
 	gint32 id;
-	gboolean first = TRUE;
+	gint printed = 0;
 
 	val = xmmsc_result_get_value (res);
 
 	if (!xmmsv_get_error (val, &err)) {
 		xmmsv_list_iter_t *it;
 
+		info_pipeline_init (&pipeline, infos, info_print_cb, &printed);
+
 		xmmsv_get_list_iter (val, &it);
 		while (xmmsv_list_iter_valid (it)) {
 			xmmsv_t *entry;
 
 			xmmsv_list_iter_entry (it, &entry);
 			if (xmmsv_get_int (entry, &id)) {
-				infores = xmmsc_medialib_get_info (infos->sync, id);
-				xmmsc_result_wait (infores);
-
-				if (!first) {
-					g_printf ("\n");
-				} else {
-					first = FALSE;
-				}
-				id_print_info (infores, id, NULL);
+				info_pipeline_push (&pipeline, id, 0);
 			}
 			xmmsv_list_iter_next (it);
 		}
 
+		info_pipeline_flush (&pipeline);
 	} else {
 		g_printf (_("Server error: %s\n"), err);
 	}
@@ -568,7 +759,6 @@ list_print_info (xmmsc_result_t *res, cli_infos_t *infos)
 static void
 pos_print_info_cb (gint pos, void *userdata)
 {
-	xmmsc_result_t *infores;
 	pl_pos_udata_t *pack = (pl_pos_udata_t *) userdata;
 	guint id;
 
@@ -579,23 +769,18 @@ pos_print_info_cb (gint pos, void *userdata)
 
 	id = g_array_index (pack->infos->cache->active_playlist, guint, pos);
 
-	infores = xmmsc_medialib_get_info (pack->infos->sync, id);
-	xmmsc_result_wait (infores);
-
-	/* Do not prepend newline before the first entry */
-	if (pack->inc > 0) {
-		g_printf ("\n");
-	} else {
-		pack->inc++;
-	}
-	id_print_info (infores, id, NULL);
+	info_pipeline_push (pack->pipeline, id, pos);
 }
 
 void
 positions_print_info (cli_infos_t *infos, playlist_positions_t *positions)
 {
-	pl_pos_udata_t udata = { infos, NULL, NULL, NULL, 0, 0 };
+	info_pipeline_t pipeline;
+	pl_pos_udata_t udata = { infos, NULL, NULL, NULL, 0, 0, &pipeline };
+
+	info_pipeline_init (&pipeline, infos, info_print_cb, &udata.inc);
 	playlist_positions_foreach (positions, pos_print_info_cb, TRUE, &udata);
+	info_pipeline_flush (&pipeline);
 }
 
 void
@@ -656,18 +841,17 @@ enrich_mediainfo (xmmsv_t *val)
 }
 
 static void
-id_coldisp_print_info (cli_infos_t *infos, column_display_t *coldisp, guint id)
+coldisp_print_info_cb (xmmsc_result_t *res, guint id, gint pos, void *userdata)
 {
-	xmmsc_result_t *infores;
+	column_display_t *coldisp = (column_display_t *) userdata;
 	xmmsv_t *info;
 
-	infores = xmmsc_medialib_get_info (infos->sync, id);
-	xmmsc_result_wait (infores);
-	info = xmmsv_propdict_to_dict (xmmsc_result_get_value (infores), NULL);
+	info = xmmsv_propdict_to_dict (xmmsc_result_get_value (res), NULL);
 	enrich_mediainfo (info);
+	column_display_set_position (coldisp, pos);
 	column_display_print (coldisp, info);
 
-	xmmsc_result_unref (infores);
+	xmmsc_result_unref (res);
 	xmmsv_unref (info);
 }
 
@@ -682,8 +866,7 @@ pos_print_row_cb (gint pos, void *userdata)
 	}
 
 	id = g_array_index (pack->entries, guint, pos);
-	column_display_set_position (pack->coldisp, pos);
-	id_coldisp_print_info (pack->infos, pack->coldisp, id);
+	info_pipeline_push (pack->pipeline, id, pos);
 }
 
 void
@@ -691,7 +874,8 @@ positions_print_list (xmmsc_result_t *res, playlist_positions_t *positions,
                       column_display_t *coldisp, gboolean is_search)
 {
 	cli_infos_t *infos = column_display_infos_get (coldisp);
-	pl_pos_udata_t udata = { infos, coldisp, NULL, NULL, 0, 0};
+	info_pipeline_t pipeline;
+	pl_pos_udata_t udata = { infos, coldisp, NULL, NULL, 0, 0, &pipeline };
 	xmmsv_t *val;
 	GArray *entries;
 
@@ -724,7 +908,9 @@ positions_print_list (xmmsc_result_t *res, playlist_positions_t *positions,
 		}
 
 		udata.entries = entries;
+		info_pipeline_init (&pipeline, infos, coldisp_print_info_cb, coldisp);
 		playlist_positions_foreach (positions, pos_print_row_cb, TRUE, &udata);
+		info_pipeline_flush (&pipeline);
 
 	} else {
 		g_printf (_("Server error: %s\n"), err);
@@ -787,6 +973,7 @@ list_print_row (xmmsc_result_t *res, xmmsv_coll_t *filter,
 {
 	/* FIXME: w00t at code copy-paste, please modularize */
 	cli_infos_t *infos = column_display_infos_get (coldisp);
+	info_pipeline_t pipeline;
 	xmmsv_t *val;
 	GTree *list = NULL;
 
@@ -813,26 +1000,29 @@ list_print_row (xmmsc_result_t *res, xmmsv_coll_t *filter,
 			column_display_print_header (coldisp);
 		}
 
+		info_pipeline_init (&pipeline, infos, coldisp_print_info_cb, coldisp);
+
 		xmmsv_get_list_iter (val, &it);
 		while (xmmsv_list_iter_valid (it)) {
 			xmmsv_t *entry;
 			xmmsv_list_iter_entry (it, &entry);
 
-			column_display_set_position (coldisp, i);
-
 			if (result_is_infos) {
+				column_display_set_position (coldisp, i);
 				enrich_mediainfo (entry);
 				column_display_print (coldisp, entry);
 			} else {
 				if (xmmsv_get_int (entry, &id) &&
 					(!list || g_tree_lookup (list, &id) != NULL)) {
-					id_coldisp_print_info (infos, coldisp, id);
+					info_pipeline_push (&pipeline, id, i);
 				}
 			}
 			xmmsv_list_iter_next (it);
 			i++;
 		}
 
+		info_pipeline_flush (&pipeline);
+
 	} else {
 		g_printf (_("Server error: %s\n"), err);
 	}
@@ -30,6 +30,7 @@ void done (xmmsc_result_t *res, cli_infos_t *infos);
 void tickle (xmmsc_result_t *res, cli_infos_t *infos);
 void list_plugins (cli_infos_t *infos, xmmsc_result_t *res);
 void print_stats (cli_infos_t *infos, xmmsc_result_t *res);
+void print_latency (cli_infos_t *infos, xmmsc_result_t *res);
 void print_config (cli_infos_t *infos, const gchar *confname);
 void print_property (cli_infos_t *infos, xmmsc_result_t *res, guint id, const gchar *source, const gchar *property);
 void remove_ids (cli_infos_t *infos, xmmsc_result_t *res);
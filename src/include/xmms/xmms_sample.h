@@ -58,6 +58,7 @@ typedef gdouble xmms_sampledouble_t;
 typedef void xmms_sample_t;
 
 guint xmms_sample_bytes_to_ms (const xmms_stream_type_t *st, guint samples);
+void xmms_sample_gain_apply (xmms_sample_format_t fmt, xmms_sample_t *buf, guint len, gfloat gain);
 
 static inline gint
 xmms_sample_size_get (xmms_sample_format_t fmt)
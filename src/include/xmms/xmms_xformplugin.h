@@ -239,6 +239,26 @@ gpointer xmms_xform_private_data_get (xmms_xform_t *xform);
  */
 void xmms_xform_private_data_set (xmms_xform_t *xform, gpointer data);
 
+/**
+ * Get a scratch buffer from the buffer pool of the chain.
+ *
+ * Buffers of up to 16KiB are recycled, so getting one for every
+ * call to the read method does not hit the heap once playback has
+ * started.
+ *
+ * @param xform current xform
+ * @param size wanted size in bytes
+ * @returns a buffer to be released with #xmms_xform_scratch_free
+ */
+gpointer xmms_xform_scratch_alloc (xmms_xform_t *xform, gsize size);
+/**
+ * Return a buffer from #xmms_xform_scratch_alloc to the pool.
+ *
+ * @param xform current xform
+ * @param buf the buffer, may be NULL
+ */
+void xmms_xform_scratch_free (xmms_xform_t *xform, gpointer buf);
+
 
 void xmms_xform_outdata_type_add (xmms_xform_t *xform, ...);
 void xmms_xform_outdata_type_copy (xmms_xform_t *xform);
@@ -356,6 +376,20 @@ gint xmms_xform_peek (xmms_xform_t *xform, gpointer buf, gint siz, xmms_error_t
  */
 gchar *xmms_xform_read_line (xmms_xform_t *xform, gchar *buf, xmms_error_t *err);
 
+/**
+ * Read one line from previous xform without copying it.
+ *
+ * The line is terminated in place in the internal line buffer of the
+ * xform and may be modified by the caller, but it is only valid until
+ * the next call to #xmms_xform_read_line_view or #xmms_xform_read_line.
+ * Lines longer than XMMS_XFORM_MAX_LINE_SIZE - 1 are split.
+ *
+ * @param xform
+ * @param err error container which is filled in if error occours.
+ * @returns the line read from the parent or NULL at end of stream or error.
+ */
+gchar *xmms_xform_read_line_view (xmms_xform_t *xform, xmms_error_t *err);
+
 /**
  * Read data from previous xform.
  *
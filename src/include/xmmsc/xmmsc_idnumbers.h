@@ -18,7 +18,7 @@
 #define __SIGNAL_XMMS_H__
 
 /* Don't forget to up this when protocol changes */
-#define XMMS_IPC_PROTOCOL_VERSION 20
+#define XMMS_IPC_PROTOCOL_VERSION 21
 
 typedef enum {
 	XMMS_IPC_OBJECT_SIGNAL,
@@ -32,6 +32,7 @@ typedef enum {
 	XMMS_IPC_OBJECT_MEDIAINFO_READER,
 	XMMS_IPC_OBJECT_XFORM,
 	XMMS_IPC_OBJECT_BINDATA,
+	XMMS_IPC_OBJECT_STATS,
 	XMMS_IPC_OBJECT_END
 } xmms_ipc_objects_t;
 
@@ -51,6 +52,7 @@ typedef enum {
 	XMMS_IPC_SIGNAL_QUIT,
 	XMMS_IPC_SIGNAL_MEDIAINFO_READER_STATUS,
 	XMMS_IPC_SIGNAL_MEDIAINFO_READER_UNINDEXED,
+	XMMS_IPC_SIGNAL_MEDIALIB_ENTRIES_CHANGED,
 	XMMS_IPC_SIGNAL_END
 } xmms_ipc_signals_t;
 
@@ -65,12 +67,21 @@ typedef enum {
 	XMMS_IPC_CMD_ERROR
 } xmms_ipc_pseudo_commands;
 
-/* Signal subsystem methods */
+/* Signal subsystem methods, handled by the IPC layer itself */
 typedef enum {
 	XMMS_IPC_CMD_SIGNAL = XMMS_IPC_CMD_FIRST,
-	XMMS_IPC_CMD_BROADCAST
+	XMMS_IPC_CMD_BROADCAST,
+	XMMS_IPC_CMD_BATCH,
+	XMMS_IPC_CMD_WIRE_FORMAT,
+	XMMS_IPC_CMD_FD_PAYLOADS
 } xmms_ipc_signal_cmds_t;
 
+/* Encodings of values a client can ask for with XMMS_IPC_CMD_WIRE_FORMAT */
+typedef enum {
+	XMMS_IPC_WIRE_LEGACY,
+	XMMS_IPC_WIRE_COMPACT
+} xmms_ipc_wire_format_t;
+
 /* Main methods */
 typedef enum {
 	XMMS_IPC_CMD_HELLO = XMMS_IPC_CMD_FIRST,
@@ -132,7 +143,10 @@ typedef enum {
 	XMMS_IPC_CMD_PROPERTY_SET_INT,
 	XMMS_IPC_CMD_PROPERTY_REMOVE,
 	XMMS_IPC_CMD_MOVE_URL,
-	XMMS_IPC_CMD_MLIB_ADD_URL
+	XMMS_IPC_CMD_MLIB_ADD_URL,
+	XMMS_IPC_CMD_REMOVE_PREFIX,
+	XMMS_IPC_CMD_REHASH_PREFIX,
+	XMMS_IPC_CMD_MOVE_PREFIX
 } xmms_ipc_medialib_cmds_t;
 
 /* Collection methods */
@@ -154,7 +168,9 @@ typedef enum {
 	XMMS_IPC_CMD_GET_DATA = XMMS_IPC_CMD_FIRST,
 	XMMS_IPC_CMD_ADD_DATA,
 	XMMS_IPC_CMD_REMOVE_DATA,
-	XMMS_IPC_CMD_LIST_DATA
+	XMMS_IPC_CMD_LIST_DATA,
+	XMMS_IPC_CMD_GET_DATA_RANGE,
+	XMMS_IPC_CMD_GET_DATA_THUMBNAIL
 } xmms_ipc_bindata_cmds_t;
 
 /* visualization methods */
@@ -173,6 +189,11 @@ typedef enum {
 	XMMS_IPC_CMD_BROWSE = XMMS_IPC_CMD_FIRST
 } xmms_ipc_xform_cmds_t;
 
+/* stats methods */
+typedef enum {
+	XMMS_IPC_CMD_STATS_GET = XMMS_IPC_CMD_FIRST
+} xmms_ipc_stats_cmds_t;
+
 typedef enum {
 	XMMS_PLAYLIST_CHANGED_ADD,
 	XMMS_PLAYLIST_CHANGED_INSERT,
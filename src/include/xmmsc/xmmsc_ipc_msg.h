@@ -27,6 +27,10 @@
 
 #define XMMS_IPC_MSG_DEFAULT_SIZE 128 /*32768*/
 #define XMMS_IPC_MSG_HEAD_LEN 16 /* all but data */
+/* set in the command of a header whose message is passed as a descriptor */
+#define XMMS_IPC_MSG_FD_PAYLOAD 0x80000000
+/* messages from this size on are passed as a descriptor when possible */
+#define XMMS_IPC_MSG_FD_MIN_SIZE 65536
 
 typedef struct xmms_ipc_msg_St xmms_ipc_msg_t;
 
@@ -40,9 +44,11 @@ xmms_ipc_msg_t * xmms_ipc_msg_alloc (void);
 void xmms_ipc_msg_destroy (xmms_ipc_msg_t *msg);
 
 bool xmms_ipc_msg_write_transport (xmms_ipc_msg_t *msg, xmms_ipc_transport_t *transport, bool *disconnected);
+int xmms_ipc_msg_write_transport_batch (xmms_ipc_msg_t **msgs, int count, xmms_ipc_transport_t *transport, bool *disconnected);
 bool xmms_ipc_msg_read_transport (xmms_ipc_msg_t *msg, xmms_ipc_transport_t *transport, bool *disconnected);
 
 uint32_t xmms_ipc_msg_put_value (xmms_ipc_msg_t *msg, xmmsv_t* v);
+uint32_t xmms_ipc_msg_put_value_compact (xmms_ipc_msg_t *msg, xmmsv_t* v);
 
 bool xmms_ipc_msg_get_value (xmms_ipc_msg_t *msg, xmmsv_t **val);
 
@@ -23,14 +23,33 @@
 
 typedef struct xmms_ipc_transport_St xmms_ipc_transport_t;
 
+/** A piece of data for a vectored write */
+typedef struct xmms_ipc_iovec_St {
+	const char *buffer;
+	int len;
+} xmms_ipc_iovec_t;
+
+/** Max number of pieces passed to a single vectored write */
+#define XMMS_IPC_IOVEC_MAX 64
+
+/** Max number of received descriptors waiting for their message */
+#define XMMS_IPC_FDS_MAX 64
+
 typedef int (*xmms_ipc_read_func) (xmms_ipc_transport_t *, char *, int);
 typedef int (*xmms_ipc_write_func) (xmms_ipc_transport_t *, char *, int);
+typedef int (*xmms_ipc_writev_func) (xmms_ipc_transport_t *, const xmms_ipc_iovec_t *, int);
+typedef int (*xmms_ipc_sendfd_func) (xmms_ipc_transport_t *, char *, int, int);
 typedef xmms_ipc_transport_t *(*xmms_ipc_accept_func) (xmms_ipc_transport_t *);
 typedef void (*xmms_ipc_destroy_func) (xmms_ipc_transport_t *);
 
 void xmms_ipc_transport_destroy (xmms_ipc_transport_t *ipct);
 int xmms_ipc_transport_read (xmms_ipc_transport_t *ipct, char *buffer, int len);
+int xmms_ipc_transport_buffered (xmms_ipc_transport_t *ipct);
 int xmms_ipc_transport_write (xmms_ipc_transport_t *ipct, char *buffer, int len);
+int xmms_ipc_transport_writev (xmms_ipc_transport_t *ipct, const xmms_ipc_iovec_t *iov, int count);
+int xmms_ipc_transport_sendfd (xmms_ipc_transport_t *ipct, char *buffer, int len, int fd);
+int xmms_ipc_transport_fd_pop (xmms_ipc_transport_t *ipct);
+int xmms_ipc_transport_fd_passing (xmms_ipc_transport_t *ipct);
 xmms_socket_t xmms_ipc_transport_fd_get (xmms_ipc_transport_t *ipct);
 xmms_ipc_transport_t * xmms_ipc_server_accept (xmms_ipc_transport_t *ipct);
 xmms_ipc_transport_t * xmms_ipc_client_init (const char *path);
@@ -46,8 +65,21 @@ struct xmms_ipc_transport_St {
 
 	xmms_ipc_accept_func accept_func;
 	xmms_ipc_write_func write_func;
+	xmms_ipc_writev_func writev_func;
 	xmms_ipc_read_func read_func;
 	xmms_ipc_destroy_func destroy_func;
+
+	/* data received but not yet consumed by a message */
+	char *rbuf;
+	int rbuf_pos;
+	int rbuf_len;
+
+	/* large payloads may be passed as a descriptor instead, see msg.c */
+	xmms_ipc_sendfd_func sendfd_func;
+	int recv_fds; /* descriptors from the peer are accepted */
+	int send_fds; /* the peer accepts descriptors */
+	int fds[XMMS_IPC_FDS_MAX];
+	int fds_len;
 };
 
 #endif
@@ -127,6 +127,10 @@ typedef struct {
 	int stereo;
 	/* wether the stereo signal should go 00001111 (false) or 01010101 (true) */
 	int pcm_hardwire;
+	/* number of spectrum bands, at most half the window size */
+	int spec_bands;
+	/* wether the spectrum bands are spaced logarithmically */
+	int spec_logscale;
 
 	/* TODO: implement following.. */
 	double freq;
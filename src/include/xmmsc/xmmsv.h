@@ -22,6 +22,7 @@
 #include "xmmsc/xmmsv_list.h"
 #include "xmmsc/xmmsv_dict.h"
 #include "xmmsc/xmmsv_bitbuffer.h"
+#include "xmmsc/xmmsv_arena.h"
 
 #include "xmmsc/xmmsv_util.h"
 #include "xmmsc/xmmsv_build.h"
@@ -0,0 +1,55 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2012 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+
+#ifndef __XMMSV_ARENA_H__
+#define __XMMSV_ARENA_H__
+
+#include <stddef.h>
+#include "xmmsc/xmmsv_general.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup ArenaType Arena
+ * @ingroup ValueType
+ * @{
+ */
+
+typedef struct xmmsv_arena_St xmmsv_arena_t;
+
+xmmsv_arena_t *xmmsv_arena_new (size_t size);
+xmmsv_arena_t *xmmsv_arena_ref (xmmsv_arena_t *arena);
+void xmmsv_arena_unref (xmmsv_arena_t *arena);
+
+xmmsv_t *xmmsv_arena_new_none (xmmsv_arena_t *arena);
+xmmsv_t *xmmsv_arena_new_error (xmmsv_arena_t *arena, const char *errstr);
+xmmsv_t *xmmsv_arena_new_int (xmmsv_arena_t *arena, int32_t i);
+xmmsv_t *xmmsv_arena_new_string (xmmsv_arena_t *arena, const char *s);
+xmmsv_t *xmmsv_arena_new_list (xmmsv_arena_t *arena);
+xmmsv_t *xmmsv_arena_new_dict (xmmsv_arena_t *arena);
+
+int xmmsv_bitbuffer_deserialize_value_arena (xmmsv_t *bb, xmmsv_arena_t *arena, xmmsv_t **val);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
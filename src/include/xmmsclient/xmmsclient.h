@@ -63,6 +63,9 @@ xmmsc_result_t *xmmsc_quit(xmmsc_connection_t *c);
 
 xmmsc_result_t *xmmsc_broadcast_quit (xmmsc_connection_t *c);
 
+/* run many commands in one round trip */
+xmmsc_result_t *xmmsc_batch (xmmsc_connection_t *c, xmmsv_t *commands);
+
 /* get user config dir */
 const char *xmmsc_userconfdir_get (char *buf, int len);
 
@@ -112,6 +115,7 @@ xmmsc_result_t *xmmsc_playlist_rinsert_encoded (xmmsc_connection_t *c, const cha
 
 /* broadcasts */
 xmmsc_result_t *xmmsc_broadcast_playlist_changed (xmmsc_connection_t *c);
+xmmsc_result_t *xmmsc_broadcast_playlist_changed_filtered (xmmsc_connection_t *c, const char *playlist);
 xmmsc_result_t *xmmsc_broadcast_playlist_current_pos (xmmsc_connection_t *c);
 xmmsc_result_t *xmmsc_broadcast_playlist_loaded (xmmsc_connection_t *c);
 
@@ -165,6 +169,8 @@ xmmsc_result_t *xmmsc_main_list_plugins (xmmsc_connection_t *c, xmms_plugin_type
 
 xmmsc_result_t *xmmsc_main_stats (xmmsc_connection_t *c);
 
+xmmsc_result_t *xmmsc_stats_get (xmmsc_connection_t *c);
+
 /* broadcasts */
 xmmsc_result_t *xmmsc_broadcast_mediainfo_reader_status (xmmsc_connection_t *c);
 
@@ -222,6 +228,9 @@ xmmsc_result_t *xmmsc_medialib_get_id (xmmsc_connection_t *conn, const char *url
 xmmsc_result_t *xmmsc_medialib_get_id_encoded (xmmsc_connection_t *conn, const char *url);
 xmmsc_result_t *xmmsc_medialib_remove_entry (xmmsc_connection_t *conn, int entry);
 xmmsc_result_t *xmmsc_medialib_move_entry (xmmsc_connection_t *conn, int entry, const char *url);
+xmmsc_result_t *xmmsc_medialib_move_prefix (xmmsc_connection_t *conn, const char *from, const char *to);
+xmmsc_result_t *xmmsc_medialib_remove_prefix (xmmsc_connection_t *conn, const char *prefix);
+xmmsc_result_t *xmmsc_medialib_rehash_prefix (xmmsc_connection_t *conn, const char *prefix);
 
 xmmsc_result_t *xmmsc_medialib_entry_property_set_int (xmmsc_connection_t *c, int id, const char *key, int32_t value);
 xmmsc_result_t *xmmsc_medialib_entry_property_set_int_with_source (xmmsc_connection_t *c, int id, const char *source, const char *key, int32_t value);
@@ -239,12 +248,16 @@ xmmsc_result_t *xmmsc_xform_media_browse_encoded (xmmsc_connection_t *c, const c
 /* Bindata object */
 xmmsc_result_t *xmmsc_bindata_add (xmmsc_connection_t *c, const unsigned char *data, unsigned int len);
 xmmsc_result_t *xmmsc_bindata_retrieve (xmmsc_connection_t *c, const char *hash);
+xmmsc_result_t *xmmsc_bindata_retrieve_range (xmmsc_connection_t *c, const char *hash, int offset, int length);
+xmmsc_result_t *xmmsc_bindata_retrieve_thumbnail (xmmsc_connection_t *c, const char *hash, int size);
 xmmsc_result_t *xmmsc_bindata_remove (xmmsc_connection_t *c, const char *hash);
 xmmsc_result_t *xmmsc_bindata_list (xmmsc_connection_t *c);
 
 /* broadcasts */
 xmmsc_result_t *xmmsc_broadcast_medialib_entry_changed (xmmsc_connection_t *c);
+xmmsc_result_t *xmmsc_broadcast_medialib_entry_changed_filtered (xmmsc_connection_t *c, xmmsv_t *ids);
 xmmsc_result_t *xmmsc_broadcast_medialib_entry_added (xmmsc_connection_t *c);
+xmmsc_result_t *xmmsc_broadcast_medialib_entries_changed (xmmsc_connection_t *c);
 
 
 /*
@@ -311,6 +324,7 @@ xmmsv_coll_token_t *xmmsv_coll_default_parse_tokens (const char *str, const char
 
 /* broadcasts */
 xmmsc_result_t *xmmsc_broadcast_collection_changed (xmmsc_connection_t *c);
+xmmsc_result_t *xmmsc_broadcast_collection_changed_filtered (xmmsc_connection_t *c, xmmsv_coll_namespace_t ns);
 
 
 /*
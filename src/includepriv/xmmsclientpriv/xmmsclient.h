@@ -71,6 +71,7 @@ xmmsc_result_t *xmmsc_send_msg_no_arg (xmmsc_connection_t *c, int object, int cm
 xmmsc_result_t *xmmsc_send_msg (xmmsc_connection_t *c, xmms_ipc_msg_t *msg);
 xmmsc_result_t *xmmsc_send_msg_flush (xmmsc_connection_t *c, xmms_ipc_msg_t *msg);
 xmmsc_result_t *xmmsc_send_broadcast_msg (xmmsc_connection_t *c, int signalid);
+xmmsc_result_t *xmmsc_send_broadcast_filtered_msg (xmmsc_connection_t *c, int signalid, xmmsv_t *filter);
 xmmsc_result_t *xmmsc_send_signal_msg (xmmsc_connection_t *c, int signalid);
 uint32_t xmmsc_write_signal_msg (xmmsc_connection_t *c, int signalid);
 char *_xmmsc_medialib_encode_url_old (const char *url, int narg, const char **args);
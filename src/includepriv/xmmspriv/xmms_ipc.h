@@ -8,8 +8,12 @@ typedef struct xmms_ipc_St xmms_ipc_t;
 xmms_ipc_t *xmms_ipc_init (void);
 void xmms_ipc_shutdown (void);
 void on_config_ipcsocket_change (xmms_object_t *object, xmmsv_t *data, gpointer udata);
+void on_config_ipcworkers_change (xmms_object_t *object, xmmsv_t *data, gpointer udata);
+void xmms_ipc_workers_set (gint count);
 gboolean xmms_ipc_setup_server (const gchar *path);
 
 gboolean xmms_ipc_has_pending (guint signalid);
+gboolean xmms_ipc_broadcast_wanted (xmms_ipc_signals_t signalid, xmms_ipc_signals_t unless);
+void xmms_ipc_broadcast_send (xmms_ipc_signals_t signalid, xmms_ipc_signals_t unless, xmmsv_t *arg);
 
 #endif
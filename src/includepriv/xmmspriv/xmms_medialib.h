@@ -24,6 +24,8 @@
 
 typedef struct xmms_medialib_St xmms_medialib_t;
 typedef struct xmms_medialib_session_St xmms_medialib_session_t;
+typedef struct xmms_medialib_url_index_St xmms_medialib_url_index_t;
+typedef void (*xmms_medialib_url_index_func_t) (const gchar *url, xmms_medialib_entry_t entry, gpointer udata);
 
 #include "xmmspriv/xmms_collection.h"
 #include "xmmspriv/xmms_fetch_info.h"
@@ -33,6 +35,7 @@ typedef struct xmms_medialib_session_St xmms_medialib_session_t;
 xmms_medialib_t *xmms_medialib_init (void);
 s4_t *xmms_medialib_get_database_backend (xmms_medialib_t *medialib);
 s4_sourcepref_t *xmms_medialib_get_source_preferences (xmms_medialib_t *medialib);
+xmms_medialib_url_index_t *xmms_medialib_get_url_index (xmms_medialib_t *medialib);
 char *xmms_medialib_uuid (xmms_medialib_t *mlib);
 s4_resultset_t *xmms_medialib_session_query (xmms_medialib_session_t *s, s4_fetchspec_t *spec, s4_condition_t *cond);
 
@@ -41,6 +44,7 @@ xmms_medialib_entry_t xmms_medialib_entry_not_resolved_get (xmms_medialib_sessio
 
 xmms_medialib_entry_t xmms_medialib_entry_new (xmms_medialib_session_t *s, const char *url, xmms_error_t *error);
 xmms_medialib_entry_t xmms_medialib_entry_new_encoded (xmms_medialib_session_t *s, const char *url, xmms_error_t *error);
+void xmms_medialib_entry_new_encoded_many (xmms_medialib_session_t *s, const char * const *urls, gint count, xmms_medialib_entry_t *entries, xmms_error_t *error);
 
 void xmms_medialib_entry_remove (xmms_medialib_session_t *s, xmms_medialib_entry_t entry);
 void xmms_medialib_entry_cleanup (xmms_medialib_session_t *s, xmms_medialib_entry_t entry);
@@ -77,6 +81,16 @@ s4_sourcepref_t *xmms_medialib_session_get_source_preferences (xmms_medialib_ses
 void xmms_medialib_session_track_garbage (xmms_medialib_session_t *session, xmmsv_t *data);
 gint xmms_medialib_session_property_set (xmms_medialib_session_t *session, xmms_medialib_entry_t entry, const gchar *key, const s4_val_t *value, const gchar *source);
 gint xmms_medialib_session_property_unset (xmms_medialib_session_t *session, xmms_medialib_entry_t entry, const gchar *key, const s4_val_t *value, const gchar *source);
+void xmms_medialib_session_coalesce_signals (xmms_medialib_session_t *session);
+gboolean xmms_medialib_session_url_lookup (xmms_medialib_session_t *session, const gchar *url, xmms_medialib_entry_t *entry);
+
+xmms_medialib_url_index_t *xmms_medialib_url_index_new (void);
+void xmms_medialib_url_index_free (xmms_medialib_url_index_t *index);
+void xmms_medialib_url_index_set (xmms_medialib_url_index_t *index, const gchar *url, xmms_medialib_entry_t entry);
+xmms_medialib_entry_t xmms_medialib_url_index_lookup (xmms_medialib_url_index_t *index, const gchar *url);
+void xmms_medialib_url_index_foreach_prefix (xmms_medialib_url_index_t *index, const gchar *prefix, xmms_medialib_url_index_func_t func, gpointer udata);
+void xmms_medialib_url_index_lock (xmms_medialib_url_index_t *index);
+void xmms_medialib_url_index_unlock (xmms_medialib_url_index_t *index, GHashTable *changes);
 
 #define xmms_medialib_entry_status_set(s, e, st) xmms_medialib_entry_property_set_int_source(s, e, XMMS_MEDIALIB_ENTRY_PROPERTY_STATUS, st, "server") /** @todo: hardcoded server id might be bad? */
 
@@ -40,4 +40,7 @@ xmms_stream_type_t *xmms_sample_converter_get_from (xmms_sample_converter_t *con
 xmms_stream_type_t *xmms_sample_converter_get_to (xmms_sample_converter_t *conv);
 void xmms_sample_converter_to_medialib (xmms_sample_converter_t *conv, xmms_medialib_entry_t entry);
 
+void xmms_sample_gain_apply_scalar (xmms_sample_format_t fmt, xmms_sample_t *buf, guint len, gfloat gain);
+const gchar *xmms_sample_gain_impl_get (void);
+
 #endif
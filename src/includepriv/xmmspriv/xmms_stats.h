@@ -0,0 +1,56 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2012 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+#ifndef __XMMS_PRIV_STATS_H__
+#define __XMMS_PRIV_STATS_H__
+
+#include <glib.h>
+
+/* Number of log2 buckets in a histogram, bucket n counts values in
+ * [2^(n-1), 2^n), the last one also everything above. */
+#define XMMS_STATS_BUCKETS 32
+
+/* Commands per IPC object that get a histogram of their own */
+#define XMMS_STATS_IPC_COMMANDS 32
+
+typedef enum {
+	XMMS_STATS_MEDIALIB_QUERY,
+	XMMS_STATS_S4_COMMIT,
+	XMMS_STATS_XFORM_CHAIN_SETUP,
+	XMMS_STATS_FILLER_READ,
+	XMMS_STATS_RING_FILL,
+	XMMS_STATS_HISTOGRAM_END
+} xmms_stats_histogram_t;
+
+typedef enum {
+	XMMS_STATS_S4_COMMIT_CONFLICTS,
+	XMMS_STATS_OUTPUT_UNDERRUNS,
+	XMMS_STATS_OUTPUT_BYTES,
+	XMMS_STATS_COUNTER_END
+} xmms_stats_counter_t;
+
+typedef struct xmms_stats_St xmms_stats_t;
+
+xmms_stats_t *xmms_stats_init (void);
+
+gint64 xmms_stats_now (void);
+void xmms_stats_record (xmms_stats_histogram_t histogram, guint64 value);
+void xmms_stats_record_since (xmms_stats_histogram_t histogram, gint64 start);
+void xmms_stats_record_ipc (guint objid, guint cmdid, gint64 start);
+void xmms_stats_record_signal (guint signalid, gint64 start);
+void xmms_stats_count (xmms_stats_counter_t counter, guint64 n);
+
+#endif
@@ -49,11 +49,27 @@ struct xmmsv_St {
 	xmmsv_type_t type;
 
 	int ref;  /* refcounting */
+
+	/* the value and its data live in this arena, if any */
+	xmmsv_arena_t *arena;
 };
 
 xmmsv_t *_xmmsv_new (xmmsv_type_t type);
+xmmsv_t *_xmmsv_new_in (xmmsv_arena_t *arena, xmmsv_type_t type);
 
 void _xmmsv_list_free (xmmsv_list_internal_t *dict);
 void _xmmsv_dict_free (xmmsv_dict_internal_t *dict);
 
+/* length of the longest interned string */
+#define XMMSV_INTERN_MAX_LEN 18
+
+uint32_t _xmmsv_string_hash (const char *key, int len);
+const char *_xmmsv_intern_lookup (const char *str, uint32_t hash);
+const char *_xmmsv_intern (const char *str);
+bool _xmmsv_interned (const char *str);
+
+void *_xmmsv_arena_alloc0 (xmmsv_arena_t *arena, size_t size);
+char *_xmmsv_arena_strdup (xmmsv_arena_t *arena, const char *str);
+void _xmmsv_arena_free (xmmsv_arena_t *arena, void *ptr);
+
 #endif
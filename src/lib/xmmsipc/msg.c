@@ -14,6 +14,12 @@
  *  Lesser General Public License for more details.
  */
 
+#include "xmms_configuration.h"
+
+#ifdef HAVE_MEMFD_CREATE
+#define _GNU_SOURCE /* memfd_create is a GNU extension */
+#endif
+
 #include <stdarg.h>
 #include <string.h>
 #include <stdlib.h>
@@ -22,6 +28,13 @@
 #include <time.h>
 #include <assert.h>
 
+#ifdef HAVE_MEMFD_CREATE
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+
 #include "xmmspriv/xmms_list.h"
 #include "xmmsc/xmmsc_ipc_transport.h"
 #include "xmmsc/xmmsc_ipc_msg.h"
@@ -33,6 +46,12 @@
 struct xmms_ipc_msg_St {
 	xmmsv_t *bb;
 	uint32_t xfered;
+
+	/* descriptor holding the message, to be sent along with its header */
+	int fd;
+	/* received message mapped from a descriptor, bb points into it */
+	void *map;
+	size_t maplen;
 };
 
 
@@ -46,6 +65,7 @@ xmms_ipc_msg_alloc (void)
 	msg = x_new0 (xmms_ipc_msg_t, 1);
 	msg->bb = xmmsv_new_bitbuffer ();
 	xmmsv_bitbuffer_put_data (msg->bb, empty, 16);
+	msg->fd = -1;
 
 	return msg;
 }
@@ -56,6 +76,16 @@ xmms_ipc_msg_destroy (xmms_ipc_msg_t *msg)
 	x_return_if_fail (msg);
 
 	xmmsv_unref (msg->bb);
+
+#ifdef HAVE_MEMFD_CREATE
+	if (msg->fd != -1) {
+		close (msg->fd);
+	}
+	if (msg->map) {
+		munmap (msg->map, msg->maplen);
+	}
+#endif
+
 	free (msg);
 }
 
@@ -167,6 +197,114 @@ xmms_ipc_msg_new (uint32_t object, uint32_t cmd)
 	return msg;
 }
 
+#ifdef HAVE_MEMFD_CREATE
+/**
+ * Move a message that hasn't been sent yet into a sealed memfd, and
+ * leave only a header in the message, flagged so the peer knows to
+ * pick up the descriptor that is sent along with it. The peer maps
+ * the descriptor instead of copying the message through the socket.
+ *
+ * @returns TRUE if the message now refers to a descriptor.
+ */
+static bool
+xmms_ipc_msg_to_fd (xmms_ipc_msg_t *msg)
+{
+	const unsigned char *buf;
+	unsigned char head[XMMS_IPC_MSG_HEAD_LEN];
+	xmmsv_t *bb;
+	int fd, len, off, ret;
+
+	buf = xmmsv_bitbuffer_buffer (msg->bb);
+	len = xmmsv_bitbuffer_len (msg->bb) / 8;
+
+	fd = memfd_create ("xmms2-ipc", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (fd == -1) {
+		return false;
+	}
+
+	for (off = 0; off < len; off += ret) {
+		ret = write (fd, buf + off, len - off);
+		if (ret == -1 && errno == EINTR) {
+			ret = 0;
+		} else if (ret <= 0) {
+			close (fd);
+			return false;
+		}
+	}
+
+	/* the peer may rely on the contents not changing under its feet */
+	fcntl (fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+
+	memcpy (head, buf, XMMS_IPC_MSG_HEAD_LEN);
+
+	bb = xmmsv_new_bitbuffer ();
+	xmmsv_bitbuffer_put_data (bb, head, XMMS_IPC_MSG_HEAD_LEN);
+	xmmsv_unref (msg->bb);
+	msg->bb = bb;
+
+	xmms_ipc_msg_set_cmd (msg, xmms_ipc_msg_get_cmd (msg) | XMMS_IPC_MSG_FD_PAYLOAD);
+	xmmsv_bitbuffer_goto (msg->bb, 12 * 8);
+	xmmsv_bitbuffer_put_bits (msg->bb, 32, 0);
+	xmmsv_bitbuffer_end (msg->bb);
+
+	msg->fd = fd;
+
+	return true;
+}
+
+/**
+ * Replace the header of a flagged message with the message passed in
+ * the next descriptor received on the transport.
+ *
+ * @returns TRUE if the message was mapped.
+ */
+static bool
+xmms_ipc_msg_map_fd (xmms_ipc_msg_t *msg, xmms_ipc_transport_t *transport)
+{
+	struct stat st;
+	xmmsv_t *bb;
+	void *map;
+	uint32_t cookie;
+	int fd;
+
+	fd = xmms_ipc_transport_fd_pop (transport);
+	if (fd == -1) {
+		return false;
+	}
+
+	if (fstat (fd, &st) == -1 || st.st_size < XMMS_IPC_MSG_HEAD_LEN ||
+	    st.st_size > INT32_MAX / 8) {
+		close (fd);
+		return false;
+	}
+
+	map = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close (fd);
+
+	if (map == MAP_FAILED) {
+		return false;
+	}
+
+	cookie = xmms_ipc_msg_get_cookie (msg);
+
+	bb = xmmsv_new_bitbuffer_ro (map, st.st_size);
+	xmmsv_unref (msg->bb);
+	msg->bb = bb;
+	msg->map = map;
+	msg->maplen = st.st_size;
+
+	/* the descriptor must hold exactly the message announced */
+	if (xmms_ipc_msg_get_cookie (msg) != cookie ||
+	    xmms_ipc_msg_get_length (msg) + XMMS_IPC_MSG_HEAD_LEN != st.st_size) {
+		return false;
+	}
+
+	msg->xfered = st.st_size;
+	xmmsv_bitbuffer_goto (msg->bb, XMMS_IPC_MSG_HEAD_LEN * 8);
+
+	return true;
+}
+#endif
 
 /**
  * Try to write message to transport. If full message isn't written
@@ -217,9 +355,120 @@ xmms_ipc_msg_write_transport (xmms_ipc_msg_t *msg,
 	return (len == msg->xfered);
 }
 
+/**
+ * Try to write as many of the given messages as possible with a single
+ * vectored write. Messages may already be partially written, like with
+ * #xmms_ipc_msg_write_transport.
+ *
+ * @returns the number of messages fully written, the message after
+ *          those may have been partially written.
+ *          disconnected is set if transport was disconnected
+ */
+int
+xmms_ipc_msg_write_transport_batch (xmms_ipc_msg_t **msgs, int count,
+                                    xmms_ipc_transport_t *transport,
+                                    bool *disconnected)
+{
+	xmms_ipc_iovec_t iov[XMMS_IPC_IOVEC_MAX];
+	int i, ret, done;
+
+	x_return_val_if_fail (msgs, 0);
+	x_return_val_if_fail (transport, 0);
+
+	if (count > XMMS_IPC_IOVEC_MAX) {
+		count = XMMS_IPC_IOVEC_MAX;
+	}
+
+#ifdef HAVE_MEMFD_CREATE
+	for (i = 0; i < count; i++) {
+		xmms_ipc_msg_t *msg = msgs[i];
+
+		if (transport->send_fds && !msg->xfered && msg->fd == -1 &&
+		    xmmsv_bitbuffer_len (msg->bb) / 8 >= XMMS_IPC_MSG_FD_MIN_SIZE) {
+			xmms_ipc_msg_to_fd (msg);
+		}
+
+		if (msg->fd == -1) {
+			continue;
+		}
+
+		/* the descriptor goes with the first byte of its header */
+		if (i > 0) {
+			count = i;
+			break;
+		}
+
+		ret = xmms_ipc_transport_sendfd (transport,
+		                                 (char *) xmmsv_bitbuffer_buffer (msg->bb),
+		                                 XMMS_IPC_MSG_HEAD_LEN, msg->fd);
+		if (ret == SOCKET_ERROR) {
+			if (!xmms_socket_error_recoverable () && disconnected) {
+				*disconnected = true;
+			}
+			return 0;
+		} else if (!ret) {
+			if (disconnected) {
+				*disconnected = true;
+			}
+			return 0;
+		}
+
+		close (msg->fd);
+		msg->fd = -1;
+		msg->xfered = ret;
+
+		return ret == XMMS_IPC_MSG_HEAD_LEN;
+	}
+#endif
+
+	for (i = 0; i < count; i++) {
+		xmms_ipc_msg_t *msg = msgs[i];
+
+		xmmsv_bitbuffer_align (msg->bb);
+
+		iov[i].len = xmmsv_bitbuffer_len (msg->bb) / 8 - msg->xfered;
+		iov[i].buffer = (const char *) xmmsv_bitbuffer_buffer (msg->bb) + msg->xfered;
+	}
+
+	ret = xmms_ipc_transport_writev (transport, iov, count);
+
+	if (ret == SOCKET_ERROR) {
+		if (!xmms_socket_error_recoverable () && disconnected) {
+			*disconnected = true;
+		}
+		return 0;
+	} else if (!ret) {
+		if (disconnected) {
+			*disconnected = true;
+		}
+		return 0;
+	}
+
+	for (done = 0; done < count && ret > 0; done++) {
+		int len = ret < iov[done].len ? ret : iov[done].len;
+
+		msgs[done]->xfered += len;
+		ret -= len;
+
+		if (len < iov[done].len) {
+			break;
+		}
+	}
+
+	return done;
+}
+
+/* size of the receive buffer of a transport */
+#define XMMS_IPC_MSG_RBUF_SIZE 65536
+
 /**
  * Try to read message from transport into msg.
  *
+ * Data is read from the socket in large chunks into a buffer kept with
+ * the transport, so a single read may cover several messages. Thus a
+ * caller must keep calling this until it returns FALSE, as only then
+ * there's no buffered data left.
+ *
  * @returns TRUE if message is fully read.
  */
 bool
@@ -227,8 +476,8 @@ xmms_ipc_msg_read_transport (xmms_ipc_msg_t *msg,
                              xmms_ipc_transport_t *transport,
                              bool *disconnected)
 {
-	char buf[512];
-	unsigned int ret, len, rlen;
+	unsigned int len, rlen;
+	int ret;
 
 	x_return_val_if_fail (msg, false);
 	x_return_val_if_fail (transport, false);
@@ -240,40 +489,65 @@ xmms_ipc_msg_read_transport (xmms_ipc_msg_t *msg,
 			len += xmms_ipc_msg_get_length (msg);
 
 			if (msg->xfered == len) {
+				if (xmms_ipc_msg_get_cmd (msg) & XMMS_IPC_MSG_FD_PAYLOAD) {
+#ifdef HAVE_MEMFD_CREATE
+					if (xmms_ipc_msg_map_fd (msg, transport)) {
+						return true;
+					}
+#endif
+					/* never asked for, or not what was announced */
+					if (disconnected) {
+						*disconnected = true;
+					}
+					return false;
+				}
 				return true;
 			}
 		}
 
 		x_return_val_if_fail (msg->xfered < len, false);
 
-		rlen = len - msg->xfered;
-		if (rlen > sizeof (buf))
-			rlen = sizeof (buf);
+		if (transport->rbuf_pos == transport->rbuf_len) {
+			if (!transport->rbuf) {
+				transport->rbuf = x_new (char, XMMS_IPC_MSG_RBUF_SIZE);
+			}
 
-		ret = xmms_ipc_transport_read (transport, buf, rlen);
+			ret = xmms_ipc_transport_read (transport, transport->rbuf,
+			                               XMMS_IPC_MSG_RBUF_SIZE);
 
-		if (ret == SOCKET_ERROR) {
-			if (xmms_socket_error_recoverable ()) {
-				return false;
-			}
+			if (ret == SOCKET_ERROR) {
+				if (xmms_socket_error_recoverable ()) {
+					return false;
+				}
 
-			if (disconnected) {
-				*disconnected = true;
-			}
+				if (disconnected) {
+					*disconnected = true;
+				}
 
-			return false;
-		} else if (ret == 0) {
-			if (disconnected) {
-				*disconnected = true;
+				return false;
+			} else if (ret == 0) {
+				if (disconnected) {
+					*disconnected = true;
+				}
+
+				return false;
 			}
 
-			return false;
-		} else {
-			xmmsv_bitbuffer_goto (msg->bb, msg->xfered * 8);
-			xmmsv_bitbuffer_put_data (msg->bb, (unsigned char *) buf, ret);
-			msg->xfered += ret;
-			xmmsv_bitbuffer_goto (msg->bb, XMMS_IPC_MSG_HEAD_LEN * 8);
+			transport->rbuf_pos = 0;
+			transport->rbuf_len = ret;
 		}
+
+		rlen = len - msg->xfered;
+		if (rlen > transport->rbuf_len - transport->rbuf_pos)
+			rlen = transport->rbuf_len - transport->rbuf_pos;
+
+		xmmsv_bitbuffer_goto (msg->bb, msg->xfered * 8);
+		xmmsv_bitbuffer_put_data (msg->bb,
+		                          (unsigned char *) transport->rbuf + transport->rbuf_pos,
+		                          rlen);
+		transport->rbuf_pos += rlen;
+		msg->xfered += rlen;
+		xmmsv_bitbuffer_goto (msg->bb, XMMS_IPC_MSG_HEAD_LEN * 8);
 	}
 }
 
@@ -286,6 +560,19 @@ xmms_ipc_msg_put_value (xmms_ipc_msg_t *msg, xmmsv_t *v)
 	return xmmsv_bitbuffer_pos (msg->bb);
 }
 
+/**
+ * Like #xmms_ipc_msg_put_value but using the compact encoding, which
+ * must only be sent to peers that asked for it.
+ */
+uint32_t
+xmms_ipc_msg_put_value_compact (xmms_ipc_msg_t *msg, xmmsv_t *v)
+{
+	if (!xmmsv_bitbuffer_serialize_value_compact (msg->bb, v))
+		return false;
+	xmms_ipc_msg_update_length (msg->bb);
+	return xmmsv_bitbuffer_pos (msg->bb);
+}
+
 
 bool
 xmms_ipc_msg_get_value (xmms_ipc_msg_t *msg, xmmsv_t **val)
@@ -20,6 +20,9 @@
 #include <stdlib.h>
 #include <signal.h>
 #include <assert.h>
+#ifndef HAVE_WINSOCK2
+# include <sys/uio.h>
+#endif
 
 #include "xmmsc/xmmsc_ipc_transport.h"
 #include "xmmsc/xmmsc_util.h"
@@ -63,6 +66,26 @@ xmms_ipc_tcp_write (xmms_ipc_transport_t *ipct, char *buffer, int len)
 
 }
 
+#ifndef HAVE_WINSOCK2
+static int
+xmms_ipc_tcp_writev (xmms_ipc_transport_t *ipct,
+                     const xmms_ipc_iovec_t *iov, int count)
+{
+	struct iovec vec[XMMS_IPC_IOVEC_MAX];
+	int i;
+
+	x_return_val_if_fail (ipct, -1);
+	x_return_val_if_fail (count <= XMMS_IPC_IOVEC_MAX, -1);
+
+	for (i = 0; i < count; i++) {
+		vec[i].iov_base = (void *) iov[i].buffer;
+		vec[i].iov_len = iov[i].len;
+	}
+
+	return writev (ipct->fd, vec, count);
+}
+#endif
+
 xmms_ipc_transport_t *
 xmms_ipc_tcp_client_init (const xmms_url_t *url, int ipv6)
 {
@@ -123,6 +146,9 @@ xmms_ipc_tcp_client_init (const xmms_url_t *url, int ipv6)
 	ipct->path = strdup (url->host);
 	ipct->read_func = xmms_ipc_tcp_read;
 	ipct->write_func = xmms_ipc_tcp_write;
+#ifndef HAVE_WINSOCK2
+	ipct->writev_func = xmms_ipc_tcp_writev;
+#endif
 	ipct->destroy_func = xmms_ipc_tcp_destroy;
 
 	return ipct;
@@ -159,6 +185,9 @@ xmms_ipc_tcp_accept (xmms_ipc_transport_t *transport)
 		ret->fd = fd;
 		ret->read_func = xmms_ipc_tcp_read;
 		ret->write_func = xmms_ipc_tcp_write;
+#ifndef HAVE_WINSOCK2
+		ret->writev_func = xmms_ipc_tcp_writev;
+#endif
 		ret->destroy_func = xmms_ipc_tcp_destroy;
 
 		return ret;
@@ -20,6 +20,7 @@
 #include <sys/socket.h>
 #include <unistd.h>
 #include <sys/un.h>
+#include <sys/uio.h>
 #include <errno.h>
 #include <string.h>
 #include <fcntl.h>
@@ -36,10 +37,43 @@
 static void
 xmms_ipc_usocket_destroy (xmms_ipc_transport_t *ipct)
 {
+	int i;
+
+	for (i = 0; i < ipct->fds_len; i++) {
+		close (ipct->fds[i]);
+	}
+
 	free (ipct->path);
 	close (ipct->fd);
 }
 
+/* Queue descriptors passed along with the data, they are picked up
+ * in order by the messages that refer to them. */
+static void
+xmms_ipc_usocket_queue_fds (xmms_ipc_transport_t *ipct, struct msghdr *hdr)
+{
+	struct cmsghdr *cmsg;
+	int *fds, i, n;
+
+	for (cmsg = CMSG_FIRSTHDR (hdr); cmsg; cmsg = CMSG_NXTHDR (hdr, cmsg)) {
+		if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+			continue;
+		}
+
+		fds = (int *) CMSG_DATA (cmsg);
+		n = (cmsg->cmsg_len - CMSG_LEN (0)) / sizeof (int);
+
+		for (i = 0; i < n; i++) {
+			if (ipct->fds_len < XMMS_IPC_FDS_MAX) {
+				ipct->fds[ipct->fds_len++] = fds[i];
+			} else {
+				/* the message it belongs to will fail to map */
+				close (fds[i]);
+			}
+		}
+	}
+}
+
 static int
 xmms_ipc_usocket_read (xmms_ipc_transport_t *ipct, char *buffer, int len)
 {
@@ -50,11 +84,70 @@ xmms_ipc_usocket_read (xmms_ipc_transport_t *ipct, char *buffer, int len)
 
 	fd = ipct->fd;
 
+	if (ipct->recv_fds) {
+		char control[CMSG_SPACE (sizeof (int) * 8)];
+		struct msghdr hdr;
+		struct iovec vec;
+		int flags = 0;
+
+		vec.iov_base = buffer;
+		vec.iov_len = len;
+
+		memset (&hdr, 0, sizeof (hdr));
+		hdr.msg_iov = &vec;
+		hdr.msg_iovlen = 1;
+		hdr.msg_control = control;
+		hdr.msg_controllen = sizeof (control);
+
+#ifdef MSG_CMSG_CLOEXEC
+		flags |= MSG_CMSG_CLOEXEC;
+#endif
+
+		ret = recvmsg (fd, &hdr, flags);
+		if (ret >= 0) {
+			xmms_ipc_usocket_queue_fds (ipct, &hdr);
+		}
+
+		return ret;
+	}
+
 	ret =  recv (fd, buffer, len, 0);
 
 	return ret;
 }
 
+static int
+xmms_ipc_usocket_sendfd (xmms_ipc_transport_t *ipct, char *buffer, int len,
+                         int sendfd)
+{
+	char control[CMSG_SPACE (sizeof (int))];
+	struct cmsghdr *cmsg;
+	struct msghdr hdr;
+	struct iovec vec;
+
+	x_return_val_if_fail (ipct, -1);
+	x_return_val_if_fail (buffer, -1);
+	x_return_val_if_fail (len > 0, -1);
+
+	vec.iov_base = buffer;
+	vec.iov_len = len;
+
+	memset (&hdr, 0, sizeof (hdr));
+	memset (control, 0, sizeof (control));
+	hdr.msg_iov = &vec;
+	hdr.msg_iovlen = 1;
+	hdr.msg_control = control;
+	hdr.msg_controllen = sizeof (control);
+
+	cmsg = CMSG_FIRSTHDR (&hdr);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN (sizeof (int));
+	memcpy (CMSG_DATA (cmsg), &sendfd, sizeof (int));
+
+	return sendmsg (ipct->fd, &hdr, 0);
+}
+
 static int
 xmms_ipc_usocket_write (xmms_ipc_transport_t *ipct, char *buffer, int len)
 {
@@ -68,6 +161,24 @@ xmms_ipc_usocket_write (xmms_ipc_transport_t *ipct, char *buffer, int len)
 
 }
 
+static int
+xmms_ipc_usocket_writev (xmms_ipc_transport_t *ipct,
+                         const xmms_ipc_iovec_t *iov, int count)
+{
+	struct iovec vec[XMMS_IPC_IOVEC_MAX];
+	int i;
+
+	x_return_val_if_fail (ipct, -1);
+	x_return_val_if_fail (count <= XMMS_IPC_IOVEC_MAX, -1);
+
+	for (i = 0; i < count; i++) {
+		vec[i].iov_base = (void *) iov[i].buffer;
+		vec[i].iov_len = iov[i].len;
+	}
+
+	return writev (ipct->fd, vec, count);
+}
+
 xmms_ipc_transport_t *
 xmms_ipc_usocket_client_init (const xmms_url_t *url)
 {
@@ -110,7 +221,9 @@ xmms_ipc_usocket_client_init (const xmms_url_t *url)
 	ipct->path = strdup (url->path);
 	ipct->read_func = xmms_ipc_usocket_read;
 	ipct->write_func = xmms_ipc_usocket_write;
+	ipct->writev_func = xmms_ipc_usocket_writev;
 	ipct->destroy_func = xmms_ipc_usocket_destroy;
+	ipct->recv_fds = 1;
 
 	return ipct;
 }
@@ -151,6 +264,8 @@ xmms_ipc_usocket_accept (xmms_ipc_transport_t *transport)
 		ret->fd = fd;
 		ret->read_func = xmms_ipc_usocket_read;
 		ret->write_func = xmms_ipc_usocket_write;
+		ret->writev_func = xmms_ipc_usocket_writev;
+		ret->sendfd_func = xmms_ipc_usocket_sendfd;
 		ret->destroy_func = xmms_ipc_usocket_destroy;
 
 		return ret;
@@ -191,7 +306,7 @@ xmms_ipc_usocket_server_init (const xmms_url_t *url)
 		return NULL;
 	}
 
-	listen (fd, 5);
+	listen (fd, SOMAXCONN);
 
 	flags = fcntl (fd, F_GETFL, 0);
 
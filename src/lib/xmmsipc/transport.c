@@ -17,6 +17,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "xmms_configuration.h"
 #include "xmmsc/xmmsc_util.h"
 #include "xmmsc/xmmsc_ipc_transport.h"
 #include "socket_unix.h"
@@ -30,6 +31,7 @@ xmms_ipc_transport_destroy (xmms_ipc_transport_t *ipct)
 
 	ipct->destroy_func (ipct);
 
+	free (ipct->rbuf);
 	free (ipct);
 }
 
@@ -39,12 +41,92 @@ xmms_ipc_transport_read (xmms_ipc_transport_t *ipct, char *buffer, int len)
 	return ipct->read_func (ipct, buffer, len);
 }
 
+/**
+ * Number of bytes that have been received but not yet consumed by a
+ * message. They are not seen by select() or poll() on the socket.
+ */
+int
+xmms_ipc_transport_buffered (xmms_ipc_transport_t *ipct)
+{
+	return ipct->rbuf_len - ipct->rbuf_pos;
+}
+
 int
 xmms_ipc_transport_write (xmms_ipc_transport_t *ipct, char *buffer, int len)
 {
 	return ipct->write_func (ipct, buffer, len);
 }
 
+/**
+ * Write several pieces of data with one call if the transport supports
+ * it, otherwise only the first piece is written.
+ *
+ * @returns number of bytes written, or SOCKET_ERROR
+ */
+int
+xmms_ipc_transport_writev (xmms_ipc_transport_t *ipct,
+                           const xmms_ipc_iovec_t *iov, int count)
+{
+	x_return_val_if_fail (count > 0, 0);
+
+	if (ipct->writev_func) {
+		return ipct->writev_func (ipct, iov, count);
+	}
+
+	return ipct->write_func (ipct, (char *) iov[0].buffer, iov[0].len);
+}
+
+/**
+ * Write data with a descriptor attached to it.
+ *
+ * @returns number of bytes written, or SOCKET_ERROR
+ */
+int
+xmms_ipc_transport_sendfd (xmms_ipc_transport_t *ipct, char *buffer,
+                           int len, int fd)
+{
+	x_return_val_if_fail (ipct->sendfd_func, SOCKET_ERROR);
+
+	return ipct->sendfd_func (ipct, buffer, len, fd);
+}
+
+/**
+ * Take the oldest descriptor received from the peer.
+ *
+ * @returns the descriptor, owned by the caller, or -1 if there is none
+ */
+int
+xmms_ipc_transport_fd_pop (xmms_ipc_transport_t *ipct)
+{
+	int fd;
+
+	if (!ipct->fds_len) {
+		return -1;
+	}
+
+	fd = ipct->fds[0];
+	ipct->fds_len--;
+	memmove (ipct->fds, ipct->fds + 1, ipct->fds_len * sizeof (int));
+
+	return fd;
+}
+
+/**
+ * Whether the transport can receive messages whose payload is passed
+ * as a descriptor.
+ */
+int
+xmms_ipc_transport_fd_passing (xmms_ipc_transport_t *ipct)
+{
+	x_return_val_if_fail (ipct, 0);
+
+#ifdef HAVE_MEMFD_CREATE
+	return ipct->recv_fds;
+#else
+	return 0;
+#endif
+}
+
 xmms_socket_t
 xmms_ipc_transport_fd_get (xmms_ipc_transport_t *ipct)
 {
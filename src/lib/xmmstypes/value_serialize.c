@@ -35,10 +35,10 @@ static bool _internal_get_from_bb_int32 (xmmsv_t *bb, int32_t *v);
 static bool _internal_get_from_bb_int32_positive (xmmsv_t *bb, int32_t *v);
 static bool _internal_get_from_bb_string_alloc (xmmsv_t *bb, char **buf, unsigned int *len);
 static bool _internal_get_from_bb_collection_alloc (xmmsv_t *bb, xmmsv_coll_t **coll);
-static bool _internal_get_from_bb_value_dict_alloc (xmmsv_t *bb, xmmsv_t **val);
-static bool _internal_get_from_bb_value_list_alloc (xmmsv_t *bb, xmmsv_t **val);
+static bool _internal_get_from_bb_value_dict_alloc (xmmsv_t *bb, xmmsv_arena_t *arena, xmmsv_t **val);
+static bool _internal_get_from_bb_value_list_alloc (xmmsv_t *bb, xmmsv_arena_t *arena, xmmsv_t **val);
 
-static bool _internal_get_from_bb_value_of_type_alloc (xmmsv_t *bb, xmmsv_type_t type, xmmsv_t **val);
+static bool _internal_get_from_bb_value_of_type_alloc (xmmsv_t *bb, xmmsv_arena_t *arena, xmmsv_type_t type, xmmsv_t **val);
 
 
 static bool
@@ -324,7 +324,7 @@ _internal_get_from_bb_collection_alloc (xmmsv_t *bb, xmmsv_coll_t **coll)
 	*coll = xmmsv_coll_new (type);
 
 	/* Get the attributes */
-	if (!_internal_get_from_bb_value_dict_alloc (bb, &dict)) {
+	if (!_internal_get_from_bb_value_dict_alloc (bb, NULL, &dict)) {
 		return false;
 	}
 
@@ -395,14 +395,15 @@ err:
 
 
 static bool
-_internal_get_from_bb_value_dict_alloc (xmmsv_t *bb, xmmsv_t **val)
+_internal_get_from_bb_value_dict_alloc (xmmsv_t *bb, xmmsv_arena_t *arena,
+                                        xmmsv_t **val)
 {
 	xmmsv_t *dict;
 	int32_t len;
 	unsigned int ignore;
 	char *key;
 
-	dict = xmmsv_new_dict ();
+	dict = xmmsv_arena_new_dict (arena);
 
 	if (!_internal_get_from_bb_int32_positive (bb, &len)) {
 		goto err;
@@ -415,7 +416,7 @@ _internal_get_from_bb_value_dict_alloc (xmmsv_t *bb, xmmsv_t **val)
 			goto err;
 		}
 
-		if (!xmmsv_bitbuffer_deserialize_value (bb, &v)) {
+		if (!xmmsv_bitbuffer_deserialize_value_arena (bb, arena, &v)) {
 			free (key);
 			goto err;
 		}
@@ -436,12 +437,13 @@ err:
 }
 
 static bool
-_internal_get_from_bb_value_list_alloc (xmmsv_t *bb, xmmsv_t **val)
+_internal_get_from_bb_value_list_alloc (xmmsv_t *bb, xmmsv_arena_t *arena,
+                                        xmmsv_t **val)
 {
 	xmmsv_t *list;
 	int32_t len;
 
-	list = xmmsv_new_list ();
+	list = xmmsv_arena_new_list (arena);
 
 	if (!_internal_get_from_bb_int32_positive (bb, &len)) {
 		goto err;
@@ -449,7 +451,7 @@ _internal_get_from_bb_value_list_alloc (xmmsv_t *bb, xmmsv_t **val)
 
 	while (len--) {
 		xmmsv_t *v;
-		if (xmmsv_bitbuffer_deserialize_value (bb, &v)) {
+		if (xmmsv_bitbuffer_deserialize_value_arena (bb, arena, &v)) {
 			xmmsv_list_append (list, v);
 		} else {
 			goto err;
@@ -468,8 +470,8 @@ err:
 }
 
 static bool
-_internal_get_from_bb_value_of_type_alloc (xmmsv_t *bb, xmmsv_type_t type,
-                                           xmmsv_t **val)
+_internal_get_from_bb_value_of_type_alloc (xmmsv_t *bb, xmmsv_arena_t *arena,
+                                           xmmsv_type_t type, xmmsv_t **val)
 {
 	int32_t i;
 	uint32_t len;
@@ -482,30 +484,30 @@ _internal_get_from_bb_value_of_type_alloc (xmmsv_t *bb, xmmsv_type_t type,
 			if (!_internal_get_from_bb_error_alloc (bb, &s, &len)) {
 				return false;
 			}
-			*val = xmmsv_new_error (s);
+			*val = xmmsv_arena_new_error (arena, s);
 			free (s);
 			break;
 		case XMMSV_TYPE_INT32:
 			if (!_internal_get_from_bb_int32 (bb, &i)) {
 				return false;
 			}
-			*val = xmmsv_new_int (i);
+			*val = xmmsv_arena_new_int (arena, i);
 			break;
 		case XMMSV_TYPE_STRING:
 			if (!_internal_get_from_bb_string_alloc (bb, &s, &len)) {
 				return false;
 			}
-			*val = xmmsv_new_string (s);
+			*val = xmmsv_arena_new_string (arena, s);
 			free (s);
 			break;
 		case XMMSV_TYPE_DICT:
-			if (!_internal_get_from_bb_value_dict_alloc (bb, val)) {
+			if (!_internal_get_from_bb_value_dict_alloc (bb, arena, val)) {
 				return false;
 			}
 			break;
 
 		case XMMSV_TYPE_LIST :
-			if (!_internal_get_from_bb_value_list_alloc (bb, val)) {
+			if (!_internal_get_from_bb_value_list_alloc (bb, arena, val)) {
 				return false;
 			}
 			break;
@@ -527,7 +529,7 @@ _internal_get_from_bb_value_of_type_alloc (xmmsv_t *bb, xmmsv_type_t type,
 			break;
 
 		case XMMSV_TYPE_NONE:
-			*val = xmmsv_new_none ();
+			*val = xmmsv_arena_new_none (arena);
 			break;
 		default:
 			x_internal_error ("Got message of unknown type!");
@@ -539,6 +541,681 @@ _internal_get_from_bb_value_of_type_alloc (xmmsv_t *bb, xmmsv_type_t type,
 
 
 
+/*
+ * Compact encoding, used on connections that asked for it.
+ *
+ * The value is preceded by a magic number where the legacy encoding
+ * would have its type, so a reader can tell the two apart. After that
+ * everything is byte aligned:
+ *
+ * - types, counts and lengths are unsigned LEB128 varints, integers
+ *   are zigzag encoded varints.
+ * - strings, errors and dict keys go through a per-message string
+ *   table. A reference of 0 is followed by a literal (length and
+ *   bytes, no terminator) which gets the next index in the table, any
+ *   other reference n repeats table entry n - 1.
+ * - lists carry a layout flag in the lowest bit of their count. A list
+ *   of dicts that all have the same keys is written column by column:
+ *   the keys once, then the values of each key for every row.
+ */
+
+#define XMMSV_COMPACT_MAGIC 0x584d4331 /* "XMC1" */
+
+typedef struct {
+	xmmsv_t *bb;
+	xmmsv_t *strings; /* dict of string -> index in the table */
+	int32_t count;
+} compact_writer_t;
+
+typedef struct {
+	xmmsv_t *bb;
+	xmmsv_t *strings; /* list of string values, by index */
+	xmmsv_arena_t *arena; /* where to build the values, if anywhere */
+} compact_reader_t;
+
+static bool _compact_put_value (compact_writer_t *w, xmmsv_t *v);
+static bool _compact_put_dict (compact_writer_t *w, xmmsv_t *v);
+static bool _compact_get_value (compact_reader_t *r, xmmsv_t **val);
+static bool _compact_get_dict (compact_reader_t *r, xmmsv_t **val);
+
+static bool
+_compact_put_uint (compact_writer_t *w, uint32_t v)
+{
+	unsigned char buf[5];
+	int n = 0;
+
+	while (v >= 0x80) {
+		buf[n++] = (v & 0x7f) | 0x80;
+		v >>= 7;
+	}
+	buf[n++] = v;
+
+	return xmmsv_bitbuffer_put_data (w->bb, buf, n);
+}
+
+static bool
+_compact_put_int (compact_writer_t *w, int32_t v)
+{
+	return _compact_put_uint (w, ((uint32_t) v << 1) ^ (uint32_t) (v >> 31));
+}
+
+static bool
+_compact_put_string (compact_writer_t *w, const char *str)
+{
+	int32_t index;
+	int len;
+
+	if (!str) {
+		str = "";
+	}
+
+	if (xmmsv_dict_entry_get_int (w->strings, str, &index)) {
+		return _compact_put_uint (w, index + 1);
+	}
+
+	xmmsv_dict_set_int (w->strings, str, w->count++);
+
+	len = strlen (str);
+
+	return _compact_put_uint (w, 0) &&
+	       _compact_put_uint (w, len) &&
+	       (len == 0 || xmmsv_bitbuffer_put_data (w->bb, (const unsigned char *) str, len));
+}
+
+/* the keys of the first dict if all entries are dicts with the same keys */
+static xmmsv_t *
+_compact_columns (xmmsv_t *list)
+{
+	xmmsv_list_iter_t *it;
+	xmmsv_dict_iter_t *dit;
+	xmmsv_t *entry, *first, *keys;
+	const char *key;
+	int size;
+
+	if (xmmsv_list_get_size (list) < 2 ||
+	    !xmmsv_list_get (list, 0, &first) ||
+	    !xmmsv_is_type (first, XMMSV_TYPE_DICT)) {
+		return NULL;
+	}
+
+	size = xmmsv_dict_get_size (first);
+	if (size == 0) {
+		return NULL;
+	}
+
+	xmmsv_get_list_iter (list, &it);
+	for (xmmsv_list_iter_next (it); xmmsv_list_iter_valid (it); xmmsv_list_iter_next (it)) {
+		xmmsv_list_iter_entry (it, &entry);
+		if (!xmmsv_is_type (entry, XMMSV_TYPE_DICT) ||
+		    xmmsv_dict_get_size (entry) != size) {
+			return NULL;
+		}
+	}
+
+	keys = xmmsv_new_list ();
+
+	xmmsv_get_dict_iter (first, &dit);
+	for (; xmmsv_dict_iter_valid (dit); xmmsv_dict_iter_next (dit)) {
+		xmmsv_dict_iter_pair (dit, &key, NULL);
+		xmmsv_list_append_string (keys, key);
+	}
+
+	for (xmmsv_list_iter_first (it); xmmsv_list_iter_valid (it); xmmsv_list_iter_next (it)) {
+		xmmsv_list_iter_entry (it, &entry);
+		for (xmmsv_dict_iter_first (dit); xmmsv_dict_iter_valid (dit); xmmsv_dict_iter_next (dit)) {
+			xmmsv_dict_iter_pair (dit, &key, NULL);
+			if (!xmmsv_dict_has_key (entry, key)) {
+				xmmsv_unref (keys);
+				return NULL;
+			}
+		}
+	}
+
+	return keys;
+}
+
+static bool
+_compact_put_list (compact_writer_t *w, xmmsv_t *v)
+{
+	xmmsv_list_iter_t *it, *kit;
+	xmmsv_t *entry, *keys, *value;
+	const char *key;
+	uint32_t count;
+
+	count = xmmsv_list_get_size (v);
+	keys = _compact_columns (v);
+
+	if (!_compact_put_uint (w, count << 1 | (keys ? 1 : 0))) {
+		if (keys) {
+			xmmsv_unref (keys);
+		}
+		return false;
+	}
+
+	xmmsv_get_list_iter (v, &it);
+
+	if (!keys) {
+		for (; xmmsv_list_iter_valid (it); xmmsv_list_iter_next (it)) {
+			xmmsv_list_iter_entry (it, &entry);
+			if (!_compact_put_value (w, entry)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	_compact_put_uint (w, xmmsv_list_get_size (keys));
+
+	xmmsv_get_list_iter (keys, &kit);
+	for (; xmmsv_list_iter_valid (kit); xmmsv_list_iter_next (kit)) {
+		xmmsv_list_iter_entry_string (kit, &key);
+		_compact_put_string (w, key);
+	}
+
+	for (xmmsv_list_iter_first (kit); xmmsv_list_iter_valid (kit); xmmsv_list_iter_next (kit)) {
+		xmmsv_list_iter_entry_string (kit, &key);
+		for (xmmsv_list_iter_first (it); xmmsv_list_iter_valid (it); xmmsv_list_iter_next (it)) {
+			xmmsv_list_iter_entry (it, &entry);
+			xmmsv_dict_get (entry, key, &value);
+			if (!_compact_put_value (w, value)) {
+				xmmsv_unref (keys);
+				return false;
+			}
+		}
+	}
+
+	xmmsv_unref (keys);
+
+	return true;
+}
+
+static bool
+_compact_put_dict (compact_writer_t *w, xmmsv_t *v)
+{
+	xmmsv_dict_iter_t *it;
+	const char *key;
+	xmmsv_t *entry;
+
+	if (!xmmsv_get_dict_iter (v, &it) ||
+	    !_compact_put_uint (w, xmmsv_dict_get_size (v))) {
+		return false;
+	}
+
+	for (; xmmsv_dict_iter_valid (it); xmmsv_dict_iter_next (it)) {
+		xmmsv_dict_iter_pair (it, &key, &entry);
+		if (!_compact_put_string (w, key) || !_compact_put_value (w, entry)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool
+_compact_put_collection (compact_writer_t *w, xmmsv_coll_t *coll)
+{
+	xmmsv_list_iter_t *it;
+	xmmsv_coll_t *op;
+	xmmsv_t *v;
+	int32_t entry;
+
+	_compact_put_uint (w, xmmsv_coll_get_type (coll));
+	_compact_put_dict (w, xmmsv_coll_attributes_get (coll));
+
+	_compact_put_uint (w, xmmsv_coll_idlist_get_size (coll));
+	xmmsv_get_list_iter (xmmsv_coll_idlist_get (coll), &it);
+	for (; xmmsv_list_iter_valid (it); xmmsv_list_iter_next (it)) {
+		if (!xmmsv_list_iter_entry_int (it, &entry)) {
+			x_api_error ("Non integer in idlist", false);
+		}
+		_compact_put_int (w, entry);
+	}
+
+	if (xmmsv_coll_get_type (coll) == XMMS_COLLECTION_TYPE_REFERENCE) {
+		return _compact_put_uint (w, 0);
+	}
+
+	_compact_put_uint (w, xmmsv_list_get_size (xmmsv_coll_operands_get (coll)));
+	xmmsv_get_list_iter (xmmsv_coll_operands_get (coll), &it);
+	for (; xmmsv_list_iter_valid (it); xmmsv_list_iter_next (it)) {
+		xmmsv_list_iter_entry (it, &v);
+		if (!xmmsv_get_coll (v, &op)) {
+			x_api_error ("Non collection operand", false);
+		}
+		if (!_compact_put_collection (w, op)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool
+_compact_put_value (compact_writer_t *w, xmmsv_t *v)
+{
+	xmmsv_type_t type;
+	const unsigned char *bc;
+	unsigned int bl;
+	xmmsv_coll_t *c;
+	const char *s;
+	int32_t i;
+
+	type = xmmsv_get_type (v);
+	if (!_compact_put_uint (w, type)) {
+		return false;
+	}
+
+	switch (type) {
+	case XMMSV_TYPE_ERROR:
+		xmmsv_get_error (v, &s);
+		return _compact_put_string (w, s);
+	case XMMSV_TYPE_INT32:
+		xmmsv_get_int (v, &i);
+		return _compact_put_int (w, i);
+	case XMMSV_TYPE_STRING:
+		xmmsv_get_string (v, &s);
+		return _compact_put_string (w, s);
+	case XMMSV_TYPE_COLL:
+		xmmsv_get_coll (v, &c);
+		return _compact_put_collection (w, c);
+	case XMMSV_TYPE_BIN:
+		xmmsv_get_bin (v, &bc, &bl);
+		return _compact_put_uint (w, bl) &&
+		       (bl == 0 || xmmsv_bitbuffer_put_data (w->bb, bc, bl));
+	case XMMSV_TYPE_LIST:
+		return _compact_put_list (w, v);
+	case XMMSV_TYPE_DICT:
+		return _compact_put_dict (w, v);
+	case XMMSV_TYPE_NONE:
+		return true;
+	default:
+		x_internal_error ("Tried to serialize value of unsupported type");
+		return false;
+	}
+}
+
+static bool
+_compact_get_uint (compact_reader_t *r, uint32_t *v)
+{
+	unsigned char b;
+	int shift;
+
+	*v = 0;
+	for (shift = 0; shift < 35; shift += 7) {
+		if (!xmmsv_bitbuffer_get_data (r->bb, &b, 1)) {
+			return false;
+		}
+		*v |= (uint32_t) (b & 0x7f) << shift;
+		if (!(b & 0x80)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool
+_compact_get_int (compact_reader_t *r, int32_t *v)
+{
+	uint32_t u;
+
+	if (!_compact_get_uint (r, &u)) {
+		return false;
+	}
+
+	*v = (int32_t) ((u >> 1) ^ -(u & 1));
+
+	return true;
+}
+
+/* every encoded element takes at least one byte */
+static bool
+_compact_get_count (compact_reader_t *r, uint32_t *count)
+{
+	uint32_t left;
+
+	left = (xmmsv_bitbuffer_len (r->bb) - xmmsv_bitbuffer_pos (r->bb)) / 8;
+
+	return _compact_get_uint (r, count) && *count <= left;
+}
+
+static bool
+_compact_get_string (compact_reader_t *r, xmmsv_t **val)
+{
+	uint32_t ref, len;
+	char *str;
+
+	if (!_compact_get_uint (r, &ref)) {
+		return false;
+	}
+
+	if (ref > 0) {
+		if (!xmmsv_list_get (r->strings, ref - 1, val)) {
+			return false;
+		}
+		xmmsv_ref (*val);
+		return true;
+	}
+
+	if (!_compact_get_count (r, &len)) {
+		return false;
+	}
+
+	str = x_malloc (len + 1);
+	if (!str) {
+		return false;
+	}
+
+	if (len > 0 && !xmmsv_bitbuffer_get_data (r->bb, (unsigned char *) str, len)) {
+		free (str);
+		return false;
+	}
+	str[len] = '\0';
+
+	*val = xmmsv_arena_new_string (r->arena, str);
+	free (str);
+
+	/* not valid utf-8 */
+	if (!*val) {
+		return false;
+	}
+
+	xmmsv_list_append (r->strings, *val);
+
+	return true;
+}
+
+static bool
+_compact_get_list (compact_reader_t *r, xmmsv_t **val)
+{
+	xmmsv_t *list, *keys, *key, *v, *row;
+	uint32_t count, nkeys, columnar, i, j;
+	const char *k;
+
+	/* the lowest bit tells the layout */
+	if (!_compact_get_uint (r, &count)) {
+		return false;
+	}
+
+	columnar = count & 1;
+	count >>= 1;
+
+	if (count > (xmmsv_bitbuffer_len (r->bb) - xmmsv_bitbuffer_pos (r->bb)) / 8) {
+		return false;
+	}
+
+	list = xmmsv_arena_new_list (r->arena);
+
+	if (!columnar) {
+		for (i = 0; i < count; i++) {
+			if (!_compact_get_value (r, &v)) {
+				xmmsv_unref (list);
+				return false;
+			}
+			xmmsv_list_append (list, v);
+			xmmsv_unref (v);
+		}
+
+		*val = list;
+		return true;
+	}
+
+	if (!_compact_get_count (r, &nkeys) || nkeys == 0) {
+		xmmsv_unref (list);
+		return false;
+	}
+
+	keys = xmmsv_new_list ();
+	for (j = 0; j < nkeys; j++) {
+		if (!_compact_get_string (r, &key)) {
+			goto err;
+		}
+		xmmsv_list_append (keys, key);
+		xmmsv_unref (key);
+	}
+
+	for (i = 0; i < count; i++) {
+		row = xmmsv_arena_new_dict (r->arena);
+		xmmsv_list_append (list, row);
+		xmmsv_unref (row);
+	}
+
+	for (j = 0; j < nkeys; j++) {
+		xmmsv_list_get_string (keys, j, &k);
+		for (i = 0; i < count; i++) {
+			if (!_compact_get_value (r, &v)) {
+				goto err;
+			}
+			xmmsv_list_get (list, i, &row);
+			xmmsv_dict_set (row, k, v);
+			xmmsv_unref (v);
+		}
+	}
+
+	xmmsv_unref (keys);
+	*val = list;
+
+	return true;
+
+err:
+	xmmsv_unref (keys);
+	xmmsv_unref (list);
+	return false;
+}
+
+static bool
+_compact_get_dict (compact_reader_t *r, xmmsv_t **val)
+{
+	xmmsv_t *dict, *key, *v;
+	const char *k;
+	uint32_t count;
+
+	if (!_compact_get_count (r, &count)) {
+		return false;
+	}
+
+	dict = xmmsv_arena_new_dict (r->arena);
+
+	while (count--) {
+		if (!_compact_get_string (r, &key)) {
+			xmmsv_unref (dict);
+			return false;
+		}
+
+		if (!_compact_get_value (r, &v)) {
+			xmmsv_unref (key);
+			xmmsv_unref (dict);
+			return false;
+		}
+
+		xmmsv_get_string (key, &k);
+		xmmsv_dict_set (dict, k, v);
+		xmmsv_unref (key);
+		xmmsv_unref (v);
+	}
+
+	*val = dict;
+
+	return true;
+}
+
+static bool
+_compact_get_collection (compact_reader_t *r, xmmsv_coll_t **coll)
+{
+	xmmsv_dict_iter_t *it;
+	xmmsv_coll_t *operand;
+	xmmsv_t *dict, *v;
+	const char *key;
+	uint32_t type, n;
+	int32_t id;
+
+	if (!_compact_get_uint (r, &type)) {
+		return false;
+	}
+
+	/* xmmsv_coll_new refuses unknown types */
+	if (type > XMMS_COLLECTION_TYPE_LAST) {
+		return false;
+	}
+
+	if (!_compact_get_dict (r, &dict)) {
+		return false;
+	}
+
+	*coll = xmmsv_coll_new (type);
+
+	xmmsv_get_dict_iter (dict, &it);
+	for (; xmmsv_dict_iter_valid (it); xmmsv_dict_iter_next (it)) {
+		xmmsv_dict_iter_pair (it, &key, &v);
+		xmmsv_dict_set (xmmsv_coll_attributes_get (*coll), key, v);
+	}
+	xmmsv_unref (dict);
+
+	if (!_compact_get_count (r, &n)) {
+		goto err;
+	}
+
+	while (n--) {
+		if (!_compact_get_int (r, &id)) {
+			goto err;
+		}
+		xmmsv_coll_idlist_append (*coll, id);
+	}
+
+	if (!_compact_get_count (r, &n)) {
+		goto err;
+	}
+
+	while (n--) {
+		if (!_compact_get_collection (r, &operand)) {
+			goto err;
+		}
+		xmmsv_coll_add_operand (*coll, operand);
+		xmmsv_coll_unref (operand);
+	}
+
+	return true;
+
+err:
+	xmmsv_coll_unref (*coll);
+	return false;
+}
+
+static bool
+_compact_get_value (compact_reader_t *r, xmmsv_t **val)
+{
+	xmmsv_coll_t *c;
+	xmmsv_t *s;
+	unsigned char *d;
+	const char *str;
+	uint32_t type, len;
+	int32_t i;
+
+	if (!_compact_get_uint (r, &type)) {
+		return false;
+	}
+
+	switch (type) {
+	case XMMSV_TYPE_ERROR:
+		if (!_compact_get_string (r, &s)) {
+			return false;
+		}
+		xmmsv_get_string (s, &str);
+		*val = xmmsv_arena_new_error (r->arena, str);
+		xmmsv_unref (s);
+		return true;
+	case XMMSV_TYPE_INT32:
+		if (!_compact_get_int (r, &i)) {
+			return false;
+		}
+		*val = xmmsv_arena_new_int (r->arena, i);
+		return true;
+	case XMMSV_TYPE_STRING:
+		/* strings are immutable, so repeated ones share one value */
+		return _compact_get_string (r, val);
+	case XMMSV_TYPE_COLL:
+		if (!_compact_get_collection (r, &c)) {
+			return false;
+		}
+		*val = xmmsv_new_coll (c);
+		xmmsv_coll_unref (c);
+		return true;
+	case XMMSV_TYPE_BIN:
+		if (!_compact_get_count (r, &len)) {
+			return false;
+		}
+		d = x_malloc (len ? len : 1);
+		if (!d) {
+			return false;
+		}
+		if (len > 0 && !xmmsv_bitbuffer_get_data (r->bb, d, len)) {
+			free (d);
+			return false;
+		}
+		*val = xmmsv_new_bin (d, len);
+		free (d);
+		return true;
+	case XMMSV_TYPE_LIST:
+		return _compact_get_list (r, val);
+	case XMMSV_TYPE_DICT:
+		return _compact_get_dict (r, val);
+	case XMMSV_TYPE_NONE:
+		*val = xmmsv_arena_new_none (r->arena);
+		return true;
+	default:
+		x_internal_error ("Got message of unknown type!");
+		return false;
+	}
+}
+
+/**
+ * Serialize a value using the compact encoding. Readers that know the
+ * compact encoding recognize it automatically in
+ * #xmmsv_bitbuffer_deserialize_value, so it must only be sent to peers
+ * that asked for it.
+ */
+int
+xmmsv_bitbuffer_serialize_value_compact (xmmsv_t *bb, xmmsv_t *v)
+{
+	compact_writer_t w;
+	bool ret;
+
+	if (!xmmsv_bitbuffer_put_bits (bb, 32, XMMSV_COMPACT_MAGIC)) {
+		return false;
+	}
+
+	w.bb = bb;
+	w.strings = xmmsv_new_dict ();
+	w.count = 0;
+
+	ret = _compact_put_value (&w, v);
+
+	xmmsv_unref (w.strings);
+
+	return ret;
+}
+
+static bool
+_compact_deserialize_value (xmmsv_t *bb, xmmsv_arena_t *arena, xmmsv_t **val)
+{
+	compact_reader_t r;
+	bool ret;
+
+	r.bb = bb;
+	r.strings = xmmsv_new_list ();
+	r.arena = arena;
+
+	ret = _compact_get_value (&r, val);
+
+	xmmsv_unref (r.strings);
+
+	if (!ret) {
+		x_internal_error ("Message from server did not parse correctly!");
+	}
+
+	return ret;
+}
+
 int
 xmmsv_bitbuffer_serialize_value (xmmsv_t *bb, xmmsv_t *v)
 {
@@ -605,6 +1282,22 @@ xmmsv_bitbuffer_serialize_value (xmmsv_t *bb, xmmsv_t *v)
 
 int
 xmmsv_bitbuffer_deserialize_value (xmmsv_t *bb, xmmsv_t **val)
+{
+	return xmmsv_bitbuffer_deserialize_value_arena (bb, NULL, val);
+}
+
+/**
+ * Like #xmmsv_bitbuffer_deserialize_value, but builds the value in
+ * an arena.
+ *
+ * @param bb The bitbuffer to read from.
+ * @param arena The arena to build the value in, or NULL.
+ * @param val Set to the value read.
+ * @return 1 upon success otherwise 0
+ */
+int
+xmmsv_bitbuffer_deserialize_value_arena (xmmsv_t *bb, xmmsv_arena_t *arena,
+                                         xmmsv_t **val)
 {
 	int32_t type;
 
@@ -612,7 +1305,11 @@ xmmsv_bitbuffer_deserialize_value (xmmsv_t *bb, xmmsv_t **val)
 		return false;
 	}
 
-	return _internal_get_from_bb_value_of_type_alloc (bb, type, val);
+	if (type == XMMSV_COMPACT_MAGIC) {
+		return _compact_deserialize_value (bb, arena, val);
+	}
+
+	return _internal_get_from_bb_value_of_type_alloc (bb, arena, type, val);
 }
 
 
@@ -0,0 +1,331 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2012 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "xmmspriv/xmmsv.h"
+#include "xmmsclientpriv/xmmsclient_util.h"
+
+#include "xmmsc/xmmsv.h"
+#include "xmmsc/xmmsc_util.h"
+
+/** @file */
+
+/* allocations are aligned for any member of xmmsv_t and its internals */
+#define ARENA_ALIGN(n) (((n) + 15) & ~((size_t) 15))
+#define ARENA_MIN_CHUNK 4096
+#define ARENA_MAX_CHUNK (1024 * 1024)
+
+/* values of one arena may be released from different threads */
+#define ARENA_REF_INC(r) __sync_add_and_fetch ((r), 1)
+#define ARENA_REF_DEC(r) __sync_sub_and_fetch ((r), 1)
+
+typedef struct xmmsv_arena_chunk_St {
+	struct xmmsv_arena_chunk_St *next;
+} xmmsv_arena_chunk_t;
+
+struct xmmsv_arena_St {
+	int ref;
+
+	xmmsv_arena_chunk_t *chunks;
+	char *pos;
+	char *end;
+	size_t chunk_size;
+};
+
+/**
+ * Allocates a new arena to build #xmmsv_t trees in.
+ *
+ * Values created in an arena are carved out of a few large chunks,
+ * and freeing them does not release any memory by itself. Each
+ * value keeps a reference to the arena, so values escaping the
+ * arena stay valid, but all of the arena memory is released only
+ * once the arena and every value created in it are unreferenced.
+ *
+ * The arena refcount is atomic, so separate values of one arena may
+ * be released from different threads. As usual, a single value must
+ * not be.
+ *
+ * @param size A hint of the memory the values will take, or 0.
+ * @return The new arena. Must be unreferenced with #xmmsv_arena_unref.
+ */
+xmmsv_arena_t *
+xmmsv_arena_new (size_t size)
+{
+	xmmsv_arena_t *arena;
+
+	arena = x_new0 (xmmsv_arena_t, 1);
+	if (!arena) {
+		x_oom ();
+		return NULL;
+	}
+
+	if (size < ARENA_MIN_CHUNK) {
+		size = ARENA_MIN_CHUNK;
+	} else if (size > ARENA_MAX_CHUNK) {
+		size = ARENA_MAX_CHUNK;
+	}
+
+	arena->chunk_size = size;
+
+	return xmmsv_arena_ref (arena);
+}
+
+/**
+ * References the arena.
+ *
+ * @param arena The arena to reference.
+ * @return arena
+ */
+xmmsv_arena_t *
+xmmsv_arena_ref (xmmsv_arena_t *arena)
+{
+	ARENA_REF_INC (&arena->ref);
+
+	return arena;
+}
+
+/**
+ * Decreases the references of the arena. All of its memory is freed
+ * when the last reference, including those of the values created in
+ * it, is gone.
+ *
+ * @param arena The arena to unreference.
+ */
+void
+xmmsv_arena_unref (xmmsv_arena_t *arena)
+{
+	xmmsv_arena_chunk_t *chunk;
+
+	x_return_if_fail (arena);
+	x_api_error_if (arena->ref < 1, "with a freed arena",);
+
+	if (ARENA_REF_DEC (&arena->ref) > 0) {
+		return;
+	}
+
+	while (arena->chunks) {
+		chunk = arena->chunks;
+		arena->chunks = chunk->next;
+		free (chunk);
+	}
+
+	free (arena);
+}
+
+static xmmsv_arena_chunk_t *
+_xmmsv_arena_chunk_new (size_t size)
+{
+	xmmsv_arena_chunk_t *chunk;
+
+	chunk = x_malloc (ARENA_ALIGN (sizeof (xmmsv_arena_chunk_t)) + size);
+	if (!chunk) {
+		x_oom ();
+		return NULL;
+	}
+
+	return chunk;
+}
+
+/**
+ * Allocates zeroed memory from the arena, or from the heap if arena
+ * is NULL.
+ * @internal
+ */
+void *
+_xmmsv_arena_alloc0 (xmmsv_arena_t *arena, size_t size)
+{
+	xmmsv_arena_chunk_t *chunk;
+	char *ret;
+
+	if (!arena) {
+		return x_malloc0 (size);
+	}
+
+	size = ARENA_ALIGN (size);
+
+	if (size > (size_t) (arena->end - arena->pos)) {
+		if (size > arena->chunk_size / 4) {
+			/* too big to share a chunk, keep the current one going */
+			chunk = _xmmsv_arena_chunk_new (size);
+			if (!chunk) {
+				return NULL;
+			}
+
+			if (arena->chunks) {
+				chunk->next = arena->chunks->next;
+				arena->chunks->next = chunk;
+			} else {
+				chunk->next = NULL;
+				arena->chunks = chunk;
+			}
+
+			ret = (char *) chunk + ARENA_ALIGN (sizeof (xmmsv_arena_chunk_t));
+			memset (ret, 0, size);
+
+			return ret;
+		}
+
+		/* the first chunk is the size asked for, then they grow */
+		if (arena->chunks && arena->chunk_size < ARENA_MAX_CHUNK) {
+			arena->chunk_size *= 2;
+		}
+
+		chunk = _xmmsv_arena_chunk_new (arena->chunk_size);
+		if (!chunk) {
+			return NULL;
+		}
+
+		chunk->next = arena->chunks;
+		arena->chunks = chunk;
+
+		arena->pos = (char *) chunk + ARENA_ALIGN (sizeof (xmmsv_arena_chunk_t));
+		arena->end = arena->pos + arena->chunk_size;
+	}
+
+	ret = arena->pos;
+	arena->pos += size;
+
+	memset (ret, 0, size);
+
+	return ret;
+}
+
+/**
+ * Duplicates a string into the arena, or onto the heap if arena is
+ * NULL.
+ * @internal
+ */
+char *
+_xmmsv_arena_strdup (xmmsv_arena_t *arena, const char *str)
+{
+	char *ret;
+	size_t len;
+
+	if (!arena) {
+		return strdup (str);
+	}
+
+	len = strlen (str) + 1;
+
+	ret = _xmmsv_arena_alloc0 (arena, len);
+	if (ret) {
+		memcpy (ret, str, len);
+	}
+
+	return ret;
+}
+
+/**
+ * Frees memory from #_xmmsv_arena_alloc0 or #_xmmsv_arena_strdup.
+ * Memory of an arena is only released with the arena itself.
+ * @internal
+ */
+void
+_xmmsv_arena_free (xmmsv_arena_t *arena, void *ptr)
+{
+	if (!arena) {
+		free (ptr);
+	}
+}
+
+/**
+ * Allocates a new empty #xmmsv_t in an arena.
+ * @param arena The arena to allocate the value in, or NULL to
+ * allocate it on its own.
+ * @return The new #xmmsv_t. Must be unreferenced with
+ * #xmmsv_unref.
+ */
+xmmsv_t *
+xmmsv_arena_new_none (xmmsv_arena_t *arena)
+{
+	return _xmmsv_new_in (arena, XMMSV_TYPE_NONE);
+}
+
+/**
+ * Allocates a new error #xmmsv_t in an arena.
+ * @param arena The arena to allocate the value in, or NULL to
+ * allocate it on its own.
+ * @param errstr The error message, copied into the arena.
+ * @return The new #xmmsv_t. Must be unreferenced with
+ * #xmmsv_unref.
+ */
+xmmsv_t *
+xmmsv_arena_new_error (xmmsv_arena_t *arena, const char *errstr)
+{
+	xmmsv_t *val;
+
+	x_return_val_if_fail (errstr, NULL);
+
+	val = _xmmsv_new_in (arena, XMMSV_TYPE_ERROR);
+	if (val) {
+		val->value.error = _xmmsv_arena_strdup (arena, errstr);
+	}
+
+	return val;
+}
+
+/**
+ * Allocates a new integer #xmmsv_t in an arena.
+ * @param arena The arena to allocate the value in, or NULL to
+ * allocate it on its own.
+ * @param i The value to store in the #xmmsv_t.
+ * @return The new #xmmsv_t. Must be unreferenced with
+ * #xmmsv_unref.
+ */
+xmmsv_t *
+xmmsv_arena_new_int (xmmsv_arena_t *arena, int32_t i)
+{
+	xmmsv_t *val;
+
+
+	val = _xmmsv_new_in (arena, XMMSV_TYPE_INT32);
+	if (val) {
+		val->value.int32 = i;
+	}
+
+	return val;
+}
+
+/**
+ * Allocates a new string #xmmsv_t in an arena.
+ * @param arena The arena to allocate the value in, or NULL to
+ * allocate it on its own.
+ * @param s The value to store in the #xmmsv_t, copied into the arena.
+ * @return The new #xmmsv_t. Must be unreferenced with
+ * #xmmsv_unref.
+ */
+xmmsv_t *
+xmmsv_arena_new_string (xmmsv_arena_t *arena, const char *s)
+{
+	xmmsv_t *val;
+
+	x_return_val_if_fail (s, NULL);
+	x_return_val_if_fail (xmmsv_utf8_validate (s), NULL);
+
+	val = _xmmsv_new_in (arena, XMMSV_TYPE_STRING);
+	if (val) {
+		const char *interned = _xmmsv_intern (s);
+		if (interned) {
+			val->value.string = (char *) interned;
+		} else {
+			val->value.string = _xmmsv_arena_strdup (arena, s);
+		}
+	}
+
+	return val;
+}
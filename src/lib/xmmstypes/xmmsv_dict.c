@@ -32,6 +32,9 @@ struct xmmsv_dict_internal_St {
 	xmmsv_dict_data_t *data;
 
 	x_list_t *iterators;
+
+	/* arena of the dict value, if any */
+	xmmsv_arena_t *arena;
 };
 
 struct xmmsv_dict_iter_St {
@@ -44,59 +47,15 @@ static void _xmmsv_dict_iter_free (xmmsv_dict_iter_t *it);
 #define HASH_MASK(table) ((1 << (table)->size) - 1)
 #define HASH_FILL_LIM 7
 #define DELETED_STR ((char*)-1)
-#define DICT_INIT_DATA(s) {.hash = _xmmsv_dict_hash (s, strlen (s)), .str = (char*)s}
+#define DICT_INIT_DATA(s) {.hash = _xmmsv_string_hash (s, strlen (s)), .str = (char*)s}
 #define START_SIZE 2
 
-/* MurmurHash2, by Austin Appleby */
-static uint32_t
-_xmmsv_dict_hash (const void *key, int len)
+static void
+_xmmsv_dict_key_free (xmmsv_dict_internal_t *dict, char *key)
 {
-	/* 'm' and 'r' are mixing constants generated offline.
-	 * They're not really 'magic', they just happen to work well.
-	 */
-	const uint32_t seed = 0x12345678;
-	const uint32_t m = 0x5bd1e995;
-	const int r = 24;
-
-	/* Initialize the hash to a 'random' value */
-	uint32_t h = seed ^ len;
-
-	/* Mix 4 bytes at a time into the hash */
-	const unsigned char * data = (const unsigned char *)key;
-
-	while (len >= 4)
-	{
-		uint32_t k;
-		memcpy (&k, data, sizeof (k));
-
-		k *= m;
-		k ^= k >> r;
-		k *= m;
-
-		h *= m;
-		h ^= k;
-
-		data += 4;
-		len -= 4;
+	if (!_xmmsv_interned (key)) {
+		_xmmsv_arena_free (dict->arena, key);
 	}
-
-	/* Handle the last few bytes of the input array */
-	switch (len)
-	{
-		case 3: h ^= data[2] << 16;
-		case 2: h ^= data[1] << 8;
-		case 1: h ^= data[0];
-			h *= m;
-	};
-
-	/* Do a few final mixes of the hash to ensure the last few
-	 * bytes are well-incorporated.
-	 */
-	h ^= h >> 13;
-	h *= m;
-	h ^= h >> 15;
-
-	return h;
 }
 
 /* Searches the hash table for an entry matching the hash and string in data.
@@ -122,7 +81,8 @@ _xmmsv_dict_search (xmmsv_dict_internal_t *dict, xmmsv_dict_data_t data,
 			}
 			/* If we found the entry we save it in the pos pointer */
 		} else if (dict->data[bucket].hash == data.hash
-		           && strcmp (dict->data[bucket].str, data.str) == 0) {
+		           && (dict->data[bucket].str == data.str
+		               || strcmp (dict->data[bucket].str, data.str) == 0)) {
 			*pos = bucket;
 			return 1;
 		}
@@ -156,9 +116,15 @@ _xmmsv_dict_insert (xmmsv_dict_internal_t *dict, xmmsv_dict_data_t data, int all
 		xmmsv_unref (dict->data[pos].value);
 		dict->data[pos].value = data.value;
 	} else {
-		/* Otherwise we insert a new entry */
-		if (alloc)
-			data.str = strdup (data.str);
+		/* Otherwise we insert a new entry, common keys are shared */
+		if (alloc) {
+			const char *interned = _xmmsv_intern_lookup (data.str, data.hash);
+			if (interned) {
+				data.str = (char *) interned;
+			} else {
+				data.str = _xmmsv_arena_strdup (dict->arena, data.str);
+			}
+		}
 		dict->elems++;
 		/* If we found a deleted entry before an empty one we use the free entry */
 		if (deleted != -1) {
@@ -174,7 +140,7 @@ _xmmsv_dict_insert (xmmsv_dict_internal_t *dict, xmmsv_dict_data_t data, int all
 static void
 _xmmsv_dict_remove (xmmsv_dict_internal_t *dict, int pos)
 {
-	free ((void*)dict->data[pos].str);
+	_xmmsv_dict_key_free (dict, dict->data[pos].str);
 	dict->data[pos].str = DELETED_STR;
 	xmmsv_unref (dict->data[pos].value);
 	dict->data[pos].value = NULL;
@@ -194,7 +160,8 @@ _xmmsv_dict_resize (xmmsv_dict_internal_t *dict)
 	dict->size++;
 	dict->elems = 0;
 	old_data = dict->data;
-	dict->data = x_new0 (xmmsv_dict_data_t, 1 << dict->size);
+	dict->data = _xmmsv_arena_alloc0 (dict->arena,
+	                                  sizeof (xmmsv_dict_data_t) << dict->size);
 
 	/* Insert all the entries in the old table into the new one */
 	for (i = 0; i < (1 << (dict->size - 1)); i++) {
@@ -203,26 +170,28 @@ _xmmsv_dict_resize (xmmsv_dict_internal_t *dict)
 		}
 	}
 
-	free (old_data);
+	_xmmsv_arena_free (dict->arena, old_data);
 }
 
 static xmmsv_dict_internal_t *
-_xmmsv_dict_new (void)
+_xmmsv_dict_new (xmmsv_arena_t *arena)
 {
 	xmmsv_dict_internal_t *dict;
 
-	dict = x_new0 (xmmsv_dict_internal_t, 1);
+	dict = _xmmsv_arena_alloc0 (arena, sizeof (xmmsv_dict_internal_t));
 	if (!dict) {
 		x_oom ();
 		return NULL;
 	}
 
+	dict->arena = arena;
 	dict->size = 2;
-	dict->data = x_new0 (xmmsv_dict_data_t, (1 << dict->size));
+	dict->data = _xmmsv_arena_alloc0 (arena,
+	                                  sizeof (xmmsv_dict_data_t) << dict->size);
 
 	if (!dict->data) {
 		x_oom ();
-		free (dict);
+		_xmmsv_arena_free (arena, dict);
 		return NULL;
 	}
 
@@ -244,14 +213,14 @@ _xmmsv_dict_free (xmmsv_dict_internal_t *dict)
 	for (i = (1 << dict->size) - 1; i >= 0; i--) {
 		if (dict->data[i].str != NULL) {
 			if (dict->data[i].str != DELETED_STR) {
-				free (dict->data[i].str);
+				_xmmsv_dict_key_free (dict, dict->data[i].str);
 				xmmsv_unref (dict->data[i].value);
 			}
 			dict->data[i].str = NULL;
 		}
 	}
-	free (dict->data);
-	free (dict);
+	_xmmsv_arena_free (dict->arena, dict->data);
+	_xmmsv_arena_free (dict->arena, dict);
 }
 
 /**
@@ -265,7 +234,28 @@ xmmsv_new_dict (void)
 	xmmsv_t *val = _xmmsv_new (XMMSV_TYPE_DICT);
 
 	if (val) {
-		val->value.dict = _xmmsv_dict_new ();
+		val->value.dict = _xmmsv_dict_new (NULL);
+	}
+
+	return val;
+}
+
+/**
+ * Allocates a new dict #xmmsv_t in an arena. The hash table and the
+ * keys of the dict are taken from the arena as well.
+ * @param arena The arena to allocate the value in, or NULL to
+ * allocate it on its own.
+ * @return The new #xmmsv_t. Must be unreferenced with
+ * #xmmsv_unref.
+ */
+xmmsv_t *
+xmmsv_arena_new_dict (xmmsv_arena_t *arena)
+{
+	xmmsv_t *val;
+
+	val = _xmmsv_new_in (arena, XMMSV_TYPE_DICT);
+	if (val) {
+		val->value.dict = _xmmsv_dict_new (arena);
 	}
 
 	return val;
@@ -426,7 +416,7 @@ xmmsv_dict_clear (xmmsv_t *dictv)
 	for (i = (1 << dict->size) - 1; i >= 0; i--) {
 		if (dict->data[i].str != NULL) {
 			if (dict->data[i].str != DELETED_STR) {
-				free (dict->data[i].str);
+				_xmmsv_dict_key_free (dict, dict->data[i].str);
 				xmmsv_unref (dict->data[i].value);
 			}
 			dict->data[i].str = NULL;
@@ -39,10 +39,16 @@ const char *xmmsv_default_source_pref[] = {
 
 xmmsv_t *
 _xmmsv_new (xmmsv_type_t type)
+{
+	return _xmmsv_new_in (NULL, type);
+}
+
+xmmsv_t *
+_xmmsv_new_in (xmmsv_arena_t *arena, xmmsv_type_t type)
 {
 	xmmsv_t *val;
 
-	val = x_new0 (xmmsv_t, 1);
+	val = _xmmsv_arena_alloc0 (arena, sizeof (xmmsv_t));
 	if (!val) {
 		x_oom ();
 		return NULL;
@@ -50,6 +56,10 @@ _xmmsv_new (xmmsv_type_t type)
 
 	val->type = type;
 
+	if (arena) {
+		val->arena = xmmsv_arena_ref (arena);
+	}
+
 	return xmmsv_ref (val);
 }
 
@@ -64,11 +74,13 @@ _xmmsv_free (xmmsv_t *val)
 		case XMMSV_TYPE_INT32 :
 			break;
 		case XMMSV_TYPE_ERROR :
-			free (val->value.error);
+			_xmmsv_arena_free (val->arena, val->value.error);
 			val->value.error = NULL;
 			break;
 		case XMMSV_TYPE_STRING :
-			free (val->value.string);
+			if (!_xmmsv_interned (val->value.string)) {
+				_xmmsv_arena_free (val->arena, val->value.string);
+			}
 			val->value.string = NULL;
 			break;
 		case XMMSV_TYPE_COLL:
@@ -95,7 +107,11 @@ _xmmsv_free (xmmsv_t *val)
 			break;
 	}
 
-	free (val);
+	if (val->arena) {
+		xmmsv_arena_unref (val->arena);
+	} else {
+		free (val);
+	}
 }
 
 
@@ -165,7 +181,8 @@ xmmsv_new_string (const char *s)
 
 	val = _xmmsv_new (XMMSV_TYPE_STRING);
 	if (val) {
-		val->value.string = strdup (s);
+		const char *interned = _xmmsv_intern (s);
+		val->value.string = interned ? (char *) interned : strdup (s);
 	}
 
 	return val;
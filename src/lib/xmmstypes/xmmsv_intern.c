@@ -0,0 +1,396 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2012 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+
+#include <string.h>
+
+#include "xmmspriv/xmmsv.h"
+#include "xmmsc/xmmsc_util.h"
+
+/** @file
+ * A fixed table of interned strings: the medialib property names and
+ * sources, and the other keys that show up in nearly every dict sent
+ * between the server and its clients. Dicts store these keys, and
+ * strings store these values, by pointing into the table instead of
+ * keeping copies of their own.
+ *
+ * The table never changes, so it can be shared between threads without
+ * any locking. The hashes are those of #_xmmsv_string_hash on a little
+ * endian machine; elsewhere lookups simply don't find anything.
+ */
+
+typedef struct {
+	uint32_t hash;
+	uint16_t offset; /* into intern_pool */
+} xmmsv_intern_entry_t;
+
+/* The property names in xmms/xmms_medialib.h, the metadata sources of
+ * the plugins and a few common keys. Maintained by hand: a new entry
+ * goes into intern_table at the position of its hash, and the offsets
+ * after it move along. test_properties_interned in the medialib tests
+ * fails when a property is missing. */
+static const char intern_pool[] =
+	"plugin/id3v2\0"
+	"commentlang\0"
+	"album_artist_sort\0"
+	"artist_id\0"
+	"barcode\0"
+	"laststarted\0"
+	"duration\0"
+	"originaldate\0"
+	"samplerate\0"
+	"release_country\0"
+	"album_artist\0"
+	"plugin/modplug\0"
+	"partofset\0"
+	"operands\0"
+	"website_file\0"
+	"plugin/tremor\0"
+	"plugin/sc68\0"
+	"size\0"
+	"plugin/playlist\0"
+	"track_id\0"
+	"plugin/ofa\0"
+	"plugin/wave\0"
+	"grouping\0"
+	"attributes\0"
+	"totaltracks\0"
+	"website_artist\0"
+	"plugin/mac\0"
+	"peak_album\0"
+	"title\0"
+	"channel\0"
+	"album_sort\0"
+	"idlist\0"
+	"catalognumber\0"
+	"isrc\0"
+	"chain\0"
+	"added\0"
+	"mixer\0"
+	"release_format\0"
+	"plugin/musepack\0"
+	"client/generic\0"
+	"plugin/speex\0"
+	"plugin/mad\0"
+	"conductor\0"
+	"copyright\0"
+	"plugin/opus\0"
+	"status\0"
+	"isvbr\0"
+	"plugin/flac\0"
+	"mime\0"
+	"lyricist\0"
+	"djmixer\0"
+	"picture_front\0"
+	"plugin/mid1\0"
+	"plugin/mp4\0"
+	"url\0"
+	"producer\0"
+	"plugin/cue\0"
+	"bpm\0"
+	"date\0"
+	"server\0"
+	"channels\0"
+	"website_copyright\0"
+	"comment\0"
+	"composer\0"
+	"id\0"
+	"album\0"
+	"plugin/avcodec\0"
+	"release_status\0"
+	"plugin/mpg123\0"
+	"plugin/faad\0"
+	"plugin/tta\0"
+	"website_publisher\0"
+	"gain_track\0"
+	"asin\0"
+	"totalset\0"
+	"startms\0"
+	"plugin/replaygain\0"
+	"plugin/daap\0"
+	"gain_album\0"
+	"genre\0"
+	"compilation\0"
+	"source\0"
+	"performer\0"
+	"description\0"
+	"artist\0"
+	"peak_track\0"
+	"publisher\0"
+	"plugin/curl\0"
+	"plugin/flv\0"
+	"title_sort\0"
+	"original_artist\0"
+	"bitrate\0"
+	"arranger\0"
+	"lmod\0"
+	"remixer\0"
+	"plugin/gme\0"
+	"plugin/cdda\0"
+	"plugin/sndfile\0"
+	"plugin/wavpack\0"
+	"album_id\0"
+	"picture_front_mime\0"
+	"timesplayed\0"
+	"release_type\0"
+	"value\0"
+	"key\0"
+	"plugin/sid\0"
+	"tracknr\0"
+	"plugin/vorbis\0"
+	"plugin/apefile\0"
+	"plugin/segment\0"
+	"stopms\0"
+	"plugin/asf\0"
+	"type\0"
+	"plugin/icymetaint\0"
+	"artist_sort\0"
+	"sample_format\0"
+	"subtunes\0";
+
+/* sorted by hash */
+static const xmmsv_intern_entry_t intern_table[] = {
+	{ 0x026ef004,    0 }, /* plugin/id3v2 */
+	{ 0x0879e255,   13 }, /* commentlang */
+	{ 0x08aa66aa,   25 }, /* album_artist_sort */
+	{ 0x0970f55f,   43 }, /* artist_id */
+	{ 0x0ebb2fb7,   53 }, /* barcode */
+	{ 0x10a50811,   61 }, /* laststarted */
+	{ 0x150075fa,   73 }, /* duration */
+	{ 0x16ec11e9,   82 }, /* originaldate */
+	{ 0x18ed6150,   95 }, /* samplerate */
+	{ 0x196e3d51,  106 }, /* release_country */
+	{ 0x1d7afbf3,  122 }, /* album_artist */
+	{ 0x1e471c7b,  135 }, /* plugin/modplug */
+	{ 0x1ef71093,  150 }, /* partofset */
+	{ 0x20cf7ad8,  160 }, /* operands */
+	{ 0x20fe256f,  169 }, /* website_file */
+	{ 0x210b8b7c,  182 }, /* plugin/tremor */
+	{ 0x23849adc,  196 }, /* plugin/sc68 */
+	{ 0x26d68039,  208 }, /* size */
+	{ 0x2761dfb8,  213 }, /* plugin/playlist */
+	{ 0x27baeeb7,  229 }, /* track_id */
+	{ 0x2a3115ec,  238 }, /* plugin/ofa */
+	{ 0x2a90c491,  249 }, /* plugin/wave */
+	{ 0x2afb4a49,  261 }, /* grouping */
+	{ 0x2ba278ad,  270 }, /* attributes */
+	{ 0x2bf0f401,  281 }, /* totaltracks */
+	{ 0x37239afc,  293 }, /* website_artist */
+	{ 0x38d251b5,  308 }, /* plugin/mac */
+	{ 0x39818b3a,  319 }, /* peak_album */
+	{ 0x3d5a918b,  330 }, /* title */
+	{ 0x3fa72001,  336 }, /* channel */
+	{ 0x3fec2ee5,  344 }, /* album_sort */
+	{ 0x4894ca8a,  355 }, /* idlist */
+	{ 0x48e4188a,  362 }, /* catalognumber */
+	{ 0x49708c9e,  376 }, /* isrc */
+	{ 0x4ace4208,  381 }, /* chain */
+	{ 0x4e07a16f,  387 }, /* added */
+	{ 0x4f3de11c,  393 }, /* mixer */
+	{ 0x53690632,  399 }, /* release_format */
+	{ 0x56bbc26a,  414 }, /* plugin/musepack */
+	{ 0x5802a236,  430 }, /* client/generic */
+	{ 0x58aac116,  445 }, /* plugin/speex */
+	{ 0x5ab90307,  458 }, /* plugin/mad */
+	{ 0x5eaf0933,  469 }, /* conductor */
+	{ 0x5ef4508a,  479 }, /* copyright */
+	{ 0x5f63b792,  489 }, /* plugin/opus */
+	{ 0x60534fc3,  501 }, /* status */
+	{ 0x63e7bb78,  508 }, /* isvbr */
+	{ 0x6668ab8e,  514 }, /* plugin/flac */
+	{ 0x683fa691,  526 }, /* mime */
+	{ 0x6b055371,  531 }, /* lyricist */
+	{ 0x6d856b9c,  540 }, /* djmixer */
+	{ 0x6e02bb0f,  548 }, /* picture_front */
+	{ 0x6e7dabd2,  562 }, /* plugin/mid1 */
+	{ 0x73802e3b,  574 }, /* plugin/mp4 */
+	{ 0x74419015,  585 }, /* url */
+	{ 0x77bde68a,  589 }, /* producer */
+	{ 0x78633a2d,  598 }, /* plugin/cue */
+	{ 0x7907d51c,  609 }, /* bpm */
+	{ 0x7bcdbf24,  613 }, /* date */
+	{ 0x7daab06b,  618 }, /* server */
+	{ 0x837a2d2d,  625 }, /* channels */
+	{ 0x8561eca7,  634 }, /* website_copyright */
+	{ 0x86bc9406,  652 }, /* comment */
+	{ 0x88006dab,  660 }, /* composer */
+	{ 0x8913d9e1,  669 }, /* id */
+	{ 0x8ae7c4b1,  672 }, /* album */
+	{ 0x8b962aee,  678 }, /* plugin/avcodec */
+	{ 0x8b99b426,  693 }, /* release_status */
+	{ 0x8c856a2a,  708 }, /* plugin/mpg123 */
+	{ 0x91fb36c0,  722 }, /* plugin/faad */
+	{ 0x955acf4c,  734 }, /* plugin/tta */
+	{ 0x9c097634,  745 }, /* website_publisher */
+	{ 0x9c4eb7a5,  763 }, /* gain_track */
+	{ 0x9e4a1a02,  774 }, /* asin */
+	{ 0x9ee42938,  779 }, /* totalset */
+	{ 0x9f1b8e1a,  788 }, /* startms */
+	{ 0xa000c33d,  796 }, /* plugin/replaygain */
+	{ 0xa73677f4,  814 }, /* plugin/daap */
+	{ 0xa764a48c,  826 }, /* gain_album */
+	{ 0xa9ef1cb5,  837 }, /* genre */
+	{ 0xabcaac51,  843 }, /* compilation */
+	{ 0xabe20603,  855 }, /* source */
+	{ 0xaeee0059,  862 }, /* performer */
+	{ 0xb1bf68bb,  872 }, /* description */
+	{ 0xb23479f4,  884 }, /* artist */
+	{ 0xb23afd1a,  891 }, /* peak_track */
+	{ 0xb39cf698,  902 }, /* publisher */
+	{ 0xb845254c,  912 }, /* plugin/curl */
+	{ 0xbb9523b5,  924 }, /* plugin/flv */
+	{ 0xbdd3a718,  935 }, /* title_sort */
+	{ 0xc295f493,  946 }, /* original_artist */
+	{ 0xc4019815,  962 }, /* bitrate */
+	{ 0xcafebd2b,  970 }, /* arranger */
+	{ 0xce2afc26,  979 }, /* lmod */
+	{ 0xcfb45c98,  984 }, /* remixer */
+	{ 0xd523767a,  992 }, /* plugin/gme */
+	{ 0xd55f187b, 1003 }, /* plugin/cdda */
+	{ 0xd8e1a04f, 1015 }, /* plugin/sndfile */
+	{ 0xdb2ea0d9, 1030 }, /* plugin/wavpack */
+	{ 0xdf3964b4, 1045 }, /* album_id */
+	{ 0xe03bb069, 1054 }, /* picture_front_mime */
+	{ 0xe08f851f, 1073 }, /* timesplayed */
+	{ 0xe207abd6, 1085 }, /* release_type */
+	{ 0xe408edcf, 1098 }, /* value */
+	{ 0xe45a254d, 1104 }, /* key */
+	{ 0xe60c53eb, 1108 }, /* plugin/sid */
+	{ 0xeaecfdd9, 1119 }, /* tracknr */
+	{ 0xec68b748, 1127 }, /* plugin/vorbis */
+	{ 0xee5813e7, 1141 }, /* plugin/apefile */
+	{ 0xf229cb3a, 1156 }, /* plugin/segment */
+	{ 0xf27d2826, 1171 }, /* stopms */
+	{ 0xf29a7510, 1178 }, /* plugin/asf */
+	{ 0xf3ebd1bf, 1189 }, /* type */
+	{ 0xf48fb916, 1194 }, /* plugin/icymetaint */
+	{ 0xf59a252e, 1212 }, /* artist_sort */
+	{ 0xfdd577d7, 1224 }, /* sample_format */
+	{ 0xfebbb912, 1238 }, /* subtunes */
+};
+
+#define INTERN_COUNT (sizeof (intern_table) / sizeof (intern_table[0]))
+
+/* MurmurHash2, by Austin Appleby */
+uint32_t
+_xmmsv_string_hash (const char *key, int len)
+{
+	/* 'm' and 'r' are mixing constants generated offline.
+	 * They're not really 'magic', they just happen to work well.
+	 */
+	const uint32_t seed = 0x12345678;
+	const uint32_t m = 0x5bd1e995;
+	const int r = 24;
+
+	/* Initialize the hash to a 'random' value */
+	uint32_t h = seed ^ len;
+
+	/* Mix 4 bytes at a time into the hash */
+	const unsigned char * data = (const unsigned char *)key;
+
+	while (len >= 4)
+	{
+		uint32_t k;
+		memcpy (&k, data, sizeof (k));
+
+		k *= m;
+		k ^= k >> r;
+		k *= m;
+
+		h *= m;
+		h ^= k;
+
+		data += 4;
+		len -= 4;
+	}
+
+	/* Handle the last few bytes of the input array */
+	switch (len)
+	{
+		case 3: h ^= data[2] << 16;
+		case 2: h ^= data[1] << 8;
+		case 1: h ^= data[0];
+			h *= m;
+	};
+
+	/* Do a few final mixes of the hash to ensure the last few
+	 * bytes are well-incorporated.
+	 */
+	h ^= h >> 13;
+	h *= m;
+	h ^= h >> 15;
+
+	return h;
+}
+
+/**
+ * Find the interned copy of a string.
+ *
+ * @param str The string to look for.
+ * @param hash The hash of str, as from #_xmmsv_string_hash.
+ * @return The interned copy, or NULL if str isn't interned.
+ * @internal
+ */
+const char *
+_xmmsv_intern_lookup (const char *str, uint32_t hash)
+{
+	int lo = 0, hi = INTERN_COUNT - 1, mid;
+	const char *interned;
+
+	while (lo <= hi) {
+		mid = (lo + hi) / 2;
+
+		if (intern_table[mid].hash < hash) {
+			lo = mid + 1;
+		} else if (intern_table[mid].hash > hash) {
+			hi = mid - 1;
+		} else {
+			interned = intern_pool + intern_table[mid].offset;
+			return strcmp (interned, str) == 0 ? interned : NULL;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Find the interned copy of a string that isn't hashed yet. Strings
+ * longer than any interned one are not even hashed.
+ * @internal
+ */
+const char *
+_xmmsv_intern (const char *str)
+{
+	size_t len;
+
+	len = strlen (str);
+	if (len > XMMSV_INTERN_MAX_LEN) {
+		return NULL;
+	}
+
+	return _xmmsv_intern_lookup (str, _xmmsv_string_hash (str, len));
+}
+
+/**
+ * Check whether a string points into the table, and thus must not be
+ * freed.
+ * @internal
+ */
+bool
+_xmmsv_interned (const char *str)
+{
+	return str >= intern_pool && str < intern_pool + sizeof (intern_pool);
+}
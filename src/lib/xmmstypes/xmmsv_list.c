@@ -35,6 +35,9 @@ struct xmmsv_list_internal_St {
 	bool restricted;
 	xmmsv_type_t restricttype;
 	x_list_t *iterators;
+
+	/* arena of the list value, if any */
+	xmmsv_arena_t *arena;
 };
 
 static void _xmmsv_list_iter_free (xmmsv_list_iter_t *it);
@@ -60,16 +63,18 @@ _xmmsv_list_position_normalize (int *pos, int size, int allow_append)
 }
 
 static xmmsv_list_internal_t *
-_xmmsv_list_new (void)
+_xmmsv_list_new (xmmsv_arena_t *arena)
 {
 	xmmsv_list_internal_t *list;
 
-	list = x_new0 (xmmsv_list_internal_t, 1);
+	list = _xmmsv_arena_alloc0 (arena, sizeof (xmmsv_list_internal_t));
 	if (!list) {
 		x_oom ();
 		return NULL;
 	}
 
+	list->arena = arena;
+
 	/* list is all empty for now! */
 
 	return list;
@@ -92,8 +97,8 @@ _xmmsv_list_free (xmmsv_list_internal_t *l)
 		xmmsv_unref (l->list[i]);
 	}
 
-	free (l->list);
-	free (l);
+	_xmmsv_arena_free (l->arena, l->list);
+	_xmmsv_arena_free (l->arena, l);
 }
 
 static int
@@ -101,7 +106,19 @@ _xmmsv_list_resize (xmmsv_list_internal_t *l, int newsize)
 {
 	xmmsv_t **newmem;
 
-	newmem = realloc (l->list, newsize * sizeof (xmmsv_t *));
+	if (l->arena) {
+		/* arena memory is never given back, so don't bother shrinking */
+		if (newsize <= l->allocated) {
+			return 1;
+		}
+
+		newmem = _xmmsv_arena_alloc0 (l->arena, newsize * sizeof (xmmsv_t *));
+		if (newmem && l->size) {
+			memcpy (newmem, l->list, l->size * sizeof (xmmsv_t *));
+		}
+	} else {
+		newmem = realloc (l->list, newsize * sizeof (xmmsv_t *));
+	}
 
 	if (newsize != 0 && newmem == NULL) {
 		x_oom ();
@@ -273,7 +290,7 @@ _xmmsv_list_clear (xmmsv_list_internal_t *l)
 	}
 
 	/* free list, declare empty */
-	free (l->list);
+	_xmmsv_arena_free (l->arena, l->list);
 	l->list = NULL;
 
 	l->size = 0;
@@ -304,7 +321,29 @@ xmmsv_new_list (void)
 	xmmsv_t *val = _xmmsv_new (XMMSV_TYPE_LIST);
 
 	if (val) {
-		val->value.list = _xmmsv_list_new ();
+		val->value.list = _xmmsv_list_new (NULL);
+		val->value.list->parent_value = val;
+	}
+
+	return val;
+}
+
+/**
+ * Allocates a new list #xmmsv_t in an arena. The storage of the list
+ * is taken from the arena as well.
+ * @param arena The arena to allocate the value in, or NULL to
+ * allocate it on its own.
+ * @return The new #xmmsv_t. Must be unreferenced with
+ * #xmmsv_unref.
+ */
+xmmsv_t *
+xmmsv_arena_new_list (xmmsv_arena_t *arena)
+{
+	xmmsv_t *val;
+
+	val = _xmmsv_new_in (arena, XMMSV_TYPE_LIST);
+	if (val) {
+		val->value.list = _xmmsv_list_new (arena);
 		val->value.list->parent_value = val;
 	}
 
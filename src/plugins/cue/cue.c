@@ -214,7 +214,7 @@ xmms_cue_browse (xmms_xform_t *xform,
                  const gchar *url,
                  xmms_error_t *error)
 {
-	gchar line[XMMS_XFORM_MAX_LINE_SIZE];
+	gchar *line;
 	cue_track track;
 	gchar *p;
 
@@ -222,7 +222,8 @@ xmms_cue_browse (xmms_xform_t *xform,
 
 	memset (&track, 0, sizeof (cue_track));
 
-	if (!xmms_xform_read_line (xform, line, error)) {
+	line = xmms_xform_read_line_view (xform, error);
+	if (!line) {
 		xmms_error_set (error, XMMS_ERROR_INVAL, "error reading cue-file!");
 		return FALSE;
 	}
@@ -278,7 +279,7 @@ xmms_cue_browse (xmms_xform_t *xform,
 				save_to_char (p, '"', t->artist);
 			}
 		}
-	} while (xmms_xform_read_line (xform, line, error));
+	} while ((line = xmms_xform_read_line_view (xform, error)));
 
 	if (track.file[0]) {
 		add_track (xform, &track);
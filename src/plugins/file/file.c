@@ -24,6 +24,9 @@
 #include <errno.h>
 #include <stdio.h>
 #include <string.h>
+#ifdef HAVE_MMAP
+# include <sys/mman.h>
+#endif
 
 #include "browse/browse.h"
 
@@ -31,12 +34,56 @@
 #if !defined(O_BINARY)
 # define O_BINARY 0
 #endif
+
+/* reads done by the read-ahead thread are aligned to this size */
+#define XMMS_FILE_READ_SIZE 65536
+
 /*
  * Type definitions
  */
 
+/**
+ * Window of the file kept buffered by the read-ahead thread. The byte
+ * at file offset o lives at buf[o % size], the valid range is
+ * [start, start + len). The thread keeps a quarter of the window behind
+ * the read position so that short backward seeks stay in the window.
+ */
 typedef struct {
 	gint fd;
+
+	GThread *thread;
+	GMutex *mutex;
+	GCond *cond;
+
+	guchar *buf;
+	gsize size;
+
+	gint64 start;
+	gsize len;
+	gint64 pos;
+
+	/* bumped on seeks outside the window, invalidates reads in flight */
+	guint generation;
+
+	gboolean running;
+	gboolean eof;
+	gint error;
+} xmms_file_readahead_t;
+
+typedef struct {
+	gint fd;
+	gint64 size;
+
+	/* set when the whole file is mapped */
+	guchar *map;
+	gint64 mappos;
+
+	/* the read-ahead thread is started once this many bytes have been
+	 * read sequentially, so short header reads never start it */
+	gint readahead;
+	gint64 pos;
+	gint64 sequential;
+	xmms_file_readahead_t *ra;
 } xmms_file_data_t;
 
 /*
@@ -48,6 +95,9 @@ static void xmms_file_destroy (xmms_xform_t *xform);
 static gint xmms_file_read (xmms_xform_t *xform, void *buffer, gint len, xmms_error_t *error);
 static gint64 xmms_file_seek (xmms_xform_t *xform, gint64 offset, xmms_xform_seek_mode_t whence, xmms_error_t *error);
 static gboolean xmms_file_plugin_setup (xmms_xform_plugin_t *xform_plugin);
+static xmms_file_readahead_t *xmms_file_readahead_new (gint fd, gsize size, gint64 offset);
+static void xmms_file_readahead_free (xmms_file_readahead_t *ra);
+static gpointer xmms_file_readahead_thread (gpointer udata);
 
 /*
  * Plugin header
@@ -79,6 +129,15 @@ xmms_file_plugin_setup (xmms_xform_plugin_t *xform_plugin)
 	                              "file://*",
 	                              XMMS_STREAM_TYPE_END);
 
+	/* size of the read-ahead window in bytes, 0 reads synchronously.
+	 * The thread only starts after the first window has been read. */
+	xmms_xform_plugin_config_property_register (xform_plugin, "readahead",
+	                                            "524288", NULL, NULL);
+
+	/* files up to this size are mapped into memory, 0 disables it */
+	xmms_xform_plugin_config_property_register (xform_plugin, "mmap_max_size",
+	                                            "0", NULL, NULL);
+
 	return TRUE;
 }
 
@@ -90,9 +149,11 @@ xmms_file_init (xmms_xform_t *xform)
 {
 	gint fd;
 	xmms_file_data_t *data;
+	xmms_config_property_t *cfgv;
 	const gchar *url;
 	const gchar *metakey;
 	struct stat st;
+	gint readahead, mmap_max;
 
 	url = xmms_xform_indata_get_str (xform, XMMS_STREAM_TYPE_URL);
 
@@ -119,6 +180,32 @@ xmms_file_init (xmms_xform_t *xform)
 
 	data = g_new0 (xmms_file_data_t, 1);
 	data->fd = fd;
+	data->size = st.st_size;
+
+#ifdef HAVE_POSIX_FADVISE
+	posix_fadvise (fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+	cfgv = xmms_xform_config_lookup (xform, "mmap_max_size");
+	mmap_max = cfgv ? xmms_config_property_get_int (cfgv) : 0;
+
+	cfgv = xmms_xform_config_lookup (xform, "readahead");
+	readahead = cfgv ? xmms_config_property_get_int (cfgv) : 0;
+
+#ifdef HAVE_MMAP
+	if (st.st_size > 0 && st.st_size <= mmap_max) {
+		data->map = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data->map == MAP_FAILED) {
+			XMMS_DBG ("Couldn't map '%s': %s", url, strerror (errno));
+			data->map = NULL;
+		}
+	}
+#endif
+
+	if (!data->map) {
+		data->readahead = MAX (readahead, 0);
+	}
+
 	xmms_xform_private_data_set (xform, data);
 
 	xmms_xform_outdata_type_add (xform,
@@ -145,12 +232,208 @@ xmms_file_destroy (xmms_xform_t *xform)
 	if (!data)
 		return;
 
+	if (data->ra)
+		xmms_file_readahead_free (data->ra);
+
+#ifdef HAVE_MMAP
+	if (data->map)
+		munmap (data->map, data->size);
+#endif
+
 	if (data->fd != -1)
 		close (data->fd);
 
 	g_free (data);
 }
 
+static xmms_file_readahead_t *
+xmms_file_readahead_new (gint fd, gsize size, gint64 offset)
+{
+	xmms_file_readahead_t *ra;
+	GError *error = NULL;
+
+	ra = g_new0 (xmms_file_readahead_t, 1);
+	ra->fd = fd;
+	ra->start = offset;
+	ra->pos = offset;
+
+	/* whole aligned reads must fit in the window */
+	ra->size = MAX (size, 4 * XMMS_FILE_READ_SIZE);
+	ra->size -= ra->size % XMMS_FILE_READ_SIZE;
+	ra->buf = g_malloc (ra->size);
+
+	ra->running = TRUE;
+	ra->mutex = g_mutex_new ();
+	ra->cond = g_cond_new ();
+
+	/* the thread is the only user of the fd from now on */
+	ra->thread = g_thread_create (xmms_file_readahead_thread,
+	                              ra, TRUE, &error);
+	if (!ra->thread) {
+		xmms_log_error ("Couldn't start read-ahead thread: %s",
+		                error ? error->message : "unknown error");
+		if (error)
+			g_error_free (error);
+		g_cond_free (ra->cond);
+		g_mutex_free (ra->mutex);
+		g_free (ra->buf);
+		g_free (ra);
+		return NULL;
+	}
+
+	return ra;
+}
+
+static void
+xmms_file_readahead_free (xmms_file_readahead_t *ra)
+{
+	g_mutex_lock (ra->mutex);
+	ra->running = FALSE;
+	g_cond_broadcast (ra->cond);
+	g_mutex_unlock (ra->mutex);
+
+	g_thread_join (ra->thread);
+
+	g_cond_free (ra->cond);
+	g_mutex_free (ra->mutex);
+	g_free (ra->buf);
+	g_free (ra);
+}
+
+
+static gpointer
+xmms_file_readahead_thread (gpointer udata)
+{
+	xmms_file_readahead_t *ra = udata;
+	gint64 fdpos = -1;
+
+	g_mutex_lock (ra->mutex);
+	while (ra->running) {
+		gint64 end, behind;
+		gsize off, chunk;
+		guint generation;
+		gssize res;
+		gint err = 0;
+
+		end = ra->start + ra->len;
+		behind = ra->size / 4;
+
+		if (ra->eof || ra->error || end - ra->pos >= ra->size - behind) {
+			g_cond_wait (ra->cond, ra->mutex);
+			continue;
+		}
+
+		/* drop what is too far behind the reader to be useful */
+		if (ra->pos - ra->start > behind) {
+			ra->len -= ra->pos - behind - ra->start;
+			ra->start = ra->pos - behind;
+		}
+
+		off = end % ra->size;
+		chunk = MIN (ra->size - ra->len, ra->size - off);
+		chunk = MIN (chunk, XMMS_FILE_READ_SIZE - end % XMMS_FILE_READ_SIZE);
+		generation = ra->generation;
+
+		/* only the reader touches the valid part of the window, and
+		 * it never looks past start + len, so fill it unlocked */
+		g_mutex_unlock (ra->mutex);
+
+		if (fdpos != end) {
+			fdpos = lseek (ra->fd, end, SEEK_SET);
+		}
+		if (fdpos == end) {
+			res = read (ra->fd, ra->buf + off, chunk);
+		} else {
+			res = -1;
+		}
+		if (res > 0) {
+			fdpos += res;
+		} else if (res == -1) {
+			err = errno;
+			fdpos = -1;
+		}
+
+		g_mutex_lock (ra->mutex);
+
+		if (generation != ra->generation) {
+			/* seeked away while reading */
+			continue;
+		}
+
+		if (res == -1) {
+			if (err != EINTR) {
+				ra->error = err;
+			}
+		} else if (res == 0) {
+			ra->eof = TRUE;
+		} else {
+			ra->len += res;
+		}
+		g_cond_broadcast (ra->cond);
+	}
+	g_mutex_unlock (ra->mutex);
+
+	return NULL;
+}
+
+static gint
+xmms_file_readahead_read (xmms_file_readahead_t *ra, guchar *buffer, gint len,
+                          xmms_error_t *error)
+{
+	gint64 end;
+	gsize off, first;
+	gint ret;
+
+	g_mutex_lock (ra->mutex);
+
+	while ((end = ra->start + ra->len) <= ra->pos && !ra->eof && !ra->error) {
+		g_cond_wait (ra->cond, ra->mutex);
+	}
+
+	if (end > ra->pos) {
+		ret = MIN (len, end - ra->pos);
+		off = ra->pos % ra->size;
+		first = MIN (ret, ra->size - off);
+		memcpy (buffer, ra->buf + off, first);
+		memcpy (buffer + first, ra->buf, ret - first);
+
+		/* the thread may be waiting for room in the window */
+		ra->pos += ret;
+		g_cond_broadcast (ra->cond);
+	} else if (ra->error) {
+		xmms_log_error ("errno(%d) %s", ra->error, strerror (ra->error));
+		xmms_error_set (error, XMMS_ERROR_GENERIC, strerror (ra->error));
+		ret = -1;
+	} else {
+		ret = 0;
+	}
+
+	g_mutex_unlock (ra->mutex);
+
+	return ret;
+}
+
+static gint64
+xmms_file_readahead_seek (xmms_file_readahead_t *ra, gint64 offset)
+{
+	g_mutex_lock (ra->mutex);
+
+	/* serve the seek from the window if possible, else start over */
+	if (offset < ra->start || offset > ra->start + ra->len) {
+		ra->start = offset;
+		ra->len = 0;
+		ra->eof = FALSE;
+		ra->error = 0;
+		ra->generation++;
+	}
+	ra->pos = offset;
+	g_cond_broadcast (ra->cond);
+
+	g_mutex_unlock (ra->mutex);
+
+	return offset;
+}
+
 static gint
 xmms_file_read (xmms_xform_t *xform, void *buffer, gint len, xmms_error_t *error)
 {
@@ -164,11 +447,35 @@ xmms_file_read (xmms_xform_t *xform, void *buffer, gint len, xmms_error_t *error
 	data = xmms_xform_private_data_get (xform);
 	g_return_val_if_fail (data, -1);
 
+	if (data->map) {
+		ret = MIN (len, MAX (data->size - data->mappos, 0));
+		memcpy (buffer, data->map + data->mappos, ret);
+		data->mappos += ret;
+		return ret;
+	}
+
+	if (data->ra) {
+		return xmms_file_readahead_read (data->ra, buffer, len, error);
+	}
+
 	ret = read (data->fd, buffer, len);
 
 	if (ret == -1) {
 		xmms_log_error ("errno(%d) %s", errno, strerror (errno));
 		xmms_error_set (error, XMMS_ERROR_GENERIC, strerror (errno));
+		return ret;
+	}
+
+	data->pos += ret;
+	data->sequential += ret;
+
+	/* this looks like playback rather than a metadata scan */
+	if (data->readahead > 0 && data->sequential >= data->readahead) {
+		data->ra = xmms_file_readahead_new (data->fd, data->readahead,
+		                                    data->pos);
+		if (!data->ra) {
+			data->readahead = 0;
+		}
 	}
 
 	return ret;
@@ -185,6 +492,35 @@ xmms_file_seek (xmms_xform_t *xform, gint64 offset, xmms_xform_seek_mode_t whenc
 	data = xmms_xform_private_data_get (xform);
 	g_return_val_if_fail (data, -1);
 
+	if (data->map || data->ra) {
+		gint64 pos = 0;
+
+		switch (whence) {
+			case XMMS_XFORM_SEEK_SET:
+				pos = offset;
+				break;
+			case XMMS_XFORM_SEEK_END:
+				pos = data->size + offset;
+				break;
+			case XMMS_XFORM_SEEK_CUR:
+				/* the position is only changed from this thread */
+				pos = (data->map ? data->mappos : data->ra->pos) + offset;
+				break;
+		}
+
+		if (pos < 0) {
+			xmms_error_set (error, XMMS_ERROR_INVAL, "Couldn't seek");
+			return -1;
+		}
+
+		if (data->map) {
+			data->mappos = pos;
+			return pos;
+		}
+
+		return xmms_file_readahead_seek (data->ra, pos);
+	}
+
 	switch (whence) {
 		case XMMS_XFORM_SEEK_SET:
 			w = SEEK_SET;
@@ -202,5 +538,9 @@ xmms_file_seek (xmms_xform_t *xform, gint64 offset, xmms_xform_seek_mode_t whenc
 		xmms_error_set (error, XMMS_ERROR_INVAL, "Couldn't seek");
 		return -1;
 	}
+
+	data->pos = res;
+	data->sequential = 0;
+
 	return res;
 }
@@ -112,8 +112,7 @@ xmms_m3u_browse (xmms_xform_t *xform,
                  const gchar *url,
                  xmms_error_t *error)
 {
-	gchar line[XMMS_XFORM_MAX_LINE_SIZE];
-	gchar *tmp;
+	gchar *line, *tmp;
 	gchar *title = NULL;
 	const gchar *d;
 
@@ -121,7 +120,8 @@ xmms_m3u_browse (xmms_xform_t *xform,
 
 	xmms_error_reset (error);
 
-	if (!xmms_xform_read_line (xform, line, error)) {
+	line = xmms_xform_read_line_view (xform, error);
+	if (!line) {
 		XMMS_DBG ("Error reading m3u-file");
 		return FALSE;
 	}
@@ -148,7 +148,7 @@ xmms_m3u_browse (xmms_xform_t *xform,
 			g_free (tmp);
 		}
 
-	} while (xmms_xform_read_line (xform, line, error));
+	} while ((line = xmms_xform_read_line_view (xform, error)));
 
 	g_free (title);
 
@@ -127,7 +127,7 @@ xmms_pls_add_entry (xmms_xform_t *xform,
 static gboolean
 xmms_pls_browse (xmms_xform_t *xform, const char *url, xmms_error_t *error)
 {
-	gchar buffer[XMMS_XFORM_MAX_LINE_SIZE];
+	gchar *buffer;
 	gint num = -1;
 	gchar **val;
 	const gchar *plspath;
@@ -139,7 +139,8 @@ xmms_pls_browse (xmms_xform_t *xform, const char *url, xmms_error_t *error)
 
 	plspath = xmms_xform_get_url (xform);
 
-	if (!xmms_xform_read_line (xform, buffer, error)) {
+	buffer = xmms_xform_read_line_view (xform, error);
+	if (!buffer) {
 		XMMS_DBG ("Error reading pls-file");
 		return FALSE;
 	}
@@ -155,7 +156,7 @@ xmms_pls_browse (xmms_xform_t *xform, const char *url, xmms_error_t *error)
 	memset (&entry, 0, sizeof (entry));
 	entry.num=-1;
 
-	while (xmms_xform_read_line (xform, buffer, error)) {
+	while ((buffer = xmms_xform_read_line_view (xform, error))) {
 		gchar *np, *ep;
 
 		if (g_ascii_strncasecmp (buffer, "File", 4) == 0) {
@@ -28,9 +28,6 @@
 #include <stdlib.h>
 #include <string.h>
 
-typedef void (*xmms_replaygain_apply_func_t)
-	(void *buf, gint len, gfloat gain);
-
 /**
  * Replaygain modes.
  */
@@ -47,7 +44,7 @@ typedef struct xmms_replaygain_data_St {
 	gfloat gain;
 	gboolean has_replaygain;
 	gboolean enabled;
-	xmms_replaygain_apply_func_t apply;
+	xmms_sample_format_t format;
 } xmms_replaygain_data_t;
 
 static const xmms_sample_format_t formats[] = {
@@ -74,15 +71,6 @@ static void xmms_replaygain_config_changed (xmms_object_t *obj, xmmsv_t *_val, g
 static void compute_gain (xmms_xform_t *xform, xmms_replaygain_data_t *data);
 static xmms_replaygain_mode_t parse_mode (const char *s);
 
-static void apply_s8 (void *buf, gint len, gfloat gain);
-static void apply_u8 (void *buf, gint len, gfloat gain);
-static void apply_s16 (void *buf, gint len, gfloat gain);
-static void apply_u16 (void *buf, gint len, gfloat gain);
-static void apply_s32 (void *buf, gint len, gfloat gain);
-static void apply_u32 (void *buf, gint len, gfloat gain);
-static void apply_float (void *buf, gint len, gfloat gain);
-static void apply_double (void *buf, gint len, gfloat gain);
-
 /*
  * Plugin header
  */
@@ -136,7 +124,6 @@ xmms_replaygain_init (xmms_xform_t *xform)
 {
 	xmms_replaygain_data_t *data;
 	xmms_config_property_t *cfgv;
-	xmms_sample_format_t fmt;
 
 	g_return_val_if_fail (xform, FALSE);
 
@@ -177,40 +164,8 @@ xmms_replaygain_init (xmms_xform_t *xform)
 
 	compute_gain (xform, data);
 
-	fmt = xmms_xform_indata_get_int (xform, XMMS_STREAM_TYPE_FMT_FORMAT);
-
-	switch (fmt) {
-		case XMMS_SAMPLE_FORMAT_S8:
-			data->apply = apply_s8;
-			break;
-		case XMMS_SAMPLE_FORMAT_U8:
-			data->apply = apply_u8;
-			break;
-		case XMMS_SAMPLE_FORMAT_S16:
-			data->apply = apply_s16;
-			break;
-		case XMMS_SAMPLE_FORMAT_U16:
-			data->apply = apply_u16;
-			break;
-		case XMMS_SAMPLE_FORMAT_S32:
-			data->apply = apply_s32;
-			break;
-		case XMMS_SAMPLE_FORMAT_U32:
-			data->apply = apply_u32;
-			break;
-		case XMMS_SAMPLE_FORMAT_FLOAT:
-			data->apply = apply_float;
-			break;
-		case XMMS_SAMPLE_FORMAT_DOUBLE:
-			data->apply = apply_double;
-			break;
-		default:
-			/* we shouldn't ever get here, since we told the daemon
-			 * earlier about this list of supported formats.
-			 */
-			g_assert_not_reached ();
-			break;
-	}
+	data->format = xmms_xform_indata_get_int (xform,
+	                                          XMMS_STREAM_TYPE_FMT_FORMAT);
 
 	return TRUE;
 }
@@ -246,7 +201,6 @@ xmms_replaygain_read (xmms_xform_t *xform, xmms_sample_t *buf, gint len,
                       xmms_error_t *error)
 {
 	xmms_replaygain_data_t *data;
-	xmms_sample_format_t fmt;
 	gint read;
 
 	g_return_val_if_fail (xform, -1);
@@ -256,14 +210,13 @@ xmms_replaygain_read (xmms_xform_t *xform, xmms_sample_t *buf, gint len,
 
 	read = xmms_xform_read (xform, buf, len, error);
 
-	if (!data->has_replaygain || !data->enabled) {
+	if (read <= 0 || !data->has_replaygain || !data->enabled) {
 		return read;
 	}
 
-	fmt = xmms_xform_indata_get_int (xform, XMMS_STREAM_TYPE_FMT_FORMAT);
-	len /= xmms_sample_size_get (fmt);
-
-	data->apply (buf, len, data->gain);
+	xmms_sample_gain_apply (data->format, buf,
+	                        read / xmms_sample_size_get (data->format),
+	                        data->gain);
 
 	return read;
 }
@@ -362,101 +315,3 @@ parse_mode (const char *s)
 		return XMMS_REPLAYGAIN_MODE_TRACK;
 	}
 }
-
-static void
-apply_s8 (void *buf, gint len, gfloat gain)
-{
-	xmms_samples8_t *samples = (xmms_samples8_t *) buf;
-	gint i;
-
-	for (i = 0; i < len; i++) {
-		gfloat sample = samples[i] * gain;
-		samples[i] = CLAMP (sample, XMMS_SAMPLES8_MIN,
-		                    XMMS_SAMPLES8_MAX);
-	}
-}
-
-static void
-apply_u8 (void *buf, gint len, gfloat gain)
-{
-	xmms_sampleu8_t *samples = (xmms_sampleu8_t *) buf;
-	gint i;
-
-	for (i = 0; i < len; i++) {
-		gfloat sample = samples[i] * gain;
-		samples[i] = CLAMP (sample, 0, XMMS_SAMPLEU8_MAX);
-	}
-}
-
-static void
-apply_s16 (void *buf, gint len, gfloat gain)
-{
-	xmms_samples16_t *samples = (xmms_samples16_t *) buf;
-	gint i;
-
-	for (i = 0; i < len; i++) {
-		gfloat sample = samples[i] * gain;
-		samples[i] = CLAMP (sample, XMMS_SAMPLES16_MIN,
-		                    XMMS_SAMPLES16_MAX);
-	}
-}
-
-static void
-apply_u16 (void *buf, gint len, gfloat gain)
-{
-	xmms_sampleu16_t *samples = (xmms_sampleu16_t *) buf;
-	gint i;
-
-	for (i = 0; i < len; i++) {
-		gfloat sample = samples[i] * gain;
-		samples[i] = CLAMP (sample, 0, XMMS_SAMPLEU16_MAX);
-	}
-}
-
-static void
-apply_s32 (void *buf, gint len, gfloat gain)
-{
-	xmms_samples32_t *samples = (xmms_samples32_t *) buf;
-	gint i;
-
-	for (i = 0; i < len; i++) {
-		gdouble sample = samples[i] * gain;
-		samples[i] = CLAMP (sample, XMMS_SAMPLES32_MIN,
-		                    XMMS_SAMPLES32_MAX);
-	}
-}
-
-static void
-apply_u32 (void *buf, gint len, gfloat gain)
-{
-	xmms_sampleu32_t *samples = (xmms_sampleu32_t *) buf;
-	gint i;
-
-	for (i = 0; i < len; i++) {
-		gdouble sample = samples[i] * gain;
-		samples[i] = CLAMP (sample, 0, XMMS_SAMPLEU32_MAX);
-	}
-}
-
-static void
-apply_float (void *buf, gint len, gfloat gain)
-{
-	xmms_samplefloat_t *samples = (xmms_samplefloat_t *) buf;
-	gint i;
-
-	for (i = 0; i < len; i++) {
-		samples[i] *= gain;
-	}
-}
-
-static void
-apply_double (void *buf, gint len, gfloat gain)
-{
-	xmms_sampledouble_t *samples = (xmms_sampledouble_t *) buf;
-	gint i;
-
-	for (i = 0; i < len; i++) {
-		samples[i] *= gain;
-	}
-}
-
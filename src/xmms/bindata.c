@@ -15,11 +15,13 @@
  */
 
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <sys/time.h>
+#include <sys/stat.h>
 #include <errno.h>
 
 #include "xmmsc/xmmsc_idnumbers.h"
@@ -36,10 +38,42 @@
 #include "xmmspriv/xmms_config.h"
 #include "xmmspriv/xmms_bindata.h"
 #include "xmmspriv/xmms_utils.h"
+#include "xmmspriv/xmms_thumbnail.h"
+
+/* Recently retrieved blobs are kept in memory, most recently used first.
+ * Blobs larger than a quarter of the cache are always read from disk so
+ * that a single large file can not flush the cover art of a whole album
+ * list. */
+#define XMMS_BINDATA_CACHE_SIZE "8388608"
+#define XMMS_BINDATA_CACHE_MAX_FRACTION 4
+
+/* Thumbnails are stored as <hash>-<size> in a sub directory of the
+ * bindata directory, for the smallest of these sizes that fits the
+ * request. Larger requests are served the original, and so are
+ * requests for which an empty thumbnail marks the blob as not
+ * scalable. */
+#define XMMS_BINDATA_THUMBNAIL_DIR "thumbnails"
+static const gint xmms_bindata_thumbnail_sizes[] = { 64, 128, 256, 512 };
+
+typedef struct xmms_bindata_cache_entry_St {
+	gchar *hash;
+	guchar *data;
+	gsize len;
+	GList *link;
+} xmms_bindata_cache_entry_t;
 
 struct xmms_bindata_St {
 	xmms_object_t obj;
 	const gchar *bindir;
+
+	GMutex *cache_lock;
+	/* hash -> xmms_bindata_cache_entry_t */
+	GHashTable *cache;
+	GQueue *cache_order;
+	gsize cache_used;
+	gsize cache_size;
+	/* bumped on removal, so blobs read before it are not cached */
+	guint cache_generation;
 };
 
 static xmms_bindata_t *global_bindata;
@@ -65,10 +99,16 @@ static gchar *xmms_bindata_build_path (xmms_bindata_t *bindata, const gchar *has
 
 static gchar *xmms_bindata_client_add (xmms_bindata_t *bindata, GString *data, xmms_error_t *err);
 static xmmsv_t *xmms_bindata_client_retrieve (xmms_bindata_t *bindata, const gchar *hash, xmms_error_t *err);
+static xmmsv_t *xmms_bindata_client_retrieve_range (xmms_bindata_t *bindata, const gchar *hash, gint32 offset, gint32 length, xmms_error_t *err);
+static xmmsv_t *xmms_bindata_client_retrieve_thumbnail (xmms_bindata_t *bindata, const gchar *hash, gint32 size, xmms_error_t *err);
 static void xmms_bindata_client_remove (xmms_bindata_t *bindata, const gchar *hash, xmms_error_t *);
 static xmmsv_t *xmms_bindata_client_list (xmms_bindata_t *bindata, xmms_error_t *err);
 static gboolean _xmms_bindata_add (xmms_bindata_t *bindata, const guchar *data, gsize len, gchar hash[33], xmms_error_t *err);
 
+static void xmms_bindata_cache_entry_free (gpointer data);
+static void xmms_bindata_cache_trim (xmms_bindata_t *bindata, gsize size);
+static void on_bindata_cache_size_changed (xmms_object_t *object, xmmsv_t *data, gpointer udata);
+
 #include "bindata_ipc.c"
 
 xmms_bindata_t *
@@ -88,12 +128,30 @@ xmms_bindata_init ()
 
 	obj->bindir = xmms_config_property_get_string (cv);
 
+	obj->cache_lock = g_mutex_new ();
+	obj->cache = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+	                                    xmms_bindata_cache_entry_free);
+	obj->cache_order = g_queue_new ();
+
+	cv = xmms_config_property_register ("bindata.cache_size",
+	                                    XMMS_BINDATA_CACHE_SIZE,
+	                                    on_bindata_cache_size_changed, obj);
+	obj->cache_size = MAX (0, xmms_config_property_get_int (cv));
+
 	if (!g_file_test (obj->bindir, G_FILE_TEST_IS_DIR)) {
 		if (g_mkdir_with_parents (obj->bindir, 0755) == -1) {
 			xmms_log_error ("Couldn't create bindir %s", obj->bindir);
 		}
 	}
 
+	tmp = xmms_bindata_build_path (obj, XMMS_BINDATA_THUMBNAIL_DIR);
+	if (!g_file_test (tmp, G_FILE_TEST_IS_DIR)) {
+		if (g_mkdir_with_parents (tmp, 0755) == -1) {
+			xmms_log_error ("Couldn't create thumbnail dir %s", tmp);
+		}
+	}
+	g_free (tmp);
+
 	global_bindata = obj;
 
 	return obj;
@@ -102,9 +160,147 @@ xmms_bindata_init ()
 static void
 xmms_bindata_destroy (xmms_object_t *obj)
 {
+	xmms_bindata_t *bindata = (xmms_bindata_t *) obj;
+	xmms_config_property_t *cv;
+
 	XMMS_DBG ("Deactivating bindata object.");
 
 	xmms_bindata_unregister_ipc_commands ();
+
+	cv = xmms_config_lookup ("bindata.cache_size");
+	xmms_config_property_callback_remove (cv, on_bindata_cache_size_changed,
+	                                      bindata);
+
+	g_queue_free (bindata->cache_order);
+	g_hash_table_destroy (bindata->cache);
+	g_mutex_free (bindata->cache_lock);
+}
+
+static void
+xmms_bindata_cache_entry_free (gpointer data)
+{
+	xmms_bindata_cache_entry_t *entry = data;
+
+	g_free (entry->hash);
+	g_free (entry->data);
+	g_free (entry);
+}
+
+static void
+on_bindata_cache_size_changed (xmms_object_t *object, xmmsv_t *data,
+                               gpointer udata)
+{
+	xmms_bindata_t *bindata = udata;
+	gint value;
+
+	value = xmms_config_property_get_int ((xmms_config_property_t *) object);
+
+	g_mutex_lock (bindata->cache_lock);
+	bindata->cache_size = MAX (0, value);
+	xmms_bindata_cache_trim (bindata, bindata->cache_size);
+	g_mutex_unlock (bindata->cache_lock);
+}
+
+/**
+ * Evict the least recently used blobs until at most size bytes are
+ * cached. Must be called with the cache lock held.
+ */
+static void
+xmms_bindata_cache_trim (xmms_bindata_t *bindata, gsize size)
+{
+	xmms_bindata_cache_entry_t *entry;
+
+	while (bindata->cache_used > size) {
+		entry = g_queue_pop_tail (bindata->cache_order);
+		bindata->cache_used -= entry->len;
+		g_hash_table_remove (bindata->cache, entry->hash);
+	}
+}
+
+/**
+ * Copy a range of a cached blob into a new value.
+ *
+ * @param generation set to the cache generation, to be passed to
+ * #xmms_bindata_cache_put if the blob was not found.
+ * @returns the value, or NULL if the blob is not cached or the range
+ * starts past its end.
+ */
+static xmmsv_t *
+xmms_bindata_cache_get (xmms_bindata_t *bindata, const gchar *hash,
+                        gsize offset, gsize length, gboolean *found,
+                        guint *generation)
+{
+	xmms_bindata_cache_entry_t *entry;
+	xmmsv_t *res = NULL;
+
+	g_mutex_lock (bindata->cache_lock);
+
+	entry = g_hash_table_lookup (bindata->cache, hash);
+	*found = (entry != NULL);
+	*generation = bindata->cache_generation;
+
+	if (entry) {
+		g_queue_unlink (bindata->cache_order, entry->link);
+		g_queue_push_head_link (bindata->cache_order, entry->link);
+
+		if (offset <= entry->len) {
+			length = MIN (length, entry->len - offset);
+			res = xmmsv_new_bin (entry->data + offset, length);
+		}
+	}
+
+	g_mutex_unlock (bindata->cache_lock);
+
+	return res;
+}
+
+static void
+xmms_bindata_cache_put (xmms_bindata_t *bindata, const gchar *hash,
+                        const guchar *data, gsize len, guint generation)
+{
+	xmms_bindata_cache_entry_t *entry;
+
+	g_mutex_lock (bindata->cache_lock);
+
+	if (generation != bindata->cache_generation ||
+	    len > bindata->cache_size / XMMS_BINDATA_CACHE_MAX_FRACTION ||
+	    g_hash_table_lookup (bindata->cache, hash)) {
+		g_mutex_unlock (bindata->cache_lock);
+		return;
+	}
+
+	xmms_bindata_cache_trim (bindata, bindata->cache_size - len);
+
+	entry = g_new (xmms_bindata_cache_entry_t, 1);
+	entry->hash = g_strdup (hash);
+	entry->data = g_memdup (data, len);
+	entry->len = len;
+
+	g_queue_push_head (bindata->cache_order, entry);
+	entry->link = g_queue_peek_head_link (bindata->cache_order);
+	g_hash_table_insert (bindata->cache, entry->hash, entry);
+	bindata->cache_used += len;
+
+	g_mutex_unlock (bindata->cache_lock);
+}
+
+static void
+xmms_bindata_cache_remove (xmms_bindata_t *bindata, const gchar *hash)
+{
+	xmms_bindata_cache_entry_t *entry;
+
+	g_mutex_lock (bindata->cache_lock);
+
+	bindata->cache_generation++;
+
+	entry = g_hash_table_lookup (bindata->cache, hash);
+	if (entry) {
+		g_queue_delete_link (bindata->cache_order, entry->link);
+		bindata->cache_used -= entry->len;
+		g_hash_table_remove (bindata->cache, hash);
+	}
+
+	g_mutex_unlock (bindata->cache_lock);
 }
 
 gchar *
@@ -147,10 +343,8 @@ xmms_bindata_plugin_add (const guchar *data, gsize size, gchar hash[33])
 static gboolean
 _xmms_bindata_add (xmms_bindata_t *bindata, const guchar *data, gsize len, gchar hash[33], xmms_error_t *err)
 {
-	const guchar *ptr;
-	gsize left;
+	GError *error = NULL;
 	gchar *path;
-	FILE *fp;
 
 	xmms_bindata_calculate_md5 (data, len, hash);
 
@@ -163,38 +357,17 @@ _xmms_bindata_add (xmms_bindata_t *bindata, const guchar *data, gsize len, gchar
 	}
 
 	XMMS_DBG ("Creating %s", path);
-	fp = fopen (path, "wb");
-	if (!fp) {
-		xmms_log_error ("Couldn't create %s", path);
+
+	/* written to a temporary file and renamed, so a blob that is being
+	 * added is never mapped or cached half written */
+	if (!g_file_set_contents (path, (const gchar *) data, len, &error)) {
+		xmms_log_error ("Couldn't create %s: %s", path, error->message);
 		xmms_error_set (err, XMMS_ERROR_GENERIC, "Couldn't create file on server!");
+		g_error_free (error);
 		g_free (path);
 		return FALSE;
 	}
 
-	/* write the data to the file */
-	ptr = data;
-	left = len;
-
-	while (left > 0) {
-		size_t w;
-
-		w = fwrite (ptr, 1, left, fp);
-		if (!w && ferror (fp)) {
-			fclose (fp);
-			unlink (path);
-
-			xmms_log_error ("Couldn't write data");
-			xmms_error_set (err, XMMS_ERROR_GENERIC,
-			                "Couldn't write data!");
-			g_free (path);
-			return FALSE;
-		}
-
-		left -= w;
-		ptr += w;
-	}
-
-	fclose (fp);
 	g_free (path);
 
 	return TRUE;
@@ -209,48 +382,206 @@ xmms_bindata_client_add (xmms_bindata_t *bindata, GString *data, xmms_error_t *e
 	return NULL;
 }
 
+/**
+ * Serve a range of a blob, from the cache if possible.
+ *
+ * Blobs are mapped rather than read, so only the pages of the requested
+ * range are touched. Only blobs retrieved as a whole are cached.
+ */
 static xmmsv_t *
-xmms_bindata_client_retrieve (xmms_bindata_t *bindata, const gchar *hash,
-                              xmms_error_t *err)
+xmms_bindata_retrieve (xmms_bindata_t *bindata, const gchar *hash,
+                       gsize offset, gsize length, xmms_error_t *err)
 {
+	GMappedFile *file;
+	GError *error = NULL;
+	const guchar *data;
+	gboolean found;
+	guint generation;
 	xmmsv_t *res;
 	gchar *path;
-	GString *str;
-	FILE *fp;
+	gsize len;
+
+	res = xmms_bindata_cache_get (bindata, hash, offset, length,
+	                              &found, &generation);
+	if (found) {
+		if (!res) {
+			xmms_error_set (err, XMMS_ERROR_INVAL, "Offset out of range");
+		}
+		return res;
+	}
 
 	path = xmms_bindata_build_path (bindata, hash);
+	file = g_mapped_file_new (path, FALSE, &error);
+	g_free (path);
 
-	fp = fopen (path, "rb");
-	if (!fp) {
-		xmms_log_error ("Requesting '%s' which is not on the server", hash);
-		xmms_error_set (err, XMMS_ERROR_NOENT, "File not found!");
-		g_free (path);
+	if (!file) {
+		if (g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT)) {
+			xmms_log_error ("Requesting '%s' which is not on the server", hash);
+			xmms_error_set (err, XMMS_ERROR_NOENT, "File not found!");
+		} else {
+			xmms_log_error ("Error reading bindata '%s': %s", hash, error->message);
+			xmms_error_set (err, XMMS_ERROR_GENERIC, "Error reading file");
+		}
+		g_error_free (error);
 		return NULL;
 	}
 
-	g_free (path);
+	/* empty files are not mapped */
+	data = (const guchar *) g_mapped_file_get_contents (file);
+	len = g_mapped_file_get_length (file);
+	if (!data) {
+		data = (const guchar *) "";
+	}
 
-	str = g_string_new (NULL);
-	while (!feof (fp)) {
-		gchar buf[1024];
-		gint l;
+	if (offset > len) {
+		xmms_error_set (err, XMMS_ERROR_INVAL, "Offset out of range");
+		g_mapped_file_free (file);
+		return NULL;
+	}
 
-		l = fread (buf, 1, 1024, fp);
-		if (ferror (fp)) {
-			g_string_free (str, TRUE);
-			xmms_log_error ("Error reading bindata '%s'", hash);
-			xmms_error_set (err, XMMS_ERROR_GENERIC, "Error reading file");
-			fclose (fp);
-			return NULL;
+	if (offset == 0 && length >= len) {
+		xmms_bindata_cache_put (bindata, hash, data, len, generation);
+	}
+
+	length = MIN (length, len - offset);
+	res = xmmsv_new_bin (data + offset, length);
+
+	g_mapped_file_free (file);
+
+	return res;
+}
+
+static xmmsv_t *
+xmms_bindata_client_retrieve (xmms_bindata_t *bindata, const gchar *hash,
+                              xmms_error_t *err)
+{
+	return xmms_bindata_retrieve (bindata, hash, 0, G_MAXSIZE, err);
+}
+
+static xmmsv_t *
+xmms_bindata_client_retrieve_range (xmms_bindata_t *bindata,
+                                    const gchar *hash, gint32 offset,
+                                    gint32 length, xmms_error_t *err)
+{
+	if (offset < 0 || length < 0) {
+		xmms_error_set (err, XMMS_ERROR_INVAL, "Invalid range");
+		return NULL;
+	}
+
+	return xmms_bindata_retrieve (bindata, hash, offset, length, err);
+}
+
+/**
+ * Round a requested thumbnail size up to one of the stored sizes.
+ *
+ * @returns the size, or 0 if the original should be served.
+ */
+static gint
+xmms_bindata_thumbnail_size (gint32 size)
+{
+	gint i;
+
+	if (size <= 0) {
+		return 0;
+	}
+
+	for (i = 0; i < G_N_ELEMENTS (xmms_bindata_thumbnail_sizes); i++) {
+		if (size <= xmms_bindata_thumbnail_sizes[i]) {
+			return xmms_bindata_thumbnail_sizes[i];
 		}
-		g_string_append_len (str, buf, l);
 	}
 
-	fclose (fp);
+	return 0;
+}
+
+static gchar *
+xmms_bindata_thumbnail_name (const gchar *hash, gint size)
+{
+	return g_strdup_printf (XMMS_BINDATA_THUMBNAIL_DIR G_DIR_SEPARATOR_S "%s-%d",
+	                        hash, size);
+}
+
+/**
+ * Scale the original blob and store the result as thumbnail. If the
+ * blob can not be scaled an empty thumbnail is stored instead, so that
+ * later requests are served the original without trying again.
+ *
+ * @returns TRUE if a thumbnail was stored.
+ */
+static gboolean
+xmms_bindata_thumbnail_create (xmms_bindata_t *bindata, const gchar *hash,
+                               const gchar *path, gint size)
+{
+	gchar *original, *thumbnail = NULL;
+	gsize thumbnail_len = 0;
+	gboolean ret;
+
+	original = xmms_bindata_build_path (bindata, hash);
+
+	if (!g_file_test (original, G_FILE_TEST_IS_REGULAR)) {
+		g_free (original);
+		return FALSE;
+	}
+
+	ret = xmms_thumbnail_scale (original, size, &thumbnail, &thumbnail_len);
+	g_free (original);
+
+	if (!ret) {
+		thumbnail_len = 0;
+	}
+
+	/* written to a temporary file and renamed, so concurrent requests
+	 * never see a partial thumbnail */
+	if (!g_file_set_contents (path, ret ? thumbnail : "", thumbnail_len, NULL)) {
+		xmms_log_error ("Couldn't write thumbnail %s", path);
+		ret = FALSE;
+	}
+
+	g_free (thumbnail);
+
+	return ret;
+}
+
+static xmmsv_t *
+xmms_bindata_client_retrieve_thumbnail (xmms_bindata_t *bindata,
+                                        const gchar *hash, gint32 size,
+                                        xmms_error_t *err)
+{
+	gboolean found, exists;
+	guint generation;
+	gchar *name, *path;
+	struct stat st;
+	xmmsv_t *res;
+
+	size = xmms_bindata_thumbnail_size (size);
+	if (!size) {
+		return xmms_bindata_retrieve (bindata, hash, 0, G_MAXSIZE, err);
+	}
+
+	name = xmms_bindata_thumbnail_name (hash, size);
+
+	res = xmms_bindata_cache_get (bindata, name, 0, G_MAXSIZE,
+	                              &found, &generation);
+	if (found) {
+		g_free (name);
+		return res;
+	}
+
+	path = xmms_bindata_build_path (bindata, name);
+	if (g_stat (path, &st) == 0) {
+		exists = st.st_size > 0;
+	} else {
+		exists = xmms_bindata_thumbnail_create (bindata, hash, path, size);
+	}
+	g_free (path);
 
-	res = xmmsv_new_bin ((unsigned char *)str->str, str->len);
+	if (exists) {
+		res = xmms_bindata_retrieve (bindata, name, 0, G_MAXSIZE, err);
+	} else {
+		res = xmms_bindata_retrieve (bindata, hash, 0, G_MAXSIZE, err);
+	}
 
-	g_string_free (str, TRUE);
+	g_free (name);
 
 	return res;
 }
@@ -259,12 +590,26 @@ static void
 xmms_bindata_client_remove (xmms_bindata_t *bindata, const gchar *hash,
                             xmms_error_t *err)
 {
-	gchar *path;
+	gchar *path, *name;
+	gint i;
+
+	xmms_bindata_cache_remove (bindata, hash);
+
 	path = xmms_bindata_build_path (bindata, hash);
 	if (unlink (path) == -1) {
 		xmms_error_set (err, XMMS_ERROR_GENERIC, "Couldn't remove file");
 	}
 	g_free (path);
+
+	for (i = 0; i < G_N_ELEMENTS (xmms_bindata_thumbnail_sizes); i++) {
+		name = xmms_bindata_thumbnail_name (hash, xmms_bindata_thumbnail_sizes[i]);
+		xmms_bindata_cache_remove (bindata, name);
+
+		path = xmms_bindata_build_path (bindata, name);
+		unlink (path);
+		g_free (path);
+		g_free (name);
+	}
 	return;
 }
 
@@ -289,6 +634,9 @@ xmms_bindata_client_list (xmms_bindata_t *bindata, xmms_error_t *err)
 	entries = xmmsv_new_list ();
 
 	while ((file = g_dir_read_name (dir))) {
+		if (strcmp (file, XMMS_BINDATA_THUMBNAIL_DIR) == 0) {
+			continue;
+		}
 		xmmsv_list_append_string (entries, file);
 	}
 
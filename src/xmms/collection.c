@@ -143,6 +143,9 @@ xmms_collection_changed_msg_send (xmms_coll_dag_t *colldag, xmmsv_t *dict)
 	                  dict);
 }
 
+/** Number of playlist entries imported per medialib transaction */
+#define XMMS_COLLECTION_IMPORT_CHUNK 256
+
 #define XMMS_COLLECTION_CHANGED_MSG(type, name, namespace) xmms_collection_changed_msg_send (dag, xmms_collection_changed_msg_new (type, name, namespace))
 
 
@@ -233,10 +236,15 @@ xmms_collection_client_idlist_from_playlist (xmms_coll_dag_t *dag,
 	xmms_stream_type_t *stream_type;
 	xmms_xform_t *xform;
 	GList *stream_types;
+	xmms_medialib_session_t *session;
+	xmms_medialib_entry_t *entries;
 	xmmsv_coll_t *coll;
 	xmmsv_t *list;
 	xmmsv_list_iter_t *it;
+	GPtrArray *paths, *dicts;
+	const gchar **urls;
 	const gchar* src;
+	guint i, start, count;
 
 	stream_type = _xmms_stream_type_new (XMMS_STREAM_TYPE_BEGIN,
 	                                     XMMS_STREAM_TYPE_MIMETYPE,
@@ -258,16 +266,16 @@ xmms_collection_client_idlist_from_playlist (xmms_coll_dag_t *dag,
 		return NULL;
 	}
 
-	coll = xmmsv_coll_new (XMMS_COLLECTION_TYPE_IDLIST);
 	src = "plugin/playlist";
 
+	/* strip the path keys so only metadata is left in the dicts */
+	paths = g_ptr_array_new ();
+	dicts = g_ptr_array_new ();
+
 	xmmsv_get_list_iter (list, &it);
 
 	while (xmmsv_list_iter_valid (it)) {
-		xmms_medialib_session_t *session;
-		xmms_medialib_entry_t entry;
 		xmmsv_t *dict, *value;
-		const gchar *realpath;
 
 		xmmsv_list_iter_entry (it, &dict);
 		xmmsv_list_iter_next (it);
@@ -277,30 +285,63 @@ xmms_collection_client_idlist_from_playlist (xmms_coll_dag_t *dag,
 			continue;
 		}
 
-		xmmsv_get_string (value, &realpath);
+		g_ptr_array_add (paths, xmmsv_ref (value));
+		g_ptr_array_add (dicts, dict);
+
 		xmmsv_dict_remove (dict, "realpath");
 		xmmsv_dict_remove (dict, "path");
+	}
+
+	urls = g_new (const gchar *, paths->len);
+	for (i = 0; i < paths->len; i++) {
+		xmmsv_get_string (g_ptr_array_index (paths, i), &urls[i]);
+	}
+
+	entries = g_new0 (xmms_medialib_entry_t, paths->len);
+
+	/* resolve and create the entries in bounded chunks so that a
+	 * conflicting commit only has to redo its own chunk */
+	for (start = 0; start < paths->len; start += count) {
+		count = MIN (paths->len - start, XMMS_COLLECTION_IMPORT_CHUNK);
 
 		do {
 			session = xmms_medialib_session_begin (dag->medialib);
-			entry = xmms_medialib_entry_new_encoded (session, realpath, err);
+			xmms_medialib_entry_new_encoded_many (session, urls + start, count,
+			                                      entries + start, err);
 
-			if (entry) {
+			for (i = start; i < start + count; i++) {
 				add_metadata_from_tree_user_data_t udata;
-				udata.entry = entry;
-				udata.src = src;
-				udata.session = session;
 
+				if (!entries[i]) {
+					continue;
+				}
 
-				xmmsv_dict_foreach (dict, add_metadata_from_tree, &udata);
+				udata.entry = entries[i];
+				udata.src = src;
+				udata.session = session;
 
-				xmmsv_coll_idlist_append (coll, entry);
-			} else {
-				xmms_log_error ("couldn't add %s to collection!", realpath);
+				xmmsv_dict_foreach (g_ptr_array_index (dicts, i),
+				                    add_metadata_from_tree, &udata);
 			}
 		} while (!xmms_medialib_session_commit (session));
 	}
 
+	coll = xmmsv_coll_new (XMMS_COLLECTION_TYPE_IDLIST);
+
+	for (i = 0; i < paths->len; i++) {
+		if (entries[i]) {
+			xmmsv_coll_idlist_append (coll, entries[i]);
+		} else {
+			xmms_log_error ("couldn't add %s to collection!", urls[i]);
+		}
+		xmmsv_unref (g_ptr_array_index (paths, i));
+	}
+
+	g_free (entries);
+	g_free (urls);
+	g_ptr_array_free (dicts, TRUE);
+	g_ptr_array_free (paths, TRUE);
+
 	xmmsv_unref (list);
 
 	xmms_object_unref (xform);
@@ -0,0 +1,94 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2012 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include "xmmspriv/xmms_thumbnail.h"
+#include "xmms/xmms_log.h"
+
+/* Images with more pixels than this are never decoded */
+#define XMMS_THUMBNAIL_MAX_PIXELS (4096 * 4096)
+
+static gpointer
+xmms_thumbnail_type_init (gpointer data)
+{
+	g_type_init ();
+	return NULL;
+}
+
+/**
+ * Scale an image file down so that neither side is larger than size.
+ *
+ * Only the header is read to decide whether the image needs scaling,
+ * and images larger than XMMS_THUMBNAIL_MAX_PIXELS are refused before
+ * they are decoded. Images with an alpha channel are encoded as PNG,
+ * everything else as JPEG.
+ *
+ * @returns FALSE if the image could not be decoded, already fits or is
+ * too large.
+ */
+gboolean
+xmms_thumbnail_scale (const gchar *path, gint size,
+                      gchar **thumbnail, gsize *thumbnail_len)
+{
+	static GOnce type_init = G_ONCE_INIT;
+	GdkPixbuf *scaled;
+	GError *error = NULL;
+	gint width, height;
+	gboolean ret;
+
+	g_once (&type_init, xmms_thumbnail_type_init, NULL);
+
+	if (!gdk_pixbuf_get_file_info (path, &width, &height)) {
+		XMMS_DBG ("Couldn't identify image %s", path);
+		return FALSE;
+	}
+
+	if (width <= size && height <= size) {
+		return FALSE;
+	}
+
+	if ((gint64) width * height > XMMS_THUMBNAIL_MAX_PIXELS) {
+		XMMS_DBG ("Not scaling %s, %dx%d is too large", path, width, height);
+		return FALSE;
+	}
+
+	/* scaled while decoding, keeping the aspect ratio */
+	scaled = gdk_pixbuf_new_from_file_at_size (path, size, size, &error);
+	if (!scaled) {
+		XMMS_DBG ("Couldn't decode image: %s", error->message);
+		g_error_free (error);
+		return FALSE;
+	}
+
+	if (gdk_pixbuf_get_has_alpha (scaled)) {
+		ret = gdk_pixbuf_save_to_buffer (scaled, thumbnail, thumbnail_len,
+		                                 "png", &error, NULL);
+	} else {
+		ret = gdk_pixbuf_save_to_buffer (scaled, thumbnail, thumbnail_len,
+		                                 "jpeg", &error, "quality", "90",
+		                                 NULL);
+	}
+
+	if (!ret) {
+		xmms_log_error ("Couldn't encode thumbnail: %s", error->message);
+		g_error_free (error);
+	}
+
+	g_object_unref (scaled);
+
+	return ret;
+}
@@ -21,6 +21,7 @@
 #include "xmms/xmms_config.h"
 #include "xmmspriv/xmms_thread_name.h"
 #include "xmmspriv/xmms_ipc.h"
+#include "xmmspriv/xmms_stats.h"
 #include "xmmsc/xmmsc_ipc_msg.h"
 
 
@@ -50,6 +51,7 @@ struct xmms_ipc_St {
 	xmms_ipc_transport_t *transport;
 	GList *clients;
 	GIOChannel *chan;
+	GSource *source;
 	GMutex *mutex_lock;
 	xmms_object_t **objects;
 	xmms_object_t **signals;
@@ -59,47 +61,135 @@ struct xmms_ipc_St {
 
 /**
  * A IPC client representation.
+ *
+ * All clients are read and written from the single I/O thread, their
+ * commands are executed on the worker pool. A client is referenced by
+ * its read watch, by a pending write watch and by a worker while it
+ * has commands queued.
  */
 typedef struct xmms_ipc_client_St {
-	GMainLoop *ml;
+	gint ref;
+
 	GIOChannel *iochan;
 
 	xmms_ipc_transport_t *transport;
 	xmms_ipc_msg_t *read_msg;
 	xmms_ipc_t *ipc;
 
-	/* this lock protects out_msg, pendingsignals and broadcasts,
-	   which can be accessed from other threads than the
-	   client-thread */
+	/* this lock protects out_msg, in_msg, busy, disconnected,
+	   pendingsignals and broadcasts, which can be accessed from
+	   other threads than the I/O thread */
 	GMutex *lock;
 
 	/** Messages waiting to be written */
 	GQueue *out_msg;
 
+	/** Commands waiting to be executed, in the order they arrived */
+	GQueue *in_msg;
+	/** TRUE while a worker is executing the commands in in_msg */
+	gboolean busy;
+	gboolean disconnected;
+
+	/** Encoding of the values sent to the client, see xmms_ipc_wire_format_t,
+	    only accessed atomically */
+	gint wire_format;
+	/** TRUE if large messages may be passed to the client as a descriptor,
+	    only accessed atomically */
+	gint fd_payloads;
+
 	guint pendingsignals[XMMS_IPC_SIGNAL_END];
+	/** xmms_ipc_broadcast_t per broadcast the client subscribed to */
 	GList *broadcasts[XMMS_IPC_SIGNAL_END];
 } xmms_ipc_client_t;
 
+/**
+ * One key of a broadcast filter and the values accepted for it.
+ */
+typedef struct xmms_ipc_filter_field_St {
+	gchar *key;
+	GHashTable *ints;
+	GHashTable *strings;
+} xmms_ipc_filter_field_t;
+
+/**
+ * A broadcast subscription. Only broadcasts that match every field of
+ * the filter are sent, a subscription without fields gets everything.
+ */
+typedef struct xmms_ipc_broadcast_St {
+	guint cookie;
+	GList *filter;
+} xmms_ipc_broadcast_t;
+
 static GMutex *ipc_servers_lock;
 static GList *ipc_servers = NULL;
 
+/* default number of threads executing client commands */
+#define XMMS_IPC_WORKERS 4
+/* commands run for one client before the worker moves on to another */
+#define XMMS_IPC_WORKER_BATCH 16
+
+static GMainContext *ipc_io_context = NULL;
+static GMainLoop *ipc_io_loop = NULL;
+static GThread *ipc_io_thread = NULL;
+static GThreadPool *ipc_workers = NULL;
+static gint ipc_worker_count = XMMS_IPC_WORKERS;
+static gint ipc_workers_stopping = 0;
+
 static GMutex *ipc_object_pool_lock;
 static struct xmms_ipc_object_pool_t *ipc_object_pool = NULL;
 
-static void xmms_ipc_client_destroy (xmms_ipc_client_t *client);
+static void xmms_ipc_client_unref (xmms_ipc_client_t *client);
+static void xmms_ipc_io_stop (void);
+static void xmms_ipc_shutdown_servers (void);
 
 static void xmms_ipc_register_signal (xmms_ipc_client_t *client, xmms_ipc_msg_t *msg, xmmsv_t *arguments);
 static void xmms_ipc_register_broadcast (xmms_ipc_client_t *client, xmms_ipc_msg_t *msg, xmmsv_t *arguments);
 static gboolean xmms_ipc_client_msg_write (xmms_ipc_client_t *client, xmms_ipc_msg_t *msg);
 
 static void
-xmms_ipc_handle_cmd_value (xmms_ipc_msg_t *msg, xmmsv_t *val)
+xmms_ipc_handle_cmd_value (xmms_ipc_client_t *client, xmms_ipc_msg_t *msg,
+                           xmmsv_t *val)
 {
-	if (xmms_ipc_msg_put_value (msg, val) == (uint32_t) -1) {
+	uint32_t ret;
+
+	if (g_atomic_int_get (&client->wire_format) == XMMS_IPC_WIRE_COMPACT) {
+		ret = xmms_ipc_msg_put_value_compact (msg, val);
+	} else {
+		ret = xmms_ipc_msg_put_value (msg, val);
+	}
+
+	if (ret == (uint32_t) -1) {
 		xmms_log_error ("Failed to serialize the return value into the IPC message!");
 	}
 }
 
+static void
+xmms_ipc_set_wire_format (xmms_ipc_client_t *client, xmmsv_t *arguments)
+{
+	gint32 format;
+
+	if (!arguments || !xmmsv_list_get_int (arguments, 0, &format)) {
+		xmms_log_error ("No wire format in this msg?!");
+		return;
+	}
+
+	/* unknown formats leave the client with what it has */
+	if (format != XMMS_IPC_WIRE_LEGACY && format != XMMS_IPC_WIRE_COMPACT) {
+		return;
+	}
+
+	g_atomic_int_set (&client->wire_format, format);
+}
+
+static void
+xmms_ipc_set_fd_payloads (xmms_ipc_client_t *client)
+{
+	/* only local transports can pass descriptors */
+	if (client->transport->sendfd_func) {
+		g_atomic_int_set (&client->fd_payloads, TRUE);
+	}
+}
+
 static void
 xmms_ipc_register_signal (xmms_ipc_client_t *client,
                           xmms_ipc_msg_t *msg, xmmsv_t *arguments)
@@ -130,11 +220,151 @@ xmms_ipc_register_signal (xmms_ipc_client_t *client,
 	g_mutex_unlock (client->lock);
 }
 
+static void
+xmms_ipc_filter_field_free (xmms_ipc_filter_field_t *field)
+{
+	g_free (field->key);
+	g_hash_table_destroy (field->ints);
+	g_hash_table_destroy (field->strings);
+	g_free (field);
+}
+
+static void
+xmms_ipc_broadcast_free (xmms_ipc_broadcast_t *broadcast)
+{
+	while (broadcast->filter) {
+		xmms_ipc_filter_field_free (broadcast->filter->data);
+		broadcast->filter = g_list_delete_link (broadcast->filter,
+		                                        broadcast->filter);
+	}
+	g_free (broadcast);
+}
+
+static gboolean
+xmms_ipc_filter_field_add (xmms_ipc_filter_field_t *field, xmmsv_t *value)
+{
+	const gchar *str;
+	gint32 i;
+
+	if (xmmsv_get_int (value, &i)) {
+		g_hash_table_insert (field->ints, GINT_TO_POINTER (i), NULL);
+	} else if (xmmsv_get_string (value, &str)) {
+		g_hash_table_insert (field->strings, g_strdup (str), NULL);
+	} else {
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Turn the filter a client sent along with a broadcast subscription
+ * into hash sets, so each broadcast is matched in constant time.
+ *
+ * The filter is a dict mapping keys of the broadcast dict to an int or
+ * string, or a list of them. Broadcasts that are not dicts are matched
+ * against the key "value".
+ */
+static gboolean
+xmms_ipc_broadcast_filter_new (xmms_ipc_broadcast_t *broadcast,
+                               xmmsv_t *filter)
+{
+	xmms_ipc_filter_field_t *field;
+	xmmsv_dict_iter_t *it;
+	const gchar *key;
+	xmmsv_t *value, *item;
+	gboolean ret = TRUE;
+	gint i;
+
+	if (!xmmsv_get_dict_iter (filter, &it)) {
+		return FALSE;
+	}
+
+	for (; ret && xmmsv_dict_iter_pair (it, &key, &value);
+	     xmmsv_dict_iter_next (it)) {
+		field = g_new0 (xmms_ipc_filter_field_t, 1);
+		field->key = g_strdup (key);
+		field->ints = g_hash_table_new (NULL, NULL);
+		field->strings = g_hash_table_new_full (g_str_hash, g_str_equal,
+		                                        g_free, NULL);
+
+		broadcast->filter = g_list_prepend (broadcast->filter, field);
+
+		if (xmmsv_is_type (value, XMMSV_TYPE_LIST)) {
+			for (i = 0; ret && xmmsv_list_get (value, i, &item); i++) {
+				ret = xmms_ipc_filter_field_add (field, item);
+			}
+		} else {
+			ret = xmms_ipc_filter_field_add (field, value);
+		}
+	}
+
+	xmmsv_dict_iter_explicit_destroy (it);
+
+	return ret;
+}
+
+static gboolean
+xmms_ipc_filter_field_match (xmms_ipc_filter_field_t *field, xmmsv_t *value)
+{
+	const gchar *str;
+	xmmsv_t *item;
+	gint32 i;
+
+	if (xmmsv_get_int (value, &i)) {
+		return g_hash_table_lookup_extended (field->ints, GINT_TO_POINTER (i),
+		                                     NULL, NULL);
+	}
+
+	if (xmmsv_get_string (value, &str)) {
+		return g_hash_table_lookup_extended (field->strings, str, NULL, NULL);
+	}
+
+	/* lists match if any of their items does */
+	for (i = 0; xmmsv_list_get (value, i, &item); i++) {
+		if (xmms_ipc_filter_field_match (field, item)) {
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static gboolean
+xmms_ipc_broadcast_matches (xmms_ipc_broadcast_t *broadcast, xmmsv_t *value)
+{
+	xmms_ipc_filter_field_t *field;
+	xmmsv_t *fieldvalue;
+	GList *n;
+
+	for (n = broadcast->filter; n; n = g_list_next (n)) {
+		field = n->data;
+
+		if (xmmsv_is_type (value, XMMSV_TYPE_DICT)) {
+			if (!xmmsv_dict_get (value, field->key, &fieldvalue)) {
+				return FALSE;
+			}
+		} else if (strcmp (field->key, "value") == 0) {
+			fieldvalue = value;
+		} else {
+			return FALSE;
+		}
+
+		if (!xmms_ipc_filter_field_match (field, fieldvalue)) {
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
 static void
 xmms_ipc_register_broadcast (xmms_ipc_client_t *client,
                              xmms_ipc_msg_t *msg, xmmsv_t *arguments)
 {
-	xmmsv_t *arg;
+	xmms_ipc_broadcast_t *broadcast;
+	xmms_ipc_msg_t *retmsg;
+	xmmsv_t *arg, *filter, *error;
 	gint32 broadcastid;
 	int r;
 
@@ -155,21 +385,134 @@ xmms_ipc_register_broadcast (xmms_ipc_client_t *client,
 		return;
 	}
 
+	broadcast = g_new0 (xmms_ipc_broadcast_t, 1);
+	broadcast->cookie = xmms_ipc_msg_get_cookie (msg);
+
+	if (xmmsv_list_get (arguments, 1, &filter) &&
+	    !xmms_ipc_broadcast_filter_new (broadcast, filter)) {
+		xmms_ipc_broadcast_free (broadcast);
+
+		/* tell the client, or it would wait for broadcasts forever */
+		retmsg = xmms_ipc_msg_new (XMMS_IPC_OBJECT_SIGNAL, XMMS_IPC_CMD_ERROR);
+		error = xmmsv_new_error ("Invalid broadcast filter");
+		xmms_ipc_msg_put_value (retmsg, error);
+		xmmsv_unref (error);
+
+		xmms_ipc_msg_set_cookie (retmsg, xmms_ipc_msg_get_cookie (msg));
+		g_mutex_lock (client->lock);
+		xmms_ipc_client_msg_write (client, retmsg);
+		g_mutex_unlock (client->lock);
+		return;
+	}
+
 	g_mutex_lock (client->lock);
 	client->broadcasts[broadcastid] =
-		g_list_append (client->broadcasts[broadcastid],
-				GUINT_TO_POINTER (xmms_ipc_msg_get_cookie (msg)));
+		g_list_append (client->broadcasts[broadcastid], broadcast);
 
 	g_mutex_unlock (client->lock);
 }
 
+/**
+ * Look up the object and command and run it. Returns FALSE if there
+ * is no such command, in which case arg is left untouched.
+ */
+static gboolean
+xmms_ipc_cmd_exec (uint32_t objid, uint32_t cmdid, xmmsv_t *arguments,
+                   xmms_object_cmd_arg_t *arg)
+{
+	xmms_object_t *object;
+	gint64 start;
+
+	if (objid >= XMMS_IPC_OBJECT_END) {
+		xmms_log_error ("Bad object id (%d)", objid);
+		return FALSE;
+	}
+
+	g_mutex_lock (ipc_object_pool_lock);
+	object = ipc_object_pool->objects[objid];
+	g_mutex_unlock (ipc_object_pool_lock);
+	if (!object) {
+		xmms_log_error ("Object %d was not found!", objid);
+		return FALSE;
+	}
+
+	if (!g_tree_lookup (object->cmds, GUINT_TO_POINTER (cmdid))) {
+		xmms_log_error ("No such cmd %d on object %d", cmdid, objid);
+		return FALSE;
+	}
+
+	xmms_object_cmd_arg_init (arg);
+	arg->args = arguments;
+
+	start = xmms_stats_now ();
+	xmms_object_cmd_call (object, cmdid, arg);
+	xmms_stats_record_ipc (objid, cmdid, start);
+
+	return TRUE;
+}
+
+/**
+ * Run a batch of commands in order on behalf of one message.
+ *
+ * The single argument is a list of [object, command, arguments]
+ * entries. The reply is a list with one value per entry, the return
+ * value of the command or an error value if it failed. A failing
+ * command does not stop the rest of the batch.
+ */
+static xmmsv_t *
+xmms_ipc_exec_batch (xmmsv_t *arguments)
+{
+	xmmsv_list_iter_t *it;
+	xmmsv_t *commands, *results;
+
+	if (!arguments || !xmmsv_list_get (arguments, 0, &commands) ||
+	    !xmmsv_get_list_iter (commands, &it)) {
+		return xmmsv_new_error ("batch needs a list of commands");
+	}
+
+	results = xmmsv_new_list ();
+
+	for (; xmmsv_list_iter_valid (it); xmmsv_list_iter_next (it)) {
+		xmms_object_cmd_arg_t arg;
+		xmmsv_t *entry, *cmdargs, *result;
+		gint32 objid, cmdid;
+
+		xmmsv_list_iter_entry (it, &entry);
+
+		if (!xmmsv_list_get_int (entry, 0, &objid) ||
+		    !xmmsv_list_get_int (entry, 1, &cmdid) ||
+		    !xmmsv_list_get (entry, 2, &cmdargs) ||
+		    !xmmsv_is_type (cmdargs, XMMSV_TYPE_LIST)) {
+			result = xmmsv_new_error ("malformed batch entry");
+		} else if (objid == XMMS_IPC_OBJECT_SIGNAL) {
+			/* signals need a cookie of their own */
+			result = xmmsv_new_error ("signal commands cannot be batched");
+		} else if (!xmms_ipc_cmd_exec (objid, cmdid, cmdargs, &arg)) {
+			result = xmmsv_new_error ("no such command");
+		} else if (!xmms_error_isok (&arg.error)) {
+			result = xmmsv_new_error (xmms_error_message_get (&arg.error));
+			if (arg.retval) {
+				xmmsv_unref (arg.retval);
+			}
+		} else if (arg.retval) {
+			result = arg.retval;
+		} else {
+			result = xmmsv_new_none ();
+		}
+
+		xmmsv_list_append (results, result);
+		xmmsv_unref (result);
+	}
+
+	return results;
+}
+
 static void
 process_msg (xmms_ipc_client_t *client, xmms_ipc_msg_t *msg)
 {
-	xmms_object_t *object;
 	xmms_object_cmd_arg_t arg;
 	xmms_ipc_msg_t *retmsg;
-	xmmsv_t *error, *arguments;
+	xmmsv_t *error, *arguments, *results;
 	uint32_t objid, cmdid;
 
 	g_return_if_fail (msg);
@@ -189,6 +532,25 @@ process_msg (xmms_ipc_client_t *client, xmms_ipc_msg_t *msg)
 			xmms_ipc_register_signal (client, msg, arguments);
 		} else if (cmdid == XMMS_IPC_CMD_BROADCAST) {
 			xmms_ipc_register_broadcast (client, msg, arguments);
+		} else if (cmdid == XMMS_IPC_CMD_BATCH) {
+			results = xmms_ipc_exec_batch (arguments);
+
+			if (xmmsv_is_error (results)) {
+				retmsg = xmms_ipc_msg_new (objid, XMMS_IPC_CMD_ERROR);
+			} else {
+				retmsg = xmms_ipc_msg_new (objid, XMMS_IPC_CMD_REPLY);
+			}
+			xmms_ipc_handle_cmd_value (client, retmsg, results);
+			xmmsv_unref (results);
+
+			xmms_ipc_msg_set_cookie (retmsg, xmms_ipc_msg_get_cookie (msg));
+			g_mutex_lock (client->lock);
+			xmms_ipc_client_msg_write (client, retmsg);
+			g_mutex_unlock (client->lock);
+		} else if (cmdid == XMMS_IPC_CMD_WIRE_FORMAT) {
+			xmms_ipc_set_wire_format (client, arguments);
+		} else if (cmdid == XMMS_IPC_CMD_FD_PAYLOADS) {
+			xmms_ipc_set_fd_payloads (client);
 		} else {
 			xmms_log_error ("Bad command id (%d) for signal object", cmdid);
 		}
@@ -196,31 +558,13 @@ process_msg (xmms_ipc_client_t *client, xmms_ipc_msg_t *msg)
 		goto out;
 	}
 
-	if (objid >= XMMS_IPC_OBJECT_END) {
-		xmms_log_error ("Bad object id (%d)", objid);
+	if (!xmms_ipc_cmd_exec (objid, cmdid, arguments, &arg)) {
 		goto out;
 	}
 
-	g_mutex_lock (ipc_object_pool_lock);
-	object = ipc_object_pool->objects[objid];
-	g_mutex_unlock (ipc_object_pool_lock);
-	if (!object) {
-		xmms_log_error ("Object %d was not found!", objid);
-		goto out;
-	}
-
-	if (!g_tree_lookup (object->cmds, GUINT_TO_POINTER (cmdid))) {
-		xmms_log_error ("No such cmd %d on object %d", cmdid, objid);
-		goto out;
-	}
-
-	xmms_object_cmd_arg_init (&arg);
-	arg.args = arguments;
-
-	xmms_object_cmd_call (object, cmdid, &arg);
 	if (xmms_error_isok (&arg.error)) {
 		retmsg = xmms_ipc_msg_new (objid, XMMS_IPC_CMD_REPLY);
-		xmms_ipc_handle_cmd_value (retmsg, arg.retval);
+		xmms_ipc_handle_cmd_value (client, retmsg, arg.retval);
 	} else {
 		/* FIXME: or we could omit setting the command to _CMD_ERROR
 		 * and let the client check whether the value it got is an
@@ -252,6 +596,89 @@ out:
 	}
 }
 
+static void
+xmms_ipc_client_ref (xmms_ipc_client_t *client)
+{
+	g_atomic_int_inc (&client->ref);
+}
+
+/**
+ * Execute the queued commands of a client. A client is only ever handed
+ * to one worker at a time, so its commands run in order.
+ */
+static void
+xmms_ipc_client_worker (gpointer data, gpointer udata)
+{
+	xmms_ipc_client_t *client = data;
+	xmms_ipc_msg_t *msg;
+	gint i;
+
+	for (i = 0; i < XMMS_IPC_WORKER_BATCH; i++) {
+		g_mutex_lock (client->lock);
+		msg = g_queue_pop_head (client->in_msg);
+		if (!msg) {
+			client->busy = FALSE;
+			g_mutex_unlock (client->lock);
+			xmms_ipc_client_unref (client);
+			return;
+		}
+		g_mutex_unlock (client->lock);
+
+		process_msg (client, msg);
+		xmms_ipc_msg_destroy (msg);
+	}
+
+	/* the pool no longer takes work while it is being shut down */
+	if (g_atomic_int_get (&ipc_workers_stopping)) {
+		g_mutex_lock (client->lock);
+		client->busy = FALSE;
+		g_mutex_unlock (client->lock);
+		xmms_ipc_client_unref (client);
+		return;
+	}
+
+	/* still busy, go to the back of the line to let other clients in */
+	g_thread_pool_push (ipc_workers, client, NULL);
+}
+
+/**
+ * Queue a command read from the client for execution.
+ */
+static void
+xmms_ipc_client_queue_cmd (xmms_ipc_client_t *client, xmms_ipc_msg_t *msg)
+{
+	g_mutex_lock (client->lock);
+	g_queue_push_tail (client->in_msg, msg);
+	if (!client->busy) {
+		client->busy = TRUE;
+		xmms_ipc_client_ref (client);
+		g_thread_pool_push (ipc_workers, client, NULL);
+	}
+	g_mutex_unlock (client->lock);
+}
+
+/**
+ * Stop delivering anything to the client. Commands already read are
+ * still executed.
+ */
+static void
+xmms_ipc_client_disconnect (xmms_ipc_client_t *client)
+{
+	if (client->read_msg) {
+		xmms_ipc_msg_destroy (client->read_msg);
+		client->read_msg = NULL;
+	}
+
+	if (client->ipc) {
+		g_mutex_lock (client->ipc->mutex_lock);
+		client->ipc->clients = g_list_remove (client->ipc->clients, client);
+		g_mutex_unlock (client->ipc->mutex_lock);
+	}
+
+	g_mutex_lock (client->lock);
+	client->disconnected = TRUE;
+	g_mutex_unlock (client->lock);
+}
 
 static gboolean
 xmms_ipc_client_read_cb (GIOChannel *iochan,
@@ -270,10 +697,8 @@ xmms_ipc_client_read_cb (GIOChannel *iochan,
 			}
 
 			if (xmms_ipc_msg_read_transport (client->read_msg, client->transport, &disconnect)) {
-				xmms_ipc_msg_t *msg = client->read_msg;
+				xmms_ipc_client_queue_cmd (client, client->read_msg);
 				client->read_msg = NULL;
-				process_msg (client, msg);
-				xmms_ipc_msg_destroy (msg);
 			} else {
 				break;
 			}
@@ -281,18 +706,14 @@ xmms_ipc_client_read_cb (GIOChannel *iochan,
 	}
 
 	if (disconnect || (cond & G_IO_HUP)) {
-		if (client->read_msg) {
-			xmms_ipc_msg_destroy (client->read_msg);
-			client->read_msg = NULL;
-		}
 		XMMS_DBG ("disconnect was true!");
-		g_main_loop_quit (client->ml);
+		xmms_ipc_client_disconnect (client);
 		return FALSE;
 	}
 
 	if (cond & G_IO_ERR) {
 		xmms_log_error ("Client got error, maybe connection died?");
-		g_main_loop_quit (client->ml);
+		xmms_ipc_client_disconnect (client);
 		return FALSE;
 	}
 
@@ -305,78 +726,62 @@ xmms_ipc_client_write_cb (GIOChannel *iochan,
                           gpointer data)
 {
 	xmms_ipc_client_t *client = data;
+	xmms_ipc_msg_t *msgs[XMMS_IPC_IOVEC_MAX];
 	bool disconnect = FALSE;
 
 	g_return_val_if_fail (client, FALSE);
 
 	while (TRUE) {
-		xmms_ipc_msg_t *msg;
+		GList *l;
+		gint i, count, written;
 
+		/* only this thread removes messages, so the head stays put */
 		g_mutex_lock (client->lock);
-		msg = g_queue_peek_head (client->out_msg);
+		l = g_queue_peek_head_link (client->out_msg);
+		for (count = 0; l && count < XMMS_IPC_IOVEC_MAX; l = l->next) {
+			msgs[count++] = l->data;
+		}
 		g_mutex_unlock (client->lock);
 
-		if (!msg)
+		if (!count)
 			break;
 
-		if (!xmms_ipc_msg_write_transport (msg,
-		                                   client->transport,
-		                                   &disconnect)) {
-			if (disconnect) {
-				break;
-			} else {
-				/* try sending again later */
-				return TRUE;
-			}
-		}
+		client->transport->send_fds = g_atomic_int_get (&client->fd_payloads);
+		written = xmms_ipc_msg_write_transport_batch (msgs, count,
+		                                              client->transport,
+		                                              &disconnect);
 
 		g_mutex_lock (client->lock);
-		g_queue_pop_head (client->out_msg);
+		for (i = 0; i < written; i++) {
+			g_queue_pop_head (client->out_msg);
+		}
 		g_mutex_unlock (client->lock);
 
-		xmms_ipc_msg_destroy (msg);
+		for (i = 0; i < written; i++) {
+			xmms_ipc_msg_destroy (msgs[i]);
+		}
+
+		if (disconnect) {
+			break;
+		} else if (written < count) {
+			/* try sending the rest later */
+			return TRUE;
+		}
 	}
 
 	return FALSE;
 }
 
-static gpointer
-xmms_ipc_client_thread (gpointer data)
-{
-	xmms_ipc_client_t *client = data;
-	GSource *source;
-
-	xmms_set_thread_name ("x2 client");
-
-	source = g_io_create_watch (client->iochan, G_IO_IN | G_IO_ERR | G_IO_HUP);
-	g_source_set_callback (source,
-	                       (GSourceFunc) xmms_ipc_client_read_cb,
-	                       (gpointer) client,
-	                       NULL);
-	g_source_attach (source, g_main_loop_get_context (client->ml));
-	g_source_unref (source);
-
-	g_main_loop_run (client->ml);
-
-	xmms_ipc_client_destroy (client);
-
-	return NULL;
-}
-
 static xmms_ipc_client_t *
 xmms_ipc_client_new (xmms_ipc_t *ipc, xmms_ipc_transport_t *transport)
 {
 	xmms_ipc_client_t *client;
-	GMainContext *context;
 	int fd;
 
 	g_return_val_if_fail (transport, NULL);
 
 	client = g_new0 (xmms_ipc_client_t, 1);
-
-	context = g_main_context_new ();
-	client->ml = g_main_loop_new (context, FALSE);
-	g_main_context_unref (context);
+	client->ref = 1;
 
 	fd = xmms_ipc_transport_fd_get (transport);
 	client->iochan = g_io_channel_unix_new (fd);
@@ -391,25 +796,23 @@ xmms_ipc_client_new (xmms_ipc_t *ipc, xmms_ipc_transport_t *transport)
 	client->transport = transport;
 	client->ipc = ipc;
 	client->out_msg = g_queue_new ();
+	client->in_msg = g_queue_new ();
 	client->lock = g_mutex_new ();
 
 	return client;
 }
 
 static void
-xmms_ipc_client_destroy (xmms_ipc_client_t *client)
+xmms_ipc_client_unref (xmms_ipc_client_t *client)
 {
 	guint i;
 
-	XMMS_DBG ("Destroying client!");
-
-	if (client->ipc) {
-		g_mutex_lock (client->ipc->mutex_lock);
-		client->ipc->clients = g_list_remove (client->ipc->clients, client);
-		g_mutex_unlock (client->ipc->mutex_lock);
+	if (!g_atomic_int_dec_and_test (&client->ref)) {
+		return;
 	}
 
-	g_main_loop_unref (client->ml);
+	XMMS_DBG ("Destroying client!");
+
 	g_io_channel_unref (client->iochan);
 
 	xmms_ipc_transport_destroy (client->transport);
@@ -422,8 +825,19 @@ xmms_ipc_client_destroy (xmms_ipc_client_t *client)
 
 	g_queue_free (client->out_msg);
 
+	while (!g_queue_is_empty (client->in_msg)) {
+		xmms_ipc_msg_t *msg = g_queue_pop_head (client->in_msg);
+		xmms_ipc_msg_destroy (msg);
+	}
+
+	g_queue_free (client->in_msg);
+
 	for (i = 0; i < XMMS_IPC_SIGNAL_END; i++) {
-		g_list_free (client->broadcasts[i]);
+		while (client->broadcasts[i]) {
+			xmms_ipc_broadcast_free (client->broadcasts[i]->data);
+			client->broadcasts[i] = g_list_delete_link (client->broadcasts[i],
+			                                            client->broadcasts[i]);
+		}
 	}
 
 	g_mutex_unlock (client->lock);
@@ -441,7 +855,8 @@ on_config_ipcsocket_change (xmms_object_t *object, xmmsv_t *_data, gpointer udat
 
 	XMMS_DBG ("Shutting down ipc server threads through config property \"core.ipcsocket\" change.");
 
-	xmms_ipc_shutdown ();
+	xmms_ipc_io_stop ();
+	xmms_ipc_shutdown_servers ();
 	value = xmms_config_property_get_string ((xmms_config_property_t *) object);
 	xmms_ipc_setup_server (value);
 }
@@ -458,22 +873,27 @@ xmms_ipc_client_msg_write (xmms_ipc_client_t *client, xmms_ipc_msg_t *msg)
 	g_return_val_if_fail (client, FALSE);
 	g_return_val_if_fail (msg, FALSE);
 
+	if (client->disconnected) {
+		xmms_ipc_msg_destroy (msg);
+		return FALSE;
+	}
+
 	queue_empty = g_queue_is_empty (client->out_msg);
 	g_queue_push_tail (client->out_msg, msg);
 
 	/* If there's no write in progress, add a new callback */
 	if (queue_empty) {
-		GMainContext *context = g_main_loop_get_context (client->ml);
 		GSource *source = g_io_create_watch (client->iochan, G_IO_OUT);
 
+		xmms_ipc_client_ref (client);
 		g_source_set_callback (source,
 		                       (GSourceFunc) xmms_ipc_client_write_cb,
 		                       (gpointer) client,
-		                       NULL);
-		g_source_attach (source, context);
+		                       (GDestroyNotify) xmms_ipc_client_unref);
+		g_source_attach (source, ipc_io_context);
 		g_source_unref (source);
 
-		g_main_context_wakeup (context);
+		g_main_context_wakeup (ipc_io_context);
 	}
 
 	return TRUE;
@@ -485,6 +905,7 @@ xmms_ipc_source_accept (GIOChannel *chan, GIOCondition cond, gpointer data)
 	xmms_ipc_t *ipc = (xmms_ipc_t *) data;
 	xmms_ipc_transport_t *transport;
 	xmms_ipc_client_t *client;
+	GSource *source;
 
 	if (!(cond & G_IO_IN)) {
 		xmms_log_error ("IPC listener got error/hup");
@@ -505,17 +926,104 @@ xmms_ipc_source_accept (GIOChannel *chan, GIOCondition cond, gpointer data)
 	}
 
 	g_mutex_lock (ipc->mutex_lock);
-	ipc->clients = g_list_append (ipc->clients, client);
+	ipc->clients = g_list_prepend (ipc->clients, client);
 	g_mutex_unlock (ipc->mutex_lock);
 
-	/* Now that the client has been registered in the ipc->clients list
-	 * we may safely start its thread.
-	 */
-	g_thread_create (xmms_ipc_client_thread, client, FALSE, NULL);
+	/* the read watch owns the initial reference */
+	source = g_io_create_watch (client->iochan, G_IO_IN | G_IO_ERR | G_IO_HUP);
+	g_source_set_callback (source,
+	                       (GSourceFunc) xmms_ipc_client_read_cb,
+	                       (gpointer) client,
+	                       (GDestroyNotify) xmms_ipc_client_unref);
+	g_source_attach (source, ipc_io_context);
+	g_source_unref (source);
+
+	return TRUE;
+}
+
+static gpointer
+xmms_ipc_io_thread (gpointer data)
+{
+	xmms_set_thread_name ("x2 ipc");
+
+	g_main_loop_run (ipc_io_loop);
+
+	return NULL;
+}
+
+/**
+ * Start the I/O thread and the worker pool shared by all servers.
+ * They live until #xmms_ipc_shutdown, as clients outlive their server
+ * when the socket is changed.
+ */
+static gboolean
+xmms_ipc_io_start (void)
+{
+	if (!ipc_workers) {
+		ipc_workers = g_thread_pool_new (xmms_ipc_client_worker, NULL,
+		                                 ipc_worker_count, FALSE, NULL);
+		if (!ipc_workers) {
+			return FALSE;
+		}
+	}
+
+	if (!ipc_io_loop) {
+		ipc_io_context = g_main_context_new ();
+		ipc_io_loop = g_main_loop_new (ipc_io_context, FALSE);
+	}
+
+	if (!ipc_io_thread) {
+		ipc_io_thread = g_thread_create (xmms_ipc_io_thread, NULL, TRUE, NULL);
+		if (!ipc_io_thread) {
+			return FALSE;
+		}
+	}
 
 	return TRUE;
 }
 
+/**
+ * Stop the I/O thread and wait for it to exit. Sources stay attached to
+ * the context and are dispatched again once the thread is restarted.
+ */
+static void
+xmms_ipc_io_stop (void)
+{
+	if (!ipc_io_thread) {
+		return;
+	}
+
+	g_main_loop_quit (ipc_io_loop);
+	g_thread_join (ipc_io_thread);
+	ipc_io_thread = NULL;
+}
+
+/**
+ * Set the number of threads executing client commands.
+ */
+void
+xmms_ipc_workers_set (gint count)
+{
+	if (count < 1) {
+		xmms_log_error ("At least one IPC worker is needed, not %d.", count);
+		return;
+	}
+
+	ipc_worker_count = count;
+	if (ipc_workers) {
+		g_thread_pool_set_max_threads (ipc_workers, count, NULL);
+	}
+}
+
+/**
+ * Gets called when the config property "core.ipcworkers" has changed.
+ */
+void
+on_config_ipcworkers_change (xmms_object_t *object, xmmsv_t *_data, gpointer udata)
+{
+	xmms_ipc_workers_set (xmms_config_property_get_int ((xmms_config_property_t *) object));
+}
+
 /**
  * Enable IPC
  */
@@ -529,8 +1037,11 @@ xmms_ipc_setup_server_internaly (xmms_ipc_t *ipc)
 	g_io_channel_set_encoding (ipc->chan, NULL, NULL);
 	g_io_channel_set_buffered (ipc->chan, FALSE);
 
-	g_io_add_watch (ipc->chan, G_IO_IN | G_IO_HUP | G_IO_ERR,
-	                xmms_ipc_source_accept, ipc);
+	ipc->source = g_io_create_watch (ipc->chan, G_IO_IN | G_IO_HUP | G_IO_ERR);
+	g_source_set_callback (ipc->source,
+	                       (GSourceFunc) xmms_ipc_source_accept,
+	                       ipc, NULL);
+	g_source_attach (ipc->source, ipc_io_context);
 	g_mutex_unlock (ipc->mutex_lock);
 	return TRUE;
 }
@@ -586,7 +1097,7 @@ xmms_ipc_signal_cb (xmms_object_t *object, xmmsv_t *arg, gpointer userdata)
 			if (cli->pendingsignals[signalid]) {
 				msg = xmms_ipc_msg_new (XMMS_IPC_OBJECT_SIGNAL, XMMS_IPC_CMD_SIGNAL);
 				xmms_ipc_msg_set_cookie (msg, cli->pendingsignals[signalid]);
-				xmms_ipc_handle_cmd_value (msg, arg);
+				xmms_ipc_handle_cmd_value (cli, msg, arg);
 				xmms_ipc_client_msg_write (cli, msg);
 				cli->pendingsignals[signalid] = 0;
 			}
@@ -599,11 +1110,16 @@ xmms_ipc_signal_cb (xmms_object_t *object, xmmsv_t *arg, gpointer userdata)
 
 }
 
+/**
+ * Write a broadcast to every client subscribed to it, skipping the
+ * clients that are also subscribed to skipid. A negative skipid skips
+ * no client.
+ */
 static void
-xmms_ipc_broadcast_cb (xmms_object_t *object, xmmsv_t *arg, gpointer userdata)
+xmms_ipc_broadcast_deliver (guint broadcastid, gint skipid, xmmsv_t *arg)
 {
 	GList *c, *s;
-	guint broadcastid = GPOINTER_TO_UINT (userdata);
+	xmms_ipc_broadcast_t *broadcast;
 	xmms_ipc_t *ipc;
 	xmms_ipc_msg_t *msg = NULL;
 	GList *l;
@@ -617,10 +1133,21 @@ xmms_ipc_broadcast_cb (xmms_object_t *object, xmmsv_t *arg, gpointer userdata)
 			xmms_ipc_client_t *cli = c->data;
 
 			g_mutex_lock (cli->lock);
+			if (skipid >= 0 && cli->broadcasts[skipid] != NULL) {
+				g_mutex_unlock (cli->lock);
+				continue;
+			}
 			for (l = cli->broadcasts[broadcastid]; l; l = g_list_next (l)) {
+				broadcast = l->data;
+
+				/* filtered out broadcasts are never encoded */
+				if (!xmms_ipc_broadcast_matches (broadcast, arg)) {
+					continue;
+				}
+
 				msg = xmms_ipc_msg_new (XMMS_IPC_OBJECT_SIGNAL, XMMS_IPC_CMD_BROADCAST);
-				xmms_ipc_msg_set_cookie (msg, GPOINTER_TO_UINT (l->data));
-				xmms_ipc_handle_cmd_value (msg, arg);
+				xmms_ipc_msg_set_cookie (msg, broadcast->cookie);
+				xmms_ipc_handle_cmd_value (cli, msg, arg);
 				xmms_ipc_client_msg_write (cli, msg);
 			}
 			g_mutex_unlock (cli->lock);
@@ -630,6 +1157,12 @@ xmms_ipc_broadcast_cb (xmms_object_t *object, xmmsv_t *arg, gpointer userdata)
 	g_mutex_unlock (ipc_servers_lock);
 }
 
+static void
+xmms_ipc_broadcast_cb (xmms_object_t *object, xmmsv_t *arg, gpointer userdata)
+{
+	xmms_ipc_broadcast_deliver (GPOINTER_TO_UINT (userdata), -1, arg);
+}
+
 /**
  * Register a broadcast signal.
  */
@@ -662,6 +1195,69 @@ xmms_ipc_broadcast_unregister (xmms_ipc_signals_t signalid)
 	g_mutex_unlock (ipc_object_pool_lock);
 }
 
+/**
+ * Check if any client is subscribed to a broadcast without also being
+ * subscribed to unless. Lets a sender skip building a long run of
+ * broadcasts that no client would receive.
+ */
+gboolean
+xmms_ipc_broadcast_wanted (xmms_ipc_signals_t signalid,
+                           xmms_ipc_signals_t unless)
+{
+	GList *c, *s;
+	xmms_ipc_t *ipc;
+	gboolean wanted = FALSE;
+
+	if (ipc_servers_lock == NULL) {
+		return FALSE;
+	}
+
+	g_mutex_lock (ipc_servers_lock);
+
+	for (s = ipc_servers; s && s->data && !wanted; s = g_list_next (s)) {
+		ipc = s->data;
+		g_mutex_lock (ipc->mutex_lock);
+		for (c = ipc->clients; c && !wanted; c = g_list_next (c)) {
+			xmms_ipc_client_t *cli = c->data;
+
+			g_mutex_lock (cli->lock);
+			wanted = cli->broadcasts[signalid] != NULL &&
+			         cli->broadcasts[unless] == NULL;
+			g_mutex_unlock (cli->lock);
+		}
+		g_mutex_unlock (ipc->mutex_lock);
+	}
+
+	g_mutex_unlock (ipc_servers_lock);
+
+	return wanted;
+}
+
+/**
+ * Send a broadcast to the subscribed clients only, without emitting it
+ * on the registered object. Used where the server itself is notified
+ * through some other signal. Clients subscribed to unless are skipped,
+ * as that broadcast already carries the same information for them.
+ */
+void
+xmms_ipc_broadcast_send (xmms_ipc_signals_t signalid,
+                         xmms_ipc_signals_t unless, xmmsv_t *arg)
+{
+	gboolean registered;
+
+	if (ipc_object_pool_lock == NULL) {
+		return;
+	}
+
+	g_mutex_lock (ipc_object_pool_lock);
+	registered = ipc_object_pool->broadcasts[signalid] != NULL;
+	g_mutex_unlock (ipc_object_pool_lock);
+
+	if (registered) {
+		xmms_ipc_broadcast_deliver (signalid, unless, arg);
+	}
+}
+
 /**
  * Register a signal
  */
@@ -739,7 +1335,8 @@ xmms_ipc_shutdown_server (xmms_ipc_t *ipc)
 	if (!ipc) return;
 
 	g_mutex_lock (ipc->mutex_lock);
-	g_source_remove_by_user_data (ipc);
+	g_source_destroy (ipc->source);
+	g_source_unref (ipc->source);
 	g_io_channel_unref (ipc->chan);
 	xmms_ipc_transport_destroy (ipc->transport);
 
@@ -759,10 +1356,11 @@ xmms_ipc_shutdown_server (xmms_ipc_t *ipc)
 
 
 /**
- * Disable IPC
+ * Shutdown all IPC servers. The I/O thread must be stopped, so that
+ * no accept callback is running.
  */
-void
-xmms_ipc_shutdown (void)
+static void
+xmms_ipc_shutdown_servers (void)
 {
 	GList *s = ipc_servers;
 	xmms_ipc_t *ipc;
@@ -775,6 +1373,32 @@ xmms_ipc_shutdown (void)
 		xmms_ipc_shutdown_server (ipc);
 	}
 	g_mutex_unlock (ipc_servers_lock);
+}
+
+/**
+ * Disable IPC
+ */
+void
+xmms_ipc_shutdown (void)
+{
+	/* nothing may call back into ipc while it's torn down */
+	xmms_ipc_io_stop ();
+
+	if (ipc_workers) {
+		g_atomic_int_set (&ipc_workers_stopping, 1);
+		g_thread_pool_free (ipc_workers, FALSE, TRUE);
+		ipc_workers = NULL;
+		g_atomic_int_set (&ipc_workers_stopping, 0);
+	}
+
+	xmms_ipc_shutdown_servers ();
+
+	if (ipc_io_loop) {
+		g_main_loop_unref (ipc_io_loop);
+		ipc_io_loop = NULL;
+		g_main_context_unref (ipc_io_context);
+		ipc_io_context = NULL;
+	}
 
 	g_mutex_free (ipc_servers_lock);
 	ipc_servers_lock = NULL;
@@ -798,6 +1422,11 @@ xmms_ipc_setup_server (const gchar *path)
 	gint i = 0, num_init = 0;
 	g_return_val_if_fail (path, FALSE);
 
+	if (!xmms_ipc_io_start ()) {
+		xmms_log_error ("Couldn't start the IPC threads.");
+		return FALSE;
+	}
+
 	split = g_strsplit (path, ";", 0);
 
 	for (i = 0; split && split[i]; i++) {
@@ -45,6 +45,7 @@
 #include "xmmspriv/xmms_log.h"
 #include "xmmspriv/xmms_xform.h"
 #include "xmmspriv/xmms_bindata.h"
+#include "xmmspriv/xmms_stats.h"
 #include "xmmspriv/xmms_utils.h"
 #include "xmmspriv/xmms_visualization.h"
 
@@ -89,6 +90,7 @@ struct xmms_main_St {
 	xmms_object_t object;
 	xmms_output_t *output_object;
 	xmms_bindata_t *bindata_object;
+	xmms_stats_t *stats_object;
 	xmms_coll_dag_t *colldag_object;
 	xmms_medialib_t *medialib_object;
 	xmms_playlist_t *playlist_object;
@@ -279,6 +281,7 @@ xmms_main_destroy (xmms_object_t *object)
 	xmms_object_unref (mainobj->visualization_object);
 	xmms_object_unref (mainobj->output_object);
 	xmms_object_unref (mainobj->bindata_object);
+	xmms_object_unref (mainobj->stats_object);
 	xmms_object_unref (mainobj->playlist_object);
 	xmms_object_unref (mainobj->colldag_object);
 	xmms_object_unref (mainobj->medialib_object);
@@ -516,6 +519,12 @@ main (int argc, char **argv)
 
 	xmms_log_set_format (xmms_config_property_get_string (cv));
 
+	/* commands of different clients run in parallel on this many threads */
+	cv = xmms_config_property_register ("core.ipcworkers", "4",
+	                                    on_config_ipcworkers_change,
+	                                    NULL);
+	xmms_ipc_workers_set (xmms_config_property_get_int (cv));
+
 	xmms_fallback_ipcpath_get (default_path, sizeof (default_path));
 
 	cv = xmms_config_property_register ("core.ipcsocket",
@@ -558,6 +567,7 @@ main (int argc, char **argv)
 
 	mainobj->xform_object = xmms_xform_object_init ();
 	mainobj->bindata_object = xmms_bindata_init ();
+	mainobj->stats_object = xmms_stats_init ();
 
 	/* find output plugin. */
 	cv = xmms_config_property_register ("output.plugin",
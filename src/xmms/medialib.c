@@ -18,6 +18,7 @@
 #include "xmmspriv/xmms_medialib.h"
 #include "xmmspriv/xmms_xform.h"
 #include "xmmspriv/xmms_utils.h"
+#include "xmmspriv/xmms_stats.h"
 #include "xmms/xmms_error.h"
 #include "xmms/xmms_config.h"
 #include "xmms/xmms_object.h"
@@ -56,8 +57,12 @@ static void xmms_medialib_client_set_property_int (xmms_medialib_t *medialib, xm
 static void xmms_medialib_client_remove_property (xmms_medialib_t *medialib, xmms_medialib_entry_t entry, const gchar *source, const gchar *key, xmms_error_t *error);
 static xmmsv_t *xmms_medialib_client_get_info (xmms_medialib_t *medialib, xmms_medialib_entry_t entry, xmms_error_t *err);
 static gint32 xmms_medialib_client_get_id (xmms_medialib_t *medialib, const gchar *url, xmms_error_t *error);
+static gint32 xmms_medialib_client_remove_prefix (xmms_medialib_t *medialib, const gchar *prefix, xmms_error_t *error);
+static gint32 xmms_medialib_client_rehash_prefix (xmms_medialib_t *medialib, const gchar *prefix, xmms_error_t *error);
+static gint32 xmms_medialib_client_move_prefix (xmms_medialib_t *medialib, const gchar *from, const gchar *to, xmms_error_t *error);
 
 static s4_t *xmms_medialib_database_open (const gchar *config_path, const gchar *indices[]);
+static void xmms_medialib_url_index_load (xmms_medialib_t *medialib);
 static xmms_medialib_entry_t xmms_medialib_entry_new_insert (xmms_medialib_session_t *session, guint32 id, const gchar *url, xmms_error_t *error);
 
 #include "medialib_ipc.c"
@@ -80,6 +85,7 @@ struct xmms_medialib_St {
 	xmms_object_t object;
 	s4_t *s4;
 	s4_sourcepref_t *default_sp;
+	xmms_medialib_url_index_t *url_index;
 };
 
 static const gchar *source_pref[] = {
@@ -102,6 +108,7 @@ xmms_medialib_destroy (xmms_object_t *object)
 
 	s4_sourcepref_unref (mlib->default_sp);
 	s4_close (mlib->s4);
+	xmms_medialib_url_index_free (mlib->url_index);
 
 	xmms_medialib_unregister_ipc_commands ();
 }
@@ -145,6 +152,9 @@ xmms_medialib_init (void)
 	medialib_path = xmms_config_property_get_string (cfg);
 	medialib->s4 = xmms_medialib_database_open (medialib_path, indices);
 	medialib->default_sp = s4_sourcepref_create (source_pref);
+	medialib->url_index = xmms_medialib_url_index_new ();
+
+	xmms_medialib_url_index_load (medialib);
 
 	return medialib;
 }
@@ -161,6 +171,12 @@ xmms_medialib_get_database_backend (xmms_medialib_t *medialib)
 	return medialib->s4;
 }
 
+xmms_medialib_url_index_t *
+xmms_medialib_get_url_index (xmms_medialib_t *medialib)
+{
+	return medialib->url_index;
+}
+
 /**
  * Extracts the file name of the old media library
  * and replaces its suffix with .s4
@@ -269,6 +285,64 @@ xmms_medialib_database_open (const gchar *database_name,
 	return xmms_medialib_database_convert (database_name, indices);
 }
 
+static gint
+has_url_filter (const s4_val_t *value, s4_condition_t *cond)
+{
+	return 0;
+}
+
+/**
+ * Fill the url index with every url in the database.
+ */
+static void
+xmms_medialib_url_index_load (xmms_medialib_t *medialib)
+{
+	xmms_medialib_session_t *session;
+	s4_condition_t *cond;
+	s4_fetchspec_t *spec;
+	s4_resultset_t *set;
+	gint i, rows;
+
+	cond = s4_cond_new_custom_filter (has_url_filter, NULL, NULL,
+	                                  XMMS_MEDIALIB_ENTRY_PROPERTY_URL,
+	                                  medialib->default_sp, S4_CMP_BINARY, 0, 0);
+
+	spec = s4_fetchspec_create ();
+	s4_fetchspec_add (spec, "song_id", medialib->default_sp, S4_FETCH_PARENT);
+	s4_fetchspec_add (spec, XMMS_MEDIALIB_ENTRY_PROPERTY_URL, NULL, S4_FETCH_DATA);
+
+	do {
+		session = xmms_medialib_session_begin_ro (medialib);
+		set = xmms_medialib_session_query (session, spec, cond);
+
+		rows = s4_resultset_get_rowcount (set);
+		for (i = 0; i < rows; i++) {
+			const s4_result_t *res;
+			const gchar *url;
+			gint32 id;
+
+			res = s4_resultset_get_result (set, i, 0);
+			if (res == NULL || !s4_val_get_int (s4_result_get_val (res), &id)) {
+				continue;
+			}
+
+			res = s4_resultset_get_result (set, i, 1);
+			for (; res != NULL; res = s4_result_next (res)) {
+				if (s4_val_get_str (s4_result_get_val (res), &url)) {
+					xmms_medialib_url_index_set (medialib->url_index, url, id);
+				}
+			}
+		}
+
+		s4_resultset_free (set);
+	} while (!xmms_medialib_session_commit (session));
+
+	s4_fetchspec_free (spec);
+	s4_cond_free (cond);
+
+	XMMS_DBG ("Indexed urls of %d entries", rows);
+}
+
 char *
 xmms_medialib_uuid (xmms_medialib_t *medialib)
 {
@@ -837,6 +911,11 @@ xmms_medialib_get_id (xmms_medialib_session_t *session, const char *url, xmms_er
 	const s4_result_t *res;
 	gint32 id = 0;
 
+	if (xmms_medialib_session_url_lookup (session, url, &id)) {
+		return id;
+	}
+
+	/* not indexed, the database also knows urls that only match caselessly */
 	sourcepref = xmms_medialib_session_get_source_preferences (session);
 
 	value = s4_val_new_string (url);
@@ -877,6 +956,136 @@ xmms_medialib_entry_new_encoded (xmms_medialib_session_t *session,
 
 }
 
+static gint
+url_set_filter (const s4_val_t *value, s4_condition_t *cond)
+{
+	GHashTable *urls;
+	const gchar *url;
+
+	if (!s4_val_get_str (value, &url)) {
+		return 1;
+	}
+
+	urls = s4_cond_get_funcdata (cond);
+
+	return !g_hash_table_lookup_extended (urls, url, NULL, NULL);
+}
+
+/**
+ * Resolve the urls in ids that map to 0 with one pass over the url
+ * property.
+ */
+static void
+xmms_medialib_entry_lookup_many (xmms_medialib_session_t *session,
+                                 GHashTable *ids)
+{
+	s4_sourcepref_t *sourcepref;
+	s4_condition_t *cond;
+	s4_fetchspec_t *spec;
+	s4_resultset_t *set;
+	gint32 id;
+	gint i, rows;
+
+	sourcepref = xmms_medialib_session_get_source_preferences (session);
+
+	cond = s4_cond_new_custom_filter (url_set_filter, ids, NULL,
+	                                  XMMS_MEDIALIB_ENTRY_PROPERTY_URL,
+	                                  sourcepref, S4_CMP_BINARY, 0, 0);
+
+	spec = s4_fetchspec_create ();
+	s4_fetchspec_add (spec, "song_id", sourcepref, S4_FETCH_PARENT);
+	s4_fetchspec_add (spec, XMMS_MEDIALIB_ENTRY_PROPERTY_URL, sourcepref, S4_FETCH_DATA);
+
+	set = xmms_medialib_session_query (session, spec, cond);
+
+	s4_fetchspec_free (spec);
+	s4_cond_free (cond);
+	s4_sourcepref_unref (sourcepref);
+
+	rows = s4_resultset_get_rowcount (set);
+	for (i = 0; i < rows; i++) {
+		const s4_result_t *res_id, *res_url;
+		const gchar *url;
+		gpointer key, value;
+
+		res_id = s4_resultset_get_result (set, i, 0);
+		res_url = s4_resultset_get_result (set, i, 1);
+
+		if (res_id == NULL || res_url == NULL ||
+		    !s4_val_get_int (s4_result_get_val (res_id), &id) ||
+		    !s4_val_get_str (s4_result_get_val (res_url), &url)) {
+			continue;
+		}
+
+		/* keep our own key, the url in the result set dies with it */
+		if (g_hash_table_lookup_extended (ids, url, &key, &value) && !value) {
+			g_hash_table_insert (ids, key, GINT_TO_POINTER (id));
+		}
+	}
+
+	s4_resultset_free (set);
+}
+
+/**
+ * Look up or create the entries of many encoded URLs at once.
+ *
+ * URLs are resolved through the url index, those not found there in one
+ * pass over the url property, and new entries get consecutive ids, where
+ * #xmms_medialib_entry_new_encoded does one lookup and one scan for the
+ * highest id per URL. URLs not in the index are matched exactly.
+ *
+ * @param session Session to look up and create the entries in
+ * @param urls Encoded URLs
+ * @param count Number of URLs
+ * @param entries Filled with the entry of each URL, 0 if it could not be added
+ * @param error If an error occurs, it will be stored in there.
+ */
+void
+xmms_medialib_entry_new_encoded_many (xmms_medialib_session_t *session,
+                                      const gchar * const *urls, gint count,
+                                      xmms_medialib_entry_t *entries,
+                                      xmms_error_t *error)
+{
+	GHashTable *ids;
+	gint32 id, next_id = 0;
+	gint i, misses = 0;
+
+	g_return_if_fail (urls);
+	g_return_if_fail (entries);
+
+	ids = g_hash_table_new (g_str_hash, g_str_equal);
+	for (i = 0; i < count; i++) {
+		xmms_medialib_session_url_lookup (session, urls[i], &id);
+		g_hash_table_insert (ids, (gpointer) urls[i], GINT_TO_POINTER (id));
+		if (!id) {
+			misses++;
+		}
+	}
+
+	if (misses > 0) {
+		xmms_medialib_entry_lookup_many (session, ids);
+	}
+
+	for (i = 0; i < count; i++) {
+		id = GPOINTER_TO_INT (g_hash_table_lookup (ids, urls[i]));
+
+		if (!id) {
+			if (!next_id) {
+				next_id = xmms_medialib_get_new_id (session);
+			}
+
+			if (xmms_medialib_entry_new_insert (session, next_id, urls[i], error)) {
+				id = next_id++;
+				g_hash_table_insert (ids, (gpointer) urls[i], GINT_TO_POINTER (id));
+			}
+		}
+
+		entries[i] = id;
+	}
+
+	g_hash_table_destroy (ids);
+}
+
 /**
  * Welcome to a function that should be called something else.
  * Returns a entry for a URL, if the URL is already in the medialib
@@ -1080,6 +1289,184 @@ xmms_medialib_client_move_entry (xmms_medialib_t *medialib,
 	g_free (encoded);
 }
 
+typedef struct {
+	GArray *entries;
+	GPtrArray *urls;
+} xmms_medialib_prefix_match_t;
+
+static void
+collect_prefix_match (const gchar *url, xmms_medialib_entry_t entry,
+                      gpointer udata)
+{
+	xmms_medialib_prefix_match_t *match = udata;
+
+	g_array_append_val (match->entries, entry);
+	if (match->urls != NULL) {
+		g_ptr_array_add (match->urls, g_strdup (url));
+	}
+}
+
+/**
+ * Find the entries below an url prefix, and optionally their urls.
+ */
+static void
+xmms_medialib_prefix_match_init (xmms_medialib_t *medialib,
+                                 xmms_medialib_prefix_match_t *match,
+                                 const gchar *prefix, gboolean with_urls)
+{
+	match->entries = g_array_new (FALSE, FALSE, sizeof (xmms_medialib_entry_t));
+	match->urls = with_urls ? g_ptr_array_new () : NULL;
+
+	xmms_medialib_url_index_foreach_prefix (medialib->url_index, prefix,
+	                                        collect_prefix_match, match);
+}
+
+static void
+xmms_medialib_prefix_match_clear (xmms_medialib_prefix_match_t *match)
+{
+	guint i;
+
+	g_array_free (match->entries, TRUE);
+
+	if (match->urls != NULL) {
+		for (i = 0; i < match->urls->len; i++) {
+			g_free (g_ptr_array_index (match->urls, i));
+		}
+		g_ptr_array_free (match->urls, TRUE);
+	}
+}
+
+static gint32
+xmms_medialib_client_remove_prefix (xmms_medialib_t *medialib,
+                                    const gchar *prefix, xmms_error_t *error)
+{
+	xmms_medialib_prefix_match_t match;
+	xmms_medialib_session_t *session;
+	xmms_medialib_entry_t entry;
+	gchar *encoded;
+	gint32 count;
+	guint i;
+
+	if (!*prefix) {
+		xmms_error_set (error, XMMS_ERROR_INVAL, "Refusing to remove the whole medialib");
+		return 0;
+	}
+
+	encoded = xmms_medialib_url_encode (prefix);
+
+	do {
+		session = xmms_medialib_session_begin (medialib);
+		xmms_medialib_session_coalesce_signals (session);
+
+		/* a retried session must see the entries added since the last try */
+		xmms_medialib_prefix_match_init (medialib, &match, encoded, FALSE);
+
+		count = 0;
+		for (i = 0; i < match.entries->len; i++) {
+			entry = g_array_index (match.entries, xmms_medialib_entry_t, i);
+			if (xmms_medialib_check_id (session, entry)) {
+				xmms_medialib_entry_remove (session, entry);
+				count++;
+			}
+		}
+
+		xmms_medialib_prefix_match_clear (&match);
+	} while (!xmms_medialib_session_commit (session));
+
+	g_free (encoded);
+
+	return count;
+}
+
+static gint32
+xmms_medialib_client_rehash_prefix (xmms_medialib_t *medialib,
+                                    const gchar *prefix, xmms_error_t *error)
+{
+	xmms_medialib_prefix_match_t match;
+	xmms_medialib_session_t *session;
+	xmms_medialib_entry_t entry;
+	gchar *encoded;
+	gint32 count;
+	guint i;
+
+	encoded = xmms_medialib_url_encode (prefix);
+
+	do {
+		session = xmms_medialib_session_begin (medialib);
+		xmms_medialib_session_coalesce_signals (session);
+
+		/* a retried session must see the entries added since the last try */
+		xmms_medialib_prefix_match_init (medialib, &match, encoded, FALSE);
+
+		count = 0;
+		for (i = 0; i < match.entries->len; i++) {
+			entry = g_array_index (match.entries, xmms_medialib_entry_t, i);
+			if (xmms_medialib_check_id (session, entry)) {
+				xmms_medialib_entry_status_set (session, entry, XMMS_MEDIALIB_ENTRY_STATUS_REHASH);
+				count++;
+			}
+		}
+
+		xmms_medialib_prefix_match_clear (&match);
+	} while (!xmms_medialib_session_commit (session));
+
+	g_free (encoded);
+
+	return count;
+}
+
+static gint32
+xmms_medialib_client_move_prefix (xmms_medialib_t *medialib,
+                                  const gchar *from, const gchar *to,
+                                  xmms_error_t *error)
+{
+	xmms_medialib_prefix_match_t match;
+	xmms_medialib_session_t *session;
+	xmms_medialib_entry_t entry;
+	gchar *enc_from, *enc_to, *url;
+	gsize len;
+	gint32 count;
+	guint i;
+
+	if (!*from) {
+		xmms_error_set (error, XMMS_ERROR_INVAL, "Refusing to move the whole medialib");
+		return 0;
+	}
+
+	enc_from = xmms_medialib_url_encode (from);
+	enc_to = xmms_medialib_url_encode (to);
+	len = strlen (enc_from);
+
+	do {
+		session = xmms_medialib_session_begin (medialib);
+		xmms_medialib_session_coalesce_signals (session);
+
+		xmms_medialib_prefix_match_init (medialib, &match, enc_from, TRUE);
+
+		count = 0;
+		for (i = 0; i < match.entries->len; i++) {
+			entry = g_array_index (match.entries, xmms_medialib_entry_t, i);
+			if (!xmms_medialib_check_id (session, entry)) {
+				continue;
+			}
+
+			url = g_strconcat (enc_to, (gchar *) g_ptr_array_index (match.urls, i) + len, NULL);
+			xmms_medialib_entry_property_set_str_source (session, entry,
+			                                             XMMS_MEDIALIB_ENTRY_PROPERTY_URL,
+			                                             url, "server");
+			g_free (url);
+			count++;
+		}
+
+		xmms_medialib_prefix_match_clear (&match);
+	} while (!xmms_medialib_session_commit (session));
+
+	g_free (enc_from);
+	g_free (enc_to);
+
+	return count;
+}
+
 static void
 xmms_medialib_client_set_property_string (xmms_medialib_t *medialib,
                                           xmms_medialib_entry_t entry,
@@ -1401,9 +1788,12 @@ xmms_medialib_query (xmms_medialib_session_t *session, xmmsv_coll_t *coll,
 	xmmsv_t *ret;
 	xmms_fetch_info_t *info;
 	xmms_fetch_spec_t *spec;
+	gint64 start;
 
 	xmms_error_reset (err);
 
+	start = xmms_stats_now ();
+
 	sourcepref = xmms_medialib_session_get_source_preferences (session);
 
 	info = xmms_fetch_info_new (sourcepref);
@@ -1426,5 +1816,7 @@ xmms_medialib_query (xmms_medialib_session_t *session, xmmsv_coll_t *coll,
 
 	xmms_medialib_session_track_garbage (session, ret);
 
+	xmms_stats_record_since (XMMS_STATS_MEDIALIB_QUERY, start);
+
 	return ret;
 }
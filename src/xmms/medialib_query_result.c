@@ -22,6 +22,7 @@
 #include <glib/gstdio.h>
 
 xmmsv_t *xmms_medialib_query_to_xmmsv (s4_resultset_t *set, xmms_fetch_spec_t *spec);
+static xmmsv_t *query_to_xmmsv (xmmsv_arena_t *arena, s4_resultset_t *set, xmms_fetch_spec_t *spec);
 
 typedef struct {
 	gint64 sum;
@@ -39,42 +40,46 @@ typedef struct {
 } set_data_t;
 
 static gboolean
-aggregate_first (xmmsv_t **current, gint int_value, const gchar *str_value)
+aggregate_first (xmmsv_arena_t *arena, xmmsv_t **current, gint int_value, const gchar *str_value)
 {
 	if (*current != NULL) {
 		return FALSE;
 	}
 
 	if (str_value != NULL) {
-		*current = xmmsv_new_string (str_value);
+		*current = xmmsv_arena_new_string (arena, str_value);
 	} else {
-		*current = xmmsv_new_int (int_value);
+		*current = xmmsv_arena_new_int (arena, int_value);
 	}
 
 	return TRUE;
 }
 
 static gboolean
-aggregate_list (xmmsv_t **current, gint int_value, const gchar *str_value)
+aggregate_list (xmmsv_arena_t *arena, xmmsv_t **current, gint int_value, const gchar *str_value)
 {
 	gboolean created = FALSE;
+	xmmsv_t *value;
 
 	if (*current == NULL) {
-		*current = xmmsv_new_list ();
+		*current = xmmsv_arena_new_list (arena);
 		created = TRUE;
 	}
 
 	if (str_value != NULL) {
-		xmmsv_list_append_string (*current, str_value);
+		value = xmmsv_arena_new_string (arena, str_value);
 	} else {
-		xmmsv_list_append_int (*current, int_value);
+		value = xmmsv_arena_new_int (arena, int_value);
 	}
 
+	xmmsv_list_append (*current, value);
+	xmmsv_unref (value);
+
 	return created;
 }
 
 static gboolean
-aggregate_set (xmmsv_t **current, gint int_value, const gchar *str_value)
+aggregate_set (xmmsv_arena_t *arena, xmmsv_t **current, gint int_value, const gchar *str_value)
 {
 	gboolean created = FALSE;
 	set_data_t *data;
@@ -85,7 +90,7 @@ aggregate_set (xmmsv_t **current, gint int_value, const gchar *str_value)
 	if (*current == NULL) {
 		set_data_t init = {
 			.ht = g_hash_table_new (NULL, NULL),
-			.list = xmmsv_new_list ()
+			.list = xmmsv_arena_new_list (arena)
 		};
 		*current = xmmsv_new_bin ((guchar *) &init, sizeof (set_data_t));
 		created = TRUE;
@@ -94,10 +99,10 @@ aggregate_set (xmmsv_t **current, gint int_value, const gchar *str_value)
 	xmmsv_get_bin (*current, (const guchar **) &data, &length);
 
 	if (str_value != NULL) {
-		value = xmmsv_new_string (str_value);
+		value = xmmsv_arena_new_string (arena, str_value);
 		key = (gpointer) str_value;
 	} else {
-		value = xmmsv_new_int (int_value);
+		value = xmmsv_arena_new_int (arena, int_value);
 		key = GINT_TO_POINTER (int_value);
 	}
 
@@ -112,7 +117,7 @@ aggregate_set (xmmsv_t **current, gint int_value, const gchar *str_value)
 }
 
 static gboolean
-aggregate_sum (xmmsv_t **current, gint int_value, const gchar *str_value)
+aggregate_sum (xmmsv_arena_t *arena, xmmsv_t **current, gint int_value, const gchar *str_value)
 {
 	gint old_value = 0;
 
@@ -132,7 +137,7 @@ aggregate_sum (xmmsv_t **current, gint int_value, const gchar *str_value)
 }
 
 static gboolean
-aggregate_min (xmmsv_t **current, gint int_value, const gchar *str_value)
+aggregate_min (xmmsv_arena_t *arena, xmmsv_t **current, gint int_value, const gchar *str_value)
 {
 	gint old_value;
 
@@ -158,7 +163,7 @@ aggregate_min (xmmsv_t **current, gint int_value, const gchar *str_value)
 }
 
 static gboolean
-aggregate_max (xmmsv_t **current, gint int_value, const gchar *str_value)
+aggregate_max (xmmsv_arena_t *arena, xmmsv_t **current, gint int_value, const gchar *str_value)
 {
 	gint old_value;
 
@@ -184,7 +189,7 @@ aggregate_max (xmmsv_t **current, gint int_value, const gchar *str_value)
 }
 
 static gboolean
-aggregate_random (xmmsv_t **current, gint int_value, const gchar *str_value)
+aggregate_random (xmmsv_arena_t *arena, xmmsv_t **current, gint int_value, const gchar *str_value)
 {
 	gboolean created = FALSE;
 	random_data_t *data;
@@ -216,7 +221,7 @@ aggregate_random (xmmsv_t **current, gint int_value, const gchar *str_value)
 }
 
 static gboolean
-aggregate_average (xmmsv_t **current, gint int_value, const gchar *str_value)
+aggregate_average (xmmsv_arena_t *arena, xmmsv_t **current, gint int_value, const gchar *str_value)
 {
 	gboolean created = FALSE;
 	avg_data_t *data;
@@ -240,8 +245,8 @@ aggregate_average (xmmsv_t **current, gint int_value, const gchar *str_value)
 
 /* Converts an S4 result (a column) into an xmmsv values */
 static void *
-result_to_xmmsv (xmmsv_t *ret, gint32 id, const s4_result_t *res,
-                 xmms_fetch_spec_t *spec)
+result_to_xmmsv (xmmsv_arena_t *arena, xmmsv_t *ret, gint32 id,
+                 const s4_result_t *res, xmms_fetch_spec_t *spec)
 {
 	const s4_val_t *val;
 	xmmsv_t *dict, *current;
@@ -298,7 +303,7 @@ result_to_xmmsv (xmmsv_t *ret, gint32 id, const s4_result_t *res,
 
 				/* Make sure the root dict exists */
 				if (dict == NULL) {
-					ret = dict = xmmsv_new_dict ();
+					ret = dict = xmmsv_arena_new_dict (arena);
 				}
 
 				/* If this dict contains dicts we have to create a new
@@ -309,7 +314,7 @@ result_to_xmmsv (xmmsv_t *ret, gint32 id, const s4_result_t *res,
 
 				if (i < (spec->data.metadata.get_size - 2)) {
 					if (current == NULL) {
-						current = xmmsv_new_dict ();
+						current = xmmsv_arena_new_dict (arena);
 						xmmsv_dict_set (dict, key, current);
 						xmmsv_unref (current);
 					}
@@ -322,28 +327,28 @@ result_to_xmmsv (xmmsv_t *ret, gint32 id, const s4_result_t *res,
 
 		switch (spec->data.metadata.aggr_func) {
 			case AGGREGATE_FIRST:
-				changed = aggregate_first (&current, int_value, str_value);
+				changed = aggregate_first (arena, &current, int_value, str_value);
 				break;
 			case AGGREGATE_LIST:
-				changed = aggregate_list (&current, int_value, str_value);
+				changed = aggregate_list (arena, &current, int_value, str_value);
 				break;
 			case AGGREGATE_SET:
-				changed = aggregate_set (&current, int_value, str_value);
+				changed = aggregate_set (arena, &current, int_value, str_value);
 				break;
 			case AGGREGATE_SUM:
-				changed = aggregate_sum (&current, int_value, str_value);
+				changed = aggregate_sum (arena, &current, int_value, str_value);
 				break;
 			case AGGREGATE_MIN:
-				changed = aggregate_min (&current, int_value, str_value);
+				changed = aggregate_min (arena, &current, int_value, str_value);
 				break;
 			case AGGREGATE_MAX:
-				changed = aggregate_max (&current, int_value, str_value);
+				changed = aggregate_max (arena, &current, int_value, str_value);
 				break;
 			case AGGREGATE_RANDOM:
-				changed = aggregate_random (&current, int_value, str_value);
+				changed = aggregate_random (arena, &current, int_value, str_value);
 				break;
 			case AGGREGATE_AVG:
-				changed = aggregate_average (&current, int_value, str_value);
+				changed = aggregate_average (arena, &current, int_value, str_value);
 				break;
 		}
 
@@ -363,7 +368,8 @@ result_to_xmmsv (xmmsv_t *ret, gint32 id, const s4_result_t *res,
 
 /* Converts the temporary value returned by result_to_xmmsv into the real value */
 static xmmsv_t *
-aggregate_data (xmmsv_t *value, aggregate_function_t aggr_func)
+aggregate_data (xmmsv_arena_t *arena, xmmsv_t *value,
+                aggregate_function_t aggr_func)
 {
 	const random_data_t *random_data;
 	const avg_data_t *avg_data;
@@ -400,7 +406,7 @@ aggregate_data (xmmsv_t *value, aggregate_function_t aggr_func)
 		case AGGREGATE_AVG:
 			avg_data = data;
 			if (avg_data != NULL) {
-				ret = xmmsv_new_int (avg_data->n ? avg_data->sum / avg_data->n : 0);
+				ret = xmmsv_arena_new_int (arena, avg_data->n ? avg_data->sum / avg_data->n : 0);
 			}
 			break;
 	}
@@ -412,7 +418,8 @@ aggregate_data (xmmsv_t *value, aggregate_function_t aggr_func)
 
 /* Applies an aggregation function to the leafs in an xmmsv dict tree */
 static xmmsv_t *
-aggregate_result (xmmsv_t *val, gint depth, aggregate_function_t aggr_func)
+aggregate_result (xmmsv_arena_t *arena, xmmsv_t *val, gint depth,
+                  aggregate_function_t aggr_func)
 {
 	xmmsv_dict_iter_t *it;
 
@@ -421,7 +428,7 @@ aggregate_result (xmmsv_t *val, gint depth, aggregate_function_t aggr_func)
 	}
 
 	if (depth == 0) {
-		return aggregate_data (val, aggr_func);
+		return aggregate_data (arena, val, aggr_func);
 	}
 
 	/* If it's a dict we call this function recursively on all its values */
@@ -433,7 +440,7 @@ aggregate_result (xmmsv_t *val, gint depth, aggregate_function_t aggr_func)
 		xmmsv_dict_iter_pair (it, NULL, &entry);
 		xmmsv_ref (entry);
 
-		entry = aggregate_result (entry, depth - 1, aggr_func);
+		entry = aggregate_result (arena, entry, depth - 1, aggr_func);
 		xmmsv_dict_iter_set (it, entry);
 		xmmsv_unref (entry);
 
@@ -445,7 +452,8 @@ aggregate_result (xmmsv_t *val, gint depth, aggregate_function_t aggr_func)
 
 /* Converts an S4 resultset to an xmmsv using the fetch specification */
 static xmmsv_t *
-metadata_to_xmmsv (s4_resultset_t *set, xmms_fetch_spec_t *spec)
+metadata_to_xmmsv (xmmsv_arena_t *arena, s4_resultset_t *set,
+                   xmms_fetch_spec_t *spec)
 {
 	const s4_resultrow_t *row;
 	xmmsv_t *ret = NULL;
@@ -460,12 +468,12 @@ metadata_to_xmmsv (s4_resultset_t *set, xmms_fetch_spec_t *spec)
 			const s4_result_t *res;
 
 			if (s4_resultrow_get_col (row, spec->data.metadata.cols[j], &res)) {
-				ret = result_to_xmmsv (ret, id, res, spec);
+				ret = result_to_xmmsv (arena, ret, id, res, spec);
 			}
 		}
 	}
 
-	return aggregate_result (ret, spec->data.metadata.get_size - 1,
+	return aggregate_result (arena, ret, spec->data.metadata.get_size - 1,
 	                         spec->data.metadata.aggr_func);
 }
 
@@ -541,7 +549,8 @@ cluster_dict (s4_resultset_t *set, xmms_fetch_spec_t *spec)
 }
 
 static xmmsv_t *
-convert_ghashtable_to_xmmsv (GHashTable *table, xmms_fetch_spec_t *spec)
+convert_ghashtable_to_xmmsv (xmmsv_arena_t *arena, GHashTable *table,
+                             xmms_fetch_spec_t *spec)
 {
 	GHashTableIter iter;
 	s4_resultset_t *value;
@@ -550,7 +559,7 @@ convert_ghashtable_to_xmmsv (GHashTable *table, xmms_fetch_spec_t *spec)
 
 	g_hash_table_iter_init (&iter, table);
 
-	ret = xmmsv_new_dict ();
+	ret = xmmsv_arena_new_dict (arena);
 
 	while (g_hash_table_iter_next (&iter, (gpointer *) &key, (gpointer *) &value)) {
 		xmmsv_t *converted;
@@ -559,7 +568,7 @@ convert_ghashtable_to_xmmsv (GHashTable *table, xmms_fetch_spec_t *spec)
 			continue;
 		}
 
-		converted = xmms_medialib_query_to_xmmsv (value, spec);
+		converted = query_to_xmmsv (arena, value, spec);
 		xmmsv_dict_set (ret, key, converted);
 		xmmsv_unref (converted);
 	}
@@ -573,8 +582,9 @@ convert_ghashtable_to_xmmsv (GHashTable *table, xmms_fetch_spec_t *spec)
 }
 
 /* Converts an S4 resultset into an xmmsv_t, based on the fetch specification */
-xmmsv_t *
-xmms_medialib_query_to_xmmsv (s4_resultset_t *set, xmms_fetch_spec_t *spec)
+static xmmsv_t *
+query_to_xmmsv (xmmsv_arena_t *arena, s4_resultset_t *set,
+                xmms_fetch_spec_t *spec)
 {
 	GHashTable *set_table;
 	GList *sets;
@@ -583,16 +593,16 @@ xmms_medialib_query_to_xmmsv (s4_resultset_t *set, xmms_fetch_spec_t *spec)
 
 	switch (spec->type) {
 		case FETCH_COUNT:
-			ret = xmmsv_new_int (s4_resultset_get_rowcount (set));
+			ret = xmmsv_arena_new_int (arena, s4_resultset_get_rowcount (set));
 			break;
 		case FETCH_METADATA:
-			ret = metadata_to_xmmsv (set, spec);
+			ret = metadata_to_xmmsv (arena, set, spec);
 			break;
 		case FETCH_ORGANIZE:
-			ret = xmmsv_new_dict ();
+			ret = xmmsv_arena_new_dict (arena);
 
 			for (i = 0; i < spec->data.organize.count; i++) {
-				val = xmms_medialib_query_to_xmmsv (set, spec->data.organize.data[i]);
+				val = query_to_xmmsv (arena, set, spec->data.organize.data[i]);
 				if (val != NULL) {
 					xmmsv_dict_set (ret, spec->data.organize.keys[i], val);
 					xmmsv_unref (val);
@@ -601,11 +611,11 @@ xmms_medialib_query_to_xmmsv (s4_resultset_t *set, xmms_fetch_spec_t *spec)
 			break;
 		case FETCH_CLUSTER_LIST:
 			sets = cluster_list (set, spec);
-			ret = xmmsv_new_list ();
+			ret = xmmsv_arena_new_list (arena);
 			for (; sets != NULL; sets = g_list_delete_link (sets, sets)) {
 				set = sets->data;
 
-				val = xmms_medialib_query_to_xmmsv (set, spec->data.cluster.data);
+				val = query_to_xmmsv (arena, set, spec->data.cluster.data);
 				if (val != NULL) {
 					xmmsv_list_append (ret, val);
 					xmmsv_unref (val);
@@ -615,7 +625,7 @@ xmms_medialib_query_to_xmmsv (s4_resultset_t *set, xmms_fetch_spec_t *spec)
 			break;
 		case FETCH_CLUSTER_DICT:
 			set_table = cluster_dict (set, spec);
-			ret = convert_ghashtable_to_xmmsv (set_table, spec->data.cluster.data);
+			ret = convert_ghashtable_to_xmmsv (arena, set_table, spec->data.cluster.data);
 
 			g_hash_table_destroy (set_table);
 			break;
@@ -623,3 +633,26 @@ xmms_medialib_query_to_xmmsv (s4_resultset_t *set, xmms_fetch_spec_t *spec)
 
 	return ret;
 }
+
+/* Converts an S4 resultset into an xmmsv_t, based on the fetch specification.
+ * The reply is built in one arena, so it takes a handful of allocations to
+ * build and to free. Values replaced while aggregating stay on the heap, as
+ * the memory of an arena is only given back all at once.
+ */
+xmmsv_t *
+xmms_medialib_query_to_xmmsv (s4_resultset_t *set, xmms_fetch_spec_t *spec)
+{
+	xmmsv_arena_t *arena;
+	xmmsv_t *ret;
+
+	if (spec->type == FETCH_COUNT) {
+		return query_to_xmmsv (NULL, set, spec);
+	}
+
+	/* a rough guess of a few values per row */
+	arena = xmmsv_arena_new (s4_resultset_get_rowcount (set) * 256);
+	ret = query_to_xmmsv (arena, set, spec);
+	xmmsv_arena_unref (arena);
+
+	return ret;
+}
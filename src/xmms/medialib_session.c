@@ -15,6 +15,8 @@
  */
 
 #include "xmmspriv/xmms_medialib.h"
+#include "xmmspriv/xmms_stats.h"
+#include "xmmspriv/xmms_ipc.h"
 #include "xmms/xmms_object.h"
 #include <string.h>
 
@@ -24,6 +26,10 @@ struct xmms_medialib_session_St {
 	GHashTable *added;
 	GHashTable *updated;
 	GHashTable *removed;
+	/* url -> entry (0 if removed) changed in this session */
+	GHashTable *urls;
+	/* send one entries_changed signal instead of one per entry */
+	gboolean coalesce;
 	xmmsv_t *vals;
 };
 
@@ -31,10 +37,13 @@ static void xmms_medialib_session_free (xmms_medialib_session_t *session);
 static void xmms_medialib_session_free_full (xmms_medialib_session_t *session);
 
 static GHashTable *xmms_medialib_session_get_table (GHashTable **table);
+static void xmms_medialib_session_track_url (xmms_medialib_session_t *session, const s4_val_t *url, xmms_medialib_entry_t entry);
 
 static void xmms_medialib_entry_send_added (xmms_medialib_t *medialib, xmms_medialib_entry_t entry);
 static void xmms_medialib_entry_send_update (xmms_medialib_t *medialib, xmms_medialib_entry_t entry);
 static void xmms_medialib_entry_send_removed (xmms_medialib_t *medialib, xmms_medialib_entry_t entry);
+static void xmms_medialib_entries_send_changed (xmms_medialib_session_t *session);
+static void xmms_medialib_entries_broadcast (xmms_medialib_session_t *session);
 
 static xmms_medialib_session_t *
 xmms_medialib_session_begin_internal (xmms_medialib_t *medialib,
@@ -73,14 +82,40 @@ xmms_medialib_session_abort (xmms_medialib_session_t *session)
 gboolean
 xmms_medialib_session_commit (xmms_medialib_session_t *session)
 {
+	xmms_medialib_url_index_t *index = NULL;
 	GHashTableIter iter;
 	gpointer key;
+	gint64 start;
+
+	start = xmms_stats_now ();
+
+	if (session->urls != NULL) {
+		index = xmms_medialib_get_url_index (session->medialib);
+		xmms_medialib_url_index_lock (index);
+	}
 
 	if (!s4_commit (session->trans)) {
+		if (index != NULL) {
+			xmms_medialib_url_index_unlock (index, NULL);
+		}
+		xmms_stats_count (XMMS_STATS_S4_COMMIT_CONFLICTS, 1);
 		xmms_medialib_session_free_full (session);
 		return FALSE;
 	}
 
+	if (index != NULL) {
+		xmms_medialib_url_index_unlock (index, session->urls);
+	}
+
+	xmms_stats_record_since (XMMS_STATS_S4_COMMIT, start);
+
+	if (session->coalesce) {
+		xmms_medialib_entries_send_changed (session);
+		xmms_medialib_entries_broadcast (session);
+		xmms_medialib_session_free (session);
+		return TRUE;
+	}
+
 	if (session->added != NULL) {
 		g_hash_table_iter_init (&iter, session->added);
 
@@ -118,6 +153,17 @@ xmms_medialib_session_commit (xmms_medialib_session_t *session)
 	return TRUE;
 }
 
+/**
+ * Announce the changes of this session with a single entries_changed
+ * signal when it commits, for sessions that touch many entries.
+ * Clients subscribed to the per-entry broadcasts still receive them.
+ */
+void
+xmms_medialib_session_coalesce_signals (xmms_medialib_session_t *session)
+{
+	session->coalesce = TRUE;
+}
+
 s4_sourcepref_t *
 xmms_medialib_session_get_source_preferences (xmms_medialib_session_t *session)
 {
@@ -168,6 +214,9 @@ xmms_medialib_session_property_set (xmms_medialib_session_t *session,
 		const s4_val_t *old_value = s4_result_get_val (res);
 		s4_del (session->trans, "song_id", song_id,
 		        key, old_value, source);
+		if (strcmp (key, XMMS_MEDIALIB_ENTRY_PROPERTY_URL) == 0) {
+			xmms_medialib_session_track_url (session, old_value, 0);
+		}
 	}
 
 	s4_resultset_free (set);
@@ -179,6 +228,7 @@ xmms_medialib_session_property_set (xmms_medialib_session_t *session,
 	s4_val_free (song_id);
 
 	if (strcmp (key, XMMS_MEDIALIB_ENTRY_PROPERTY_URL) == 0) {
+		xmms_medialib_session_track_url (session, value, entry);
 		events = xmms_medialib_session_get_table (&session->added);
 	} else {
 		events = xmms_medialib_session_get_table (&session->updated);
@@ -208,6 +258,7 @@ xmms_medialib_session_property_unset (xmms_medialib_session_t *session,
 	s4_val_free (song_id);
 
 	if (strcmp (key, XMMS_MEDIALIB_ENTRY_PROPERTY_URL) == 0) {
+		xmms_medialib_session_track_url (session, value, 0);
 		events = xmms_medialib_session_get_table (&session->removed);
 	} else {
 		events = xmms_medialib_session_get_table (&session->updated);
@@ -220,6 +271,52 @@ xmms_medialib_session_property_unset (xmms_medialib_session_t *session,
 	return result;
 }
 
+/**
+ * Look up the entry of an encoded url as seen by this session.
+ *
+ * Urls changed in the session are answered from the session itself,
+ * everything else from the url index of the medialib.
+ *
+ * @returns TRUE if the url was found, FALSE if the database has to be
+ * asked.
+ */
+gboolean
+xmms_medialib_session_url_lookup (xmms_medialib_session_t *session,
+                                  const gchar *url,
+                                  xmms_medialib_entry_t *entry)
+{
+	gpointer value;
+
+	if (session->urls != NULL &&
+	    g_hash_table_lookup_extended (session->urls, url, NULL, &value)) {
+		*entry = GPOINTER_TO_INT (value);
+		return *entry != 0;
+	}
+
+	*entry = xmms_medialib_url_index_lookup (xmms_medialib_get_url_index (session->medialib), url);
+
+	return *entry != 0;
+}
+
+static void
+xmms_medialib_session_track_url (xmms_medialib_session_t *session,
+                                 const s4_val_t *url,
+                                 xmms_medialib_entry_t entry)
+{
+	const gchar *str;
+
+	if (!s4_val_get_str (url, &str)) {
+		return;
+	}
+
+	if (session->urls == NULL) {
+		session->urls = g_hash_table_new_full (g_str_hash, g_str_equal,
+		                                       g_free, NULL);
+	}
+
+	g_hash_table_insert (session->urls, g_strdup (str), GINT_TO_POINTER (entry));
+}
+
 void
 xmms_medialib_session_track_garbage (xmms_medialib_session_t *session,
                                      xmmsv_t *data)
@@ -254,6 +351,8 @@ xmms_medialib_session_free (xmms_medialib_session_t *session)
 		g_hash_table_unref (session->updated);
 	if (session->removed != NULL)
 		g_hash_table_unref (session->removed);
+	if (session->urls != NULL)
+		g_hash_table_unref (session->urls);
 	if (session->vals != NULL)
 		xmmsv_unref (session->vals);
 
@@ -311,3 +410,106 @@ xmms_medialib_entry_send_removed (xmms_medialib_t *medialib, xmms_medialib_entry
 	                  XMMS_IPC_SIGNAL_MEDIALIB_ENTRY_REMOVED,
 	                  xmmsv_new_int (entry));
 }
+
+static xmmsv_t *
+xmms_medialib_entries_list (GHashTable *entries, GHashTable *skip1,
+                            GHashTable *skip2)
+{
+	GHashTableIter iter;
+	gpointer key;
+	xmmsv_t *list;
+
+	list = xmmsv_new_list ();
+
+	if (entries == NULL) {
+		return list;
+	}
+
+	g_hash_table_iter_init (&iter, entries);
+	while (g_hash_table_iter_next (&iter, &key, NULL)) {
+		if ((skip1 && g_hash_table_lookup (skip1, key)) ||
+		    (skip2 && g_hash_table_lookup (skip2, key))) {
+			continue;
+		}
+		xmmsv_list_append_int (list, GPOINTER_TO_INT (key));
+	}
+
+	return list;
+}
+
+/**
+ * Trigger one entries_changed signal for all entries added, changed
+ * and removed in a session.
+ */
+static void
+xmms_medialib_entries_send_changed (xmms_medialib_session_t *session)
+{
+	xmmsv_t *added, *changed, *removed;
+
+	if (session->added == NULL && session->updated == NULL &&
+	    session->removed == NULL) {
+		return;
+	}
+
+	added = xmms_medialib_entries_list (session->added, NULL, NULL);
+	removed = xmms_medialib_entries_list (session->removed, NULL, NULL);
+	changed = xmms_medialib_entries_list (session->updated, session->added,
+	                                      session->removed);
+
+	xmms_object_emit (XMMS_OBJECT (session->medialib),
+	                  XMMS_IPC_SIGNAL_MEDIALIB_ENTRIES_CHANGED,
+	                  xmmsv_build_dict (XMMSV_DICT_ENTRY ("added", added),
+	                                    XMMSV_DICT_ENTRY ("changed", changed),
+	                                    XMMSV_DICT_ENTRY ("removed", removed),
+	                                    XMMSV_DICT_END));
+}
+
+static void
+xmms_medialib_entries_broadcast_table (GHashTable *entries, GHashTable *skip1,
+                                       GHashTable *skip2,
+                                       xmms_ipc_signals_t signalid)
+{
+	GHashTableIter iter;
+	gpointer key;
+	xmmsv_t *value;
+
+	if (entries == NULL) {
+		return;
+	}
+
+	if (!xmms_ipc_broadcast_wanted (signalid, XMMS_IPC_SIGNAL_MEDIALIB_ENTRIES_CHANGED)) {
+		return;
+	}
+
+	g_hash_table_iter_init (&iter, entries);
+	while (g_hash_table_iter_next (&iter, &key, NULL)) {
+		if ((skip1 && g_hash_table_lookup (skip1, key)) ||
+		    (skip2 && g_hash_table_lookup (skip2, key))) {
+			continue;
+		}
+		value = xmmsv_new_int (GPOINTER_TO_INT (key));
+		xmms_ipc_broadcast_send (signalid, XMMS_IPC_SIGNAL_MEDIALIB_ENTRIES_CHANGED,
+		                         value);
+		xmmsv_unref (value);
+	}
+}
+
+/**
+ * Send the per-entry added, removed and update broadcasts of a
+ * coalesced session to clients. The server itself only acts on the
+ * entries_changed signal, so these are not emitted on the medialib.
+ * Clients subscribed to entries_changed already got every id in one
+ * message and are skipped, and when no other client listens nothing
+ * is sent at all.
+ */
+static void
+xmms_medialib_entries_broadcast (xmms_medialib_session_t *session)
+{
+	xmms_medialib_entries_broadcast_table (session->added, NULL, NULL,
+	                                       XMMS_IPC_SIGNAL_MEDIALIB_ENTRY_ADDED);
+	xmms_medialib_entries_broadcast_table (session->removed, NULL, NULL,
+	                                       XMMS_IPC_SIGNAL_MEDIALIB_ENTRY_REMOVED);
+	xmms_medialib_entries_broadcast_table (session->updated, session->added,
+	                                       session->removed,
+	                                       XMMS_IPC_SIGNAL_MEDIALIB_ENTRY_UPDATE);
+}
@@ -0,0 +1,235 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2012 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+#include "xmmspriv/xmms_medialib.h"
+#include <string.h>
+
+/**
+ * @file
+ * In-memory index from encoded url to medialib entry.
+ *
+ * The index mirrors the committed url properties of the medialib. It is
+ * filled when the medialib is opened and updated by every session that
+ * changed an url, while that session commits.
+ */
+
+typedef struct xmms_medialib_url_node_St {
+	gchar *url;
+	xmms_medialib_entry_t entry;
+	GSequenceIter *iter;
+} xmms_medialib_url_node_t;
+
+struct xmms_medialib_url_index_St {
+	GMutex *mutex;
+	/* url -> node */
+	GHashTable *urls;
+	/* nodes ordered by url, for prefix lookups */
+	GSequence *sorted;
+};
+
+static gint
+xmms_medialib_url_node_compare (gconstpointer a, gconstpointer b, gpointer udata)
+{
+	const xmms_medialib_url_node_t *na = a, *nb = b;
+
+	return strcmp (na->url, nb->url);
+}
+
+static void
+xmms_medialib_url_node_free (gpointer data)
+{
+	xmms_medialib_url_node_t *node = data;
+
+	g_free (node->url);
+	g_free (node);
+}
+
+xmms_medialib_url_index_t *
+xmms_medialib_url_index_new (void)
+{
+	xmms_medialib_url_index_t *index;
+
+	index = g_new0 (xmms_medialib_url_index_t, 1);
+	index->mutex = g_mutex_new ();
+	index->urls = g_hash_table_new (g_str_hash, g_str_equal);
+	index->sorted = g_sequence_new (xmms_medialib_url_node_free);
+
+	return index;
+}
+
+void
+xmms_medialib_url_index_free (xmms_medialib_url_index_t *index)
+{
+	g_return_if_fail (index);
+
+	g_hash_table_destroy (index->urls);
+	g_sequence_free (index->sorted);
+	g_mutex_free (index->mutex);
+	g_free (index);
+}
+
+static void
+xmms_medialib_url_index_set_unlocked (xmms_medialib_url_index_t *index,
+                                      const gchar *url,
+                                      xmms_medialib_entry_t entry)
+{
+	xmms_medialib_url_node_t *node;
+
+	node = g_hash_table_lookup (index->urls, url);
+
+	if (entry == 0) {
+		if (node) {
+			g_hash_table_remove (index->urls, url);
+			g_sequence_remove (node->iter);
+		}
+		return;
+	}
+
+	if (node) {
+		node->entry = entry;
+		return;
+	}
+
+	node = g_new (xmms_medialib_url_node_t, 1);
+	node->url = g_strdup (url);
+	node->entry = entry;
+	node->iter = g_sequence_insert_sorted (index->sorted, node,
+	                                       xmms_medialib_url_node_compare,
+	                                       NULL);
+
+	g_hash_table_insert (index->urls, node->url, node);
+}
+
+/**
+ * Map an url to an entry, or remove the url from the index if entry is 0.
+ */
+void
+xmms_medialib_url_index_set (xmms_medialib_url_index_t *index,
+                             const gchar *url, xmms_medialib_entry_t entry)
+{
+	g_return_if_fail (index);
+	g_return_if_fail (url);
+
+	g_mutex_lock (index->mutex);
+	xmms_medialib_url_index_set_unlocked (index, url, entry);
+	g_mutex_unlock (index->mutex);
+}
+
+/**
+ * Look up the entry of an encoded url.
+ *
+ * @returns the entry or 0 if the url is not in the index
+ */
+xmms_medialib_entry_t
+xmms_medialib_url_index_lookup (xmms_medialib_url_index_t *index,
+                                const gchar *url)
+{
+	xmms_medialib_url_node_t *node;
+	xmms_medialib_entry_t entry = 0;
+
+	g_return_val_if_fail (index, 0);
+	g_return_val_if_fail (url, 0);
+
+	g_mutex_lock (index->mutex);
+	node = g_hash_table_lookup (index->urls, url);
+	if (node) {
+		entry = node->entry;
+	}
+	g_mutex_unlock (index->mutex);
+
+	return entry;
+}
+
+/**
+ * Call func for every url starting with prefix, in url order.
+ *
+ * The index is locked during the iteration, func must not use it.
+ */
+void
+xmms_medialib_url_index_foreach_prefix (xmms_medialib_url_index_t *index,
+                                        const gchar *prefix,
+                                        xmms_medialib_url_index_func_t func,
+                                        gpointer udata)
+{
+	xmms_medialib_url_node_t probe, *node;
+	GSequenceIter *iter;
+	gsize len;
+
+	g_return_if_fail (index);
+	g_return_if_fail (prefix);
+	g_return_if_fail (func);
+
+	probe.url = (gchar *) prefix;
+	len = strlen (prefix);
+
+	g_mutex_lock (index->mutex);
+
+	/* search returns the position after any node equal to the probe */
+	iter = g_sequence_search (index->sorted, &probe,
+	                          xmms_medialib_url_node_compare, NULL);
+
+	if (!g_sequence_iter_is_begin (iter)) {
+		GSequenceIter *prev = g_sequence_iter_prev (iter);
+		node = g_sequence_get (prev);
+		if (strcmp (node->url, prefix) == 0) {
+			iter = prev;
+		}
+	}
+
+	for (; !g_sequence_iter_is_end (iter); iter = g_sequence_iter_next (iter)) {
+		node = g_sequence_get (iter);
+		if (strncmp (node->url, prefix, len) != 0) {
+			break;
+		}
+		func (node->url, node->entry, udata);
+	}
+
+	g_mutex_unlock (index->mutex);
+}
+
+/**
+ * Hold back lookups while a session that changed urls commits, so the
+ * index changes in the same order as the database.
+ */
+void
+xmms_medialib_url_index_lock (xmms_medialib_url_index_t *index)
+{
+	g_mutex_lock (index->mutex);
+}
+
+/**
+ * Apply the url changes of a committed session and release the index.
+ *
+ * @param changes url -> entry, 0 for urls that were removed, or NULL if
+ * the session did not commit.
+ */
+void
+xmms_medialib_url_index_unlock (xmms_medialib_url_index_t *index,
+                                GHashTable *changes)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+
+	if (changes != NULL) {
+		g_hash_table_iter_init (&iter, changes);
+		while (g_hash_table_iter_next (&iter, &key, &value)) {
+			xmms_medialib_url_index_set_unlocked (index, key,
+			                                      GPOINTER_TO_INT (value));
+		}
+	}
+
+	g_mutex_unlock (index->mutex);
+}
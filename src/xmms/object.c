@@ -17,6 +17,7 @@
 #include "xmms/xmms_object.h"
 #include "xmms/xmms_log.h"
 #include "xmmsc/xmmsc_idnumbers.h"
+#include "xmmspriv/xmms_stats.h"
 
 #include <stdarg.h>
 #include <string.h>
@@ -37,15 +38,45 @@ typedef struct {
 	gpointer userdata;
 } xmms_object_handler_entry_t;
 
-static gboolean
-cleanup_signal_list (gpointer key, gpointer value, gpointer data)
+/**
+ * The handlers connected to a signal.
+ *
+ * A list is never modified once it is stored in the signal tree,
+ * connect and disconnect store a modified copy instead. Emitting only
+ * has to take a reference on the current list while holding the lock,
+ * and can call the handlers without allocating anything.
+ */
+typedef struct {
+	gint ref;
+	guint length;
+	xmms_object_handler_entry_t entries[];
+} xmms_object_handler_list_t;
+
+static xmms_object_handler_list_t *
+xmms_object_handler_list_new (guint length)
 {
-	GList *list = value;
+	xmms_object_handler_list_t *list;
+
+	list = g_malloc (sizeof (xmms_object_handler_list_t) +
+	                 length * sizeof (xmms_object_handler_entry_t));
+	list->ref = 1;
+	list->length = length;
+
+	return list;
+}
 
-	while (list) {
-		g_free (list->data);
-		list = g_list_delete_link (list, list);
+static void
+xmms_object_handler_list_unref (xmms_object_handler_list_t *list)
+{
+	if (list && g_atomic_int_dec_and_test (&list->ref)) {
+		g_free (list);
 	}
+}
+
+static gboolean
+cleanup_signal_list (gpointer key, gpointer value, gpointer data)
+{
+	xmms_object_handler_list_unref (value);
 
 	return FALSE; /* keep going */
 }
@@ -110,16 +141,15 @@ void
 xmms_object_connect (xmms_object_t *object, guint32 signalid,
                      xmms_object_handler_t handler, gpointer userdata)
 {
-	GList *list = NULL;
+	xmms_object_handler_list_t *list = NULL, *copy;
 	xmms_object_handler_entry_t *entry;
+	guint length = 0;
 
 	g_return_if_fail (object);
 	g_return_if_fail (XMMS_IS_OBJECT (object));
 	g_return_if_fail (handler);
 
-	entry = g_new0 (xmms_object_handler_entry_t, 1);
-	entry->handler = handler;
-	entry->userdata = userdata;
+	g_mutex_lock (object->mutex);
 
 	if (!object->signals)
 		object->signals = g_tree_new (compare_signal_key);
@@ -127,10 +157,27 @@ xmms_object_connect (xmms_object_t *object, guint32 signalid,
 		list = g_tree_lookup (object->signals,
 		                      GINT_TO_POINTER (signalid));
 
-	list = g_list_prepend (list, entry);
+	if (list) {
+		length = list->length;
+	}
+
+	/* handlers are called in the order they were connected */
+	copy = xmms_object_handler_list_new (length + 1);
+	if (list) {
+		memcpy (copy->entries, list->entries,
+		        length * sizeof (xmms_object_handler_entry_t));
+	}
+
+	entry = &copy->entries[length];
+	entry->handler = handler;
+	entry->userdata = userdata;
+
+	g_tree_insert (object->signals, GINT_TO_POINTER (signalid), copy);
+
+	g_mutex_unlock (object->mutex);
 
-	/* store the list's new head in the tree */
-	g_tree_insert (object->signals, GINT_TO_POINTER (signalid), list);
+	/* emits that already hold the old list keep it alive */
+	xmms_object_handler_list_unref (list);
 }
 
 /**
@@ -141,8 +188,9 @@ void
 xmms_object_disconnect (xmms_object_t *object, guint32 signalid,
                         xmms_object_handler_t handler, gpointer userdata)
 {
-	GList *list, *node = NULL;
+	xmms_object_handler_list_t *list = NULL, *copy;
 	xmms_object_handler_entry_t *entry;
+	gint i, found = -1;
 
 	g_return_if_fail (object);
 	g_return_if_fail (XMMS_IS_OBJECT (object));
@@ -153,34 +201,45 @@ xmms_object_disconnect (xmms_object_t *object, guint32 signalid,
 	if (object->signals) {
 		list = g_tree_lookup (object->signals,
 		                      GINT_TO_POINTER (signalid));
+	}
 
-		for (node = list; node; node = g_list_next (node)) {
-			entry = node->data;
+	for (i = 0; list && i < list->length; i++) {
+		entry = &list->entries[i];
 
-			if (entry->handler == handler && entry->userdata == userdata)
-				break;
+		if (entry->handler == handler && entry->userdata == userdata) {
+			found = i;
+			break;
 		}
+	}
 
-		if (node) {
-			list = g_list_remove_link (list, node);
+	if (found >= 0) {
+		if (list->length == 1) {
+			g_tree_remove (object->signals, GINT_TO_POINTER (signalid));
+		} else {
+			copy = xmms_object_handler_list_new (list->length - 1);
+			memcpy (copy->entries, list->entries,
+			        found * sizeof (xmms_object_handler_entry_t));
+			memcpy (copy->entries + found, list->entries + found + 1,
+			        (list->length - found - 1) * sizeof (xmms_object_handler_entry_t));
 
-			/* store the list's new head in the tree */
 			g_tree_insert (object->signals,
-			               GINT_TO_POINTER (signalid), list);
+			               GINT_TO_POINTER (signalid), copy);
 		}
 	}
 
 	g_mutex_unlock (object->mutex);
 
-	g_return_if_fail (node);
+	g_return_if_fail (found >= 0);
 
-	g_free (node->data);
-	g_list_free_1 (node);
+	xmms_object_handler_list_unref (list);
 }
 
 /**
   * Emit a signal and thus call all the handlers that are connected.
   *
+  * The handlers connected at the time of the call are run, even if
+  * some of them are disconnected meanwhile.
+  *
   * @param object the object to signal on.
   * @param signalid the signalid to emit
   * @param data the data that should be sent to the handler.
@@ -189,40 +248,42 @@ xmms_object_disconnect (xmms_object_t *object, guint32 signalid,
 void
 xmms_object_emit (xmms_object_t *object, guint32 signalid, xmmsv_t *data)
 {
-	GList *list, *node, *list2 = NULL;
+	xmms_object_handler_list_t *list = NULL;
 	xmms_object_handler_entry_t *entry;
+	gint64 start;
+	guint i;
 
 	g_return_if_fail (object);
 	g_return_if_fail (XMMS_IS_OBJECT (object));
 
+	start = xmms_stats_now ();
+
 	g_mutex_lock (object->mutex);
 
 	if (object->signals) {
 		list = g_tree_lookup (object->signals,
 		                      GINT_TO_POINTER (signalid));
-
-		for (node = list; node; node = g_list_next (node)) {
-			entry = node->data;
-
-			list2 = g_list_prepend (list2, entry);
+		if (list) {
+			g_atomic_int_inc (&list->ref);
 		}
 	}
 
 	g_mutex_unlock (object->mutex);
 
-	while (list2) {
-		entry = list2->data;
+	for (i = 0; list && i < list->length; i++) {
+		entry = &list->entries[i];
 
 		/* NULL entries may never be added to the trees. */
-		g_assert (entry);
 		g_assert (entry->handler);
 
 		entry->handler (object, data, entry->userdata);
-
-		list2 = g_list_delete_link (list2, list2);
 	}
 
+	xmms_object_handler_list_unref (list);
+
 	xmmsv_unref (data);
+
+	xmms_stats_record_signal (signalid, start);
 }
 
 /**
@@ -30,6 +30,7 @@
 #include "xmmspriv/xmms_medialib.h"
 #include "xmmspriv/xmms_outputplugin.h"
 #include "xmmspriv/xmms_thread_name.h"
+#include "xmmspriv/xmms_stats.h"
 #include "xmms/xmms_log.h"
 #include "xmms/xmms_ipc.h"
 #include "xmms/xmms_object.h"
@@ -373,6 +374,7 @@ xmms_output_filler (void *arg)
 	gboolean last_was_kill = FALSE;
 	char buf[4096];
 	xmms_error_t err;
+	gint64 start;
 	gint ret;
 
 	xmms_error_reset (&err);
@@ -485,7 +487,9 @@ xmms_output_filler (void *arg)
 		}
 		g_mutex_unlock (output->filler_mutex);
 
+		start = xmms_stats_now ();
 		ret = xmms_xform_this_read (chain, buf, sizeof (buf), &err);
+		xmms_stats_record_since (XMMS_STATS_FILLER_READ, start);
 
 		g_mutex_lock (output->filler_mutex);
 
@@ -534,6 +538,7 @@ xmms_output_read (xmms_output_t *output, char *buffer, gint len)
 	g_return_val_if_fail (buffer, -1);
 
 	g_mutex_lock (output->filler_mutex);
+	xmms_stats_record (XMMS_STATS_RING_FILL, xmms_ringbuf_bytes_used (output->filler_buffer));
 	xmms_ringbuf_wait_used (output->filler_buffer, len, output->filler_mutex);
 	ret = xmms_ringbuf_read (output->filler_buffer, buffer, len);
 	if (ret == 0 && xmms_ringbuf_iseos (output->filler_buffer)) {
@@ -555,9 +560,11 @@ xmms_output_read (xmms_output_t *output, char *buffer, gint len)
 			xmms_log_error ("***********************************");
 		}
 		output->buffer_underruns++;
+		xmms_stats_count (XMMS_STATS_OUTPUT_UNDERRUNS, 1);
 	}
 
 	output->bytes_written += ret;
+	xmms_stats_count (XMMS_STATS_OUTPUT_BYTES, ret);
 
 	return ret;
 }
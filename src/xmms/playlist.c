@@ -231,6 +231,8 @@ xmms_playlist_update (xmms_playlist_t *playlist, const gchar *plname)
 typedef struct {
 	xmms_playlist_t *pls;
 	xmms_medialib_entry_t entry;
+	/* if set, remove all entries in this set instead */
+	GHashTable *entries;
 } playlist_remove_context_t;
 
 static void
@@ -244,7 +246,8 @@ remove_from_playlist (gpointer key, gpointer value, gpointer udata)
 	guint32 i;
 
 	for (i = 0; xmmsv_coll_idlist_get_index (coll, i, &val); i++) {
-		if (val == ctx->entry) {
+		if (ctx->entries != NULL ? g_hash_table_lookup (ctx->entries, GINT_TO_POINTER (val)) != NULL
+		                         : val == ctx->entry) {
 			XMMS_DBG ("removing entry on pos %d in %s", i, name);
 			xmms_playlist_remove_unlocked (ctx->pls, name, coll, i, NULL);
 			i--; /* reset it */
@@ -264,6 +267,7 @@ on_medialib_entry_removed (xmms_object_t *object, xmmsv_t *val, gpointer udata)
 
 	ctx.pls = playlist;
 	ctx.entry = entry;
+	ctx.entries = NULL;
 
 	g_mutex_lock (playlist->mutex);
 
@@ -274,6 +278,46 @@ on_medialib_entry_removed (xmms_object_t *object, xmmsv_t *val, gpointer udata)
 	g_mutex_unlock (playlist->mutex);
 }
 
+static void
+on_medialib_entries_changed (xmms_object_t *object, xmmsv_t *val, gpointer udata)
+{
+	xmms_playlist_t *playlist = (xmms_playlist_t *) udata;
+	playlist_remove_context_t ctx;
+	xmmsv_list_iter_t *it;
+	xmmsv_t *removed;
+	gint entry;
+
+	g_return_if_fail (playlist);
+
+	if (!xmmsv_dict_get (val, "removed", &removed) ||
+	    xmmsv_list_get_size (removed) == 0) {
+		return;
+	}
+
+	ctx.pls = playlist;
+	ctx.entry = 0;
+	ctx.entries = g_hash_table_new (NULL, NULL);
+
+	xmmsv_get_list_iter (removed, &it);
+	for (; xmmsv_list_iter_valid (it); xmmsv_list_iter_next (it)) {
+		if (xmmsv_list_iter_entry_int (it, &entry)) {
+			g_hash_table_insert (ctx.entries, GINT_TO_POINTER (entry),
+			                     GINT_TO_POINTER (entry));
+		}
+	}
+
+	/* one pass over the playlists for all removed entries */
+	g_mutex_lock (playlist->mutex);
+
+	xmms_collection_foreach_in_namespace (playlist->colldag,
+	                                      XMMS_COLLECTION_NSID_PLAYLISTS,
+	                                      remove_from_playlist, &ctx);
+
+	g_mutex_unlock (playlist->mutex);
+
+	g_hash_table_destroy (ctx.entries);
+}
+
 static void
 on_collection_changed (xmms_object_t *object, xmmsv_t *val, gpointer udata)
 {
@@ -326,6 +370,10 @@ xmms_playlist_init (xmms_medialib_t *medialib, xmms_coll_dag_t *colldag)
 	                     XMMS_IPC_SIGNAL_MEDIALIB_ENTRY_REMOVED,
 	                     on_medialib_entry_removed, ret);
 
+	xmms_object_connect (XMMS_OBJECT (ret->medialib),
+	                     XMMS_IPC_SIGNAL_MEDIALIB_ENTRIES_CHANGED,
+	                     on_medialib_entries_changed, ret);
+
 	xmms_object_connect (XMMS_OBJECT (ret->colldag),
 	                     XMMS_IPC_SIGNAL_COLLECTION_CHANGED,
 	                     on_collection_changed, ret);
@@ -1236,6 +1284,10 @@ xmms_playlist_destroy (xmms_object_t *object)
 	                        XMMS_IPC_SIGNAL_MEDIALIB_ENTRY_REMOVED,
 	                        on_medialib_entry_removed, playlist);
 
+	xmms_object_disconnect (XMMS_OBJECT (playlist->medialib),
+	                        XMMS_IPC_SIGNAL_MEDIALIB_ENTRIES_CHANGED,
+	                        on_medialib_entries_changed, playlist);
+
 	xmms_object_disconnect (XMMS_OBJECT (playlist->colldag),
 	                        XMMS_IPC_SIGNAL_COLLECTION_CHANGED,
 	                        on_collection_changed, playlist);
@@ -0,0 +1,415 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2012 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+#include <glib.h>
+
+#include "xmmspriv/xmms_sample.h"
+
+#if defined (__AVX2__)
+# include <immintrin.h>
+# define XMMS_GAIN_IMPL "avx2"
+#elif defined (__SSE2__)
+# include <emmintrin.h>
+# define XMMS_GAIN_IMPL "sse2"
+#elif defined (__ARM_NEON__) || defined (__ARM_NEON)
+# include <arm_neon.h>
+# define XMMS_GAIN_IMPL "neon"
+#else
+# define XMMS_GAIN_IMPL "scalar"
+#endif
+
+/**
+  * @defgroup SampleGain Sample Gain
+  * @ingroup Sample
+  * @brief Multiply samples by a gain factor and clip them to the format.
+  *
+  * The kernels are selected at compile time from the instruction sets
+  * the compiler targets. Each vector loop handles a whole number of
+  * vectors and leaves the remainder to the scalar code, so all variants
+  * produce the same result as the scalar one.
+  * @{
+  */
+
+static void
+gain_s8 (xmms_samples8_t *samples, guint len, gfloat gain)
+{
+	guint i;
+
+	for (i = 0; i < len; i++) {
+		gfloat sample = samples[i] * gain;
+		samples[i] = CLAMP (sample, XMMS_SAMPLES8_MIN, XMMS_SAMPLES8_MAX);
+	}
+}
+
+static void
+gain_u8 (xmms_sampleu8_t *samples, guint len, gfloat gain)
+{
+	guint i;
+
+	for (i = 0; i < len; i++) {
+		gfloat sample = samples[i] * gain;
+		samples[i] = CLAMP (sample, 0, XMMS_SAMPLEU8_MAX);
+	}
+}
+
+static void
+gain_s16 (xmms_samples16_t *samples, guint len, gfloat gain)
+{
+	guint i;
+
+	for (i = 0; i < len; i++) {
+		gfloat sample = samples[i] * gain;
+		samples[i] = CLAMP (sample, XMMS_SAMPLES16_MIN, XMMS_SAMPLES16_MAX);
+	}
+}
+
+static void
+gain_u16 (xmms_sampleu16_t *samples, guint len, gfloat gain)
+{
+	guint i;
+
+	for (i = 0; i < len; i++) {
+		gfloat sample = samples[i] * gain;
+		samples[i] = CLAMP (sample, 0, XMMS_SAMPLEU16_MAX);
+	}
+}
+
+static void
+gain_s32 (xmms_samples32_t *samples, guint len, gfloat gain)
+{
+	guint i;
+
+	for (i = 0; i < len; i++) {
+		gdouble sample = samples[i] * (gdouble) gain;
+		samples[i] = CLAMP (sample, XMMS_SAMPLES32_MIN, XMMS_SAMPLES32_MAX);
+	}
+}
+
+static void
+gain_u32 (xmms_sampleu32_t *samples, guint len, gfloat gain)
+{
+	guint i;
+
+	for (i = 0; i < len; i++) {
+		gdouble sample = samples[i] * (gdouble) gain;
+		samples[i] = CLAMP (sample, 0, XMMS_SAMPLEU32_MAX);
+	}
+}
+
+static void
+gain_float (xmms_samplefloat_t *samples, guint len, gfloat gain)
+{
+	guint i;
+
+	for (i = 0; i < len; i++) {
+		samples[i] *= gain;
+	}
+}
+
+static void
+gain_double (xmms_sampledouble_t *samples, guint len, gfloat gain)
+{
+	guint i;
+
+	for (i = 0; i < len; i++) {
+		samples[i] *= gain;
+	}
+}
+
+#if defined (__AVX2__)
+
+static guint
+gain_s16_simd (xmms_samples16_t *samples, guint len, gfloat gain)
+{
+	const __m256 g = _mm256_set1_ps (gain);
+	const __m256 lo = _mm256_set1_ps (XMMS_SAMPLES16_MIN);
+	const __m256 hi = _mm256_set1_ps (XMMS_SAMPLES16_MAX);
+	guint i;
+
+	for (i = 0; i + 16 <= len; i += 16) {
+		__m128i *p = (__m128i *) (samples + i);
+		__m256 a, b;
+		__m256i packed;
+
+		a = _mm256_cvtepi32_ps (_mm256_cvtepi16_epi32 (_mm_loadu_si128 (p)));
+		b = _mm256_cvtepi32_ps (_mm256_cvtepi16_epi32 (_mm_loadu_si128 (p + 1)));
+
+		a = _mm256_max_ps (_mm256_min_ps (_mm256_mul_ps (a, g), hi), lo);
+		b = _mm256_max_ps (_mm256_min_ps (_mm256_mul_ps (b, g), hi), lo);
+
+		/* packs works per 128 bit lane, put the quadwords back in order */
+		packed = _mm256_packs_epi32 (_mm256_cvttps_epi32 (a),
+		                             _mm256_cvttps_epi32 (b));
+		packed = _mm256_permute4x64_epi64 (packed, 0xd8);
+
+		_mm256_storeu_si256 ((__m256i *) (samples + i), packed);
+	}
+
+	return i;
+}
+
+static guint
+gain_s32_simd (xmms_samples32_t *samples, guint len, gfloat gain)
+{
+	const __m256d g = _mm256_set1_pd (gain);
+	const __m256d lo = _mm256_set1_pd (XMMS_SAMPLES32_MIN);
+	const __m256d hi = _mm256_set1_pd (XMMS_SAMPLES32_MAX);
+	guint i;
+
+	for (i = 0; i + 4 <= len; i += 4) {
+		__m128i *p = (__m128i *) (samples + i);
+		__m256d a;
+
+		a = _mm256_mul_pd (_mm256_cvtepi32_pd (_mm_loadu_si128 (p)), g);
+		a = _mm256_max_pd (_mm256_min_pd (a, hi), lo);
+
+		_mm_storeu_si128 (p, _mm256_cvttpd_epi32 (a));
+	}
+
+	return i;
+}
+
+static guint
+gain_float_simd (xmms_samplefloat_t *samples, guint len, gfloat gain)
+{
+	const __m256 g = _mm256_set1_ps (gain);
+	guint i;
+
+	for (i = 0; i + 8 <= len; i += 8) {
+		__m256 a = _mm256_loadu_ps (samples + i);
+		_mm256_storeu_ps (samples + i, _mm256_mul_ps (a, g));
+	}
+
+	return i;
+}
+
+#elif defined (__SSE2__)
+
+static guint
+gain_s16_simd (xmms_samples16_t *samples, guint len, gfloat gain)
+{
+	const __m128 g = _mm_set1_ps (gain);
+	const __m128 lo = _mm_set1_ps (XMMS_SAMPLES16_MIN);
+	const __m128 hi = _mm_set1_ps (XMMS_SAMPLES16_MAX);
+	guint i;
+
+	for (i = 0; i + 8 <= len; i += 8) {
+		__m128i *p = (__m128i *) (samples + i);
+		__m128i x = _mm_loadu_si128 (p);
+		__m128 a, b;
+
+		/* sign extend by shifting the duplicated halves back down */
+		a = _mm_cvtepi32_ps (_mm_srai_epi32 (_mm_unpacklo_epi16 (x, x), 16));
+		b = _mm_cvtepi32_ps (_mm_srai_epi32 (_mm_unpackhi_epi16 (x, x), 16));
+
+		a = _mm_max_ps (_mm_min_ps (_mm_mul_ps (a, g), hi), lo);
+		b = _mm_max_ps (_mm_min_ps (_mm_mul_ps (b, g), hi), lo);
+
+		_mm_storeu_si128 (p, _mm_packs_epi32 (_mm_cvttps_epi32 (a),
+		                                      _mm_cvttps_epi32 (b)));
+	}
+
+	return i;
+}
+
+static guint
+gain_s32_simd (xmms_samples32_t *samples, guint len, gfloat gain)
+{
+	const __m128d g = _mm_set1_pd (gain);
+	const __m128d lo = _mm_set1_pd (XMMS_SAMPLES32_MIN);
+	const __m128d hi = _mm_set1_pd (XMMS_SAMPLES32_MAX);
+	guint i;
+
+	for (i = 0; i + 4 <= len; i += 4) {
+		__m128i *p = (__m128i *) (samples + i);
+		__m128i x = _mm_loadu_si128 (p);
+		__m128d a, b;
+
+		a = _mm_mul_pd (_mm_cvtepi32_pd (x), g);
+		b = _mm_mul_pd (_mm_cvtepi32_pd (_mm_unpackhi_epi64 (x, x)), g);
+
+		a = _mm_max_pd (_mm_min_pd (a, hi), lo);
+		b = _mm_max_pd (_mm_min_pd (b, hi), lo);
+
+		_mm_storeu_si128 (p, _mm_unpacklo_epi64 (_mm_cvttpd_epi32 (a),
+		                                         _mm_cvttpd_epi32 (b)));
+	}
+
+	return i;
+}
+
+static guint
+gain_float_simd (xmms_samplefloat_t *samples, guint len, gfloat gain)
+{
+	const __m128 g = _mm_set1_ps (gain);
+	guint i;
+
+	for (i = 0; i + 4 <= len; i += 4) {
+		__m128 a = _mm_loadu_ps (samples + i);
+		_mm_storeu_ps (samples + i, _mm_mul_ps (a, g));
+	}
+
+	return i;
+}
+
+#elif defined (__ARM_NEON__) || defined (__ARM_NEON)
+
+static guint
+gain_s16_simd (xmms_samples16_t *samples, guint len, gfloat gain)
+{
+	const float32x4_t lo = vdupq_n_f32 (XMMS_SAMPLES16_MIN);
+	const float32x4_t hi = vdupq_n_f32 (XMMS_SAMPLES16_MAX);
+	guint i;
+
+	for (i = 0; i + 8 <= len; i += 8) {
+		int16x8_t x = vld1q_s16 (samples + i);
+		float32x4_t a, b;
+
+		a = vcvtq_f32_s32 (vmovl_s16 (vget_low_s16 (x)));
+		b = vcvtq_f32_s32 (vmovl_s16 (vget_high_s16 (x)));
+
+		a = vmaxq_f32 (vminq_f32 (vmulq_n_f32 (a, gain), hi), lo);
+		b = vmaxq_f32 (vminq_f32 (vmulq_n_f32 (b, gain), hi), lo);
+
+		vst1q_s16 (samples + i, vcombine_s16 (vqmovn_s32 (vcvtq_s32_f32 (a)),
+		                                      vqmovn_s32 (vcvtq_s32_f32 (b))));
+	}
+
+	return i;
+}
+
+static guint
+gain_s32_simd (xmms_samples32_t *samples, guint len, gfloat gain)
+{
+	/* needs double precision to be exact, leave it to the scalar code */
+	return 0;
+}
+
+static guint
+gain_float_simd (xmms_samplefloat_t *samples, guint len, gfloat gain)
+{
+	guint i;
+
+	for (i = 0; i + 4 <= len; i += 4) {
+		vst1q_f32 (samples + i, vmulq_n_f32 (vld1q_f32 (samples + i), gain));
+	}
+
+	return i;
+}
+
+#else
+
+static guint
+gain_s16_simd (xmms_samples16_t *samples, guint len, gfloat gain)
+{
+	return 0;
+}
+
+static guint
+gain_s32_simd (xmms_samples32_t *samples, guint len, gfloat gain)
+{
+	return 0;
+}
+
+static guint
+gain_float_simd (xmms_samplefloat_t *samples, guint len, gfloat gain)
+{
+	return 0;
+}
+
+#endif
+
+/**
+ * Multiply samples by a gain factor, clipping the result to the range
+ * of the sample format. Floating point samples are not clipped.
+ *
+ * @param fmt format of the samples in buf
+ * @param buf the samples, modified in place
+ * @param len number of samples (not frames, not bytes)
+ * @param gain the factor to apply
+ */
+void
+xmms_sample_gain_apply (xmms_sample_format_t fmt, xmms_sample_t *buf,
+                        guint len, gfloat gain)
+{
+	guint done;
+
+	switch (fmt) {
+		case XMMS_SAMPLE_FORMAT_S16:
+			done = gain_s16_simd (buf, len, gain);
+			gain_s16 ((xmms_samples16_t *) buf + done, len - done, gain);
+			break;
+		case XMMS_SAMPLE_FORMAT_S32:
+			done = gain_s32_simd (buf, len, gain);
+			gain_s32 ((xmms_samples32_t *) buf + done, len - done, gain);
+			break;
+		case XMMS_SAMPLE_FORMAT_FLOAT:
+			done = gain_float_simd (buf, len, gain);
+			gain_float ((xmms_samplefloat_t *) buf + done, len - done, gain);
+			break;
+		default:
+			xmms_sample_gain_apply_scalar (fmt, buf, len, gain);
+			break;
+	}
+}
+
+/**
+ * Same as #xmms_sample_gain_apply but never uses vector instructions.
+ */
+void
+xmms_sample_gain_apply_scalar (xmms_sample_format_t fmt, xmms_sample_t *buf,
+                               guint len, gfloat gain)
+{
+	switch (fmt) {
+		case XMMS_SAMPLE_FORMAT_S8:
+			gain_s8 (buf, len, gain);
+			break;
+		case XMMS_SAMPLE_FORMAT_U8:
+			gain_u8 (buf, len, gain);
+			break;
+		case XMMS_SAMPLE_FORMAT_S16:
+			gain_s16 (buf, len, gain);
+			break;
+		case XMMS_SAMPLE_FORMAT_U16:
+			gain_u16 (buf, len, gain);
+			break;
+		case XMMS_SAMPLE_FORMAT_S32:
+			gain_s32 (buf, len, gain);
+			break;
+		case XMMS_SAMPLE_FORMAT_U32:
+			gain_u32 (buf, len, gain);
+			break;
+		case XMMS_SAMPLE_FORMAT_FLOAT:
+			gain_float (buf, len, gain);
+			break;
+		case XMMS_SAMPLE_FORMAT_DOUBLE:
+			gain_double (buf, len, gain);
+			break;
+		case XMMS_SAMPLE_FORMAT_UNKNOWN:
+			g_return_if_reached ();
+	}
+}
+
+/**
+ * Name of the instruction set used by #xmms_sample_gain_apply.
+ */
+const gchar *
+xmms_sample_gain_impl_get (void)
+{
+	return XMMS_GAIN_IMPL;
+}
+
+/** @} */
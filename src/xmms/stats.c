@@ -0,0 +1,452 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2012 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+/** @file
+ * Always-on counters and latency histograms for the hot paths of the
+ * daemon, exposed to clients through the stats object.
+ *
+ * Every thread records into a block of its own, so recording never
+ * takes a lock or touches memory shared with another thread. Blocks
+ * are only locked to be registered, summed up for a client, or folded
+ * into the retired block when their thread exits. Summing reads the
+ * blocks while their threads keep writing, so a reply may be off by
+ * the few events that happen during the walk.
+ */
+
+#include <glib.h>
+
+#include "xmmsc/xmmsc_idnumbers.h"
+#include "xmms/xmms_log.h"
+#include "xmmspriv/xmms_ipc.h"
+#include "xmmspriv/xmms_stats.h"
+
+typedef struct xmms_stats_data_St {
+	guint64 count;
+	guint64 sum;
+	guint64 max;
+	guint32 buckets[XMMS_STATS_BUCKETS];
+} xmms_stats_data_t;
+
+typedef struct xmms_stats_block_St {
+	xmms_stats_data_t histograms[XMMS_STATS_HISTOGRAM_END];
+	guint64 counters[XMMS_STATS_COUNTER_END];
+	/* only allocated for threads that dispatch IPC commands, and
+	 * published with an atomic set as other threads merge the block */
+	xmms_stats_data_t *ipc;
+	/* only allocated for threads that emit signals, likewise */
+	xmms_stats_data_t *signals;
+} xmms_stats_block_t;
+
+struct xmms_stats_St {
+	xmms_object_t object;
+};
+
+#define IPC_HISTOGRAMS (XMMS_IPC_OBJECT_END * XMMS_STATS_IPC_COMMANDS)
+
+static const gchar *histogram_names[XMMS_STATS_HISTOGRAM_END] = {
+	"medialib_query",
+	"s4_commit",
+	"xform_chain_setup",
+	"filler_read",
+	"ring_fill"
+};
+
+static const gchar *histogram_units[XMMS_STATS_HISTOGRAM_END] = {
+	"us", "us", "us", "us", "bytes"
+};
+
+static const gchar *counter_names[XMMS_STATS_COUNTER_END] = {
+	"s4_commit_conflicts",
+	"output_underruns",
+	"output_bytes"
+};
+
+static const gchar *object_names[XMMS_IPC_OBJECT_END] = {
+	"signal",
+	"main",
+	"playlist",
+	"config",
+	"playback",
+	"medialib",
+	"collection",
+	"visualization",
+	"mediainfo_reader",
+	"xform",
+	"bindata",
+	"stats"
+};
+
+static GStaticPrivate thread_block = G_STATIC_PRIVATE_INIT;
+static GStaticMutex blocks_mutex = G_STATIC_MUTEX_INIT;
+static GList *blocks;
+static xmms_stats_data_t retired_ipc[IPC_HISTOGRAMS];
+static xmms_stats_data_t retired_signals[XMMS_IPC_SIGNAL_END];
+static xmms_stats_block_t retired = { { { 0 } }, { 0 }, retired_ipc, retired_signals };
+
+static void xmms_stats_destroy (xmms_object_t *object);
+static xmmsv_t *xmms_stats_client_get (xmms_stats_t *stats, xmms_error_t *err);
+
+#include "stats_ipc.c"
+
+/**
+ * @defgroup Stats Stats
+ * @ingroup XMMSServer
+ * @brief Counters and latency histograms.
+ * @{
+ */
+
+xmms_stats_t *
+xmms_stats_init (void)
+{
+	xmms_stats_t *stats;
+
+	stats = xmms_object_new (xmms_stats_t, xmms_stats_destroy);
+
+	xmms_stats_register_ipc_commands (XMMS_OBJECT (stats));
+
+	return stats;
+}
+
+static void
+xmms_stats_destroy (xmms_object_t *object)
+{
+	XMMS_DBG ("Deactivating stats object.");
+
+	xmms_stats_unregister_ipc_commands ();
+}
+
+static void
+xmms_stats_data_merge (xmms_stats_data_t *dst, const xmms_stats_data_t *src)
+{
+	gint i;
+
+	dst->count += src->count;
+	dst->sum += src->sum;
+	dst->max = MAX (dst->max, src->max);
+
+	for (i = 0; i < XMMS_STATS_BUCKETS; i++) {
+		dst->buckets[i] += src->buckets[i];
+	}
+}
+
+static void
+xmms_stats_block_merge (xmms_stats_block_t *dst, xmms_stats_block_t *src)
+{
+	xmms_stats_data_t *ipc, *signals;
+	gint i;
+
+	for (i = 0; i < XMMS_STATS_HISTOGRAM_END; i++) {
+		xmms_stats_data_merge (&dst->histograms[i], &src->histograms[i]);
+	}
+
+	for (i = 0; i < XMMS_STATS_COUNTER_END; i++) {
+		dst->counters[i] += src->counters[i];
+	}
+
+	ipc = g_atomic_pointer_get ((volatile gpointer *) &src->ipc);
+	if (ipc) {
+		for (i = 0; i < IPC_HISTOGRAMS; i++) {
+			xmms_stats_data_merge (&dst->ipc[i], &ipc[i]);
+		}
+	}
+
+	signals = g_atomic_pointer_get ((volatile gpointer *) &src->signals);
+	if (signals) {
+		for (i = 0; i < XMMS_IPC_SIGNAL_END; i++) {
+			xmms_stats_data_merge (&dst->signals[i], &signals[i]);
+		}
+	}
+}
+
+/**
+ * Called when a thread exits, keep what it recorded.
+ */
+static void
+xmms_stats_block_retire (gpointer data)
+{
+	xmms_stats_block_t *block = data;
+
+	g_static_mutex_lock (&blocks_mutex);
+	xmms_stats_block_merge (&retired, block);
+	blocks = g_list_remove (blocks, block);
+	g_static_mutex_unlock (&blocks_mutex);
+
+	g_free (block->ipc);
+	g_free (block->signals);
+	g_free (block);
+}
+
+static xmms_stats_block_t *
+xmms_stats_block_get (void)
+{
+	xmms_stats_block_t *block;
+
+	block = g_static_private_get (&thread_block);
+	if (G_UNLIKELY (block == NULL)) {
+		block = g_new0 (xmms_stats_block_t, 1);
+
+		g_static_mutex_lock (&blocks_mutex);
+		blocks = g_list_prepend (blocks, block);
+		g_static_mutex_unlock (&blocks_mutex);
+
+		g_static_private_set (&thread_block, block, xmms_stats_block_retire);
+	}
+
+	return block;
+}
+
+static void
+xmms_stats_data_add (xmms_stats_data_t *data, guint64 value)
+{
+	guint64 v;
+	gint bucket;
+
+	for (bucket = 0, v = value; v && bucket < XMMS_STATS_BUCKETS - 1; bucket++) {
+		v >>= 1;
+	}
+
+	data->count++;
+	data->sum += value;
+	data->buckets[bucket]++;
+	if (value > data->max) {
+		data->max = value;
+	}
+}
+
+/**
+ * Current time in microseconds, for timing with #xmms_stats_record_since.
+ * Monotonic where glib provides such a clock.
+ */
+gint64
+xmms_stats_now (void)
+{
+#if GLIB_CHECK_VERSION(2,28,0)
+	return g_get_monotonic_time ();
+#else
+	GTimeVal now;
+
+	g_get_current_time (&now);
+
+	return (gint64) now.tv_sec * G_USEC_PER_SEC + now.tv_usec;
+#endif
+}
+
+static guint64
+xmms_stats_elapsed (gint64 start)
+{
+	gint64 elapsed = xmms_stats_now () - start;
+
+	/* without a monotonic clock the wall clock may have been set back */
+	return MAX (elapsed, 0);
+}
+
+/**
+ * Add a value to a histogram.
+ */
+void
+xmms_stats_record (xmms_stats_histogram_t histogram, guint64 value)
+{
+	g_return_if_fail (histogram < XMMS_STATS_HISTOGRAM_END);
+
+	xmms_stats_data_add (&xmms_stats_block_get ()->histograms[histogram], value);
+}
+
+/**
+ * Add the time elapsed since start, as returned by #xmms_stats_now,
+ * to a histogram.
+ */
+void
+xmms_stats_record_since (xmms_stats_histogram_t histogram, gint64 start)
+{
+	xmms_stats_record (histogram, xmms_stats_elapsed (start));
+}
+
+/**
+ * Add the time it took to run an IPC command to the histogram of
+ * that command.
+ */
+void
+xmms_stats_record_ipc (guint objid, guint cmdid, gint64 start)
+{
+	xmms_stats_block_t *block;
+
+	if (objid >= XMMS_IPC_OBJECT_END || cmdid < XMMS_IPC_CMD_FIRST ||
+	    cmdid >= XMMS_IPC_CMD_FIRST + XMMS_STATS_IPC_COMMANDS) {
+		return;
+	}
+
+	block = xmms_stats_block_get ();
+	if (G_UNLIKELY (block->ipc == NULL)) {
+		g_atomic_pointer_set ((volatile gpointer *) &block->ipc,
+		                      g_new0 (xmms_stats_data_t, IPC_HISTOGRAMS));
+	}
+
+	xmms_stats_data_add (&block->ipc[objid * XMMS_STATS_IPC_COMMANDS + cmdid - XMMS_IPC_CMD_FIRST],
+	                     xmms_stats_elapsed (start));
+}
+
+/**
+ * Add the time it took to run the handlers of a signal to the
+ * histogram of that signal. The count of the histogram is the number
+ * of emits.
+ */
+void
+xmms_stats_record_signal (guint signalid, gint64 start)
+{
+	xmms_stats_block_t *block;
+
+	if (signalid >= XMMS_IPC_SIGNAL_END) {
+		return;
+	}
+
+	block = xmms_stats_block_get ();
+	if (G_UNLIKELY (block->signals == NULL)) {
+		g_atomic_pointer_set ((volatile gpointer *) &block->signals,
+		                      g_new0 (xmms_stats_data_t, XMMS_IPC_SIGNAL_END));
+	}
+
+	xmms_stats_data_add (&block->signals[signalid], xmms_stats_elapsed (start));
+}
+
+/**
+ * Increase a counter.
+ */
+void
+xmms_stats_count (xmms_stats_counter_t counter, guint64 n)
+{
+	g_return_if_fail (counter < XMMS_STATS_COUNTER_END);
+
+	xmms_stats_block_get ()->counters[counter] += n;
+}
+
+static xmmsv_t *
+xmms_stats_uint_value (guint64 value)
+{
+	return xmmsv_new_int (MIN (value, G_MAXINT32));
+}
+
+static xmmsv_t *
+xmms_stats_data_to_xmmsv (const xmms_stats_data_t *data, const gchar *unit)
+{
+	xmmsv_t *dict, *buckets, *value;
+	gint i, used;
+
+	for (used = XMMS_STATS_BUCKETS; used > 0 && !data->buckets[used - 1]; used--);
+
+	buckets = xmmsv_new_list ();
+	for (i = 0; i < used; i++) {
+		value = xmmsv_new_int (MIN (data->buckets[i], G_MAXINT32));
+		xmmsv_list_append (buckets, value);
+		xmmsv_unref (value);
+	}
+
+	dict = xmmsv_build_dict (XMMSV_DICT_ENTRY ("count", xmms_stats_uint_value (data->count)),
+	                         XMMSV_DICT_ENTRY ("mean", xmms_stats_uint_value (data->count ? data->sum / data->count : 0)),
+	                         XMMSV_DICT_ENTRY ("max", xmms_stats_uint_value (data->max)),
+	                         XMMSV_DICT_ENTRY_STR ("unit", unit),
+	                         XMMSV_DICT_ENTRY ("buckets", buckets),
+	                         XMMSV_DICT_END);
+
+	return dict;
+}
+
+/**
+ * Sum up the blocks of all threads and return them as:
+ * { "threads": n,
+ *   "counters": { name: n, ... },
+ *   "histograms": { name: histogram, ... },
+ *   "ipc": [ { "object": name, "command": id, histogram fields }, ... ],
+ *   "signals": [ { "signal": id, histogram fields }, ... ] }
+ *
+ * where a histogram is { "count", "mean", "max", "unit", "buckets" }
+ * and buckets holds the counts of the log2 buckets up to the last one
+ * in use.
+ */
+static xmmsv_t *
+xmms_stats_client_get (xmms_stats_t *stats, xmms_error_t *err)
+{
+	xmms_stats_block_t *total;
+	xmmsv_t *ret, *dict, *list, *value;
+	GList *n;
+	gint i, threads;
+
+	total = g_new0 (xmms_stats_block_t, 1);
+	total->ipc = g_new0 (xmms_stats_data_t, IPC_HISTOGRAMS);
+	total->signals = g_new0 (xmms_stats_data_t, XMMS_IPC_SIGNAL_END);
+
+	g_static_mutex_lock (&blocks_mutex);
+	xmms_stats_block_merge (total, &retired);
+	for (n = blocks, threads = 0; n; n = g_list_next (n), threads++) {
+		xmms_stats_block_merge (total, n->data);
+	}
+	g_static_mutex_unlock (&blocks_mutex);
+
+	ret = xmmsv_new_dict ();
+	xmmsv_dict_set_int (ret, "threads", threads);
+
+	dict = xmmsv_new_dict ();
+	for (i = 0; i < XMMS_STATS_COUNTER_END; i++) {
+		value = xmms_stats_uint_value (total->counters[i]);
+		xmmsv_dict_set (dict, counter_names[i], value);
+		xmmsv_unref (value);
+	}
+	xmmsv_dict_set (ret, "counters", dict);
+	xmmsv_unref (dict);
+
+	dict = xmmsv_new_dict ();
+	for (i = 0; i < XMMS_STATS_HISTOGRAM_END; i++) {
+		value = xmms_stats_data_to_xmmsv (&total->histograms[i], histogram_units[i]);
+		xmmsv_dict_set (dict, histogram_names[i], value);
+		xmmsv_unref (value);
+	}
+	xmmsv_dict_set (ret, "histograms", dict);
+	xmmsv_unref (dict);
+
+	list = xmmsv_new_list ();
+	for (i = 0; i < IPC_HISTOGRAMS; i++) {
+		if (total->ipc[i].count == 0) {
+			continue;
+		}
+		value = xmms_stats_data_to_xmmsv (&total->ipc[i], "us");
+		xmmsv_dict_set_string (value, "object", object_names[i / XMMS_STATS_IPC_COMMANDS]);
+		xmmsv_dict_set_int (value, "command", XMMS_IPC_CMD_FIRST + i % XMMS_STATS_IPC_COMMANDS);
+		xmmsv_list_append (list, value);
+		xmmsv_unref (value);
+	}
+	xmmsv_dict_set (ret, "ipc", list);
+	xmmsv_unref (list);
+
+	list = xmmsv_new_list ();
+	for (i = 0; i < XMMS_IPC_SIGNAL_END; i++) {
+		if (total->signals[i].count == 0) {
+			continue;
+		}
+		value = xmms_stats_data_to_xmmsv (&total->signals[i], "us");
+		xmmsv_dict_set_int (value, "signal", i);
+		xmmsv_list_append (list, value);
+		xmmsv_unref (value);
+	}
+	xmmsv_dict_set (ret, "signals", list);
+	xmmsv_unref (list);
+
+	g_free (total->signals);
+	g_free (total->ipc);
+	g_free (total);
+
+	return ret;
+}
+
+/** @} */
@@ -0,0 +1,7 @@
+#!/usr/bin/python
+import sys
+
+sys.path.append('../waftools')
+from genipc_server import build
+
+build('stats', 'xmms_stats_t *')
@@ -338,6 +338,25 @@ xmms_stream_type_coerce (const xmms_stream_type_t *in, const GList *goal_types)
 }
 
 
+/**
+ * Create an audio/pcm type with the channels and samplerate of st
+ * but a different sample format.
+ */
+xmms_stream_type_t *
+xmms_stream_type_pcm_with_format (const xmms_stream_type_t *st, gint format)
+{
+	gint channels, samplerate;
+
+	channels = xmms_stream_type_get_int (st, XMMS_STREAM_TYPE_FMT_CHANNELS);
+	samplerate = xmms_stream_type_get_int (st, XMMS_STREAM_TYPE_FMT_SAMPLERATE);
+
+	return _xmms_stream_type_new (XMMS_STREAM_TYPE_BEGIN,
+	                              XMMS_STREAM_TYPE_MIMETYPE, "audio/pcm",
+	                              XMMS_STREAM_TYPE_FMT_FORMAT, format,
+	                              XMMS_STREAM_TYPE_FMT_CHANNELS, channels,
+	                              XMMS_STREAM_TYPE_FMT_SAMPLERATE, samplerate,
+	                              XMMS_STREAM_TYPE_END);
+}
 
 /*
 	XMMS_DBG ("Looking for xform with intypes matching:");
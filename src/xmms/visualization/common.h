@@ -37,6 +37,21 @@ typedef struct {
 	xmmsc_vis_properties_t prop;
 } xmms_vis_client_t;
 
+/**
+ * One chunk of audio handed to all vis clients. Analysis results are
+ * computed on first use and shared by every client of the frame.
+ */
+
+typedef struct {
+	int channels;
+	int size;
+	short *buf;
+	gboolean spec_done;
+	gfloat spec[XMMSC_VISUALIZATION_WINDOW_SIZE / 2];
+	gboolean peak_done;
+	short peak[2];
+} xmms_vis_frame_t;
+
 /* provided by object.c */
 xmms_vis_client_t *get_client (int32_t id);
 void delete_client (int32_t id);
@@ -48,16 +63,17 @@ void cleanup_shm (xmmsc_vis_unixshm_t *t);
 gboolean write_start_shm (int32_t id, xmmsc_vis_unixshm_t *t, xmmsc_vischunk_t **dest);
 void write_finish_shm (int32_t id, xmmsc_vis_unixshm_t *t, xmmsc_vischunk_t *dest);
 
-gboolean write_shm (xmmsc_vis_unixshm_t *t, xmms_vis_client_t *c, int32_t id, struct timeval *time, int channels, int size, short *buf);
+gboolean write_shm (xmmsc_vis_unixshm_t *t, xmms_vis_client_t *c, int32_t id, struct timeval *time, xmms_vis_frame_t *frame);
 
 /* provided by udp.c */
 int32_t init_udp (xmms_visualization_t *vis, int32_t id, xmms_error_t *err);
 void cleanup_udp (xmmsc_vis_udp_t *t, xmms_socket_t socket);
-gboolean write_udp (xmmsc_vis_udp_t *t, xmms_vis_client_t *c, int32_t id, struct timeval *time, int channels, int size, short *buf, int socket);
+gboolean write_udp (xmmsc_vis_udp_t *t, xmms_vis_client_t *c, int32_t id, struct timeval *time, xmms_vis_frame_t *frame, int socket);
 
 /* provided by format.c */
-void fft_init (void);
-short fill_buffer (int16_t *dest, xmmsc_vis_properties_t* prop, int channels, int size, short *src);
+void xmms_vis_analysis_init (void);
+void xmms_vis_frame_init (xmms_vis_frame_t *frame, int channels, int size, short *buf);
+short fill_buffer (int16_t *dest, xmmsc_vis_properties_t* prop, xmms_vis_frame_t *frame);
 
 /* never call a fetch without a guaranteed release following! */
 #define x_fetch_client(id) \
@@ -2,137 +2,260 @@
 #include "common.h"
 
 #define FFT_LEN XMMSC_VISUALIZATION_WINDOW_SIZE
-/* TODO: better way, check this! */
-#define FFT_BITS 9
+/* the real input is packed into a complex sequence of half the length */
+#define FFT_HALF (FFT_LEN / 2)
 
 /* Log scale settings */
 #define AMP_LOG_SCALE_THRESHOLD0	0.001f
 #define AMP_LOG_SCALE_DIVISOR		6.908f	/* divisor = -log threshold */
 #define FREQ_LOG_SCALE_BASE		2.0f
 
+/* read-only after xmms_vis_analysis_init, so safe to share between threads */
 static gfloat window[FFT_LEN];
-static gfloat spec[FFT_LEN/2];
-static gboolean fft_ready = FALSE;
-static gboolean fft_done;
+static guint16 bitrev[FFT_HALF];
+/* twiddles for each butterfly stage, stage with span h starts at h - 1 */
+static gfloat stage_re[FFT_HALF - 1];
+static gfloat stage_im[FFT_HALF - 1];
+/* twiddles used to split the packed transform into the real spectrum */
+static gfloat split_re[FFT_HALF];
+static gfloat split_im[FFT_HALF];
+static gboolean analysis_ready = FALSE;
 
-void fft_init ()
+/**
+ * Precalculate the tables used by the spectrum analysis.
+ * Must be called once before any frame is analysed.
+ */
+void
+xmms_vis_analysis_init (void)
 {
-	if (!fft_ready) {
-		int i;
-		/* calculate Hann window used to reduce spectral leakage */
-		for (i = 0; i < FFT_LEN; i++) {
-			window[i] = 0.5 - 0.5 * cos (2.0 * M_PI * i / FFT_LEN);
+	gint i, j, bits, h;
+
+	if (analysis_ready) {
+		return;
+	}
+
+	/* calculate Hann window used to reduce spectral leakage */
+	for (i = 0; i < FFT_LEN; i++) {
+		window[i] = 0.5 - 0.5 * cos (2.0 * M_PI * i / FFT_LEN);
+	}
+
+	for (bits = 0; (1 << bits) < FFT_HALF; bits++);
+
+	for (i = 0; i < FFT_HALF; i++) {
+		gint r = 0;
+		for (j = 0; j < bits; j++) {
+			if (i & (1 << j)) {
+				r |= 1 << (bits - 1 - j);
+			}
 		}
-		fft_done = TRUE;
+		bitrev[i] = r;
 	}
-	fft_done = FALSE;
+
+	for (h = 1; h < FFT_HALF; h <<= 1) {
+		for (j = 0; j < h; j++) {
+			stage_re[h - 1 + j] =  cos (M_PI * j / h);
+			stage_im[h - 1 + j] = -sin (M_PI * j / h);
+		}
+	}
+
+	for (i = 0; i < FFT_HALF; i++) {
+		split_re[i] =  cos (2.0 * M_PI * i / FFT_LEN);
+		split_im[i] = -sin (2.0 * M_PI * i / FFT_LEN);
+	}
+
+	analysis_ready = TRUE;
+}
+
+/**
+ * Prepare a frame for analysis. Nothing is computed until a client
+ * actually asks for it, and then only once per frame.
+ */
+void
+xmms_vis_frame_init (xmms_vis_frame_t *frame, int channels, int size, short *buf)
+{
+	frame->channels = channels;
+	frame->size = size;
+	frame->buf = buf;
+	frame->spec_done = FALSE;
+	frame->peak_done = FALSE;
 }
 
 /* interesting:	data->value.uint32 = xmms_sample_samples_to_ms (vis->format, pos); */
 
+/**
+ * Magnitude spectrum of the mono downmix using a real FFT: even and odd
+ * samples are packed into one complex sequence of half the length,
+ * transformed, and then split into the spectrum of the real input.
+ */
 static void
-fft (short *samples, gfloat *spec)
+fft (const short *samples, int channels, gfloat *spec)
 {
-	gint nv2, k, l, j = 0, i;
-	gfloat t_r, t_i;
-	gfloat buf[FFT_LEN][2];
-
-	for (i = 0; i < FFT_LEN; i++){
-		buf[i][0]  = (float) samples[j++];
-		buf[i][0] += (float) samples[j++];
-		buf[i][0] /= (float) (1 << 17);
-		buf[i][0] *= window[i];
-		buf[i][1] = 0.0f;
-	}
-
-	/* reorder... */  /* this is crappy! Go rewrite it using real bitreversing */
-	nv2 = FFT_LEN / 2;
-	j = 1;
-
-	for (i = 1; i < FFT_LEN; i++) {
-		if (i < j) {
-			t_r = buf[i - 1][0];
-			t_i = buf[i - 1][1];
-			buf[i - 1][0] = buf[j - 1][0];
-			buf[i - 1][1] = buf[j - 1][1];
-			buf[j - 1][0] = t_r;
-			buf[j - 1][1] = t_i;
-		}
+	gfloat re[FFT_HALF], im[FFT_HALF];
+	gfloat scale;
+	gint i, j, c, h, start;
+
+	scale = 1.0f / ((gfloat) channels * (1 << 16));
 
-		k = nv2;
+	for (i = 0; i < FFT_HALF; i++) {
+		const short *even = samples + (2 * i) * channels;
+		const short *odd = even + channels;
+		gfloat e = 0.0f, o = 0.0f;
 
-		while (k < j) {
-			j -= k;
-			k >>= 1;
+		for (c = 0; c < channels; c++) {
+			e += even[c];
+			o += odd[c];
 		}
 
-		j += k;
+		re[bitrev[i]] = e * scale * window[2 * i];
+		im[bitrev[i]] = o * scale * window[2 * i + 1];
 	}
 
-	/* do fft */
-	for (l = 1; l <= FFT_BITS; l++) {
-		gint le = 1 << l;
-		gint le1 = le / 2;
-		gfloat u_r = 1.0;
-		gfloat u_i = 0.0;
-		gfloat w_r =  cosf (M_PI / (float) le1);
-		gfloat w_i = -sinf (M_PI / (float) le1);
+	/* iterative radix-2, butterflies of one group run over contiguous memory */
+	for (h = 1; h < FFT_HALF; h <<= 1) {
+		const gfloat *w_r = stage_re + h - 1;
+		const gfloat *w_i = stage_im + h - 1;
 
-		for (j = 1; j <= le1; j++) {
-			for (i = j; i <= FFT_LEN; i += le) {
-				gint ip = i + le1;
+		for (start = 0; start < FFT_HALF; start += 2 * h) {
+			gfloat *a_r = re + start, *a_i = im + start;
+			gfloat *b_r = a_r + h, *b_i = a_i + h;
 
-				t_r = buf[ip - 1][0] * u_r - u_i * buf[ip - 1][1];
-				t_i = buf[ip - 1][1] * u_r + u_i * buf[ip - 1][0];
+			for (j = 0; j < h; j++) {
+				gfloat t_r = b_r[j] * w_r[j] - b_i[j] * w_i[j];
+				gfloat t_i = b_i[j] * w_r[j] + b_r[j] * w_i[j];
 
-				buf[ip - 1][0] = buf[i - 1][0] - t_r;
-				buf[ip - 1][1] = buf[i - 1][1] - t_i;
-
-				buf[i - 1][0] =  buf[i - 1][0] + t_r;
-				buf[i - 1][1] =  buf[i - 1][1] + t_i;
+				b_r[j] = a_r[j] - t_r;
+				b_i[j] = a_i[j] - t_i;
+				a_r[j] = a_r[j] + t_r;
+				a_i[j] = a_i[j] + t_i;
 			}
-
-			t_r = u_r * w_r - w_i * u_i;
-			u_i = w_r * u_i + w_i * u_r;
-			u_r = t_r;
 		}
 	}
 
-	/* output abs-value instead */
-	for (i = 0; i < nv2; i++) {
-		spec[i] = 2 * hypot (buf[i][0], buf[i][1]) / FFT_LEN;
+	/* split into the first half of the real spectrum, output abs-value */
+	for (i = 0; i < FFT_HALF; i++) {
+		gint m = (FFT_HALF - i) & (FFT_HALF - 1);
+		gfloat e_r = 0.5f * (re[i] + re[m]);
+		gfloat e_i = 0.5f * (im[i] - im[m]);
+		gfloat o_r = 0.5f * (im[i] + im[m]);
+		gfloat o_i = 0.5f * (re[m] - re[i]);
+		gfloat x_r = e_r + split_re[i] * o_r - split_im[i] * o_i;
+		gfloat x_i = e_i + split_re[i] * o_i + split_im[i] * o_r;
+
+		spec[i] = 2 * sqrtf (x_r * x_r + x_i * x_i) / FFT_LEN;
 	}
 
 	/* correct the scale */
-	spec[nv2 - 1] /= 2;
+	spec[FFT_HALF - 1] /= 2;
+}
+
+static const gfloat *
+frame_spectrum (xmms_vis_frame_t *frame)
+{
+	if (!frame->spec_done) {
+		fft (frame->buf, frame->channels, frame->spec);
+		frame->spec_done = TRUE;
+	}
+	return frame->spec;
+}
+
+static const short *
+frame_peak (xmms_vis_frame_t *frame)
+{
+	int i, channels = frame->channels;
+	short *src = frame->buf;
+	short l = 0, r = 0;
+
+	if (frame->peak_done) {
+		return frame->peak;
+	}
+
+	for (i = 0; i < frame->size; i += channels) {
+		if (src[i] > 0 && src[i] > l) {
+			l = src[i];
+		}
+		if (src[i] < 0 && -src[i] > l) {
+			l = -src[i];
+		}
+		if (channels > 1) {
+			if (src[i+1] > 0 && src[i+1] > r) {
+				r = src[i+1];
+			}
+			if (src[i+1] < 0 && -src[i+1] > r) {
+				r = -src[i+1];
+			}
+		}
+	}
+	if (channels == 1) {
+		r = l;
+	}
+
+	frame->peak[0] = l;
+	frame->peak[1] = r;
+	frame->peak_done = TRUE;
+
+	return frame->peak;
+}
+
+/**
+ * First spectrum bin belonging to a band. Log bands are spaced evenly
+ * on a log2 frequency axis starting at the first non-DC bin.
+ */
+static int
+band_start (int band, int bands, gboolean logscale)
+{
+	if (!logscale) {
+		return band * FFT_HALF / bands;
+	}
+	if (band == 0) {
+		return 0;
+	}
+	return (int) powf (FREQ_LOG_SCALE_BASE,
+	                   log2f (FFT_HALF) * band / bands);
 }
 
 /**
- * Calcualte the FFT on the decoded data buffer.
+ * Aggregate the shared spectrum of the frame into the bands the client
+ * asked for.
  */
 static short
-fill_buffer_fft (int16_t* dest, int size, short *src)
+fill_buffer_fft (int16_t* dest, xmmsc_vis_properties_t *prop, xmms_vis_frame_t *frame)
 {
-	int i;
+	const gfloat *spec;
+	int i, bands, from, to;
 	float tmp;
 
-	if (size != FFT_LEN * 2) {
+	if (frame->size != FFT_LEN * frame->channels) {
 		return 0;
 	}
 
-	if (!fft_done) {
-		fft (src, spec);
-		fft_done = TRUE;
+	spec = frame_spectrum (frame);
+
+	bands = prop->spec_bands;
+	if (bands <= 0 || bands > FFT_HALF) {
+		bands = FFT_HALF;
 	}
 
-	/* TODO: more sophisticated! */
-	for (i = 0; i < FFT_LEN / 2; ++i) {
-		if (spec[i] >= 1.0) {
+	to = band_start (0, bands, prop->spec_logscale);
+	for (i = 0; i < bands; ++i) {
+		from = to;
+		to = band_start (i + 1, bands, prop->spec_logscale);
+		if (to <= from) {
+			to = from + 1;
+		}
+
+		/* a band is as loud as its loudest bin */
+		for (tmp = spec[from++]; from < to && from < FFT_HALF; from++) {
+			if (spec[from] > tmp) {
+				tmp = spec[from];
+			}
+		}
+
+		/* TODO: more sophisticated! */
+		if (tmp >= 1.0) {
 			dest[i] = htons (SHRT_MAX);
-		} else if (spec[i] < 0.0) {
+		} else if (tmp < 0.0) {
 			dest[i] = 0;
 		} else {
-			tmp = spec[i];
 			if (tmp > AMP_LOG_SCALE_THRESHOLD0) {
 //				tmp = 1.0f + (logf (tmp) /  AMP_LOG_SCALE_DIVISOR);
 			} else {
@@ -141,40 +264,25 @@ fill_buffer_fft (int16_t* dest, int size, short *src)
 			dest[i] = htons ((int16_t)(tmp * SHRT_MAX));
 		}
 	}
-	return FFT_LEN / 2;
+	return bands;
 }
 
 short
-fill_buffer (int16_t *dest, xmmsc_vis_properties_t* prop, int channels, int size, short *src)
+fill_buffer (int16_t *dest, xmmsc_vis_properties_t* prop, xmms_vis_frame_t *frame)
 {
 	int i, j;
+	int channels = frame->channels;
+	int size = frame->size;
+	short *src = frame->buf;
+
 	if (prop->type == VIS_PEAK) {
-		short l = 0, r = 0;
-		for (i = 0; i < size; i += channels) {
-			if (src[i] > 0 && src[i] > l) {
-				l = src[i];
-			}
-			if (src[i] < 0 && -src[i] > l) {
-				l = -src[i];
-			}
-			if (channels > 1) {
-				if (src[i+1] > 0 && src[i+1] > r) {
-					r = src[i+1];
-				}
-				if (src[i+1] < 0 && -src[i+1] > r) {
-					r = -src[i+1];
-				}
-			}
-		}
-		if (channels == 1) {
-			r = l;
-		}
+		const short *peak = frame_peak (frame);
 		if (prop->stereo) {
-			dest[0] = htons (l);
-			dest[1] = htons (r);
+			dest[0] = htons (peak[0]);
+			dest[1] = htons (peak[1]);
 			size = 2;
 		} else {
-			dest[0] = htons ((l + r) / 2);
+			dest[0] = htons ((peak[0] + peak[1]) / 2);
 			size = 1;
 		}
 	}
@@ -203,7 +311,7 @@ fill_buffer (int16_t *dest, xmmsc_vis_properties_t* prop, int channels, int size
 		}
 	}
 	if (prop->type == VIS_SPECTRUM) {
-		size = fill_buffer_fft (dest, size, src);
+		size = fill_buffer_fft (dest, prop, frame);
 	}
 	return size;
 }
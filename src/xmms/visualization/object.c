@@ -119,6 +119,8 @@ xmms_visualization_new (xmms_output_t *output)
 
 	xmms_object_ref (output);
 
+	xmms_vis_analysis_init ();
+
 	xmms_visualization_register_ipc_commands (XMMS_OBJECT (vis));
 
 	xmms_socket_invalidate (&vis->socket);
@@ -169,6 +171,8 @@ properties_init (xmmsc_vis_properties_t *p)
 	p->type = VIS_PCM;
 	p->stereo = 1;
 	p->pcm_hardwire = 0;
+	p->spec_bands = XMMSC_VISUALIZATION_WINDOW_SIZE / 2;
+	p->spec_logscale = 0;
 }
 
 static gboolean
@@ -188,6 +192,20 @@ property_set (xmmsc_vis_properties_t *p, const gchar* key, const gchar* data)
 		p->stereo = (atoi (data) > 0);
 	} else if (!g_ascii_strcasecmp (key, "pcm.hardwire")) {
 		p->pcm_hardwire = (atoi (data) > 0);
+	} else if (!g_ascii_strcasecmp (key, "spectrum.bands")) {
+		p->spec_bands = atoi (data);
+		if (p->spec_bands <= 0 || p->spec_bands > XMMSC_VISUALIZATION_WINDOW_SIZE / 2) {
+			p->spec_bands = XMMSC_VISUALIZATION_WINDOW_SIZE / 2;
+			return FALSE;
+		}
+	} else if (!g_ascii_strcasecmp (key, "spectrum.scale")) {
+		if (!g_ascii_strcasecmp (data, "linear")) {
+			p->spec_logscale = 0;
+		} else if (!g_ascii_strcasecmp (data, "log")) {
+			p->spec_logscale = 1;
+		} else {
+			return FALSE;
+		}
 	/* TODO: all the stuff following */
 	} else if (!g_ascii_strcasecmp (key, "timeframe")) {
 		p->timeframe = g_strtod (data, NULL);
@@ -303,12 +321,12 @@ xmms_visualization_client_shutdown (xmms_visualization_t *vis, int32_t id, xmms_
 }
 
 static gboolean
-package_write (xmms_vis_client_t *c, int32_t id, struct timeval *time, int channels, int size, short *buf)
+package_write (xmms_vis_client_t *c, int32_t id, struct timeval *time, xmms_vis_frame_t *frame)
 {
 	if (c->type == VIS_UNIXSHM) {
-		return write_shm (&c->transport.shm, c, id, time, channels, size, buf);
+		return write_shm (&c->transport.shm, c, id, time, frame);
 	} else if (c->type == VIS_UDP) {
-		return write_udp (&c->transport.udp, c, id, time, channels, size, buf, vis->socket);
+		return write_udp (&c->transport.udp, c, id, time, frame, vis->socket);
 	}
 	return FALSE;
 }
@@ -319,6 +337,7 @@ send_data (int channels, int size, short *buf)
 	int i;
 	struct timeval time;
 	guint32 latency;
+	xmms_vis_frame_t frame;
 
 	if (!vis) {
 		return;
@@ -326,7 +345,7 @@ send_data (int channels, int size, short *buf)
 
 	latency = xmms_output_latency (vis->output);
 
-	fft_init ();
+	xmms_vis_frame_init (&frame, channels, size, buf);
 
 	gettimeofday (&time, NULL);
 	time.tv_sec += (latency / 1000);
@@ -339,7 +358,7 @@ send_data (int channels, int size, short *buf)
 	g_mutex_lock (vis->clientlock);
 	for (i = 0; i < vis->clientc; ++i) {
 		if (vis->clientv[i]) {
-			package_write (vis->clientv[i], i, &time, channels, size, buf);
+			package_write (vis->clientv[i], i, &time, &frame);
 		}
 	}
 	g_mutex_unlock (vis->clientlock);
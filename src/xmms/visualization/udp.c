@@ -179,7 +179,7 @@ cleanup_udp (xmmsc_vis_udp_t *t, xmms_socket_t socket)
 }
 
 gboolean
-write_udp (xmmsc_vis_udp_t *t, xmms_vis_client_t *c, int32_t id, struct timeval *time, int channels, int size, short *buf, int socket)
+write_udp (xmmsc_vis_udp_t *t, xmms_vis_client_t *c, int32_t id, struct timeval *time, xmms_vis_frame_t *frame, int socket)
 {
 	xmmsc_vis_udp_data_t packet_d;
 	xmmsc_vischunk_t *__unaligned_dest;
@@ -208,7 +208,7 @@ write_udp (xmmsc_vis_udp_t *t, xmms_vis_client_t *c, int32_t id, struct timeval
 
 
 	XMMSC_VIS_UNALIGNED_WRITE (&__unaligned_dest->format, (uint16_t)htons (c->format), uint16_t);
-	res = fill_buffer (__unaligned_dest->data, &c->prop, channels, size, buf);
+	res = fill_buffer (__unaligned_dest->data, &c->prop, frame);
 	XMMSC_VIS_UNALIGNED_WRITE (&__unaligned_dest->size, (uint16_t)htons (res), uint16_t);
 
 	offset = ((char*)&__unaligned_dest->data - (char*)__unaligned_dest);
@@ -134,7 +134,7 @@ increment_client (xmmsc_vis_unixshm_t *t)
 }
 
 gboolean
-write_shm (xmmsc_vis_unixshm_t *t, xmms_vis_client_t *c, int32_t id, struct timeval *time, int channels, int size, short *buf)
+write_shm (xmmsc_vis_unixshm_t *t, xmms_vis_client_t *c, int32_t id, struct timeval *time, xmms_vis_frame_t *frame)
 {
 	xmmsc_vischunk_t *dest;
 	short res;
@@ -144,7 +144,7 @@ write_shm (xmmsc_vis_unixshm_t *t, xmms_vis_client_t *c, int32_t id, struct time
 
 	tv2net (dest->timestamp, time);
 	dest->format = htons (c->format);
-	res = fill_buffer (dest->data, &c->prop, channels, size, buf);
+	res = fill_buffer (dest->data, &c->prop, frame);
 	dest->size = htons (res);
 	write_finish_shm (id, t, dest);
 
@@ -27,6 +27,7 @@
 #include "xmmspriv/xmms_medialib.h"
 #include "xmmspriv/xmms_utils.h"
 #include "xmmspriv/xmms_xform_plugin.h"
+#include "xmmspriv/xmms_stats.h"
 #include "xmms/xmms_ipc.h"
 #include "xmms/xmms_log.h"
 #include "xmms/xmms_object.h"
@@ -35,10 +36,38 @@ struct xmms_xform_object_St {
 	xmms_object_t obj;
 };
 
+/**
+ * Fixed size block handed out by the buffer pool. The header is padded so
+ * the payload keeps the alignment of the underlying allocation.
+ */
+typedef union xmms_xform_block_U {
+	struct {
+		union xmms_xform_block_U *next;
+		gsize size;
+	} h;
+	gdouble align[2];
+} xmms_xform_block_t;
+
+/**
+ * Buffer pool shared by all xforms of a chain. Blocks of
+ * XMMS_XFORM_POOL_BLOCK_SIZE bytes are recycled through a free list,
+ * larger requests go straight to the heap.
+ */
+typedef struct xmms_xform_pool_St {
+	xmms_object_t obj;
+	GMutex *mutex;
+	xmms_xform_block_t *free;
+	guint allocations;
+} xmms_xform_pool_t;
+
+#define XMMS_XFORM_POOL_BLOCK_SIZE 16384
+
 struct xmms_xform_St {
 	xmms_object_t obj;
 	struct xmms_xform_St *prev;
 
+	xmms_xform_pool_t *pool;
+
 	const xmms_xform_plugin_t *plugin;
 	xmms_medialib_entry_t entry;
 
@@ -55,7 +84,9 @@ struct xmms_xform_St {
 	gboolean eos;
 	gboolean error;
 
+	/** ring buffer of peeked data, buffersize is a power of two */
 	char *buffer;
+	gint bufstart;
 	gint buffered;
 	gint buffersize;
 
@@ -71,10 +102,11 @@ struct xmms_xform_St {
 	xmmsv_t *browse_dict;
 	gint browse_index;
 
-	/** used for line reading */
+	/** used for line reading, lines are handed out from start to end */
 	struct {
 		gchar buf[XMMS_XFORM_MAX_LINE_SIZE];
-		gchar *bufend;
+		gchar *start;
+		gchar *end;
 	} lr;
 };
 
@@ -92,11 +124,16 @@ xmms_xform_t *xmms_xform_find (xmms_xform_t *prev, xmms_medialib_entry_t entry,
 const char *xmms_xform_shortname (xmms_xform_t *xform);
 static xmms_xform_t *add_effects (xmms_xform_t *last,
                                   xmms_medialib_entry_t entry,
-                                  GList *goal_formats);
+                                  GList *goal_formats,
+                                  gboolean float_mode);
 static xmms_xform_t *xmms_xform_new_effect (xmms_xform_t* last,
                                             xmms_medialib_entry_t entry,
                                             GList *goal_formats,
-                                            const gchar *name);
+                                            const gchar *name,
+                                            gboolean float_mode);
+static xmms_xform_t *xmms_xform_new_converter (xmms_xform_t *last,
+                                               xmms_medialib_entry_t entry,
+                                               GList *goal_formats);
 static void xmms_xform_destroy (xmms_object_t *object);
 static void effect_callbacks_init (void);
 
@@ -104,6 +141,189 @@ static xmmsv_t *xmms_xform_client_browse (xmms_xform_object_t *obj, const gchar
 
 #include "xform_ipc.c"
 
+static void
+xmms_xform_pool_destroy (xmms_object_t *object)
+{
+	xmms_xform_pool_t *pool = (xmms_xform_pool_t *) object;
+	xmms_xform_block_t *block;
+
+	while ((block = pool->free) != NULL) {
+		pool->free = block->h.next;
+		g_free (block);
+	}
+
+	g_mutex_free (pool->mutex);
+}
+
+static xmms_xform_pool_t *
+xmms_xform_pool_new (void)
+{
+	xmms_xform_pool_t *pool;
+
+	pool = xmms_object_new (xmms_xform_pool_t, xmms_xform_pool_destroy);
+	pool->mutex = g_mutex_new ();
+
+	return pool;
+}
+
+static gpointer
+xmms_xform_pool_alloc (xmms_xform_pool_t *pool, gsize size)
+{
+	xmms_xform_block_t *block = NULL;
+
+	g_mutex_lock (pool->mutex);
+	if (size <= XMMS_XFORM_POOL_BLOCK_SIZE && pool->free) {
+		block = pool->free;
+		pool->free = block->h.next;
+	} else {
+		pool->allocations++;
+	}
+	g_mutex_unlock (pool->mutex);
+
+	if (!block) {
+		size = MAX (size, XMMS_XFORM_POOL_BLOCK_SIZE);
+		block = g_malloc (sizeof (xmms_xform_block_t) + size);
+		block->h.size = size;
+	}
+
+	return block + 1;
+}
+
+static void
+xmms_xform_pool_free (xmms_xform_pool_t *pool, gpointer data)
+{
+	xmms_xform_block_t *block;
+
+	if (!data) {
+		return;
+	}
+
+	block = (xmms_xform_block_t *) data - 1;
+	if (block->h.size != XMMS_XFORM_POOL_BLOCK_SIZE) {
+		g_free (block);
+		return;
+	}
+
+	g_mutex_lock (pool->mutex);
+	block->h.next = pool->free;
+	pool->free = block;
+	g_mutex_unlock (pool->mutex);
+}
+
+/**
+ * Copy the first len buffered bytes out of the ring.
+ */
+static void
+xmms_xform_buffer_copy (xmms_xform_t *xform, gpointer buf, gint len)
+{
+	gint first;
+
+	first = MIN (len, xform->buffersize - xform->bufstart);
+	memcpy (buf, xform->buffer + xform->bufstart, first);
+	memcpy ((gchar *) buf + first, xform->buffer, len - first);
+}
+
+static void
+xmms_xform_buffer_consume (xmms_xform_t *xform, gint len)
+{
+	xform->buffered -= len;
+	if (xform->buffered) {
+		xform->bufstart = (xform->bufstart + len) & (xform->buffersize - 1);
+	} else {
+		xform->bufstart = 0;
+	}
+}
+
+/**
+ * Make room for at least len more bytes, linearizing the ring into a
+ * larger buffer if needed.
+ */
+static void
+xmms_xform_buffer_reserve (xmms_xform_t *xform, gint len)
+{
+	gchar *buffer;
+	gint size;
+
+	if (xform->buffered + len <= xform->buffersize) {
+		return;
+	}
+
+	for (size = xform->buffersize; size < xform->buffered + len; size *= 2);
+
+	buffer = xmms_xform_pool_alloc (xform->pool, size);
+	xmms_xform_buffer_copy (xform, buffer, xform->buffered);
+	xmms_xform_pool_free (xform->pool, xform->buffer);
+
+	xform->buffer = buffer;
+	xform->buffersize = size;
+	xform->bufstart = 0;
+}
+
+/**
+ * Get the contiguous free space following the buffered data.
+ */
+static gchar *
+xmms_xform_buffer_tail (xmms_xform_t *xform, gint *len)
+{
+	gint end = xform->bufstart + xform->buffered;
+
+	if (end < xform->buffersize) {
+		*len = xform->buffersize - end;
+		return xform->buffer + end;
+	}
+
+	*len = xform->buffersize - xform->buffered;
+	return xform->buffer + end - xform->buffersize;
+}
+
+static void
+xmms_xform_buffer_append (xmms_xform_t *xform, gconstpointer buf, gint len)
+{
+	gchar *tail;
+	gint avail;
+
+	xmms_xform_buffer_reserve (xform, len);
+
+	tail = xmms_xform_buffer_tail (xform, &avail);
+	avail = MIN (avail, len);
+	memcpy (tail, buf, avail);
+	memcpy (xform->buffer, (const gchar *) buf + avail, len - avail);
+
+	xform->buffered += len;
+}
+
+/**
+ * Get the number of heap allocations made by the buffer pool of the
+ * chain this xform belongs to.
+ */
+guint
+xmms_xform_pool_allocations_get (xmms_xform_t *xform)
+{
+	guint ret;
+
+	g_mutex_lock (xform->pool->mutex);
+	ret = xform->pool->allocations;
+	g_mutex_unlock (xform->pool->mutex);
+
+	return ret;
+}
+
+gpointer
+xmms_xform_scratch_alloc (xmms_xform_t *xform, gsize size)
+{
+	g_return_val_if_fail (xform, NULL);
+
+	return xmms_xform_pool_alloc (xform->pool, size);
+}
+
+void
+xmms_xform_scratch_free (xmms_xform_t *xform, gpointer buf)
+{
+	g_return_if_fail (xform);
+
+	xmms_xform_pool_free (xform->pool, buf);
+}
+
 void
 xmms_xform_browse_add_entry_property_str (xmms_xform_t *xform,
                                           const gchar *key,
@@ -363,7 +583,8 @@ xmms_xform_destroy (xmms_object_t *object)
 	g_hash_table_destroy (xform->privdata);
 	g_queue_free (xform->hotspots);
 
-	g_free (xform->buffer);
+	xmms_xform_pool_free (xform->pool, xform->buffer);
+	xmms_object_unref (xform->pool);
 
 	xmms_object_unref (xform->out_type);
 	xmms_object_unref (xform->plugin);
@@ -388,11 +609,16 @@ xmms_xform_new (xmms_xform_plugin_t *plugin, xmms_xform_t *prev,
 	xform->entry = entry;
 	xform->medialib = medialib;
 	xform->goal_hints = goal_hints;
-	xform->lr.bufend = &xform->lr.buf[0];
+	xform->lr.start = xform->lr.end = &xform->lr.buf[0];
 
 	if (prev) {
 		xmms_object_ref (prev);
 		xform->prev = prev;
+
+		xmms_object_ref (prev->pool);
+		xform->pool = prev->pool;
+	} else {
+		xform->pool = xmms_xform_pool_new ();
 	}
 
 	xform->metadata = g_hash_table_new_full (g_str_hash, g_str_equal,
@@ -413,8 +639,8 @@ xmms_xform_new (xmms_xform_plugin_t *plugin, xmms_xform_t *prev,
 		g_return_val_if_fail (xform->out_type, NULL);
 	}
 
-	xform->buffer = g_malloc (READ_CHUNK);
-	xform->buffersize = READ_CHUNK;
+	xform->buffer = xmms_xform_pool_alloc (xform->pool, XMMS_XFORM_POOL_BLOCK_SIZE);
+	xform->buffersize = XMMS_XFORM_POOL_BLOCK_SIZE;
 
 	return xform;
 }
@@ -888,16 +1114,14 @@ xmms_xform_this_peek (xmms_xform_t *xform, gpointer buf, gint siz,
                       xmms_error_t *err)
 {
 	while (xform->buffered < siz) {
-		gint res;
+		gchar *tail;
+		gint res, avail;
 
-		if (xform->buffered + READ_CHUNK > xform->buffersize) {
-			xform->buffersize *= 2;
-			xform->buffer = g_realloc (xform->buffer, xform->buffersize);
-		}
+		xmms_xform_buffer_reserve (xform, READ_CHUNK);
+		tail = xmms_xform_buffer_tail (xform, &avail);
 
-		res = xmms_xform_plugin_read (xform->plugin, xform,
-		                              &xform->buffer[xform->buffered],
-		                              READ_CHUNK, err);
+		res = xmms_xform_plugin_read (xform->plugin, xform, tail,
+		                              MIN (avail, READ_CHUNK), err);
 
 		if (res < -1) {
 			XMMS_DBG ("Read method of %s returned bad value (%d) - BUG IN PLUGIN",
@@ -918,7 +1142,7 @@ xmms_xform_this_peek (xmms_xform_t *xform, gpointer buf, gint siz,
 
 	/* might have eosed */
 	siz = MIN (siz, xform->buffered);
-	memcpy (buf, xform->buffer, siz);
+	xmms_xform_buffer_copy (xform, buf, siz);
 	return siz;
 }
 
@@ -973,17 +1197,11 @@ xmms_xform_this_read (xmms_xform_t *xform, gpointer buf, gint siz,
 
 	if (xform->buffered) {
 		read = MIN (siz, xform->buffered);
-		memcpy (buf, xform->buffer, read);
-		xform->buffered -= read;
+		xmms_xform_buffer_copy (xform, buf, read);
+		xmms_xform_buffer_consume (xform, read);
 
 		/* buffer edited, update hotspot positions */
 		g_queue_foreach (xform->hotspots, &xmms_xform_hotspot_callback, &read);
-
-		if (xform->buffered) {
-			/* unless we are _peek:ing often
-			   this should be fine */
-			memmove (xform->buffer, &xform->buffer[read], xform->buffered);
-		}
 	}
 
 	if (xform->eos) {
@@ -1013,15 +1231,7 @@ xmms_xform_this_read (xmms_xform_t *xform, gpointer buf, gint siz,
 				xmms_xform_hotspots_update (xform);
 
 			if (!g_queue_is_empty (xform->hotspots)) {
-				if (xform->buffered + res > xform->buffersize) {
-					xform->buffersize = MAX (xform->buffersize * 2,
-					                         xform->buffersize + res);
-					xform->buffer = g_realloc (xform->buffer,
-					                           xform->buffersize);
-				}
-
-				g_memmove (xform->buffer + xform->buffered, buf + read, res);
-				xform->buffered += res;
+				xmms_xform_buffer_append (xform, (gchar *) buf + read, res);
 				break;
 			}
 			read += res;
@@ -1058,6 +1268,7 @@ xmms_xform_this_seek (xmms_xform_t *xform, gint64 offset,
 
 		xform->eos = FALSE;
 		xform->buffered = 0;
+		xform->bufstart = 0;
 
 		/* flush the hotspot queue on seek */
 		while ((hs = g_queue_pop_head (xform->hotspots)) != NULL) {
@@ -1079,46 +1290,75 @@ xmms_xform_peek (xmms_xform_t *xform, gpointer buf, gint siz,
 }
 
 gchar *
-xmms_xform_read_line (xmms_xform_t *xform, gchar *line, xmms_error_t *err)
+xmms_xform_read_line_view (xmms_xform_t *xform, xmms_error_t *err)
 {
-	gchar *p;
+	gchar *line, *p, *scan;
+	gint l, r;
 
 	g_return_val_if_fail (xform, NULL);
-	g_return_val_if_fail (line, NULL);
 
-	p = strchr (xform->lr.buf, '\n');
+	scan = xform->lr.start;
 
-	if (!p) {
-		gint l, r;
+	while (!(p = memchr (scan, '\n', xform->lr.end - scan))) {
+		/* only the unfinished line is moved, once per refill */
+		if (xform->lr.start > xform->lr.buf) {
+			l = xform->lr.end - xform->lr.start;
+			memmove (xform->lr.buf, xform->lr.start, l);
+			xform->lr.start = xform->lr.buf;
+			xform->lr.end = xform->lr.buf + l;
+		}
+		scan = xform->lr.end;
 
-		l = (XMMS_XFORM_MAX_LINE_SIZE - 1) - (xform->lr.bufend - xform->lr.buf);
-		if (l) {
-			r = xmms_xform_read (xform, xform->lr.bufend, l, err);
-			if (r < 0) {
-				return NULL;
-			}
-			xform->lr.bufend += r;
+		l = (XMMS_XFORM_MAX_LINE_SIZE - 1) - (xform->lr.end - xform->lr.buf);
+		if (!l) {
+			/* line longer than the buffer, hand it out in pieces */
+			p = xform->lr.end;
+			break;
 		}
-		if (xform->lr.bufend <= xform->lr.buf)
+
+		r = xmms_xform_read (xform, xform->lr.end, l, err);
+		if (r < 0) {
 			return NULL;
+		}
 
-		*(xform->lr.bufend) = '\0';
-		p = strchr (xform->lr.buf, '\n');
-		if (!p) {
-			p = xform->lr.bufend;
+		if (!r) {
+			if (xform->lr.end == xform->lr.start) {
+				return NULL;
+			}
+			/* last line without a newline */
+			p = xform->lr.end;
+			break;
 		}
+
+		xform->lr.end += r;
 	}
 
-	if (p > xform->lr.buf && *(p-1) == '\r') {
+	line = xform->lr.start;
+	xform->lr.start = p < xform->lr.end ? p + 1 : p;
+
+	if (p > line && *(p-1) == '\r') {
 		*(p-1) = '\0';
 	} else {
 		*p = '\0';
 	}
 
-	strcpy (line, xform->lr.buf);
-	memmove (xform->lr.buf, p + 1, xform->lr.bufend - p);
-	xform->lr.bufend -= (p - xform->lr.buf) + 1;
-	*xform->lr.bufend = '\0';
+	return line;
+}
+
+gchar *
+xmms_xform_read_line (xmms_xform_t *xform, gchar *line, xmms_error_t *err)
+{
+	gchar *p;
+
+	g_return_val_if_fail (xform, NULL);
+	g_return_val_if_fail (line, NULL);
+
+	p = xmms_xform_read_line_view (xform, err);
+	if (!p) {
+		return NULL;
+	}
+
+	strcpy (line, p);
 
 	return line;
 }
@@ -1301,9 +1541,25 @@ outdata_type_metadata_collect (xmms_xform_t *xform)
 	}
 }
 
+static gboolean
+is_pcm (xmms_xform_t *xform)
+{
+	const gchar *mime;
+
+	mime = xmms_stream_type_get_str (xform->out_type,
+	                                 XMMS_STREAM_TYPE_MIMETYPE);
+
+	return mime && strcmp (mime, "audio/pcm") == 0;
+}
+
+/**
+ * Build the chain from url up to one of goal_formats, or with
+ * decoded_only set, up to the first xform that outputs PCM so that the
+ * effects see the decoder's own sample format.
+ */
 static xmms_xform_t *
 chain_setup (xmms_medialib_t *medialib, xmms_medialib_entry_t entry,
-             const gchar *url, GList *goal_formats)
+             const gchar *url, GList *goal_formats, gboolean decoded_only)
 {
 	xmms_xform_t *xform, *last;
 	gchar *durl, *args;
@@ -1360,7 +1616,8 @@ chain_setup (xmms_medialib_t *medialib, xmms_medialib_entry_t entry,
 		}
 		xmms_object_unref (last);
 		last = xform;
-	} while (!has_goalformat (xform, goal_formats));
+	} while (!(decoded_only && is_pcm (xform)) &&
+	         !has_goalformat (xform, goal_formats));
 
 	outdata_type_metadata_collect (last);
 
@@ -1373,11 +1630,20 @@ chain_finalize (xmms_medialib_session_t *session,
                 const gchar *url, gboolean rehashing)
 {
 	GString *namestr;
+	xmms_xform_t *x;
+	gint conversions = 0;
+
+	for (x = xform; x; x = x->prev) {
+		if (x->plugin && !strcmp (xmms_xform_shortname (x), "converter")) {
+			conversions++;
+		}
+	}
 
 	namestr = g_string_new ("");
 	xmms_xform_metadata_collect (session, xform, namestr, rehashing);
-	xmms_log_info ("Successfully setup chain for '%s' (%d) containing %s",
-	               url, entry, namestr->str);
+	xmms_log_info ("Successfully setup chain for '%s' (%d) containing %s "
+	               "with %d sample format conversion(s)",
+	               url, entry, namestr->str, conversions);
 
 	g_string_free (namestr, TRUE);
 }
@@ -1433,19 +1699,27 @@ xmms_xform_chain_setup_session (xmms_medialib_t *medialib,
 	return xform;
 }
 
-xmms_xform_t *
-xmms_xform_chain_setup_url_session (xmms_medialib_t *medialib,
-                                    xmms_medialib_session_t *session,
-                                    xmms_medialib_entry_t entry, const gchar *url,
-                                    GList *goal_formats, gboolean rehash)
+static xmms_xform_t *
+chain_setup_full (xmms_medialib_t *medialib, xmms_medialib_session_t *session,
+                  xmms_medialib_entry_t entry, const gchar *url,
+                  GList *goal_formats, gboolean rehash)
 {
 	xmms_xform_t *last;
 	xmms_plugin_t *plugin;
 	xmms_xform_plugin_t *xform_plugin;
+	xmms_config_property_t *cfg;
 	gboolean add_segment = FALSE;
+	gboolean float_mode = FALSE;
 	gint priority;
 
-	last = chain_setup (medialib, entry, url, goal_formats);
+	/* with float effects, the coercion to the output format happens
+	 * after the effects instead of before them */
+	cfg = xmms_config_lookup ("effect.float32");
+	if (cfg && !rehash) {
+		float_mode = !!xmms_config_property_get_int (cfg);
+	}
+
+	last = chain_setup (medialib, entry, url, goal_formats, float_mode);
 	if (!last) {
 		return NULL;
 	}
@@ -1465,7 +1739,8 @@ xmms_xform_chain_setup_url_session (xmms_medialib_t *medialib,
 
 	/* add segment plugin to the chain if it can be added */
 	if (add_segment) {
-		last = xmms_xform_new_effect (last, entry, goal_formats, "segment");
+		last = xmms_xform_new_effect (last, entry, goal_formats, "segment",
+		                              FALSE);
 		if (!last) {
 			return NULL;
 		}
@@ -1473,7 +1748,7 @@ xmms_xform_chain_setup_url_session (xmms_medialib_t *medialib,
 
 	/* if not rehashing, also initialize all the effect plugins */
 	if (!rehash) {
-		last = add_effects (last, entry, goal_formats);
+		last = add_effects (last, entry, goal_formats, float_mode);
 		if (!last) {
 			return NULL;
 		}
@@ -1483,6 +1758,22 @@ xmms_xform_chain_setup_url_session (xmms_medialib_t *medialib,
 	return last;
 }
 
+xmms_xform_t *
+xmms_xform_chain_setup_url_session (xmms_medialib_t *medialib,
+                                    xmms_medialib_session_t *session,
+                                    xmms_medialib_entry_t entry, const gchar *url,
+                                    GList *goal_formats, gboolean rehash)
+{
+	xmms_xform_t *xform;
+	gint64 start;
+
+	start = xmms_stats_now ();
+	xform = chain_setup_full (medialib, session, entry, url, goal_formats, rehash);
+	xmms_stats_record_since (XMMS_STATS_XFORM_CHAIN_SETUP, start);
+
+	return xform;
+}
+
 xmms_xform_t *
 xmms_xform_chain_setup_url (xmms_medialib_t *medialib,
                             xmms_medialib_entry_t entry, const gchar *url,
@@ -1510,31 +1801,145 @@ xmms_xform_config_lookup (xmms_xform_t *xform, const gchar *path)
 	return xmms_plugin_config_lookup ((xmms_plugin_t *) xform->plugin, path);
 }
 
+/**
+ * Append the configured effects to the chain.
+ *
+ * With float_mode set, the chain ends at the decoder's output and
+ * effects are fed float samples whenever they accept them, so the
+ * effect section converts once on the way in and, if the output can't
+ * take float, once on the way out to goal_formats. Effects that don't
+ * take float get the nearest format they do take instead of being
+ * skipped.
+ */
 static xmms_xform_t *
 add_effects (xmms_xform_t *last, xmms_medialib_entry_t entry,
-             GList *goal_formats)
+             GList *goal_formats, gboolean float_mode)
 {
 	gint effect_no;
 
 	for (effect_no = 0; TRUE; effect_no++) {
-		xmms_config_property_t *cfg;
+		xmms_config_property_t *order;
 		gchar key[64];
 		const gchar *name;
 
 		g_snprintf (key, sizeof (key), "effect.order.%i", effect_no);
 
-		cfg = xmms_config_lookup (key);
-		if (!cfg) {
+		order = xmms_config_lookup (key);
+		if (!order) {
 			break;
 		}
 
-		name = xmms_config_property_get_string (cfg);
+		name = xmms_config_property_get_string (order);
 
 		if (!name[0]) {
 			continue;
 		}
 
-		last = xmms_xform_new_effect (last, entry, goal_formats, name);
+		last = xmms_xform_new_effect (last, entry, goal_formats, name,
+		                              float_mode);
+	}
+
+	if (float_mode && !has_goalformat (last, goal_formats)) {
+		last = xmms_xform_new_converter (last, entry, goal_formats);
+		if (!has_goalformat (last, goal_formats)) {
+			xmms_log_error ("Couldn't convert effect output to an output format");
+			xmms_object_unref (last);
+			return NULL;
+		}
+	}
+
+	return last;
+}
+
+/**
+ * Append a sample format converter towards one of goal_formats.
+ * The chain is returned unchanged if that's not possible.
+ */
+static xmms_xform_t *
+xmms_xform_new_converter (xmms_xform_t *last, xmms_medialib_entry_t entry,
+                          GList *goal_formats)
+{
+	xmms_plugin_t *plugin;
+	xmms_xform_t *xform;
+
+	plugin = xmms_plugin_find (XMMS_PLUGIN_TYPE_XFORM, "converter");
+	if (!plugin) {
+		return last;
+	}
+
+	xform = xmms_xform_new ((xmms_xform_plugin_t *) plugin, last,
+	                        last->medialib, entry, goal_formats);
+	xmms_object_unref (plugin);
+
+	if (!xform) {
+		return last;
+	}
+
+	xmms_object_unref (last);
+	return xform;
+}
+
+/**
+ * Convert the chain to the format of a given type.
+ */
+static xmms_xform_t *
+convert_to_type (xmms_xform_t *last, xmms_medialib_entry_t entry,
+                 xmms_stream_type_t *type)
+{
+	xmms_xform_t *xform;
+	GList *goal;
+
+	goal = g_list_prepend (NULL, type);
+	xform = xmms_xform_new_converter (last, entry, goal);
+	if (xform != last) {
+		/* the hints are only consulted while the converter initializes */
+		xform->goal_hints = NULL;
+	}
+	g_list_free (goal);
+
+	return xform;
+}
+
+/**
+ * Make the chain output a format the effect takes, preferring float
+ * so that following effects can keep it without another conversion.
+ */
+static xmms_xform_t *
+effect_input_convert (xmms_xform_t *last, xmms_medialib_entry_t entry,
+                      xmms_xform_plugin_t *xform_plugin)
+{
+	static const xmms_sample_format_t preferred[] = {
+		XMMS_SAMPLE_FORMAT_FLOAT,
+		XMMS_SAMPLE_FORMAT_S16
+	};
+	gint i, priority, format;
+
+	format = xmms_stream_type_get_int (last->out_type,
+	                                   XMMS_STREAM_TYPE_FMT_FORMAT);
+
+	for (i = 0; i < G_N_ELEMENTS (preferred); i++) {
+		xmms_stream_type_t *type;
+		gboolean supported;
+
+		if (format == preferred[i]) {
+			if (xmms_xform_plugin_supports (xform_plugin, last->out_type,
+			                                &priority)) {
+				return last;
+			}
+			continue;
+		}
+
+		type = xmms_stream_type_pcm_with_format (last->out_type,
+		                                         preferred[i]);
+		supported = xmms_xform_plugin_supports (xform_plugin, type, &priority);
+		if (supported) {
+			last = convert_to_type (last, entry, type);
+		}
+		xmms_object_unref (type);
+
+		if (supported) {
+			break;
+		}
 	}
 
 	return last;
@@ -1542,7 +1947,8 @@ add_effects (xmms_xform_t *last, xmms_medialib_entry_t entry,
 
 static xmms_xform_t *
 xmms_xform_new_effect (xmms_xform_t *last, xmms_medialib_entry_t entry,
-                       GList *goal_formats, const gchar *name)
+                       GList *goal_formats, const gchar *name,
+                       gboolean float_mode)
 {
 	xmms_plugin_t *plugin;
 	xmms_xform_plugin_t *xform_plugin;
@@ -1556,6 +1962,11 @@ xmms_xform_new_effect (xmms_xform_t *last, xmms_medialib_entry_t entry,
 	}
 
 	xform_plugin = (xmms_xform_plugin_t *) plugin;
+
+	if (float_mode) {
+		last = effect_input_convert (last, entry, xform_plugin);
+	}
+
 	if (!xmms_xform_plugin_supports (xform_plugin, last->out_type, &priority)) {
 		xmms_log_info ("Effect '%s' doesn't support format, skipping",
 		               xmms_plugin_shortname_get (plugin));
@@ -1654,6 +2065,8 @@ effect_callbacks_init (void)
 		xmms_object_unref (plugin);
 	}
 
+	xmms_config_property_register ("effect.float32", "0", NULL, NULL);
+
 	/* the name stored in the last present property was not "" or there was no
 	   last present property */
 	if ((!effect_no) || name[0]) {
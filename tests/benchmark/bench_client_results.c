@@ -0,0 +1,159 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2012 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+/* Reply dispatch in libxmmsclient: a client pipelines an increasing
+ * number of requests against an in-process server before it starts
+ * reading, so every reply has to be matched against all pending
+ * results. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "xmmspriv/xmms_log.h"
+#include "xmmspriv/xmms_ipc.h"
+#include "xmmsclient/xmmsclient.h"
+
+typedef struct {
+	xmms_object_t obj;
+} bench_object_t;
+
+static void
+bench_hello (xmms_object_t *object, xmms_object_cmd_arg_t *arg)
+{
+	arg->retval = xmmsv_new_int (1);
+}
+
+static void
+bench_stats (xmms_object_t *object, xmms_object_cmd_arg_t *arg)
+{
+	arg->retval = xmmsv_new_int (0);
+}
+
+static int
+count_reply (xmmsv_t *value, void *udata)
+{
+	gint *replies = udata;
+
+	(*replies)++;
+
+	return FALSE;
+}
+
+static void
+measure (xmmsc_connection_t *c, gint count)
+{
+	xmmsc_result_t **results;
+	struct pollfd pfd;
+	GTimer *timer;
+	gdouble elapsed;
+	gint i, replies = 0;
+
+	results = g_new0 (xmmsc_result_t *, count);
+
+	timer = g_timer_new ();
+
+	for (i = 0; i < count; i++) {
+		results[i] = xmmsc_main_stats (c);
+		xmmsc_result_notifier_set (results[i], count_reply, &replies);
+	}
+
+	pfd.fd = xmmsc_io_fd_get (c);
+
+	while (replies < count) {
+		pfd.events = POLLIN;
+		if (xmmsc_io_want_out (c)) {
+			pfd.events |= POLLOUT;
+		}
+
+		if (poll (&pfd, 1, 5000) <= 0) {
+			fprintf (stderr, "timeout waiting for %d replies\n", count - replies);
+			exit (EXIT_FAILURE);
+		}
+
+		if (pfd.revents & POLLOUT) {
+			xmmsc_io_out_handle (c);
+		}
+		if ((pfd.revents & POLLIN) && !xmmsc_io_in_handle (c)) {
+			fprintf (stderr, "disconnected\n");
+			exit (EXIT_FAILURE);
+		}
+	}
+
+	elapsed = g_timer_elapsed (timer, NULL);
+
+	for (i = 0; i < count; i++) {
+		xmmsc_result_unref (results[i]);
+	}
+
+	printf ("%d,%.3f,%.0f\n", count, elapsed * 1000.0, count / elapsed);
+	fflush (stdout);
+
+	g_timer_destroy (timer);
+	g_free (results);
+}
+
+int
+main (int argc, char **argv)
+{
+	const gint counts[] = { 1000, 10000, 100000 };
+	xmmsc_connection_t *c;
+	bench_object_t *object;
+	gchar *path;
+	gint i;
+
+	g_thread_init (NULL);
+
+	xmms_log_init (0);
+	xmms_ipc_init ();
+
+	object = xmms_object_new (bench_object_t, NULL);
+	xmms_object_cmd_add (XMMS_OBJECT (object), XMMS_IPC_CMD_HELLO, bench_hello);
+	xmms_object_cmd_add (XMMS_OBJECT (object), XMMS_IPC_CMD_STATS, bench_stats);
+	xmms_ipc_object_register (XMMS_IPC_OBJECT_MAIN, XMMS_OBJECT (object));
+
+	path = g_strdup_printf ("unix:///tmp/xmms-bench-results-%d", (gint) getpid ());
+	if (!xmms_ipc_setup_server (path)) {
+		fprintf (stderr, "could not listen on %s\n", path);
+		return EXIT_FAILURE;
+	}
+
+	c = xmmsc_init ("bench");
+	if (!xmmsc_connect (c, path)) {
+		fprintf (stderr, "could not connect: %s\n", xmmsc_get_last_error (c));
+		return EXIT_FAILURE;
+	}
+
+	printf ("requests,total_ms,replies_per_sec\n");
+	for (i = 0; i < G_N_ELEMENTS (counts); i++) {
+		measure (c, counts[i]);
+	}
+
+	xmmsc_unref (c);
+
+	xmms_ipc_object_unregister (XMMS_IPC_OBJECT_MAIN);
+	xmms_object_unref (object);
+	xmms_ipc_shutdown ();
+
+	g_unlink (path + strlen ("unix://"));
+	g_free (path);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,144 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2012 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+/* Memory use and build time of a list of 300k medialib info dicts,
+ * shaped like the trees built by xmms_medialib_tree_add_tuple. The
+ * list is built once with the usual property names and sources, which
+ * are interned, and once with made up ones of the same length, which
+ * are not. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <glib.h>
+
+#include "xmmsc/xmmsv.h"
+
+#define ENTRIES 300000
+
+typedef struct {
+	const gchar *key;
+	const gchar *source;
+} property_t;
+
+static const property_t common[] = {
+	{ "id", "server" },
+	{ "url", "server" },
+	{ "added", "server" },
+	{ "lmod", "server" },
+	{ "status", "server" },
+	{ "timesplayed", "server" },
+	{ "artist", "plugin/id3v2" },
+	{ "album", "plugin/id3v2" },
+	{ "title", "plugin/id3v2" },
+	{ "tracknr", "plugin/id3v2" },
+	{ "genre", "plugin/id3v2" },
+	{ "date", "plugin/id3v2" },
+	{ "duration", "plugin/mad" },
+	{ "bitrate", "plugin/mad" },
+	{ "samplerate", "plugin/mad" },
+	{ "channels", "plugin/mad" },
+};
+
+static const property_t uncommon[] = {
+	{ "xd", "xerver" },
+	{ "xrl", "xerver" },
+	{ "xdded", "xerver" },
+	{ "xmod", "xerver" },
+	{ "xtatus", "xerver" },
+	{ "ximesplayed", "xerver" },
+	{ "xrtist", "xlugin/id3v2" },
+	{ "xlbum", "xlugin/id3v2" },
+	{ "xitle", "xlugin/id3v2" },
+	{ "xracknr", "xlugin/id3v2" },
+	{ "xenre", "xlugin/id3v2" },
+	{ "xate", "xlugin/id3v2" },
+	{ "xuration", "xlugin/mad" },
+	{ "xitrate", "xlugin/mad" },
+	{ "xamplerate", "xlugin/mad" },
+	{ "xhannels", "xlugin/mad" },
+};
+
+static gsize
+heap_in_use (void)
+{
+#if defined (__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+	return mallinfo2 ().uordblks;
+#elif defined (__GLIBC__)
+	return (guint) mallinfo ().uordblks;
+#else
+	return 0;
+#endif
+}
+
+static void
+measure (const gchar *name, const property_t *props, gint count)
+{
+	xmmsv_t *list, *entry, *sources;
+	GTimer *timer;
+	gdouble build, release;
+	gsize before, after;
+	gchar buf[32];
+	gint i, j;
+
+	before = heap_in_use ();
+	timer = g_timer_new ();
+
+	list = xmmsv_new_list ();
+	for (i = 0; i < ENTRIES; i++) {
+		entry = xmmsv_new_dict ();
+
+		for (j = 0; j < count; j++) {
+			sources = xmmsv_new_dict ();
+			if (j < 6) {
+				xmmsv_dict_set_int (sources, props[j].source, i);
+			} else {
+				/* few distinct values, like artists and albums */
+				g_snprintf (buf, sizeof (buf), "value %d", i % 1000);
+				xmmsv_dict_set_string (sources, props[j].source, buf);
+			}
+			xmmsv_dict_set (entry, props[j].key, sources);
+			xmmsv_unref (sources);
+		}
+
+		xmmsv_list_append (list, entry);
+		xmmsv_unref (entry);
+	}
+
+	build = g_timer_elapsed (timer, NULL);
+	after = heap_in_use ();
+
+	g_timer_start (timer);
+	xmmsv_unref (list);
+	release = g_timer_elapsed (timer, NULL);
+
+	printf ("%s,%d,%.1f,%.1f,%" G_GSIZE_FORMAT "\n", name, ENTRIES,
+	        build * 1000.0, release * 1000.0, after - before);
+	fflush (stdout);
+
+	g_timer_destroy (timer);
+}
+
+int
+main (int argc, char **argv)
+{
+	printf ("keys,entries,build_ms,free_ms,heap_bytes\n");
+
+	measure ("interned", common, G_N_ELEMENTS (common));
+	measure ("not_interned", uncommon, G_N_ELEMENTS (uncommon));
+
+	return EXIT_SUCCESS;
+}
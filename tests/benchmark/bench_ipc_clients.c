@@ -0,0 +1,231 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2012 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+/* Connection scaling of the IPC server: an in-process server is fed by
+ * an increasing number of concurrently connected clients, each issuing
+ * one command per round. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "xmmspriv/xmms_log.h"
+#include "xmmspriv/xmms_ipc.h"
+#include "xmmsc/xmmsc_ipc_transport.h"
+#include "xmmsc/xmmsc_ipc_msg.h"
+
+#define ROUNDS 20
+
+typedef struct {
+	xmms_object_t obj;
+} bench_object_t;
+
+static void
+bench_hello (xmms_object_t *object, xmms_object_cmd_arg_t *arg)
+{
+	arg->retval = xmmsv_new_int (1);
+}
+
+static gint
+thread_count (void)
+{
+	gchar *status, *line;
+	gint threads = -1;
+
+	if (!g_file_get_contents ("/proc/self/status", &status, NULL, NULL)) {
+		return -1;
+	}
+
+	line = strstr (status, "Threads:");
+	if (line) {
+		threads = atoi (line + strlen ("Threads:"));
+	}
+	g_free (status);
+
+	return threads;
+}
+
+static void
+send_hello (xmms_ipc_transport_t *transport, guint32 cookie)
+{
+	xmms_ipc_msg_t *msg;
+	xmmsv_t *args;
+	bool disconnected = false;
+
+	msg = xmms_ipc_msg_new (XMMS_IPC_OBJECT_MAIN, XMMS_IPC_CMD_HELLO);
+	xmms_ipc_msg_set_cookie (msg, cookie);
+
+	args = xmmsv_new_list ();
+	xmms_ipc_msg_put_value (msg, args);
+	xmmsv_unref (args);
+
+	while (!xmms_ipc_msg_write_transport (msg, transport, &disconnected)) {
+		if (disconnected) {
+			fprintf (stderr, "client disconnected\n");
+			exit (EXIT_FAILURE);
+		}
+		g_usleep (100);
+	}
+
+	xmms_ipc_msg_destroy (msg);
+}
+
+/* send one command on every client, wait for all the replies */
+static void
+run_round (xmms_ipc_transport_t **clients, struct pollfd *fds, gint count)
+{
+	xmms_ipc_msg_t **replies;
+	gint i, pending;
+
+	replies = g_new0 (xmms_ipc_msg_t *, count);
+
+	for (i = 0; i < count; i++) {
+		send_hello (clients[i], i);
+		fds[i].events = POLLIN;
+	}
+
+	for (pending = count; pending > 0; ) {
+		if (poll (fds, count, 5000) <= 0) {
+			fprintf (stderr, "timeout waiting for %d replies\n", pending);
+			exit (EXIT_FAILURE);
+		}
+
+		for (i = 0; i < count; i++) {
+			bool disconnected = false;
+
+			if (!(fds[i].revents & POLLIN)) {
+				continue;
+			}
+
+			if (!replies[i]) {
+				replies[i] = xmms_ipc_msg_alloc ();
+			}
+
+			if (xmms_ipc_msg_read_transport (replies[i], clients[i], &disconnected)) {
+				fds[i].events = 0;
+				pending--;
+			} else if (disconnected) {
+				fprintf (stderr, "client disconnected\n");
+				exit (EXIT_FAILURE);
+			}
+		}
+	}
+
+	for (i = 0; i < count; i++) {
+		xmms_ipc_msg_destroy (replies[i]);
+	}
+	g_free (replies);
+}
+
+static void
+measure (const gchar *path, gint count)
+{
+	xmms_ipc_transport_t **clients;
+	struct pollfd *fds;
+	GTimer *timer;
+	gdouble connect_time, round_time;
+	gint i, threads;
+
+	clients = g_new0 (xmms_ipc_transport_t *, count);
+	fds = g_new0 (struct pollfd, count);
+
+	timer = g_timer_new ();
+	for (i = 0; i < count; i++) {
+		clients[i] = xmms_ipc_client_init (path);
+		if (!clients[i]) {
+			fprintf (stderr, "could not connect client %d\n", i);
+			exit (EXIT_FAILURE);
+		}
+		fds[i].fd = xmms_ipc_transport_fd_get (clients[i]);
+	}
+	connect_time = g_timer_elapsed (timer, NULL);
+
+	/* first round also waits for all accepts */
+	run_round (clients, fds, count);
+
+	g_timer_start (timer);
+	for (i = 0; i < ROUNDS; i++) {
+		run_round (clients, fds, count);
+	}
+	round_time = g_timer_elapsed (timer, NULL);
+
+	threads = thread_count ();
+
+	printf ("%d,%.3f,%.0f,%d\n", count, connect_time * 1000.0,
+	        count * ROUNDS / round_time, threads);
+	fflush (stdout);
+
+	for (i = 0; i < count; i++) {
+		xmms_ipc_transport_destroy (clients[i]);
+	}
+
+	g_timer_destroy (timer);
+	g_free (clients);
+	g_free (fds);
+
+	/* let the server notice the hangups before the next run */
+	g_usleep (G_USEC_PER_SEC / 2);
+}
+
+int
+main (int argc, char **argv)
+{
+	const gint counts[] = { 1, 10, 100, 1000 };
+	bench_object_t *object;
+	struct rlimit limit;
+	gchar *path;
+	gint i;
+
+	/* both ends of every connection live in this process */
+	if (getrlimit (RLIMIT_NOFILE, &limit) == 0) {
+		limit.rlim_cur = limit.rlim_max;
+		setrlimit (RLIMIT_NOFILE, &limit);
+	}
+
+	g_thread_init (NULL);
+
+	xmms_log_init (0);
+	xmms_ipc_init ();
+
+	object = xmms_object_new (bench_object_t, NULL);
+	xmms_object_cmd_add (XMMS_OBJECT (object), XMMS_IPC_CMD_HELLO, bench_hello);
+	xmms_ipc_object_register (XMMS_IPC_OBJECT_MAIN, XMMS_OBJECT (object));
+
+	path = g_strdup_printf ("unix:///tmp/xmms-bench-ipc-%d", (gint) getpid ());
+	if (!xmms_ipc_setup_server (path)) {
+		fprintf (stderr, "could not listen on %s\n", path);
+		return EXIT_FAILURE;
+	}
+
+	printf ("clients,connect_ms,requests_per_sec,threads\n");
+	for (i = 0; i < G_N_ELEMENTS (counts); i++) {
+		measure (path, counts[i]);
+	}
+
+	xmms_ipc_object_unregister (XMMS_IPC_OBJECT_MAIN);
+	xmms_object_unref (object);
+	xmms_ipc_shutdown ();
+
+	g_unlink (path + strlen ("unix://"));
+	g_free (path);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,200 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2012 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+/* Playlist import: large m3u and cue files are generated and turned into
+ * an idlist by the collection object, which runs them through the file
+ * transport and the line based playlist xforms.
+ *
+ * Usage: bench_playlist_parse [plugin directory]
+ * The directory must contain the file, m3u and cue plugins.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <locale.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "xmmspriv/xmms_plugin.h"
+#include "xmmspriv/xmms_xform.h"
+#include "xmmspriv/xmms_config.h"
+#include "xmmspriv/xmms_log.h"
+#include "xmmspriv/xmms_ipc.h"
+#include "xmmspriv/xmms_medialib.h"
+#include "xmmspriv/xmms_collection.h"
+
+#include "server-utils/ipc_call.h"
+
+/* tracks per FILE section in the generated cue sheets */
+#define CUE_TRACKS_PER_FILE 20
+
+static gchar *
+write_m3u (const gchar *dir, gint entries, gsize *size)
+{
+	GString *data;
+	gchar *path;
+	gint i;
+
+	data = g_string_new ("#EXTM3U\n");
+
+	for (i = 0; i < entries; i++) {
+		g_string_append_printf (data, "#EXTINF:%d,Artist %d - Title %d\n",
+		                        120 + i % 300, i / 100, i);
+		g_string_append_printf (data, "/music/artist %d/album %d/%02d title %d.flac\n",
+		                        i / 100, i / 10, i % 10, i);
+	}
+
+	path = g_strdup_printf ("%s/bench-%d.m3u", dir, entries);
+	g_file_set_contents (path, data->str, data->len, NULL);
+	*size = data->len;
+
+	g_string_free (data, TRUE);
+
+	return path;
+}
+
+static gchar *
+write_cue (const gchar *dir, gint entries, gsize *size)
+{
+	GString *data;
+	gchar *path;
+	gint i, t;
+
+	data = g_string_new ("");
+
+	for (i = 0; i < entries; i++) {
+		t = i % CUE_TRACKS_PER_FILE;
+		if (t == 0) {
+			g_string_append_printf (data, "PERFORMER \"Artist %d\"\r\n",
+			                        i / CUE_TRACKS_PER_FILE);
+			g_string_append_printf (data, "TITLE \"Album %d\"\r\n",
+			                        i / CUE_TRACKS_PER_FILE);
+			g_string_append_printf (data, "FILE \"album %d.flac\" WAVE\r\n",
+			                        i / CUE_TRACKS_PER_FILE);
+		}
+		g_string_append_printf (data, "  TRACK %02d AUDIO\r\n", t + 1);
+		g_string_append_printf (data, "    TITLE \"Title %d\"\r\n", i);
+		g_string_append_printf (data, "    PERFORMER \"Artist %d\"\r\n",
+		                        i / CUE_TRACKS_PER_FILE);
+		g_string_append_printf (data, "    INDEX 01 %02d:%02d:00\r\n",
+		                        t * 4, (t * 17) % 60);
+	}
+
+	path = g_strdup_printf ("%s/bench-%d.cue", dir, entries);
+	g_file_set_contents (path, data->str, data->len, NULL);
+	*size = data->len;
+
+	g_string_free (data, TRUE);
+
+	return path;
+}
+
+static void
+measure (xmms_coll_dag_t *dag, const gchar *format, const gchar *path,
+         gint entries, gsize size)
+{
+	xmmsv_coll_t *coll;
+	xmmsv_t *result;
+	GTimer *timer;
+	gdouble elapsed;
+	gchar *url;
+	gint parsed = -1;
+
+	url = g_strdup_printf ("file://%s", path);
+
+	timer = g_timer_new ();
+	result = XMMS_IPC_CALL (dag, XMMS_IPC_CMD_IDLIST_FROM_PLS,
+	                        xmmsv_new_string (url));
+	elapsed = g_timer_elapsed (timer, NULL);
+
+	if (xmmsv_get_coll (result, &coll)) {
+		parsed = xmmsv_coll_idlist_get_size (coll);
+	}
+
+	if (parsed != entries) {
+		fprintf (stderr, "%s: expected %d entries, got %d\n",
+		         format, entries, parsed);
+	}
+
+	printf ("%s,%d,%" G_GSIZE_FORMAT ",%.3f,%.0f\n", format, entries, size,
+	        elapsed * 1000.0, entries / elapsed);
+	fflush (stdout);
+
+	xmmsv_unref (result);
+	g_timer_destroy (timer);
+	g_free (url);
+}
+
+int
+main (int argc, char **argv)
+{
+	const gint counts[] = { 1000, 10000, 50000 };
+	xmms_xform_object_t *xform_object;
+	xmms_medialib_t *medialib;
+	xmms_coll_dag_t *dag;
+	gchar *dir, *path;
+	gsize size;
+	gint i;
+
+	g_thread_init (NULL);
+
+	setlocale (LC_COLLATE, "");
+
+	xmms_ipc_init ();
+	xmms_log_init (0);
+
+	xmms_config_init ("memory://");
+	xmms_config_property_register ("medialib.path", "memory://", NULL, NULL);
+
+	if (!xmms_plugin_init (argc > 1 ? argv[1] : NULL)) {
+		fprintf (stderr, "could not load plugins\n");
+		return EXIT_FAILURE;
+	}
+
+	xform_object = xmms_xform_object_init ();
+	medialib = xmms_medialib_init ();
+	dag = xmms_collection_init (medialib);
+
+	dir = g_strdup_printf ("/tmp/xmms-bench-playlist-%d", (gint) getpid ());
+	g_mkdir (dir, 0700);
+
+	printf ("format,entries,bytes,total_ms,entries_per_sec\n");
+	for (i = 0; i < G_N_ELEMENTS (counts); i++) {
+		path = write_m3u (dir, counts[i], &size);
+		measure (dag, "m3u", path, counts[i], size);
+		g_unlink (path);
+		g_free (path);
+
+		path = write_cue (dir, counts[i], &size);
+		measure (dag, "cue", path, counts[i], size);
+		g_unlink (path);
+		g_free (path);
+	}
+
+	g_rmdir (dir);
+	g_free (dir);
+
+	xmms_object_unref (dag);
+	xmms_object_unref (medialib);
+	xmms_object_unref (xform_object);
+	xmms_plugin_shutdown ();
+	xmms_config_shutdown ();
+	xmms_ipc_shutdown ();
+
+	return EXIT_SUCCESS;
+}
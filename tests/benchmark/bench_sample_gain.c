@@ -0,0 +1,88 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2012 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+/* Throughput of the gain kernels, vector against scalar, per format. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <glib.h>
+
+#include "xmmspriv/xmms_sample.h"
+
+#define SAMPLES 4096
+#define ROUNDS 20000
+
+typedef void (*gain_func_t) (xmms_sample_format_t, xmms_sample_t *, guint, gfloat);
+
+static gdouble
+measure (gain_func_t func, xmms_sample_format_t fmt, guint8 *buf)
+{
+	GTimer *timer;
+	gdouble elapsed;
+	gint i;
+
+	timer = g_timer_new ();
+	for (i = 0; i < ROUNDS; i++) {
+		/* alternate so the samples neither saturate nor vanish */
+		func (fmt, buf, SAMPLES, (i & 1) ? 1.25 : 0.8);
+	}
+	elapsed = g_timer_elapsed (timer, NULL);
+	g_timer_destroy (timer);
+
+	return (gdouble) SAMPLES * ROUNDS / elapsed / 1000000.0;
+}
+
+int
+main (int argc, char **argv)
+{
+	const xmms_sample_format_t formats[] = {
+		XMMS_SAMPLE_FORMAT_S8, XMMS_SAMPLE_FORMAT_U8,
+		XMMS_SAMPLE_FORMAT_S16, XMMS_SAMPLE_FORMAT_U16,
+		XMMS_SAMPLE_FORMAT_S32, XMMS_SAMPLE_FORMAT_U32,
+		XMMS_SAMPLE_FORMAT_FLOAT, XMMS_SAMPLE_FORMAT_DOUBLE
+	};
+	guint8 *buf;
+	gint f, i;
+
+	buf = g_malloc (SAMPLES * sizeof (gdouble));
+
+	printf ("format,impl,msamples_per_sec\n");
+
+	for (f = 0; f < G_N_ELEMENTS (formats); f++) {
+		for (i = 0; i < SAMPLES * sizeof (gdouble); i++) {
+			buf[i] = g_random_int_range (0, 64);
+		}
+		if (formats[f] == XMMS_SAMPLE_FORMAT_FLOAT) {
+			for (i = 0; i < SAMPLES; i++) {
+				((gfloat *) buf)[i] = g_random_double_range (-0.5, 0.5);
+			}
+		} else if (formats[f] == XMMS_SAMPLE_FORMAT_DOUBLE) {
+			for (i = 0; i < SAMPLES; i++) {
+				((gdouble *) buf)[i] = g_random_double_range (-0.5, 0.5);
+			}
+		}
+
+		printf ("%s,scalar,%.1f\n", xmms_sample_name_get (formats[f]),
+		        measure (xmms_sample_gain_apply_scalar, formats[f], buf));
+		printf ("%s,%s,%.1f\n", xmms_sample_name_get (formats[f]),
+		        xmms_sample_gain_impl_get (),
+		        measure (xmms_sample_gain_apply, formats[f], buf));
+	}
+
+	g_free (buf);
+
+	return EXIT_SUCCESS;
+}
@@ -37,6 +37,7 @@ typedef void (*xmms_test_predicate)(xmms_medialib_t *medialib, const gchar *name
 typedef struct xmms_test_args_St {
 	enum {
 		PERFORMANCE,
+		BENCHMARK,
 		UNITTEST
 	} variant;
 	enum {
@@ -45,6 +46,8 @@ typedef struct xmms_test_args_St {
 	} format;
 	const gchar *database_path;
 	const gchar *testcase_path;
+	const gchar *sizes;
+	gint seed;
 	gboolean debug;
 } xmms_test_args_t;
 
@@ -315,6 +318,36 @@ run_unit_test (xmms_medialib_t *mlib, const gchar *name, xmmsv_t *content,
 }
 
 
+static guint64
+elapsed_usec (const GTimeVal *t0, const GTimeVal *t1)
+{
+	return (guint64)((t1->tv_sec - t0->tv_sec) * G_USEC_PER_SEC) + (t1->tv_usec - t0->tv_usec);
+}
+
+
+static void
+print_performance_result (const gchar *name, const gchar *datasetname,
+                          xmms_error_t *err, guint64 duration, gint format)
+{
+	if (format == FORMAT_PRETTY)
+		g_print ("* Test %s\n", name);
+
+	if (xmms_error_iserror (err)) {
+		if (format == FORMAT_CSV) {
+			g_print ("\"%s\",\"%s\",0,0\n", datasetname, name);
+		} else {
+			g_print ("   - Query failed: %s\n", xmms_error_message_get (err));
+		}
+	} else {
+		if (format == FORMAT_CSV) {
+			g_print ("\"%s\",\"%s\",1,%" G_GUINT64_FORMAT "\n", datasetname, name, duration);
+		} else {
+			g_print ("   - Time elapsed: %.3fms\n", duration / 1000.0);
+		}
+	}
+}
+
+
 /**
  * Performance test predicate
  */
@@ -337,24 +370,9 @@ run_performance_test (xmms_medialib_t *medialib, const gchar *name, xmmsv_t *con
 
 	xmms_medialib_session_commit (session);
 
-	duration = (guint64)((t1.tv_sec - t0.tv_sec) * G_USEC_PER_SEC) + (t1.tv_usec - t0.tv_usec);
-
-	if (format == FORMAT_PRETTY)
-		g_print ("* Test %s\n", name);
+	duration = elapsed_usec (&t0, &t1);
 
-	if (xmms_error_iserror (&err)) {
-		if (format == FORMAT_CSV) {
-			g_print ("\"%s\",\"%s\",0,0\n", datasetname, name);
-		} else {
-			g_print ("   - Query failed: %s\n", xmms_error_message_get (&err));
-		}
-	} else {
-		if (format == FORMAT_CSV) {
-			g_print ("\"%s\",\"%s\",1,%" G_GUINT64_FORMAT "\n", datasetname, name, duration);
-		} else {
-			g_print ("   - Time elapsed: %.3fms\n", duration / 1000.0);
-		}
-	}
+	print_performance_result (name, datasetname, &err, duration, format);
 
 	xmmsv_unref (ret);
 }
@@ -428,6 +446,380 @@ run_performance_tests (xmmsv_t *databases, xmmsv_t *testcases, gint format)
 }
 
 
+/**
+ * Synthetic libraries for the benchmark variant.
+ *
+ * Albums of 8-16 tracks are generated for artists picked with a skewed
+ * distribution, so a few artists own most of the library like in a real
+ * collection. The generator is seeded, so the same size always yields
+ * the same library and results can be compared across commits.
+ */
+#define SYNTH_COMMIT_INTERVAL 5000
+#define SYNTH_RANDOM_PICKS 100
+
+static const gchar *synth_genres[] = {
+	"Rock", "Pop", "Electronic", "Metal", "Jazz", "Hip-Hop", "Classical",
+	"Folk", "Indie", "Punk", "Blues", "Soul", "Ambient", "Reggae",
+	"Country", "Soundtrack", "Trance", "Funk", "Latin", "World"
+};
+
+static const gint synth_bitrates[] = {
+	128000, 192000, 192000, 256000, 320000, 320000, 320000
+};
+
+static const struct {
+	const gchar *name;
+	const gchar *collection;
+	const gchar *specification;
+} synth_queries[] = {
+	{
+		"universe_ids",
+		"{ 'type': 'universe' }",
+		"{ 'type': 'cluster-list', 'cluster-by': 'position',"
+		"  'data': { 'type': 'metadata', 'get': ['id'] } }"
+	},
+	{
+		"universe_infos",
+		"{ 'type': 'universe' }",
+		"{ 'type': 'cluster-list', 'cluster-by': 'position',"
+		"  'data': { 'type': 'organize', 'data': {"
+		"    'id': { 'type': 'metadata', 'get': ['id'], 'aggregate': 'first' },"
+		"    'artist': { 'type': 'metadata', 'fields': ['artist'], 'get': ['value'], 'aggregate': 'first' },"
+		"    'album': { 'type': 'metadata', 'fields': ['album'], 'get': ['value'], 'aggregate': 'first' },"
+		"    'title': { 'type': 'metadata', 'fields': ['title'], 'get': ['value'], 'aggregate': 'first' } } } }"
+	},
+	{
+		"universe_count",
+		"{ 'type': 'universe' }",
+		"{ 'type': 'count' }"
+	},
+	{
+		"cluster_artists",
+		"{ 'type': 'universe' }",
+		"{ 'type': 'cluster-dict', 'cluster-by': 'value', 'cluster-field': 'artist',"
+		"  'data': { 'type': 'count' } }"
+	},
+	{
+		"cluster_albums",
+		"{ 'type': 'universe' }",
+		"{ 'type': 'cluster-dict', 'cluster-by': 'value', 'cluster-field': 'album',"
+		"  'data': { 'type': 'metadata', 'fields': ['artist'], 'get': ['value'], 'aggregate': 'set' } }"
+	},
+	{
+		"ordered_limit_head",
+		"{ 'type': 'limit', 'attributes': { 'start': '0', 'length': '100' },"
+		"  'operands': [{ 'type': 'order', 'attributes': { 'type': 'value', 'field': 'artist' },"
+		"  'operands': [{ 'type': 'order', 'attributes': { 'type': 'value', 'field': 'album' },"
+		"  'operands': [{ 'type': 'order', 'attributes': { 'type': 'value', 'field': 'tracknr' },"
+		"  'operands': [{ 'type': 'universe' }] }] }] }] }",
+		"{ 'type': 'cluster-list', 'cluster-by': 'position',"
+		"  'data': { 'type': 'metadata', 'get': ['id'] } }"
+	},
+	{
+		"ordered_limit_middle",
+		"{ 'type': 'limit', 'attributes': { 'start': '5000', 'length': '100' },"
+		"  'operands': [{ 'type': 'order', 'attributes': { 'type': 'value', 'field': 'artist' },"
+		"  'operands': [{ 'type': 'order', 'attributes': { 'type': 'value', 'field': 'album' },"
+		"  'operands': [{ 'type': 'order', 'attributes': { 'type': 'value', 'field': 'tracknr' },"
+		"  'operands': [{ 'type': 'universe' }] }] }] }] }",
+		"{ 'type': 'cluster-list', 'cluster-by': 'position',"
+		"  'data': { 'type': 'metadata', 'get': ['id'] } }"
+	},
+	{
+		"filtered_ordered_limit",
+		"{ 'type': 'limit', 'attributes': { 'start': '0', 'length': '50' },"
+		"  'operands': [{ 'type': 'order', 'attributes': { 'type': 'value', 'field': 'date', 'direction': 'DESC' },"
+		"  'operands': [{ 'type': 'equals', 'attributes': { 'field': 'genre', 'value': 'Rock' },"
+		"  'operands': [{ 'type': 'universe' }] }] }] }",
+		"{ 'type': 'cluster-list', 'cluster-by': 'position',"
+		"  'data': { 'type': 'metadata', 'get': ['id'] } }"
+	},
+	{
+		"match_title",
+		"{ 'type': 'match', 'attributes': { 'field': 'title', 'value': 'Title 12*' },"
+		"  'operands': [{ 'type': 'universe' }] }",
+		"{ 'type': 'count' }"
+	}
+};
+
+/**
+ * Pick an index in [0, n), low indices being much more likely.
+ */
+static gint
+synth_skewed (GRand *rand, gint n)
+{
+	return g_rand_int_range (rand, 0, g_rand_int_range (rand, 1, n + 1));
+}
+
+static GArray *
+synth_populate (xmms_medialib_t *medialib, GRand *rand, gint size)
+{
+	xmms_medialib_session_t *session;
+	gint artists, artist, album, tracknr, tracks, year, duration;
+	const gchar *genre;
+	GArray *entries;
+
+	entries = g_array_sized_new (FALSE, FALSE, sizeof (xmms_medialib_entry_t), size);
+	artists = MAX (size / 40, 10);
+
+	session = xmms_medialib_session_begin (medialib);
+
+	for (album = 0; entries->len < size; album++) {
+		artist = synth_skewed (rand, artists);
+		genre = synth_genres[synth_skewed (rand, G_N_ELEMENTS (synth_genres))];
+		year = g_rand_int_range (rand, 1960, 2013);
+		tracks = g_rand_int_range (rand, 8, 17);
+
+		for (tracknr = 1; tracknr <= tracks && entries->len < size; tracknr++) {
+			xmms_medialib_entry_t entry;
+			xmms_error_t err;
+			gchar *str;
+
+			xmms_error_reset (&err);
+
+			str = g_strdup_printf ("file:///music/%d/%d/%02d.mp3", artist, album, tracknr);
+			entry = xmms_medialib_entry_new (session, str, &err);
+			g_free (str);
+
+			g_array_append_val (entries, entry);
+
+			str = g_strdup_printf ("Artist %d", artist);
+			xmms_medialib_entry_property_set_str_source (session, entry, "artist", str, "plugin/id3v2");
+			g_free (str);
+
+			str = g_strdup_printf ("Album %d", album);
+			xmms_medialib_entry_property_set_str_source (session, entry, "album", str, "plugin/id3v2");
+			g_free (str);
+
+			str = g_strdup_printf ("Title %u", entries->len);
+			xmms_medialib_entry_property_set_str_source (session, entry, "title", str, "plugin/id3v2");
+			g_free (str);
+
+			str = g_strdup_printf ("%d", year);
+			xmms_medialib_entry_property_set_str_source (session, entry, "date", str, "plugin/id3v2");
+			g_free (str);
+
+			xmms_medialib_entry_property_set_str_source (session, entry, "genre", genre, "plugin/id3v2");
+			xmms_medialib_entry_property_set_int_source (session, entry, "tracknr", tracknr, "plugin/id3v2");
+
+			/* sum of uniforms, centered around four minutes */
+			duration = 90000 + g_rand_int_range (rand, 0, 100000)
+			         + g_rand_int_range (rand, 0, 100000)
+			         + g_rand_int_range (rand, 0, 100000);
+			xmms_medialib_entry_property_set_int_source (session, entry, "duration", duration, "plugin/mad");
+			xmms_medialib_entry_property_set_int_source (session, entry, "bitrate",
+			                                             synth_bitrates[g_rand_int_range (rand, 0, G_N_ELEMENTS (synth_bitrates))],
+			                                             "plugin/mad");
+			xmms_medialib_entry_property_set_int_source (session, entry, "samplerate",
+			                                             g_rand_int_range (rand, 0, 10) ? 44100 : 48000,
+			                                             "plugin/mad");
+			xmms_medialib_entry_property_set_int_source (session, entry, "channels", 2, "plugin/mad");
+
+			xmms_medialib_entry_property_set_int (session, entry, "timesplayed", synth_skewed (rand, 200));
+
+			if (entries->len % SYNTH_COMMIT_INTERVAL == 0) {
+				xmms_medialib_session_commit (session);
+				session = xmms_medialib_session_begin (medialib);
+			}
+		}
+	}
+
+	xmms_medialib_session_commit (session);
+
+	return entries;
+}
+
+static void
+synth_run_query (xmms_medialib_t *medialib, const gchar *name,
+                 const gchar *collection, const gchar *specification,
+                 gint format, const gchar *datasetname)
+{
+	xmmsv_t *spec;
+	xmmsv_coll_t *coll;
+
+	coll = xmmsv_coll_from_string (collection);
+	spec = xmmsv_from_xson (specification);
+
+	run_performance_test (medialib, name, NULL, coll, spec, NULL,
+	                      format, datasetname);
+
+	xmmsv_unref (spec);
+	xmmsv_coll_unref (coll);
+}
+
+static void
+synth_random_picks (xmms_medialib_t *medialib, const gchar *name,
+                    const gchar *collection, gint format,
+                    const gchar *datasetname)
+{
+	xmms_medialib_session_t *session;
+	xmmsv_coll_t *coll;
+	xmms_error_t err;
+	GTimeVal t0, t1;
+	gint i;
+
+	xmms_error_reset (&err);
+
+	coll = xmmsv_coll_from_string (collection);
+
+	g_get_current_time (&t0);
+	for (i = 0; i < SYNTH_RANDOM_PICKS; i++) {
+		session = xmms_medialib_session_begin_ro (medialib);
+		if (xmms_medialib_query_random_id (session, coll) == 0) {
+			xmms_error_set (&err, XMMS_ERROR_NOENT, "Collection is empty");
+		}
+		xmms_medialib_session_commit (session);
+	}
+	g_get_current_time (&t1);
+
+	print_performance_result (name, datasetname, &err,
+	                          elapsed_usec (&t0, &t1), format);
+
+	xmmsv_coll_unref (coll);
+}
+
+/**
+ * Update a tenth of the entries in one session, like a tag editor or
+ * a rating script would.
+ */
+static void
+synth_bulk_write (xmms_medialib_t *medialib, GArray *entries, GRand *rand,
+                  gint format, const gchar *datasetname)
+{
+	xmms_medialib_session_t *session;
+	xmms_medialib_entry_t entry;
+	xmms_error_t err;
+	GTimeVal t0, t1;
+	gint i;
+
+	xmms_error_reset (&err);
+
+	g_get_current_time (&t0);
+	session = xmms_medialib_session_begin (medialib);
+	for (i = 0; i < entries->len; i += 10) {
+		entry = g_array_index (entries, xmms_medialib_entry_t, i);
+		xmms_medialib_entry_property_set_int_source (session, entry, "rating",
+		                                             g_rand_int_range (rand, 1, 6),
+		                                             "client/bench");
+		xmms_medialib_entry_property_set_int (session, entry, "timesplayed",
+		                                      synth_skewed (rand, 200));
+	}
+	xmms_medialib_session_commit (session);
+	g_get_current_time (&t1);
+
+	print_performance_result ("bulk_write", datasetname, &err,
+	                          elapsed_usec (&t0, &t1), format);
+}
+
+/**
+ * Remove one entry out of a hundred, spread over the whole library.
+ */
+static void
+synth_remove (xmms_medialib_t *medialib, GArray *entries,
+              gint format, const gchar *datasetname)
+{
+	xmms_medialib_session_t *session;
+	xmms_medialib_entry_t entry;
+	xmms_error_t err;
+	GTimeVal t0, t1;
+	gint i;
+
+	xmms_error_reset (&err);
+
+	g_get_current_time (&t0);
+	session = xmms_medialib_session_begin (medialib);
+	for (i = 0; i < entries->len; i += 100) {
+		entry = g_array_index (entries, xmms_medialib_entry_t, i);
+		xmms_medialib_entry_remove (session, entry);
+	}
+	xmms_medialib_session_commit (session);
+	g_get_current_time (&t1);
+
+	print_performance_result ("remove", datasetname, &err,
+	                          elapsed_usec (&t0, &t1), format);
+}
+
+static void
+run_synthetic_benchmark (gint size, guint32 seed, gint format)
+{
+	xmms_medialib_t *medialib;
+	xmms_error_t err;
+	GTimeVal t0, t1;
+	GArray *entries;
+	gchar *datasetname;
+	GRand *rand;
+	gint i;
+
+	datasetname = g_strdup_printf ("synthetic-%d", size);
+	rand = g_rand_new_with_seed (seed);
+
+	if (format == FORMAT_PRETTY)
+		g_print ("Running suite with: %s\n", datasetname);
+
+	xmms_ipc_init ();
+	xmms_config_init ("memory://");
+	xmms_config_property_register ("medialib.path", "memory://", NULL, NULL);
+
+	medialib = xmms_medialib_init ();
+
+	xmms_error_reset (&err);
+
+	g_get_current_time (&t0);
+	entries = synth_populate (medialib, rand, size);
+	g_get_current_time (&t1);
+
+	print_performance_result ("populate", datasetname, &err,
+	                          elapsed_usec (&t0, &t1), format);
+
+	for (i = 0; i < G_N_ELEMENTS (synth_queries); i++) {
+		synth_run_query (medialib, synth_queries[i].name,
+		                 synth_queries[i].collection,
+		                 synth_queries[i].specification,
+		                 format, datasetname);
+	}
+
+	synth_random_picks (medialib, "random_picks_universe",
+	                    "{ 'type': 'universe' }", format, datasetname);
+	synth_random_picks (medialib, "random_picks_filtered",
+	                    "{ 'type': 'equals', 'attributes': { 'field': 'genre', 'value': 'Rock' },"
+	                    "  'operands': [{ 'type': 'universe' }] }",
+	                    format, datasetname);
+
+	synth_bulk_write (medialib, entries, rand, format, datasetname);
+	synth_remove (medialib, entries, format, datasetname);
+
+	g_array_free (entries, TRUE);
+
+	xmms_object_unref (medialib);
+	xmms_config_shutdown ();
+	xmms_ipc_shutdown ();
+
+	g_rand_free (rand);
+	g_free (datasetname);
+}
+
+
+static void
+run_synthetic_benchmarks (const gchar *sizes, guint32 seed, gint format)
+{
+	gchar **parts;
+	gint i, size;
+
+	parts = g_strsplit (sizes, ",", 0);
+
+	for (i = 0; parts[i] != NULL; i++) {
+		size = atoi (parts[i]);
+		if (size <= 0) {
+			g_print ("Invalid library size: %s\n", parts[i]);
+			exit (EXIT_FAILURE);
+		}
+		run_synthetic_benchmark (size, seed, format);
+	}
+
+	g_strfreev (parts);
+}
+
+
 static void
 parse_command_line (gint argc, gchar **argv, xmms_test_args_t *args)
 {
@@ -438,12 +830,14 @@ parse_command_line (gint argc, gchar **argv, xmms_test_args_t *args)
 
 	args->database_path = "tests/server/databases";
 	args->testcase_path = "tests/server/medialib";
+	args->sizes = "10000,100000,1000000";
+	args->seed = 4711;
 
 	const GOptionEntry options[] = {
 		{
 			"variant", 'v', 0,
 			G_OPTION_ARG_STRING, &variant,
-			"'performance' or 'unittest' (default).", "<variant>"
+			"'performance', 'benchmark' or 'unittest' (default).", "<variant>"
 		},
 		{
 			"format", 'f', 0,
@@ -460,6 +854,16 @@ parse_command_line (gint argc, gchar **argv, xmms_test_args_t *args)
 			G_OPTION_ARG_FILENAME, &args->testcase_path,
 			"Scan <path> for 1..n test cases.", "<path>"
 		},
+		{
+			"sizes", 's', 0,
+			G_OPTION_ARG_STRING, &args->sizes,
+			"Comma separated sizes of the synthetic libraries to benchmark.", "<n,...>"
+		},
+		{
+			"seed", 0, 0,
+			G_OPTION_ARG_INT, &args->seed,
+			"Seed for generating the synthetic libraries.", "<seed>"
+		},
 		{
 			"debug", 'd', 0,
 			G_OPTION_ARG_NONE, &args->debug,
@@ -482,6 +886,8 @@ parse_command_line (gint argc, gchar **argv, xmms_test_args_t *args)
 
 	if (strcmp (variant, "performance") == 0) {
 		args->variant = PERFORMANCE;
+	} else if (strcmp (variant, "benchmark") == 0) {
+		args->variant = BENCHMARK;
 	} else {
 		args->variant = UNITTEST;
 	}
@@ -501,6 +907,7 @@ parse_command_line (gint argc, gchar **argv, xmms_test_args_t *args)
  * - load a number of tests from json files
  * - by default, run tests as unit tests
  * - optionally run tests as performance tests, but then require a db directory
+ * - or benchmark common workloads against generated libraries of given sizes
  */
 gint
 main (gint argc, gchar **argv)
@@ -516,11 +923,23 @@ main (gint argc, gchar **argv)
 
 	g_log_set_default_handler (simple_log_handler, (gpointer) &args);
 
-	g_debug ("Test variant: %s", args.variant == UNITTEST ? "unit test" : "performance test");
+	g_debug ("Test variant: %s", args.variant == UNITTEST ? "unit test" :
+	         args.variant == BENCHMARK ? "benchmark" : "performance test");
 	g_debug ("Output format: %s", args.format == FORMAT_PRETTY ? "pretty" : "csv");
 	g_debug ("Database path: %s", args.database_path);
 	g_debug ("Testcase path: %s", args.testcase_path);
 
+	if (args.variant == BENCHMARK) {
+		if (args.format == FORMAT_CSV)
+			g_print ("\"dataset\",\"test\",\"success\",\"duration\"\n");
+		else
+			g_print (" - Running Benchmark -\n");
+
+		run_synthetic_benchmarks (args.sizes, args.seed, args.format);
+
+		return EXIT_SUCCESS;
+	}
+
 	testcases = scan_path (args.testcase_path, filter_testcase);
 
 	if (args.variant == PERFORMANCE) {
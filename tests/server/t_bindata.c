@@ -0,0 +1,385 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2012 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+#include "xcu.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <string.h>
+#include <unistd.h>
+
+#include "xmmspriv/xmms_bindata.h"
+#include "xmmspriv/xmms_config.h"
+#include "xmmspriv/xmms_log.h"
+#include "xmmspriv/xmms_ipc.h"
+
+#include "server-utils/ipc_call.h"
+
+/* blobs up to a quarter of this, BLOB_SIZE, are cached, so four fit */
+#define CACHE_SIZE "4096"
+#define BLOB_SIZE 1000
+
+static xmms_bindata_t *bindata;
+static gchar *bindir;
+
+SETUP (bindata)
+{
+	g_thread_init (0);
+
+	xmms_ipc_init ();
+	xmms_log_init (0);
+
+	xmms_config_init ("memory://");
+
+	bindir = g_strdup_printf ("/tmp/xmms-test-bindata-%d", getpid ());
+	xmms_config_property_register ("bindata.path", bindir, NULL, NULL);
+	xmms_config_property_register ("bindata.cache_size", CACHE_SIZE, NULL, NULL);
+
+	bindata = xmms_bindata_init ();
+
+	return 0;
+}
+
+static void
+remove_dir (const gchar *path)
+{
+	const gchar *name;
+	gchar *child;
+	GDir *dir;
+
+	dir = g_dir_open (path, 0, NULL);
+	if (!dir) {
+		return;
+	}
+
+	while ((name = g_dir_read_name (dir))) {
+		child = g_build_filename (path, name, NULL);
+		if (g_file_test (child, G_FILE_TEST_IS_DIR)) {
+			remove_dir (child);
+		} else {
+			g_unlink (child);
+		}
+		g_free (child);
+	}
+
+	g_dir_close (dir);
+	g_rmdir (path);
+}
+
+CLEANUP ()
+{
+	xmms_object_unref (bindata);
+	xmms_config_shutdown ();
+	xmms_ipc_shutdown ();
+
+	remove_dir (bindir);
+	g_free (bindir);
+
+	return 0;
+}
+
+/* Add a blob of BLOB_SIZE bytes filled with c, returns its hash */
+static gchar *
+add_blob (gchar c)
+{
+	xmmsv_t *result;
+	const gchar *hash;
+	gchar *ret;
+	guchar data[BLOB_SIZE];
+
+	memset (data, c, sizeof (data));
+
+	result = XMMS_IPC_CALL (bindata, XMMS_IPC_CMD_ADD_DATA,
+	                        xmmsv_new_bin (data, sizeof (data)));
+	CU_ASSERT_TRUE (xmmsv_get_string (result, &hash));
+	ret = g_strdup (hash);
+	xmmsv_unref (result);
+
+	return ret;
+}
+
+/* Unlink a blob behind the server's back, so only the cache has it */
+static void
+unlink_blob (const gchar *hash)
+{
+	gchar *path;
+
+	path = g_build_filename (bindir, hash, NULL);
+	CU_ASSERT_EQUAL (0, g_unlink (path));
+	g_free (path);
+}
+
+static gboolean
+retrieve (const gchar *hash, gsize expected_len)
+{
+	const guchar *data;
+	guint len;
+	xmmsv_t *result;
+	gboolean ret;
+
+	result = XMMS_IPC_CALL (bindata, XMMS_IPC_CMD_GET_DATA,
+	                        xmmsv_new_string (hash));
+	ret = xmmsv_get_bin (result, &data, &len) && len == expected_len;
+	xmmsv_unref (result);
+
+	return ret;
+}
+
+CASE (test_bindata_cache_eviction_order)
+{
+	gchar *hashes[5];
+	gint i;
+
+	for (i = 0; i < 5; i++) {
+		hashes[i] = add_blob ('a' + i);
+	}
+
+	/* fill the cache with the first four, then make the first the most
+	 * recently used so the second one is evicted for the fifth */
+	for (i = 0; i < 4; i++) {
+		CU_ASSERT_TRUE (retrieve (hashes[i], BLOB_SIZE));
+	}
+	CU_ASSERT_TRUE (retrieve (hashes[0], BLOB_SIZE));
+	CU_ASSERT_TRUE (retrieve (hashes[4], BLOB_SIZE));
+
+	for (i = 0; i < 5; i++) {
+		unlink_blob (hashes[i]);
+	}
+
+	CU_ASSERT_TRUE (retrieve (hashes[0], BLOB_SIZE));
+	CU_ASSERT_FALSE (retrieve (hashes[1], BLOB_SIZE));
+	CU_ASSERT_TRUE (retrieve (hashes[2], BLOB_SIZE));
+	CU_ASSERT_TRUE (retrieve (hashes[3], BLOB_SIZE));
+	CU_ASSERT_TRUE (retrieve (hashes[4], BLOB_SIZE));
+
+	for (i = 0; i < 5; i++) {
+		g_free (hashes[i]);
+	}
+}
+
+CASE (test_bindata_cache_size_limit)
+{
+	guchar data[BLOB_SIZE * 2];
+	const gchar *hash;
+	xmmsv_t *result;
+
+	/* larger than a quarter of the cache, never cached */
+	memset (data, 'x', sizeof (data));
+	result = XMMS_IPC_CALL (bindata, XMMS_IPC_CMD_ADD_DATA,
+	                        xmmsv_new_bin (data, sizeof (data)));
+	CU_ASSERT_TRUE (xmmsv_get_string (result, &hash));
+
+	CU_ASSERT_TRUE (retrieve (hash, sizeof (data)));
+	unlink_blob (hash);
+	CU_ASSERT_FALSE (retrieve (hash, sizeof (data)));
+
+	xmmsv_unref (result);
+}
+
+CASE (test_bindata_cache_remove)
+{
+	xmmsv_t *result;
+	gchar *hash;
+
+	hash = add_blob ('a');
+	CU_ASSERT_TRUE (retrieve (hash, BLOB_SIZE));
+
+	/* removal bumps the cache generation and drops the cached copy */
+	result = XMMS_IPC_CALL (bindata, XMMS_IPC_CMD_REMOVE_DATA,
+	                        xmmsv_new_string (hash));
+	CU_ASSERT_FALSE (xmmsv_is_error (result));
+	xmmsv_unref (result);
+
+	CU_ASSERT_FALSE (retrieve (hash, BLOB_SIZE));
+
+	/* blobs read after the removal are cached again */
+	g_free (hash);
+	hash = add_blob ('a');
+	CU_ASSERT_TRUE (retrieve (hash, BLOB_SIZE));
+	unlink_blob (hash);
+	CU_ASSERT_TRUE (retrieve (hash, BLOB_SIZE));
+
+	g_free (hash);
+}
+
+static xmmsv_t *
+retrieve_range (const gchar *hash, gint offset, gint length)
+{
+	return XMMS_IPC_CALL (bindata, XMMS_IPC_CMD_GET_DATA_RANGE,
+	                      xmmsv_new_string (hash),
+	                      xmmsv_new_int (offset),
+	                      xmmsv_new_int (length));
+}
+
+static void
+check_range_bounds (const gchar *hash)
+{
+	const guchar *data;
+	xmmsv_t *result;
+	guint len;
+
+	result = retrieve_range (hash, 10, 20);
+	CU_ASSERT_TRUE (xmmsv_get_bin (result, &data, &len));
+	CU_ASSERT_EQUAL (20, len);
+	xmmsv_unref (result);
+
+	/* clipped to the end of the blob */
+	result = retrieve_range (hash, BLOB_SIZE - 10, 20);
+	CU_ASSERT_TRUE (xmmsv_get_bin (result, &data, &len));
+	CU_ASSERT_EQUAL (10, len);
+	xmmsv_unref (result);
+
+	result = retrieve_range (hash, BLOB_SIZE, 20);
+	CU_ASSERT_TRUE (xmmsv_get_bin (result, &data, &len));
+	CU_ASSERT_EQUAL (0, len);
+	xmmsv_unref (result);
+
+	result = retrieve_range (hash, BLOB_SIZE + 1, 20);
+	CU_ASSERT_TRUE (xmmsv_is_error (result));
+	xmmsv_unref (result);
+
+	result = retrieve_range (hash, -1, 20);
+	CU_ASSERT_TRUE (xmmsv_is_error (result));
+	xmmsv_unref (result);
+}
+
+CASE (test_bindata_range_bounds)
+{
+	gchar *hash;
+
+	hash = add_blob ('a');
+
+	/* from disk, ranges do not populate the cache */
+	check_range_bounds (hash);
+	unlink_blob (hash);
+	CU_ASSERT_FALSE (retrieve (hash, BLOB_SIZE));
+	g_free (hash);
+
+	/* and the same from the cache */
+	hash = add_blob ('b');
+	CU_ASSERT_TRUE (retrieve (hash, BLOB_SIZE));
+	unlink_blob (hash);
+	check_range_bounds (hash);
+	g_free (hash);
+}
+
+/* Store a thumbnail of a blob behind the server's back */
+static void
+put_thumbnail (const gchar *hash, gint size, const gchar *contents)
+{
+	gchar *path, *name;
+
+	name = g_strdup_printf ("%s-%d", hash, size);
+	path = g_build_filename (bindir, "thumbnails", name, NULL);
+	CU_ASSERT_TRUE (g_file_set_contents (path, contents, -1, NULL));
+	g_free (path);
+	g_free (name);
+}
+
+static gboolean
+has_thumbnail (const gchar *hash, gint size)
+{
+	gchar *path, *name;
+	gboolean ret;
+
+	name = g_strdup_printf ("%s-%d", hash, size);
+	path = g_build_filename (bindir, "thumbnails", name, NULL);
+	ret = g_file_test (path, G_FILE_TEST_EXISTS);
+	g_free (path);
+	g_free (name);
+
+	return ret;
+}
+
+static gsize
+retrieve_thumbnail (const gchar *hash, gint size)
+{
+	const guchar *data;
+	xmmsv_t *result;
+	guint len = 0;
+
+	result = XMMS_IPC_CALL (bindata, XMMS_IPC_CMD_GET_DATA_THUMBNAIL,
+	                        xmmsv_new_string (hash),
+	                        xmmsv_new_int (size));
+	CU_ASSERT_TRUE (xmmsv_get_bin (result, &data, &len));
+	xmmsv_unref (result);
+
+	return len;
+}
+
+CASE (test_bindata_thumbnail_size)
+{
+	gchar *hash;
+
+	hash = add_blob ('a');
+	put_thumbnail (hash, 128, "thumb");
+
+	/* rounded up to the next stored size */
+	CU_ASSERT_EQUAL (5, retrieve_thumbnail (hash, 65));
+	CU_ASSERT_EQUAL (5, retrieve_thumbnail (hash, 128));
+
+	/* no size, or larger than the largest stored one, is the original */
+	CU_ASSERT_EQUAL (BLOB_SIZE, retrieve_thumbnail (hash, 0));
+	CU_ASSERT_EQUAL (BLOB_SIZE, retrieve_thumbnail (hash, 513));
+	CU_ASSERT_FALSE (has_thumbnail (hash, 513));
+
+	g_free (hash);
+}
+
+CASE (test_bindata_thumbnail_fallback)
+{
+	gchar *hash;
+
+	/* not an image, so never scaled */
+	hash = add_blob ('a');
+
+	CU_ASSERT_EQUAL (BLOB_SIZE, retrieve_thumbnail (hash, 64));
+
+	/* the decision is remembered as an empty thumbnail */
+	CU_ASSERT_TRUE (has_thumbnail (hash, 64));
+	CU_ASSERT_EQUAL (BLOB_SIZE, retrieve_thumbnail (hash, 64));
+
+	g_free (hash);
+}
+
+CASE (test_bindata_thumbnail_remove)
+{
+	xmmsv_t *result;
+	gchar *hash;
+
+	hash = add_blob ('a');
+	put_thumbnail (hash, 128, "thumb");
+	CU_ASSERT_EQUAL (5, retrieve_thumbnail (hash, 128));
+	CU_ASSERT_EQUAL (BLOB_SIZE, retrieve_thumbnail (hash, 256));
+
+	result = XMMS_IPC_CALL (bindata, XMMS_IPC_CMD_REMOVE_DATA,
+	                        xmmsv_new_string (hash));
+	CU_ASSERT_FALSE (xmmsv_is_error (result));
+	xmmsv_unref (result);
+
+	CU_ASSERT_FALSE (has_thumbnail (hash, 128));
+	CU_ASSERT_FALSE (has_thumbnail (hash, 256));
+
+	/* the cached thumbnail went with it */
+	result = XMMS_IPC_CALL (bindata, XMMS_IPC_CMD_GET_DATA_THUMBNAIL,
+	                        xmmsv_new_string (hash),
+	                        xmmsv_new_int (128));
+	CU_ASSERT_TRUE (xmmsv_is_error (result));
+	xmmsv_unref (result);
+
+	g_free (hash);
+}
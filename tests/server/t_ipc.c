@@ -0,0 +1,535 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2012 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+/* Client and server talking over a unix socket in the same process. */
+
+#include "xcu.h"
+
+#include "xmms_configuration.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include "xmmspriv/xmms_log.h"
+#include "xmmspriv/xmms_ipc.h"
+#include "xmms/xmms_error.h"
+#include "xmmsc/xmmsc_ipc_transport.h"
+#include "xmmsc/xmmsc_ipc_msg.h"
+#include "xmmsclient/xmmsclient.h"
+#include "xmmsclientpriv/xmmsclient.h"
+
+#include "utils/jsonism.h"
+#include "utils/value_utils.h"
+
+/* commands of the test object, after the ones of the main object */
+enum {
+	TEST_CMD_ECHO = XMMS_IPC_CMD_STATS + 1,
+	TEST_CMD_FAIL,
+};
+
+/* broadcast emitted by the test object */
+#define TEST_BROADCAST XMMS_IPC_SIGNAL_PLAYLIST_CHANGED
+
+typedef struct {
+	xmms_object_t obj;
+} test_object_t;
+
+static test_object_t *object;
+static xmmsc_connection_t *conn;
+static gchar *path;
+
+static void
+test_hello (xmms_object_t *obj, xmms_object_cmd_arg_t *arg)
+{
+	arg->retval = xmmsv_new_int (1);
+}
+
+static void
+test_echo (xmms_object_t *obj, xmms_object_cmd_arg_t *arg)
+{
+	xmmsv_t *value;
+
+	xmmsv_list_get (arg->args, 0, &value);
+	arg->retval = xmmsv_ref (value);
+}
+
+static void
+test_fail (xmms_object_t *obj, xmms_object_cmd_arg_t *arg)
+{
+	xmms_error_set (&arg->error, XMMS_ERROR_INVAL, "failed on purpose");
+}
+
+SETUP (ipc) {
+	g_thread_init (0);
+
+	xmms_log_init (0);
+	xmms_ipc_init ();
+
+	object = xmms_object_new (test_object_t, NULL);
+	xmms_object_cmd_add (XMMS_OBJECT (object), XMMS_IPC_CMD_HELLO, test_hello);
+	xmms_object_cmd_add (XMMS_OBJECT (object), TEST_CMD_ECHO, test_echo);
+	xmms_object_cmd_add (XMMS_OBJECT (object), TEST_CMD_FAIL, test_fail);
+	xmms_ipc_object_register (XMMS_IPC_OBJECT_MAIN, XMMS_OBJECT (object));
+	xmms_ipc_broadcast_register (XMMS_OBJECT (object), TEST_BROADCAST);
+
+	path = g_strdup_printf ("unix:///tmp/xmms-test-ipc-%d", (gint) getpid ());
+	if (!xmms_ipc_setup_server (path)) {
+		return 1;
+	}
+
+	conn = xmmsc_init ("test");
+	if (!xmmsc_connect (conn, path)) {
+		return 1;
+	}
+
+	return 0;
+}
+
+CLEANUP () {
+	xmmsc_unref (conn);
+
+	xmms_ipc_broadcast_unregister (TEST_BROADCAST);
+	xmms_ipc_object_unregister (XMMS_IPC_OBJECT_MAIN);
+	xmms_object_unref (object);
+	xmms_ipc_shutdown ();
+
+	g_unlink (path + strlen ("unix://"));
+	g_free (path);
+
+	xmms_log_shutdown ();
+
+	return 0;
+}
+
+/* Send everything queued, so that the replies can pile up unread. */
+static void
+flush_and_settle (void)
+{
+	while (xmmsc_io_want_out (conn)) {
+		xmmsc_io_out_handle (conn);
+	}
+	g_usleep (G_USEC_PER_SEC / 5);
+}
+
+static gint
+wait_for_other (xmmsv_t *value, void *udata)
+{
+	xmmsc_result_t *other = udata;
+
+	/* this reply was read together with the other one */
+	xmmsc_result_wait (other);
+
+	return FALSE;
+}
+
+CASE (test_wait_in_callback)
+{
+	xmmsc_result_t *first, *second;
+	gint32 i;
+
+	first = xmmsc_send_cmd (conn, XMMS_IPC_OBJECT_MAIN, TEST_CMD_ECHO,
+	                        XMMSV_LIST_ENTRY_INT (1), XMMSV_LIST_END);
+	second = xmmsc_send_cmd (conn, XMMS_IPC_OBJECT_MAIN, TEST_CMD_ECHO,
+	                         XMMSV_LIST_ENTRY_INT (2), XMMSV_LIST_END);
+	xmmsc_result_notifier_set (first, wait_for_other, second);
+
+	flush_and_settle ();
+
+	xmmsc_result_wait (first);
+
+	CU_ASSERT_TRUE (xmmsv_get_int (xmmsc_result_get_value (first), &i));
+	CU_ASSERT_EQUAL (1, i);
+	CU_ASSERT_TRUE (xmmsv_get_int (xmmsc_result_get_value (second), &i));
+	CU_ASSERT_EQUAL (2, i);
+
+	xmmsc_result_unref (first);
+	xmmsc_result_unref (second);
+}
+
+static GString *reply_order;
+
+static gint
+record_reply (xmmsv_t *value, void *udata)
+{
+	g_string_append_c (reply_order, GPOINTER_TO_INT (udata));
+
+	return FALSE;
+}
+
+CASE (test_batch)
+{
+	xmmsc_result_t *before, *batch, *bad_batch, *after;
+	xmmsv_t *commands, *value, *entry;
+	const gchar *err, *s;
+	gint32 i;
+
+	commands = xmmsv_build_list (
+		XMMSV_LIST_ENTRY (xmmsv_build_list (
+			XMMSV_LIST_ENTRY_INT (XMMS_IPC_OBJECT_MAIN),
+			XMMSV_LIST_ENTRY_INT (TEST_CMD_ECHO),
+			XMMSV_LIST_ENTRY (xmmsv_build_list (XMMSV_LIST_ENTRY_INT (10),
+			                                    XMMSV_LIST_END)),
+			XMMSV_LIST_END)),
+		XMMSV_LIST_ENTRY (xmmsv_build_list (
+			XMMSV_LIST_ENTRY_INT (XMMS_IPC_OBJECT_MAIN),
+			XMMSV_LIST_ENTRY_INT (TEST_CMD_FAIL),
+			XMMSV_LIST_ENTRY (xmmsv_new_list ()),
+			XMMSV_LIST_END)),
+		XMMSV_LIST_ENTRY (xmmsv_build_list (
+			XMMSV_LIST_ENTRY_INT (XMMS_IPC_OBJECT_MAIN),
+			XMMSV_LIST_ENTRY_INT (TEST_CMD_ECHO),
+			XMMSV_LIST_ENTRY (xmmsv_build_list (XMMSV_LIST_ENTRY_STR ("eleven"),
+			                                    XMMSV_LIST_END)),
+			XMMSV_LIST_END)),
+		XMMSV_LIST_ENTRY (xmmsv_build_list (
+			XMMSV_LIST_ENTRY_INT (XMMS_IPC_OBJECT_PLAYLIST),
+			XMMSV_LIST_ENTRY_INT (TEST_CMD_ECHO),
+			XMMSV_LIST_ENTRY (xmmsv_new_list ()),
+			XMMSV_LIST_END)),
+		XMMSV_LIST_ENTRY (xmmsv_build_list (
+			XMMSV_LIST_ENTRY_INT (XMMS_IPC_OBJECT_SIGNAL),
+			XMMSV_LIST_ENTRY_INT (XMMS_IPC_CMD_BROADCAST),
+			XMMSV_LIST_ENTRY (xmmsv_build_list (XMMSV_LIST_ENTRY_INT (XMMS_IPC_SIGNAL_QUIT),
+			                                    XMMSV_LIST_END)),
+			XMMSV_LIST_END)),
+		XMMSV_LIST_ENTRY_STR ("not a command"),
+		XMMSV_LIST_END);
+
+	reply_order = g_string_new (NULL);
+
+	before = xmmsc_send_cmd (conn, XMMS_IPC_OBJECT_MAIN, TEST_CMD_ECHO,
+	                         XMMSV_LIST_ENTRY_INT (1), XMMSV_LIST_END);
+	batch = xmmsc_batch (conn, commands);
+	bad_batch = xmmsc_send_cmd (conn, XMMS_IPC_OBJECT_SIGNAL, XMMS_IPC_CMD_BATCH,
+	                            XMMSV_LIST_ENTRY_INT (1), XMMSV_LIST_END);
+	after = xmmsc_send_cmd (conn, XMMS_IPC_OBJECT_MAIN, TEST_CMD_ECHO,
+	                        XMMSV_LIST_ENTRY_INT (2), XMMSV_LIST_END);
+	xmmsv_unref (commands);
+
+	xmmsc_result_notifier_set (before, record_reply, GINT_TO_POINTER ('a'));
+	xmmsc_result_notifier_set (batch, record_reply, GINT_TO_POINTER ('b'));
+	xmmsc_result_notifier_set (bad_batch, record_reply, GINT_TO_POINTER ('c'));
+	xmmsc_result_notifier_set (after, record_reply, GINT_TO_POINTER ('d'));
+
+	/* every command has a cookie of its own, in the order sent */
+	CU_ASSERT_TRUE (xmmsc_result_cookie_get (before) < xmmsc_result_cookie_get (batch));
+	CU_ASSERT_TRUE (xmmsc_result_cookie_get (batch) < xmmsc_result_cookie_get (bad_batch));
+	CU_ASSERT_TRUE (xmmsc_result_cookie_get (bad_batch) < xmmsc_result_cookie_get (after));
+
+	xmmsc_result_wait (after);
+
+	/* replies are matched by cookie, so each result got its own reply */
+	CU_ASSERT_STRING_EQUAL ("abcd", reply_order->str);
+
+	CU_ASSERT_TRUE (xmmsv_get_int (xmmsc_result_get_value (before), &i));
+	CU_ASSERT_EQUAL (1, i);
+	CU_ASSERT_TRUE (xmmsv_get_int (xmmsc_result_get_value (after), &i));
+	CU_ASSERT_EQUAL (2, i);
+
+	CU_ASSERT_TRUE (xmmsv_is_error (xmmsc_result_get_value (bad_batch)));
+
+	value = xmmsc_result_get_value (batch);
+	CU_ASSERT_TRUE_FATAL (xmmsv_is_type (value, XMMSV_TYPE_LIST));
+	CU_ASSERT_EQUAL_FATAL (6, xmmsv_list_get_size (value));
+
+	CU_ASSERT_TRUE (xmmsv_list_get_int (value, 0, &i));
+	CU_ASSERT_EQUAL (10, i);
+
+	CU_ASSERT_TRUE (xmmsv_list_get (value, 1, &entry));
+	CU_ASSERT_TRUE (xmmsv_get_error (entry, &err));
+	CU_ASSERT_STRING_EQUAL ("failed on purpose", err);
+
+	CU_ASSERT_TRUE (xmmsv_list_get_string (value, 2, &s));
+	CU_ASSERT_STRING_EQUAL ("eleven", s);
+
+	/* no object, signal registration and a malformed entry all fail
+	 * without stopping the batch */
+	for (i = 3; i < 6; i++) {
+		CU_ASSERT_TRUE (xmmsv_list_get (value, i, &entry));
+		CU_ASSERT_TRUE (xmmsv_is_error (entry));
+	}
+
+	xmmsc_result_unref (before);
+	xmmsc_result_unref (batch);
+	xmmsc_result_unref (bad_batch);
+	xmmsc_result_unref (after);
+
+	g_string_free (reply_order, TRUE);
+}
+
+static gchar *
+large_payload (gsize size)
+{
+	gchar *payload;
+	gsize i;
+
+	payload = g_malloc (size + 1);
+	for (i = 0; i < size; i++) {
+		payload[i] = 'a' + i % 26;
+	}
+	payload[size] = '\0';
+
+	return payload;
+}
+
+CASE (test_fd_payload)
+{
+#ifdef HAVE_MEMFD_CREATE
+	xmms_ipc_transport_t *server, *client, *peer;
+	xmms_ipc_msg_t *msg;
+	xmmsc_result_t *res;
+	xmmsv_t *value;
+	gchar *fdpath, *payload, head[256];
+	const gchar *s;
+	bool disconnected = false;
+	gint i;
+
+	payload = large_payload (256 * 1024);
+
+	fdpath = g_strdup_printf ("unix:///tmp/xmms-test-ipc-fd-%d", (gint) getpid ());
+	server = xmms_ipc_server_init (fdpath);
+	CU_ASSERT_PTR_NOT_NULL_FATAL (server);
+	client = xmms_ipc_client_init (fdpath);
+	CU_ASSERT_PTR_NOT_NULL_FATAL (client);
+	peer = xmms_ipc_server_accept (server);
+	CU_ASSERT_PTR_NOT_NULL_FATAL (peer);
+
+	CU_ASSERT_TRUE (xmms_ipc_transport_fd_passing (client));
+	peer->send_fds = 1;
+
+	msg = xmms_ipc_msg_new (XMMS_IPC_OBJECT_MAIN, TEST_CMD_ECHO);
+	value = xmmsv_new_string (payload);
+	xmms_ipc_msg_put_value (msg, value);
+	xmmsv_unref (value);
+	xmms_ipc_msg_set_cookie (msg, 42);
+
+	CU_ASSERT_EQUAL (1, xmms_ipc_msg_write_transport_batch (&msg, 1, peer,
+	                                                        &disconnected));
+	xmms_ipc_msg_destroy (msg);
+
+	/* only the header went through the socket */
+	CU_ASSERT_EQUAL (XMMS_IPC_MSG_HEAD_LEN,
+	                 recv (xmms_ipc_transport_fd_get (client), head,
+	                       sizeof (head), MSG_PEEK | MSG_DONTWAIT));
+
+	msg = xmms_ipc_msg_alloc ();
+	for (i = 0; i < 100; i++) {
+		if (xmms_ipc_msg_read_transport (msg, client, &disconnected)) {
+			break;
+		}
+		CU_ASSERT_FALSE_FATAL (disconnected);
+		g_usleep (G_USEC_PER_SEC / 100);
+	}
+	CU_ASSERT_TRUE_FATAL (i < 100);
+
+	CU_ASSERT_EQUAL (42, xmms_ipc_msg_get_cookie (msg));
+	CU_ASSERT_EQUAL (TEST_CMD_ECHO, xmms_ipc_msg_get_cmd (msg));
+	CU_ASSERT_TRUE_FATAL (xmms_ipc_msg_get_value (msg, &value));
+	CU_ASSERT_TRUE (xmmsv_get_string (value, &s));
+	CU_ASSERT_STRING_EQUAL (payload, s);
+	xmmsv_unref (value);
+	xmms_ipc_msg_destroy (msg);
+
+	xmms_ipc_transport_destroy (peer);
+	xmms_ipc_transport_destroy (client);
+	xmms_ipc_transport_destroy (server);
+	g_unlink (fdpath + strlen ("unix://"));
+	g_free (fdpath);
+
+	/* and the same through the daemon, which the client asked for it */
+	res = xmmsc_send_cmd (conn, XMMS_IPC_OBJECT_MAIN, TEST_CMD_ECHO,
+	                      XMMSV_LIST_ENTRY_STR (payload), XMMSV_LIST_END);
+	xmmsc_result_wait (res);
+	CU_ASSERT_TRUE (xmmsv_get_string (xmmsc_result_get_value (res), &s));
+	CU_ASSERT_STRING_EQUAL (payload, s);
+	xmmsc_result_unref (res);
+
+	g_free (payload);
+#endif
+}
+
+/* Wait for a round trip, so everything sent before has been handled and
+ * everything the server sent before has been read. */
+static void
+sync_with_server (void)
+{
+	xmmsc_result_t *res;
+
+	res = xmmsc_send_cmd (conn, XMMS_IPC_OBJECT_MAIN, TEST_CMD_ECHO,
+	                      XMMSV_LIST_ENTRY_INT (0), XMMSV_LIST_END);
+	xmmsc_result_wait (res);
+	xmmsc_result_unref (res);
+}
+
+static gint
+record_broadcast (xmmsv_t *value, void *udata)
+{
+	xmmsv_list_append ((xmmsv_t *) udata, value);
+
+	return TRUE;
+}
+
+/* Subscribe to the test broadcast with a filter given as xson, and
+ * collect everything that arrives in received. */
+static xmmsc_result_t *
+subscribe (const gchar *filter, xmmsv_t *received)
+{
+	xmmsc_result_t *res;
+
+	res = xmmsc_send_broadcast_filtered_msg (conn, TEST_BROADCAST,
+	                                         xmmsv_from_xson (filter));
+	xmmsc_result_notifier_set (res, record_broadcast, received);
+	sync_with_server ();
+
+	return res;
+}
+
+/* Emit each item of a list given as xson as one broadcast */
+static void
+emit_all (const gchar *values)
+{
+	xmmsv_t *list, *value;
+	gint i;
+
+	list = xmmsv_from_xson (values);
+	for (i = 0; xmmsv_list_get (list, i, &value); i++) {
+		xmms_object_emit (XMMS_OBJECT (object), TEST_BROADCAST,
+		                  xmmsv_ref (value));
+	}
+	xmmsv_unref (list);
+
+	sync_with_server ();
+}
+
+static void
+check_filter (const gchar *filter, const gchar *emitted,
+              const gchar *expected)
+{
+	xmmsc_result_t *res;
+	xmmsv_t *received, *expected_list;
+
+	received = xmmsv_new_list ();
+
+	res = subscribe (filter, received);
+	emit_all (emitted);
+
+	expected_list = xmmsv_from_xson (expected);
+	CU_ASSERT_TRUE (xmmsv_compare (expected_list, received));
+	xmmsv_unref (expected_list);
+
+	xmmsc_result_disconnect (res);
+	xmmsc_result_unref (res);
+	xmmsv_unref (received);
+}
+
+CASE (test_broadcast_filter_dict)
+{
+	check_filter ("{ 'name': 'Default' }",
+	              "[{ 'name': 'Default', 'type': 1 },"
+	              " { 'name': 'Other', 'type': 1 },"
+	              " { 'type': 1 }]",
+	              "[{ 'name': 'Default', 'type': 1 }]");
+
+	check_filter ("{ 'type': [0, 2] }",
+	              "[{ 'type': 0 }, { 'type': 1 }, { 'type': 2 }]",
+	              "[{ 'type': 0 }, { 'type': 2 }]");
+}
+
+CASE (test_broadcast_filter_value)
+{
+	/* broadcasts that are not dicts match against "value" */
+	check_filter ("{ 'value': [1, 3] }",
+	              "[1, 2, 3, 'one']",
+	              "[1, 3]");
+
+	check_filter ("{ 'value': 'one' }",
+	              "[1, 'one', 'two']",
+	              "['one']");
+
+	/* and against no other key */
+	check_filter ("{ 'id': 1 }", "[1]", "[]");
+}
+
+CASE (test_broadcast_filter_list_any)
+{
+	/* list payloads match if any of their items does */
+	check_filter ("{ 'ids': 5 }",
+	              "[{ 'ids': [1, 5] }, { 'ids': [2, 3] }, { 'ids': [] }]",
+	              "[{ 'ids': [1, 5] }]");
+
+	check_filter ("{ 'value': ['a', 'b'] }",
+	              "[['c', 'b'], ['c', 'd']]",
+	              "[['c', 'b']]");
+}
+
+CASE (test_broadcast_filter_and)
+{
+	/* every key of the filter has to match */
+	check_filter ("{ 'name': 'Default', 'type': [0, 2] }",
+	              "[{ 'name': 'Default', 'type': 0 },"
+	              " { 'name': 'Default', 'type': 1 },"
+	              " { 'name': 'Other', 'type': 0 },"
+	              " { 'name': 'Default' }]",
+	              "[{ 'name': 'Default', 'type': 0 }]");
+}
+
+CASE (test_broadcast_filter_empty)
+{
+	check_filter ("{}",
+	              "[1, 'one', { 'name': 'Default' }]",
+	              "[1, 'one', { 'name': 'Default' }]");
+}
+
+CASE (test_broadcast_filter_invalid)
+{
+	xmmsc_result_t *res;
+	xmmsv_t *received, *value;
+	const gchar *err;
+
+	received = xmmsv_new_list ();
+
+	/* a filter value that is neither int, string nor list of them */
+	res = subscribe ("{ 'name': { 'nested': 1 } }", received);
+
+	/* the error is sent on the subscription's cookie */
+	CU_ASSERT_EQUAL_FATAL (1, xmmsv_list_get_size (received));
+	CU_ASSERT_TRUE (xmmsv_list_get (received, 0, &value));
+	CU_ASSERT_TRUE (xmmsv_get_error (value, &err));
+	CU_ASSERT_STRING_EQUAL ("Invalid broadcast filter", err);
+
+	/* and nothing after it */
+	emit_all ("[{ 'name': 'Default' }]");
+	CU_ASSERT_EQUAL (1, xmmsv_list_get_size (received));
+
+	xmmsc_result_disconnect (res);
+	xmmsc_result_unref (res);
+	xmmsv_unref (received);
+
+	/* a filter that is not a dict */
+	received = xmmsv_new_list ();
+	res = subscribe ("['Default']", received);
+	CU_ASSERT_EQUAL (1, xmmsv_list_get_size (received));
+	CU_ASSERT_TRUE (xmmsv_list_get (received, 0, &value));
+	CU_ASSERT_TRUE (xmmsv_is_error (value));
+
+	xmmsc_result_disconnect (res);
+	xmmsc_result_unref (res);
+	xmmsv_unref (received);
+}
@@ -4,6 +4,7 @@
 #include "xmmspriv/xmms_ipc.h"
 #include "xmmspriv/xmms_config.h"
 #include "xmmspriv/xmms_medialib.h"
+#include "xmmspriv/xmmsv.h"
 
 #include "utils/jsonism.h"
 #include "utils/value_utils.h"
@@ -630,6 +631,42 @@ CASE(test_client_get_id)
 	xmmsv_unref (result);
 }
 
+CASE (test_entry_new_encoded_many)
+{
+	const gchar *urls[] = {
+		"file:///new+one",
+		"Red+FangRed+FangPrehistoric+Dog",
+		"file:///new+two",
+		"file:///new+one"
+	};
+	xmms_medialib_entry_t entries[G_N_ELEMENTS (urls)];
+	xmms_medialib_session_t *session;
+	xmms_medialib_entry_t existing;
+	xmms_error_t err;
+
+	existing = xmms_mock_entry (medialib, 1, "Red Fang", "Red Fang", "Prehistoric Dog");
+
+	xmms_error_reset (&err);
+
+	session = xmms_medialib_session_begin (medialib);
+	xmms_medialib_entry_new_encoded_many (session, urls, G_N_ELEMENTS (urls),
+	                                      entries, &err);
+	CU_ASSERT (xmms_medialib_session_commit (session));
+
+	/* existing entries are reused, duplicates resolve to the same entry */
+	CU_ASSERT_EQUAL (existing, entries[1]);
+	CU_ASSERT_EQUAL (entries[0], entries[3]);
+	CU_ASSERT_NOT_EQUAL (0, entries[0]);
+	CU_ASSERT_NOT_EQUAL (0, entries[2]);
+	CU_ASSERT_NOT_EQUAL (entries[0], entries[2]);
+	CU_ASSERT_NOT_EQUAL (existing, entries[0]);
+	CU_ASSERT_NOT_EQUAL (existing, entries[2]);
+
+	session = xmms_medialib_session_begin (medialib);
+	CU_ASSERT_EQUAL (entries[2], xmms_medialib_entry_new_encoded (session, urls[2], &err));
+	xmms_medialib_session_commit (session);
+}
+
 CASE(test_client_property_set)
 {
 	xmms_medialib_entry_t entry;
@@ -816,6 +853,124 @@ CASE(test_client_move_entry)
 	g_free (string);
 }
 
+static void
+count_url (const gchar *url, xmms_medialib_entry_t entry, gpointer udata)
+{
+	gint *count = udata;
+	(*count)++;
+}
+
+CASE (test_url_index)
+{
+	xmms_medialib_url_index_t *index;
+	xmms_medialib_session_t *session;
+	xmms_medialib_entry_t first, second;
+	xmmsv_t *result;
+	gchar *url;
+	gint count;
+
+	index = xmms_medialib_get_url_index (medialib);
+
+	first = xmms_mock_entry (medialib, 1, "Red Fang", "Red Fang", "Prehistoric Dog");
+	second = xmms_mock_entry (medialib, 2, "Red Fang", "Red Fang", "Reverse Thunder");
+
+	CU_ASSERT_EQUAL (first, xmms_medialib_url_index_lookup (index, "Red+FangRed+FangPrehistoric+Dog"));
+	CU_ASSERT_EQUAL (second, xmms_medialib_url_index_lookup (index, "Red+FangRed+FangReverse+Thunder"));
+
+	result = XMMS_IPC_CALL (medialib, XMMS_IPC_CMD_MOVE_URL,
+	                        xmmsv_new_int (first),
+	                        xmmsv_new_string ("file:///music/a/1.mp3"));
+	xmmsv_unref (result);
+	result = XMMS_IPC_CALL (medialib, XMMS_IPC_CMD_MOVE_URL,
+	                        xmmsv_new_int (second),
+	                        xmmsv_new_string ("file:///music/a/2.mp3"));
+	xmmsv_unref (result);
+
+	CU_ASSERT_EQUAL (0, xmms_medialib_url_index_lookup (index, "Red+FangRed+FangPrehistoric+Dog"));
+
+	session = xmms_medialib_session_begin (medialib);
+	url = xmms_medialib_entry_property_get_str (session, first, "url");
+	xmms_medialib_session_abort (session);
+	CU_ASSERT_EQUAL (first, xmms_medialib_url_index_lookup (index, url));
+	g_free (url);
+
+	count = 0;
+	xmms_medialib_url_index_foreach_prefix (index, "file:///music/a/", count_url, &count);
+	CU_ASSERT_EQUAL (2, count);
+
+	count = 0;
+	xmms_medialib_url_index_foreach_prefix (index, "file:///music/a/2", count_url, &count);
+	CU_ASSERT_EQUAL (1, count);
+
+	count = 0;
+	xmms_medialib_url_index_foreach_prefix (index, "file:///music/b/", count_url, &count);
+	CU_ASSERT_EQUAL (0, count);
+
+	result = XMMS_IPC_CALL (medialib, XMMS_IPC_CMD_REMOVE_ID, xmmsv_new_int (second));
+	xmmsv_unref (result);
+
+	count = 0;
+	xmms_medialib_url_index_foreach_prefix (index, "file:///music/", count_url, &count);
+	CU_ASSERT_EQUAL (1, count);
+}
+
+CASE (test_client_prefix)
+{
+	xmms_medialib_url_index_t *index;
+	xmms_medialib_entry_t first, second, third;
+	xmmsv_t *result;
+	gint count;
+
+	index = xmms_medialib_get_url_index (medialib);
+
+	first = xmms_mock_entry (medialib, 1, "Red Fang", "Red Fang", "Prehistoric Dog");
+	second = xmms_mock_entry (medialib, 2, "Red Fang", "Red Fang", "Reverse Thunder");
+	third = xmms_mock_entry (medialib, 3, "Red Fang", "Red Fang", "Humans Remain Human Remains");
+
+	result = XMMS_IPC_CALL (medialib, XMMS_IPC_CMD_MOVE_URL, xmmsv_new_int (first),
+	                        xmmsv_new_string ("file:///music/a/1.mp3"));
+	xmmsv_unref (result);
+	result = XMMS_IPC_CALL (medialib, XMMS_IPC_CMD_MOVE_URL, xmmsv_new_int (second),
+	                        xmmsv_new_string ("file:///music/a/2.mp3"));
+	xmmsv_unref (result);
+	result = XMMS_IPC_CALL (medialib, XMMS_IPC_CMD_MOVE_URL, xmmsv_new_int (third),
+	                        xmmsv_new_string ("file:///music/b/3.mp3"));
+	xmmsv_unref (result);
+
+	/* an empty prefix would match everything */
+	result = XMMS_IPC_CALL (medialib, XMMS_IPC_CMD_REMOVE_PREFIX,
+	                        xmmsv_new_string (""));
+	CU_ASSERT (xmmsv_is_error (result));
+	xmmsv_unref (result);
+
+	result = XMMS_IPC_CALL (medialib, XMMS_IPC_CMD_REHASH_PREFIX,
+	                        xmmsv_new_string ("file:///music/a/"));
+	CU_ASSERT (xmmsv_get_int (result, &count));
+	CU_ASSERT_EQUAL (2, count);
+	xmmsv_unref (result);
+
+	result = XMMS_IPC_CALL (medialib, XMMS_IPC_CMD_MOVE_PREFIX,
+	                        xmmsv_new_string ("file:///music/a/"),
+	                        xmmsv_new_string ("file:///music/c/"));
+	CU_ASSERT (xmmsv_get_int (result, &count));
+	CU_ASSERT_EQUAL (2, count);
+	xmmsv_unref (result);
+
+	CU_ASSERT_EQUAL (first, xmms_medialib_url_index_lookup (index, "file:///music/c/1.mp3"));
+	CU_ASSERT_EQUAL (0, xmms_medialib_url_index_lookup (index, "file:///music/a/1.mp3"));
+
+	result = XMMS_IPC_CALL (medialib, XMMS_IPC_CMD_REMOVE_PREFIX,
+	                        xmmsv_new_string ("file:///music/c/"));
+	CU_ASSERT (xmmsv_get_int (result, &count));
+	CU_ASSERT_EQUAL (2, count);
+	xmmsv_unref (result);
+
+	count = 0;
+	xmms_medialib_url_index_foreach_prefix (index, "file:///music/", count_url, &count);
+	CU_ASSERT_EQUAL (1, count);
+	CU_ASSERT_EQUAL (third, xmms_medialib_url_index_lookup (index, "file:///music/b/3.mp3"));
+}
+
 CASE (test_session_locking)
 {
 	xmms_medialib_session_t *session, *inner_session;
@@ -849,3 +1004,89 @@ CASE (test_session_locking)
 
 	CU_ASSERT_NOT_EQUAL (status, new_status);
 }
+
+CASE (test_properties_interned)
+{
+	/* keep in sync with xmms/xmms_medialib.h */
+	static const gchar *properties[] = {
+		XMMS_MEDIALIB_ENTRY_PROPERTY_MIME,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_ID,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_URL,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_ARTIST,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_ARTIST_SORT,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_ORIGINAL_ARTIST,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_ALBUM,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_ALBUM_SORT,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_ALBUM_ARTIST,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_ALBUM_ARTIST_SORT,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_TITLE,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_TITLE_SORT,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_YEAR,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_ORIGINALYEAR,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_TRACKNR,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_TOTALTRACKS,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_GENRE,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_BITRATE,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_COMMENT,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_COMMENT_LANG,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_DURATION,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_CHANNEL,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_CHANNELS,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_SAMPLE_FMT,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_SAMPLERATE,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_LMOD,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_GAIN_TRACK,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_GAIN_ALBUM,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_PEAK_TRACK,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_PEAK_ALBUM,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_COMPILATION,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_ALBUM_ID,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_ARTIST_ID,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_TRACK_ID,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_ADDED,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_BPM,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_LASTSTARTED,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_SIZE,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_IS_VBR,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_SUBTUNES,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_CHAIN,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_TIMESPLAYED,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_PARTOFSET,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_TOTALSET,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_PICTURE_FRONT,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_PICTURE_FRONT_MIME,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_STARTMS,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_STOPMS,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_STATUS,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_DESCRIPTION,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_GROUPING,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_PERFORMER,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_CONDUCTOR,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_REMIXER,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_DJMIXER,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_MIXER,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_ARRANGER,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_PRODUCER,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_PUBLISHER,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_COMPOSER,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_LYRICIST,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_ASIN,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_ISRC,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_BARCODE,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_CATALOGNUMBER,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_COPYRIGHT,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_WEBSITE_ARTIST,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_WEBSITE_FILE,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_WEBSITE_PUBLISHER,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_WEBSITE_COPYRIGHT,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_RELEASE_STATUS,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_RELEASE_TYPE,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_RELEASE_COUNTRY,
+		XMMS_MEDIALIB_ENTRY_PROPERTY_RELEASE_FORMAT,
+	};
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (properties); i++) {
+		CU_ASSERT_PTR_NOT_NULL (_xmmsv_intern (properties[i]));
+	}
+}
@@ -0,0 +1,97 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2012 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+#include "xcu.h"
+
+#include <glib.h>
+
+#include "xmms/xmms_object.h"
+
+typedef struct {
+	xmms_object_t obj;
+} test_object_t;
+
+typedef struct {
+	xmms_object_t *object;
+	GString *calls;
+} test_emit_t;
+
+SETUP (object) {
+	g_thread_init (0);
+	return 0;
+}
+
+CLEANUP () {
+	return 0;
+}
+
+static void
+on_signal_a (xmms_object_t *object, xmmsv_t *data, gpointer udata)
+{
+	test_emit_t *emit = udata;
+
+	g_string_append_c (emit->calls, 'a');
+}
+
+static void
+on_signal_b (xmms_object_t *object, xmmsv_t *data, gpointer udata)
+{
+	test_emit_t *emit = udata;
+
+	g_string_append_c (emit->calls, 'b');
+
+	/* the current emit must still reach c */
+	xmms_object_disconnect (emit->object, XMMS_IPC_SIGNAL_QUIT,
+	                        on_signal_b, udata);
+}
+
+static void
+on_signal_c (xmms_object_t *object, xmmsv_t *data, gpointer udata)
+{
+	test_emit_t *emit = udata;
+
+	g_string_append_c (emit->calls, 'c');
+}
+
+CASE (test_emit_order)
+{
+	test_emit_t emit;
+
+	emit.object = XMMS_OBJECT (xmms_object_new (test_object_t, NULL));
+	emit.calls = g_string_new (NULL);
+
+	/* nothing connected */
+	xmms_object_emit (emit.object, XMMS_IPC_SIGNAL_QUIT, xmmsv_new_int (0));
+
+	xmms_object_connect (emit.object, XMMS_IPC_SIGNAL_QUIT, on_signal_a, &emit);
+	xmms_object_connect (emit.object, XMMS_IPC_SIGNAL_QUIT, on_signal_b, &emit);
+	xmms_object_connect (emit.object, XMMS_IPC_SIGNAL_QUIT, on_signal_c, &emit);
+
+	xmms_object_emit (emit.object, XMMS_IPC_SIGNAL_QUIT, xmmsv_new_int (0));
+	CU_ASSERT_STRING_EQUAL ("abc", emit.calls->str);
+
+	xmms_object_emit (emit.object, XMMS_IPC_SIGNAL_QUIT, xmmsv_new_int (0));
+	CU_ASSERT_STRING_EQUAL ("abcac", emit.calls->str);
+
+	xmms_object_disconnect (emit.object, XMMS_IPC_SIGNAL_QUIT, on_signal_a, &emit);
+	xmms_object_disconnect (emit.object, XMMS_IPC_SIGNAL_QUIT, on_signal_c, &emit);
+
+	xmms_object_emit (emit.object, XMMS_IPC_SIGNAL_QUIT, xmmsv_new_int (0));
+	CU_ASSERT_STRING_EQUAL ("abcac", emit.calls->str);
+
+	g_string_free (emit.calls, TRUE);
+	xmms_object_unref (emit.object);
+}
@@ -0,0 +1,118 @@
+/*  XMMS2 - X Music Multiplexer System
+ *  Copyright (C) 2003-2012 XMMS2 Team
+ *
+ *  PLUGINS ARE NOT CONSIDERED TO BE DERIVED WORK !!!
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ */
+
+#include "xcu.h"
+
+#include <glib.h>
+#include <string.h>
+
+#include "xmmspriv/xmms_sample.h"
+
+SETUP (sample_gain) {
+	return 0;
+}
+
+CLEANUP () {
+	return 0;
+}
+
+CASE (test_gain_s16_clip)
+{
+	xmms_samples16_t samples[] = { 0, 100, -100, 20000, -20000, 32767, -32768,
+	                               1, -1, 16384, -16384, 3, -3, 7, -7, 9, -9 };
+	gint n = G_N_ELEMENTS (samples);
+
+	xmms_sample_gain_apply (XMMS_SAMPLE_FORMAT_S16, samples, n, 2.0);
+
+	CU_ASSERT_EQUAL (0, samples[0]);
+	CU_ASSERT_EQUAL (200, samples[1]);
+	CU_ASSERT_EQUAL (-200, samples[2]);
+	CU_ASSERT_EQUAL (XMMS_SAMPLES16_MAX, samples[3]);
+	CU_ASSERT_EQUAL (XMMS_SAMPLES16_MIN, samples[4]);
+	CU_ASSERT_EQUAL (XMMS_SAMPLES16_MAX, samples[5]);
+	CU_ASSERT_EQUAL (XMMS_SAMPLES16_MIN, samples[6]);
+	CU_ASSERT_EQUAL (XMMS_SAMPLES16_MAX, samples[9]);
+	CU_ASSERT_EQUAL (-18, samples[16]);
+}
+
+CASE (test_gain_s32_clip)
+{
+	xmms_samples32_t samples[] = { 0, 1 << 30, -(1 << 30), 12345, -12345 };
+	gint n = G_N_ELEMENTS (samples);
+
+	xmms_sample_gain_apply (XMMS_SAMPLE_FORMAT_S32, samples, n, 4.0);
+
+	CU_ASSERT_EQUAL (0, samples[0]);
+	CU_ASSERT_EQUAL (XMMS_SAMPLES32_MAX, samples[1]);
+	CU_ASSERT_EQUAL (XMMS_SAMPLES32_MIN, samples[2]);
+	CU_ASSERT_EQUAL (49380, samples[3]);
+	CU_ASSERT_EQUAL (-49380, samples[4]);
+}
+
+CASE (test_gain_float_noclip)
+{
+	xmms_samplefloat_t samples[] = { 0.5, -0.5, 0.25, 1.0, -1.0 };
+	gint n = G_N_ELEMENTS (samples);
+
+	xmms_sample_gain_apply (XMMS_SAMPLE_FORMAT_FLOAT, samples, n, 3.0);
+
+	CU_ASSERT_DOUBLE_EQUAL (1.5, samples[0], 0.0001);
+	CU_ASSERT_DOUBLE_EQUAL (-1.5, samples[1], 0.0001);
+	CU_ASSERT_DOUBLE_EQUAL (0.75, samples[2], 0.0001);
+	CU_ASSERT_DOUBLE_EQUAL (3.0, samples[3], 0.0001);
+	CU_ASSERT_DOUBLE_EQUAL (-3.0, samples[4], 0.0001);
+}
+
+CASE (test_gain_matches_scalar)
+{
+	const xmms_sample_format_t formats[] = {
+		XMMS_SAMPLE_FORMAT_S8, XMMS_SAMPLE_FORMAT_U8,
+		XMMS_SAMPLE_FORMAT_S16, XMMS_SAMPLE_FORMAT_U16,
+		XMMS_SAMPLE_FORMAT_S32, XMMS_SAMPLE_FORMAT_U32,
+		XMMS_SAMPLE_FORMAT_FLOAT, XMMS_SAMPLE_FORMAT_DOUBLE
+	};
+	const gfloat gains[] = { 0.0, 0.3, 1.0, 1.7, 8.0 };
+	guint8 a[67 * sizeof (gdouble)], b[67 * sizeof (gdouble)];
+	gint f, g, len, i;
+
+	for (f = 0; f < G_N_ELEMENTS (formats); f++) {
+		gint size = xmms_sample_size_get (formats[f]);
+
+		for (g = 0; g < G_N_ELEMENTS (gains); g++) {
+			/* odd lengths exercise the scalar tail after the vectors */
+			for (len = 0; len <= 67; len++) {
+				for (i = 0; i < len; i++) {
+					if (formats[f] == XMMS_SAMPLE_FORMAT_FLOAT) {
+						((gfloat *) a)[i] = g_random_double_range (-1.0, 1.0);
+					} else if (formats[f] == XMMS_SAMPLE_FORMAT_DOUBLE) {
+						((gdouble *) a)[i] = g_random_double_range (-1.0, 1.0);
+					} else {
+						gint j;
+						for (j = 0; j < size; j++) {
+							a[i * size + j] = g_random_int ();
+						}
+					}
+				}
+				memcpy (b, a, len * size);
+
+				xmms_sample_gain_apply (formats[f], a, len, gains[g]);
+				xmms_sample_gain_apply_scalar (formats[f], b, len, gains[g]);
+
+				CU_ASSERT_EQUAL (0, memcmp (a, b, len * size));
+			}
+		}
+	}
+}
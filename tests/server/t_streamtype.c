@@ -316,3 +316,25 @@ CASE (test_coerce)
 	xmms_object_unref (to);
 }
 
+
+CASE (test_pcm_with_format)
+{
+	xmms_stream_type_t *st1, *st2;
+
+	st1 = _xmms_stream_type_new ("dummy",
+	                             XMMS_STREAM_TYPE_MIMETYPE, "audio/pcm",
+	                             XMMS_STREAM_TYPE_FMT_FORMAT, XMMS_SAMPLE_FORMAT_S16,
+	                             XMMS_STREAM_TYPE_FMT_CHANNELS, 2,
+	                             XMMS_STREAM_TYPE_FMT_SAMPLERATE, 44100,
+	                             XMMS_STREAM_TYPE_END);
+	st2 = xmms_stream_type_pcm_with_format (st1, XMMS_SAMPLE_FORMAT_FLOAT);
+
+	CU_ASSERT_STRING_EQUAL ("audio/pcm", xmms_stream_type_get_str (st2, XMMS_STREAM_TYPE_MIMETYPE));
+	CU_ASSERT_EQUAL (XMMS_SAMPLE_FORMAT_FLOAT, xmms_stream_type_get_int (st2, XMMS_STREAM_TYPE_FMT_FORMAT));
+	CU_ASSERT_EQUAL (2, xmms_stream_type_get_int (st2, XMMS_STREAM_TYPE_FMT_CHANNELS));
+	CU_ASSERT_EQUAL (44100, xmms_stream_type_get_int (st2, XMMS_STREAM_TYPE_FMT_SAMPLERATE));
+	CU_ASSERT_FALSE (xmms_stream_type_match (st1, st2));
+
+	xmms_object_unref (st1);
+	xmms_object_unref (st2);
+}
@@ -19,6 +19,7 @@
 #include <glib.h>
 
 #include <locale.h>
+#include <string.h>
 
 #include "xmmspriv/xmms_plugin.h"
 #include "xmmspriv/xmms_xform.h"
@@ -287,3 +288,295 @@ CASE(test_browse)
 	CU_ASSERT_BROWSE_ENTRY (result, 5, "file:///Last_Directory", 1, 0);
 	xmmsv_unref (result);
 }
+
+static guint pool_test_pos;
+
+static gboolean
+xmms_pool_test_init (xmms_xform_t *xform)
+{
+	xmms_xform_outdata_type_add (xform,
+	                             XMMS_STREAM_TYPE_MIMETYPE,
+	                             "application/x-pooltest",
+	                             XMMS_STREAM_TYPE_END);
+	return TRUE;
+}
+
+static gint
+xmms_pool_test_read (xmms_xform_t *xform, gpointer buf, gint len,
+                     xmms_error_t *error)
+{
+	guchar *scratch;
+	gint i;
+
+	/* odd sized reads, to make the peek buffer wrap around */
+	len = MIN (len, 1021);
+
+	scratch = xmms_xform_scratch_alloc (xform, len);
+	for (i = 0; i < len; i++) {
+		scratch[i] = pool_test_pos++ & 0xff;
+	}
+	memcpy (buf, scratch, len);
+	xmms_xform_scratch_free (xform, scratch);
+
+	return len;
+}
+
+static gboolean
+xmms_pool_test_xform_plugin_setup (xmms_xform_plugin_t *xform_plugin)
+{
+	xmms_xform_methods_t methods;
+
+	XMMS_XFORM_METHODS_INIT (methods);
+
+	methods.init = xmms_pool_test_init;
+	methods.read = xmms_pool_test_read;
+
+	xmms_xform_plugin_methods_set (xform_plugin, &methods);
+
+	xmms_xform_plugin_indata_add (xform_plugin,
+	                              XMMS_STREAM_TYPE_MIMETYPE,
+	                              "application/x-url",
+	                              XMMS_STREAM_TYPE_URL, "pooltest://*",
+	                              XMMS_STREAM_TYPE_END);
+
+	return TRUE;
+}
+
+XMMS_XFORM_BUILTIN (pool_test_xform,
+                    "pool test xform",
+                    XMMS_VERSION,
+                    "pool test xform",
+                    xmms_pool_test_xform_plugin_setup);
+
+static gboolean
+xmms_pool_peek_init (xmms_xform_t *xform)
+{
+	xmms_xform_outdata_type_add (xform,
+	                             XMMS_STREAM_TYPE_MIMETYPE,
+	                             "audio/pcm",
+	                             XMMS_STREAM_TYPE_END);
+	return TRUE;
+}
+
+static gint
+xmms_pool_peek_read (xmms_xform_t *xform, gpointer buf, gint len,
+                     xmms_error_t *error)
+{
+	gchar peeked[3000];
+	gint res;
+
+	/* peek ahead, then only consume part of it */
+	res = xmms_xform_peek (xform, peeked, sizeof (peeked), error);
+	if (res <= 0) {
+		return res;
+	}
+
+	res = xmms_xform_read (xform, buf, MIN (len, 1500), error);
+	if (res > 0) {
+		CU_ASSERT_EQUAL (0, memcmp (buf, peeked, res));
+	}
+
+	return res;
+}
+
+static gboolean
+xmms_pool_peek_xform_plugin_setup (xmms_xform_plugin_t *xform_plugin)
+{
+	xmms_xform_methods_t methods;
+
+	XMMS_XFORM_METHODS_INIT (methods);
+
+	methods.init = xmms_pool_peek_init;
+	methods.read = xmms_pool_peek_read;
+
+	xmms_xform_plugin_methods_set (xform_plugin, &methods);
+
+	xmms_xform_plugin_indata_add (xform_plugin,
+	                              XMMS_STREAM_TYPE_MIMETYPE,
+	                              "application/x-pooltest",
+	                              XMMS_STREAM_TYPE_END);
+
+	return TRUE;
+}
+
+XMMS_XFORM_BUILTIN (pool_peek_xform,
+                    "pool peek xform",
+                    XMMS_VERSION,
+                    "pool peek xform",
+                    xmms_pool_peek_xform_plugin_setup);
+
+CASE(test_xform_pool)
+{
+	xmms_medialib_session_t *session;
+	xmms_stream_type_t *format;
+	xmms_xform_t *xform;
+	xmms_error_t err;
+	GList *goal_format;
+	guchar buf[4096];
+	guint allocations, expected = 0;
+	gint i, j, res;
+
+	format = _xmms_stream_type_new (XMMS_STREAM_TYPE_BEGIN,
+	                                XMMS_STREAM_TYPE_MIMETYPE,
+	                                "audio/pcm",
+	                                XMMS_STREAM_TYPE_END);
+	goal_format = g_list_prepend (NULL, format);
+
+	xmms_plugin_load (&xmms_builtin_pool_test_xform, NULL);
+	xmms_plugin_load (&xmms_builtin_pool_peek_xform, NULL);
+
+	pool_test_pos = 0;
+
+	session = xmms_medialib_session_begin (medialib);
+	xform = xmms_xform_chain_setup_url_session (medialib, session, 1,
+	                                            "pooltest://", goal_format,
+	                                            TRUE);
+	xmms_medialib_session_abort (session);
+	CU_ASSERT_PTR_NOT_NULL_FATAL (xform);
+
+	xmms_error_reset (&err);
+
+	/* warm up, the peek buffer and scratch buffers settle here */
+	for (i = 0; i < 16; i++) {
+		res = xmms_xform_this_read (xform, buf, sizeof (buf), &err);
+		CU_ASSERT_TRUE (res > 0);
+		for (j = 0; j < res; j++) {
+			CU_ASSERT_EQUAL_FATAL (expected++ & 0xff, buf[j]);
+		}
+	}
+
+	allocations = xmms_xform_pool_allocations_get (xform);
+
+	for (i = 0; i < 1000; i++) {
+		res = xmms_xform_this_read (xform, buf, sizeof (buf), &err);
+		CU_ASSERT_TRUE (res > 0);
+		for (j = 0; j < res; j++) {
+			CU_ASSERT_EQUAL_FATAL (expected++ & 0xff, buf[j]);
+		}
+	}
+
+	/* steady state must not hit the heap */
+	CU_ASSERT_EQUAL (allocations, xmms_xform_pool_allocations_get (xform));
+
+	xmms_object_unref (xform);
+
+	g_list_free (goal_format);
+	xmms_object_unref (format);
+}
+
+static guint pcm_test_pos;
+
+static gboolean
+xmms_pcm_test_init (xmms_xform_t *xform)
+{
+	xmms_xform_outdata_type_add (xform,
+	                             XMMS_STREAM_TYPE_MIMETYPE,
+	                             "audio/pcm",
+	                             XMMS_STREAM_TYPE_FMT_FORMAT,
+	                             XMMS_SAMPLE_FORMAT_S16,
+	                             XMMS_STREAM_TYPE_FMT_CHANNELS,
+	                             1,
+	                             XMMS_STREAM_TYPE_FMT_SAMPLERATE,
+	                             44100,
+	                             XMMS_STREAM_TYPE_END);
+	return TRUE;
+}
+
+static gint
+xmms_pcm_test_read (xmms_xform_t *xform, gpointer buf, gint len,
+                    xmms_error_t *error)
+{
+	gint16 *samples = buf;
+	gint i;
+
+	len = MIN (len, 1000) & ~1;
+
+	for (i = 0; i < len / 2; i++) {
+		samples[i] = pcm_test_pos++ & 0x7fff;
+	}
+
+	return len;
+}
+
+static gboolean
+xmms_pcm_test_xform_plugin_setup (xmms_xform_plugin_t *xform_plugin)
+{
+	xmms_xform_methods_t methods;
+
+	XMMS_XFORM_METHODS_INIT (methods);
+
+	methods.init = xmms_pcm_test_init;
+	methods.read = xmms_pcm_test_read;
+
+	xmms_xform_plugin_methods_set (xform_plugin, &methods);
+
+	xmms_xform_plugin_indata_add (xform_plugin,
+	                              XMMS_STREAM_TYPE_MIMETYPE,
+	                              "application/x-url",
+	                              XMMS_STREAM_TYPE_URL, "pcmtest://*",
+	                              XMMS_STREAM_TYPE_END);
+
+	return TRUE;
+}
+
+XMMS_XFORM_BUILTIN (pcm_test_xform,
+                    "pcm test xform",
+                    XMMS_VERSION,
+                    "pcm test xform",
+                    xmms_pcm_test_xform_plugin_setup);
+
+/* mono to stereo goes through the converter, which takes its input
+ * buffer from the pool on every read */
+CASE(test_xform_converter)
+{
+	extern const xmms_plugin_desc_t xmms_builtin_converter;
+	xmms_medialib_session_t *session;
+	xmms_stream_type_t *format;
+	xmms_xform_t *xform;
+	xmms_error_t err;
+	GList *goal_format;
+	gint16 buf[2048];
+	guint expected = 0;
+	gint i, j, res;
+
+	format = _xmms_stream_type_new (XMMS_STREAM_TYPE_BEGIN,
+	                                XMMS_STREAM_TYPE_MIMETYPE,
+	                                "audio/pcm",
+	                                XMMS_STREAM_TYPE_FMT_FORMAT,
+	                                XMMS_SAMPLE_FORMAT_S16,
+	                                XMMS_STREAM_TYPE_FMT_CHANNELS,
+	                                2,
+	                                XMMS_STREAM_TYPE_FMT_SAMPLERATE,
+	                                44100,
+	                                XMMS_STREAM_TYPE_END);
+	goal_format = g_list_prepend (NULL, format);
+
+	xmms_plugin_load (&xmms_builtin_converter, NULL);
+	xmms_plugin_load (&xmms_builtin_pcm_test_xform, NULL);
+
+	pcm_test_pos = 0;
+
+	session = xmms_medialib_session_begin (medialib);
+	xform = xmms_xform_chain_setup_url_session (medialib, session, 1,
+	                                            "pcmtest://", goal_format,
+	                                            TRUE);
+	xmms_medialib_session_abort (session);
+	CU_ASSERT_PTR_NOT_NULL_FATAL (xform);
+
+	xmms_error_reset (&err);
+
+	for (i = 0; i < 1000; i++) {
+		res = xmms_xform_this_read (xform, buf, sizeof (buf), &err);
+		CU_ASSERT_TRUE_FATAL (res > 0 && res % 4 == 0);
+		for (j = 0; j < res / 2; j += 2) {
+			CU_ASSERT_EQUAL_FATAL (expected & 0x7fff, buf[j]);
+			CU_ASSERT_EQUAL_FATAL (expected & 0x7fff, buf[j + 1]);
+			expected++;
+		}
+	}
+
+	xmms_object_unref (xform);
+
+	g_list_free (goal_format);
+	xmms_object_unref (format);
+}
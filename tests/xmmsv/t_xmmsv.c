@@ -937,6 +937,44 @@ CASE (test_xmmsv_type_bitbuffer_ro)
 	xmmsv_unref (value);
 }
 
+CASE (test_xmmsv_type_bitbuffer_data)
+{
+	xmmsv_t *value;
+	unsigned char data[1000], b[1000];
+	int i, r;
+
+	for (i = 0; i < sizeof (data); i++) {
+		data[i] = i * 7;
+	}
+
+	value = xmmsv_new_bitbuffer ();
+
+	/* byte aligned, large enough to grow the buffer a few times */
+	CU_ASSERT_TRUE (xmmsv_bitbuffer_put_data (value, data, sizeof (data)));
+	CU_ASSERT_EQUAL (sizeof (data) * 8, xmmsv_bitbuffer_len (value));
+
+	/* unaligned */
+	CU_ASSERT_TRUE (xmmsv_bitbuffer_put_bits (value, 3, 5));
+	CU_ASSERT_TRUE (xmmsv_bitbuffer_put_data (value, data, 10));
+
+	CU_ASSERT_TRUE (xmmsv_bitbuffer_rewind (value));
+	CU_ASSERT_TRUE (xmmsv_bitbuffer_get_data (value, b, sizeof (data)));
+	CU_ASSERT_EQUAL (0, memcmp (data, b, sizeof (data)));
+
+	CU_ASSERT_TRUE (xmmsv_bitbuffer_get_bits (value, 3, &r));
+	CU_ASSERT_EQUAL (5, r);
+	CU_ASSERT_TRUE (xmmsv_bitbuffer_get_data (value, b, 10));
+	CU_ASSERT_EQUAL (0, memcmp (data, b, 10));
+
+	CU_ASSERT_FALSE (xmmsv_bitbuffer_get_data (value, b, 1));
+
+	/* aligned read past the end */
+	CU_ASSERT_TRUE (xmmsv_bitbuffer_goto (value, 8 * (sizeof (data) + 9)));
+	CU_ASSERT_FALSE (xmmsv_bitbuffer_get_data (value, b, 4));
+
+	xmmsv_unref (value);
+}
+
 CASE (test_xmmsv_list_flatten) {
 	xmmsv_t *list, *flat, *tmp;
 	int l1[] = {0, 1, 2, 3};
@@ -1080,3 +1118,136 @@ CASE (test_xmmsv_deep_copy_bitbuffer)
 
 	xmmsv_unref (val_cpy);
 }
+
+CASE (test_xmmsv_arena)
+{
+	xmmsv_arena_t *arena;
+	xmmsv_t *dict, *list, *value, *bb, *copy;
+	const char *s;
+	char key[16], *big;
+	int i, j;
+
+	arena = xmmsv_arena_new (0);
+
+	dict = xmmsv_arena_new_dict (arena);
+	list = xmmsv_arena_new_list (arena);
+
+	/* grow the containers well past their first allocation */
+	for (i = 0; i < 1000; i++) {
+		snprintf (key, sizeof (key), "key%d", i);
+
+		value = xmmsv_arena_new_int (arena, i);
+		xmmsv_dict_set (dict, key, value);
+		xmmsv_list_append (list, value);
+		xmmsv_unref (value);
+	}
+
+	for (i = 0; i < 1000; i += 2) {
+		snprintf (key, sizeof (key), "key%d", i);
+		CU_ASSERT_TRUE (xmmsv_dict_remove (dict, key));
+	}
+	CU_ASSERT_TRUE (xmmsv_list_remove (list, 0));
+
+	/* too big to share a chunk with the other values */
+	big = malloc (100000);
+	memset (big, 'x', 99999);
+	big[99999] = '\0';
+	value = xmmsv_arena_new_string (arena, big);
+	xmmsv_dict_set (dict, "big", value);
+	xmmsv_unref (value);
+
+	value = xmmsv_arena_new_string (arena, "escaping");
+	xmmsv_dict_set (dict, "escaping", value);
+
+	/* the values keep the arena alive */
+	xmmsv_arena_unref (arena);
+
+	CU_ASSERT_EQUAL (xmmsv_dict_get_size (dict), 502);
+	CU_ASSERT_EQUAL (xmmsv_list_get_size (list), 999);
+	for (i = 1; i < 1000; i++) {
+		snprintf (key, sizeof (key), "key%d", i);
+		CU_ASSERT_EQUAL (xmmsv_dict_get (dict, key, NULL), i % 2);
+		CU_ASSERT_TRUE (xmmsv_list_get_int (list, i - 1, &j));
+		CU_ASSERT_EQUAL (j, i);
+	}
+
+	CU_ASSERT_TRUE (xmmsv_dict_entry_get_string (dict, "big", &s));
+	CU_ASSERT_STRING_EQUAL (s, big);
+
+	/* arena values read back into another arena */
+	bb = xmmsv_new_bitbuffer ();
+	CU_ASSERT_TRUE (xmmsv_bitbuffer_serialize_value (bb, dict));
+	CU_ASSERT_TRUE (xmmsv_bitbuffer_rewind (bb));
+
+	arena = xmmsv_arena_new (4096);
+	CU_ASSERT_TRUE (xmmsv_bitbuffer_deserialize_value_arena (bb, arena, &copy));
+	xmmsv_arena_unref (arena);
+	xmmsv_unref (bb);
+
+	CU_ASSERT_EQUAL (xmmsv_dict_get_size (copy), 502);
+	CU_ASSERT_TRUE (xmmsv_dict_entry_get_string (copy, "big", &s));
+	CU_ASSERT_STRING_EQUAL (s, big);
+	CU_ASSERT_TRUE (xmmsv_dict_entry_get_int (copy, "key999", &j));
+	CU_ASSERT_EQUAL (j, 999);
+
+	xmmsv_unref (copy);
+	xmmsv_unref (list);
+	xmmsv_unref (dict);
+
+	/* only the escaped value is left */
+	CU_ASSERT_TRUE (xmmsv_get_string (value, &s));
+	CU_ASSERT_STRING_EQUAL (s, "escaping");
+	xmmsv_unref (value);
+
+	free (big);
+}
+
+CASE (test_xmmsv_interned_strings)
+{
+	xmmsv_dict_iter_t *it;
+	xmmsv_t *a, *b, *value;
+	const char *ka, *kb, *sa, *sb;
+
+	a = xmmsv_build_dict (XMMSV_DICT_ENTRY_STR ("artist", "server"),
+	                      XMMSV_DICT_END);
+	b = xmmsv_build_dict (XMMSV_DICT_ENTRY_STR ("artist", "server"),
+	                      XMMSV_DICT_END);
+
+	/* common keys and values are shared */
+	CU_ASSERT_TRUE (xmmsv_get_dict_iter (a, &it));
+	CU_ASSERT_TRUE (xmmsv_dict_iter_pair_string (it, &ka, &sa));
+	CU_ASSERT_TRUE (xmmsv_get_dict_iter (b, &it));
+	CU_ASSERT_TRUE (xmmsv_dict_iter_pair_string (it, &kb, &sb));
+	CU_ASSERT_PTR_EQUAL (ka, kb);
+	CU_ASSERT_PTR_EQUAL (sa, sb);
+	CU_ASSERT_STRING_EQUAL (ka, "artist");
+	CU_ASSERT_STRING_EQUAL (sa, "server");
+
+	/* and behave like any other */
+	CU_ASSERT_TRUE (xmmsv_dict_remove (a, "artist"));
+	CU_ASSERT_FALSE (xmmsv_dict_has_key (a, "artist"));
+	CU_ASSERT_TRUE (xmmsv_dict_set_string (a, "artist", "someone"));
+	CU_ASSERT_TRUE (xmmsv_dict_entry_get_string (a, "artist", &sa));
+	CU_ASSERT_STRING_EQUAL (sa, "someone");
+	xmmsv_unref (a);
+	xmmsv_unref (b);
+
+	/* other strings get a copy of their own */
+	a = xmmsv_build_dict (XMMSV_DICT_ENTRY_STR ("artists", "servers"),
+	                      XMMSV_DICT_END);
+	b = xmmsv_build_dict (XMMSV_DICT_ENTRY_STR ("artists", "servers"),
+	                      XMMSV_DICT_END);
+	CU_ASSERT_TRUE (xmmsv_get_dict_iter (a, &it));
+	CU_ASSERT_TRUE (xmmsv_dict_iter_pair_string (it, &ka, &sa));
+	CU_ASSERT_TRUE (xmmsv_get_dict_iter (b, &it));
+	CU_ASSERT_TRUE (xmmsv_dict_iter_pair_string (it, &kb, &sb));
+	CU_ASSERT_TRUE (ka != kb);
+	CU_ASSERT_TRUE (sa != sb);
+	xmmsv_unref (a);
+	xmmsv_unref (b);
+
+	value = xmmsv_new_string ("plugin/id3v2");
+	CU_ASSERT_TRUE (xmmsv_get_string (value, &sa));
+	CU_ASSERT_STRING_EQUAL (sa, "plugin/id3v2");
+	xmmsv_unref (value);
+}
@@ -485,3 +485,177 @@ CASE (test_xmmsv_serialize_dict)
 
 	xmmsv_unref (value);
 }
+
+CASE (test_xmmsv_serialize_compact_columns)
+{
+	xmmsv_t *bb, *value, *item, *dict;
+	const unsigned char *data;
+	const char *s;
+	int i, length;
+	const unsigned char expected[] = {
+		0x58, 0x4d, 0x43, 0x31, /* compact encoding magic */
+		0x06,                   /* XMMSV_TYPE_LIST */
+		0x05,                   /* 2 (number of items) << 1 | columnar */
+		0x01,                   /* 1 (number of keys) */
+		0x00, 0x01, 0x61,       /* key[0]: new string of length 1, "a" */
+
+		0x03,                   /* column[0][0]: XMMSV_TYPE_STRING */
+		0x00, 0x03,             /* column[0][0]: new string of length 3 */
+		0x66, 0x6f, 0x6f,       /* column[0][0]: "foo" */
+
+		0x03,                   /* column[0][1]: XMMSV_TYPE_STRING */
+		0x02                    /* column[0][1]: string 1 of the table */
+	};
+
+	value = xmmsv_new_list ();
+	for (i = 0; i < 2; i++) {
+		dict = xmmsv_new_dict ();
+		xmmsv_dict_set_string (dict, "a", "foo");
+		xmmsv_list_append (value, dict);
+		xmmsv_unref (dict);
+	}
+
+	bb = xmmsv_new_bitbuffer ();
+	CU_ASSERT_TRUE (xmmsv_bitbuffer_serialize_value_compact (bb, value));
+	xmmsv_unref (value);
+
+	data = xmmsv_bitbuffer_buffer (bb);
+	length = xmmsv_bitbuffer_len (bb) / 8;
+
+	CU_ASSERT_EQUAL_FATAL (length, sizeof (expected));
+	CU_ASSERT_EQUAL (memcmp (data, expected, length), 0);
+
+	xmmsv_bitbuffer_rewind (bb);
+	CU_ASSERT_TRUE_FATAL (xmmsv_bitbuffer_deserialize_value (bb, &value));
+	xmmsv_unref (bb);
+
+	CU_ASSERT_TRUE (xmmsv_is_type (value, XMMSV_TYPE_LIST));
+	CU_ASSERT_EQUAL (xmmsv_list_get_size (value), 2);
+
+	for (i = 0; i < 2; i++) {
+		CU_ASSERT_TRUE (xmmsv_list_get (value, i, &item));
+		CU_ASSERT_TRUE (xmmsv_is_type (item, XMMSV_TYPE_DICT));
+		CU_ASSERT_EQUAL (xmmsv_dict_get_size (item), 1);
+		CU_ASSERT_TRUE (xmmsv_dict_entry_get_string (item, "a", &s));
+		CU_ASSERT_STRING_EQUAL (s, "foo");
+	}
+
+	xmmsv_unref (value);
+}
+
+CASE (test_xmmsv_serialize_compact_roundtrip)
+{
+	xmmsv_t *bb, *value, *item, *dict, *mixed;
+	const unsigned char *bin;
+	unsigned int binlen;
+	const char *s;
+	int32_t i;
+	const int32_t ints[] = { 0, -1, 1, 300, -300, INT_MIN, INT_MAX };
+	const unsigned char raw[] = { 0x00, 0xff, 0x10 };
+
+	value = xmmsv_new_dict ();
+
+	/* ints of every varint length and sign */
+	item = xmmsv_new_list ();
+	for (i = 0; i < sizeof (ints) / sizeof (ints[0]); i++) {
+		xmmsv_list_append_int (item, ints[i]);
+	}
+	xmmsv_dict_set (value, "ints", item);
+	xmmsv_unref (item);
+
+	/* dicts with different keys stay row by row */
+	mixed = xmmsv_new_list ();
+	dict = xmmsv_new_dict ();
+	xmmsv_dict_set_string (dict, "title", "one");
+	xmmsv_list_append (mixed, dict);
+	xmmsv_unref (dict);
+	dict = xmmsv_new_dict ();
+	xmmsv_dict_set_string (dict, "artist", "title");
+	xmmsv_list_append (mixed, dict);
+	xmmsv_unref (dict);
+	xmmsv_dict_set (value, "mixed", mixed);
+	xmmsv_unref (mixed);
+
+	item = xmmsv_new_bin (raw, sizeof (raw));
+	xmmsv_dict_set (value, "bin", item);
+	xmmsv_unref (item);
+
+	item = xmmsv_new_error ("title");
+	xmmsv_dict_set (value, "error", item);
+	xmmsv_unref (item);
+
+	item = xmmsv_new_none ();
+	xmmsv_dict_set (value, "", item);
+	xmmsv_unref (item);
+
+	bb = xmmsv_new_bitbuffer ();
+	CU_ASSERT_TRUE (xmmsv_bitbuffer_serialize_value_compact (bb, value));
+	xmmsv_unref (value);
+
+	xmmsv_bitbuffer_rewind (bb);
+	CU_ASSERT_TRUE_FATAL (xmmsv_bitbuffer_deserialize_value (bb, &value));
+	xmmsv_unref (bb);
+
+	CU_ASSERT_EQUAL (xmmsv_dict_get_size (value), 5);
+
+	CU_ASSERT_TRUE (xmmsv_dict_get (value, "ints", &item));
+	CU_ASSERT_EQUAL (xmmsv_list_get_size (item), sizeof (ints) / sizeof (ints[0]));
+	for (i = 0; i < sizeof (ints) / sizeof (ints[0]); i++) {
+		int32_t v;
+		CU_ASSERT_TRUE (xmmsv_list_get_int (item, i, &v));
+		CU_ASSERT_EQUAL (v, ints[i]);
+	}
+
+	CU_ASSERT_TRUE (xmmsv_dict_get (value, "mixed", &mixed));
+	CU_ASSERT_TRUE (xmmsv_list_get (mixed, 0, &dict));
+	CU_ASSERT_TRUE (xmmsv_dict_entry_get_string (dict, "title", &s));
+	CU_ASSERT_STRING_EQUAL (s, "one");
+	CU_ASSERT_TRUE (xmmsv_list_get (mixed, 1, &dict));
+	CU_ASSERT_TRUE (xmmsv_dict_entry_get_string (dict, "artist", &s));
+	CU_ASSERT_STRING_EQUAL (s, "title");
+
+	CU_ASSERT_TRUE (xmmsv_dict_get (value, "bin", &item));
+	CU_ASSERT_TRUE (xmmsv_get_bin (item, &bin, &binlen));
+	CU_ASSERT_EQUAL (binlen, sizeof (raw));
+	CU_ASSERT_EQUAL (memcmp (bin, raw, sizeof (raw)), 0);
+
+	CU_ASSERT_TRUE (xmmsv_dict_get (value, "error", &item));
+	CU_ASSERT_TRUE (xmmsv_get_error (item, &s));
+	CU_ASSERT_STRING_EQUAL (s, "title");
+
+	CU_ASSERT_TRUE (xmmsv_dict_get (value, "", &item));
+	CU_ASSERT_TRUE (xmmsv_is_type (item, XMMSV_TYPE_NONE));
+
+	xmmsv_unref (value);
+}
+
+CASE (test_xmmsv_serialize_compact_truncated)
+{
+	xmmsv_t *bb, *value;
+	/* a list claiming more items than there are bytes left */
+	const unsigned char data[] = {
+		0x58, 0x4d, 0x43, 0x31, 0x06, 0x80, 0x80, 0x04
+	};
+
+	bb = xmmsv_new_bitbuffer_ro (data, sizeof (data));
+	CU_ASSERT_FALSE (xmmsv_bitbuffer_deserialize_value (bb, &value));
+	xmmsv_unref (bb);
+}
+
+CASE (test_xmmsv_serialize_compact_bad_collection_type)
+{
+	xmmsv_t *bb, *value;
+	/* a collection of a type beyond XMMS_COLLECTION_TYPE_LAST */
+	const unsigned char data[] = {
+		0x58, 0x4d, 0x43, 0x31, /* compact encoding magic */
+		0x04,                   /* XMMSV_TYPE_COLL */
+		0x7f,                   /* collection type 127 */
+		0x00,                   /* no attributes */
+		0x00,                   /* no ids */
+		0x00                    /* no operands */
+	};
+
+	bb = xmmsv_new_bitbuffer_ro (data, sizeof (data));
+	CU_ASSERT_FALSE (xmmsv_bitbuffer_deserialize_value (bb, &value));
+	xmmsv_unref (bb);
+}